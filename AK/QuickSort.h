@@ -1,5 +1,8 @@
 #pragma once
 
+#include <AK/StdLibExtras.h>
+#include <AK/Vector.h>
+
 namespace AK {
 
 template<typename T>
@@ -8,32 +11,201 @@ bool is_less_than(const T& a, const T& b)
     return a < b;
 }
 
-template <typename Iterator, typename LessThan>
+namespace SortDetail {
+
+// The sorts below only ever compare and swap elements by index, through an
+// "ops" object with less(a, b) and swap(a, b). That lets qsort() in LibC,
+// which sorts runtime-sized byte blobs, share them with quick_sort().
+// Elements are never copied, only swapped.
+
+// Ranges this short are left to insertion sort.
+static const int insertion_sort_threshold = 16;
+
+template<typename Ops>
+void insertion_sort(Ops& ops, int start, int end)
+{
+    for (int i = start + 1; i < end; ++i) {
+        for (int j = i; j > start && ops.less(j, j - 1); --j)
+            ops.swap(j, j - 1);
+    }
+}
+
+template<typename Ops>
+void sift_down(Ops& ops, int start, int root, int size)
+{
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= size)
+            return;
+        if (child + 1 < size && ops.less(start + child, start + child + 1))
+            ++child;
+        if (!ops.less(start + root, start + child))
+            return;
+        ops.swap(start + root, start + child);
+        root = child;
+    }
+}
+
+template<typename Ops>
+void heap_sort(Ops& ops, int start, int end)
+{
+    int size = end - start;
+    for (int i = size / 2 - 1; i >= 0; --i)
+        sift_down(ops, start, i, size);
+    for (int i = size - 1; i > 0; --i) {
+        ops.swap(start, start + i);
+        sift_down(ops, start, 0, i);
+    }
+}
+
+// Puts the median of a, b and c at target.
+template<typename Ops>
+void move_median_to(Ops& ops, int target, int a, int b, int c)
+{
+    if (ops.less(a, b)) {
+        if (ops.less(b, c))
+            ops.swap(target, b);
+        else if (ops.less(a, c))
+            ops.swap(target, c);
+        else
+            ops.swap(target, a);
+    } else if (ops.less(a, c)) {
+        ops.swap(target, a);
+    } else if (ops.less(b, c)) {
+        ops.swap(target, c);
+    } else {
+        ops.swap(target, b);
+    }
+}
+
+// Hoare partition of [start + 1, end) around the pivot at start.
+// Median-of-three leaves an element on either side of the pivot's value in
+// the range, so neither scan can run off the end.
+template<typename Ops>
+int partition(Ops& ops, int start, int end)
+{
+    int left = start + 1;
+    int right = end;
+    for (;;) {
+        while (ops.less(left, start))
+            ++left;
+        --right;
+        while (ops.less(start, right))
+            --right;
+        if (left >= right)
+            return left;
+        ops.swap(left, right);
+        ++left;
+    }
+}
+
+inline int depth_limit_for(int size)
+{
+    int depth = 0;
+    for (; size > 1; size >>= 1)
+        depth += 2;
+    return depth;
+}
+
+// Introsort: quicksort with median-of-three pivots, falling back to heapsort
+// once it has recursed deeper than 2 * log2(size), which only happens on
+// adversarial input. Recursing into the smaller half keeps the stack shallow.
+template<typename Ops>
+void intro_sort(Ops& ops, int start, int end, int depth_limit)
+{
+    while (end - start > insertion_sort_threshold) {
+        if (!depth_limit) {
+            heap_sort(ops, start, end);
+            return;
+        }
+        --depth_limit;
+        move_median_to(ops, start, start + 1, start + (end - start) / 2, end - 1);
+        int cut = partition(ops, start, end);
+        if (cut - start < end - cut) {
+            intro_sort(ops, start, cut, depth_limit);
+            start = cut;
+        } else {
+            intro_sort(ops, cut, end, depth_limit);
+            end = cut;
+        }
+    }
+    insertion_sort(ops, start, end);
+}
+
+template<typename Ops>
+void intro_sort(Ops& ops, int size)
+{
+    if (size > 1)
+        intro_sort(ops, 0, size, depth_limit_for(size));
+}
+
+template<typename Iterator, typename LessThan>
+struct IteratorOps {
+    Iterator start;
+    LessThan& less_than;
+
+    bool less(int a, int b) { return less_than(*(start + a), *(start + b)); }
+    void swap(int a, int b) { AK::swap(*(start + a), *(start + b)); }
+};
+
+}
+
+template<typename Iterator, typename LessThan>
 void quick_sort(Iterator start, Iterator end, LessThan less_than = is_less_than)
 {
+    SortDetail::IteratorOps<Iterator, LessThan> ops { start, less_than };
+    SortDetail::intro_sort(ops, end - start);
+}
+
+// Stable, unlike quick_sort(): equal elements keep their order. Needs a
+// scratch buffer the size of the range and moves elements through it.
+template<typename Iterator, typename LessThan>
+void merge_sort(Iterator start, Iterator end, LessThan less_than = is_less_than)
+{
+    typedef typename RemoveReference<decltype(*start)>::Type T;
     int size = end - start;
     if (size <= 1)
         return;
 
-    int pivot_point = size / 2;
-    auto pivot = *(start + pivot_point);
+    SortDetail::IteratorOps<Iterator, LessThan> ops { start, less_than };
+    if (size <= SortDetail::insertion_sort_threshold) {
+        SortDetail::insertion_sort(ops, 0, size);
+        return;
+    }
 
-    if (pivot_point)
-        swap(*(start + pivot_point), *start);
+    // Insertion sort (which is stable) short runs, then merge them bottom-up.
+    for (int run = 0; run < size; run += SortDetail::insertion_sort_threshold)
+        SortDetail::insertion_sort(ops, run, min(run + SortDetail::insertion_sort_threshold, size));
 
-    int i = 1;
-    for (int j = 1; j < size; ++j) {
-        if (less_than(*(start + j), pivot)) {
-            swap(*(start+j), *(start + i));
-            ++i;
+    Vector<T> buffer;
+    buffer.ensure_capacity(size);
+    for (int width = SortDetail::insertion_sort_threshold; width < size; width *= 2) {
+        for (int left = 0; left + width < size; left += 2 * width) {
+            int middle = left + width;
+            int right = min(left + 2 * width, size);
+            // Already in order; nothing to merge.
+            if (!less_than(*(start + middle), *(start + middle - 1)))
+                continue;
+            buffer.clear_with_capacity();
+            for (int i = left; i < middle; ++i)
+                buffer.unchecked_append(move(*(start + i)));
+            int out = left;
+            int a = 0;
+            int b = middle;
+            while (a < buffer.size() && b < right) {
+                // Take from the right run only if strictly smaller, to stay stable.
+                if (less_than(*(start + b), buffer[a]))
+                    *(start + out++) = move(*(start + b++));
+                else
+                    *(start + out++) = move(buffer[a++]);
+            }
+            while (a < buffer.size())
+                *(start + out++) = move(buffer[a++]);
         }
     }
-
-    swap(*start, *(start + i - 1));
-    quick_sort(start, start + i - 1, less_than);
-    quick_sort(start + i, end, less_than);
 }
 
 }
 
+using AK::merge_sort;
 using AK::quick_sort;
@@ -55,6 +55,22 @@ public:
         return value;
     }
 
+    // Walks the whole list to find the new tail, so keep this to short lists.
+    T take_last()
+    {
+        ASSERT(m_tail);
+        if (m_head == m_tail)
+            return take_first();
+        auto* new_tail = m_head;
+        while (new_tail->next != m_tail)
+            new_tail = new_tail->next;
+        T value = move(m_tail->value);
+        delete m_tail;
+        new_tail->next = nullptr;
+        m_tail = new_tail;
+        return value;
+    }
+
     void append(T&& value)
     {
         auto* node = new Node(move(value));
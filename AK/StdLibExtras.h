@@ -189,6 +189,10 @@ template<class T> struct RemovePointer<T* const> { typedef T Type; };
 template<class T> struct RemovePointer<T* volatile> { typedef T Type; };
 template<class T> struct RemovePointer<T* const volatile> { typedef T Type; };
 
+template<class T> struct RemoveReference { typedef T Type; };
+template<class T> struct RemoveReference<T&> { typedef T Type; };
+template<class T> struct RemoveReference<T&&> { typedef T Type; };
+
 template<typename T, typename U>
 struct IsSame {
     enum { value = 0 };
@@ -43,9 +43,16 @@ void StringBuilder::append(char ch)
 
 void StringBuilder::appendvf(const char* fmt, va_list ap)
 {
-    printf_internal([this] (char*&, char ch) {
-        append(ch);
-    }, nullptr, fmt, ap);
+    struct Sink {
+        StringBuilder& builder;
+        void append(const char* characters, int length) { builder.append(characters, length); }
+        void fill(char ch, int count)
+        {
+            while (count--)
+                builder.append(ch);
+        }
+    } sink { *this };
+    printf_internal(sink, fmt, ap);
 }
 
 void StringBuilder::appendf(const char* fmt, ...)
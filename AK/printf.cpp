@@ -11,299 +11,787 @@ typedef long long unsigned int qword;
     return len;
 }
 
-static constexpr const char* h = "0123456789abcdef";
+// printf_internal() writes into a Sink, which has to provide:
+//
+//     void append(const char* characters, int length); // A run of output.
+//     void fill(char ch, int count);                   // Padding.
+//
+// Literal text and each formatted field are handed over as whole runs,
+// so a sink can copy them in one go instead of taking a character at a time.
+
+// For sprintf() and friends, where the caller promises the buffer is big enough.
+struct PrintfBufferSink {
+    char* bufptr;
+
+    void append(const char* characters, int length)
+    {
+        __builtin_memcpy(bufptr, characters, length);
+        bufptr += length;
+    }
 
-template<typename PutChFunc, typename T>
-[[gnu::always_inline]] inline int print_hex(PutChFunc putch, char*& bufptr, T number, byte fields)
+    void fill(char ch, int count)
+    {
+        __builtin_memset(bufptr, ch, count);
+        bufptr += count;
+    }
+};
+
+// For snprintf() and friends: keeps what fits and drops the rest.
+struct PrintfSizedBufferSink {
+    char* bufptr;
+    size_t space_remaining;
+
+    void append(const char* characters, int length)
+    {
+        size_t count = (size_t)length < space_remaining ? length : space_remaining;
+        __builtin_memcpy(bufptr, characters, count);
+        bufptr += count;
+        space_remaining -= count;
+    }
+
+    void fill(char ch, int length)
+    {
+        size_t count = (size_t)length < space_remaining ? length : space_remaining;
+        __builtin_memset(bufptr, ch, count);
+        bufptr += count;
+        space_remaining -= count;
+    }
+};
+
+static constexpr const char* printf_hex_digits = "0123456789abcdef";
+static constexpr const char* printf_upper_hex_digits = "0123456789ABCDEF";
+
+// "00", "01", ... "99", so decimal numbers can be produced two digits per division.
+static constexpr const char printf_digit_pairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+// Writes the digits of number so that they end just before end, and returns where they start.
+[[gnu::always_inline]] inline char* format_decimal(char* end, dword number)
 {
-    int ret = 0;
-    byte shr_count = fields * 4;
-    while (shr_count) {
-        shr_count -= 4;
-        putch(bufptr, h[(number >> shr_count) & 0x0F]);
-        ++ret;
+    char* p = end;
+    while (number >= 100) {
+        dword pair = (number % 100) * 2;
+        number /= 100;
+        *--p = printf_digit_pairs[pair + 1];
+        *--p = printf_digit_pairs[pair];
     }
-    return ret;
+    if (number >= 10) {
+        *--p = printf_digit_pairs[number * 2 + 1];
+        *--p = printf_digit_pairs[number * 2];
+    } else {
+        *--p = '0' + number;
+    }
+    return p;
 }
 
-template<typename PutChFunc>
-[[gnu::always_inline]] inline int print_number(PutChFunc putch, char*& bufptr, dword number, bool leftPad, bool zeroPad, dword fieldWidth)
+inline char* format_decimal(char* end, qword number)
 {
-    dword divisor = 1000000000;
-    char ch;
-    char padding = 1;
-    char buf[16];
-    char* p = buf;
-
-    for (;;) {
-        ch = '0' + (number / divisor);
-        number %= divisor;
-        if (ch != '0')
-            padding = 0;
-        if (!padding || divisor == 1)
-            *(p++) = ch;
-        if (divisor == 1)
-            break;
-        divisor /= 10;
+    // One 64-bit division peels off eight digits, and the rest is done in 32 bits.
+    while (number > 0xffffffff) {
+        dword low = number % 100000000;
+        number /= 100000000;
+        char* start = format_decimal(end, low);
+        end -= 8;
+        while (start > end)
+            *--start = '0';
     }
+    return format_decimal(end, (dword)number);
+}
 
-    size_t numlen = p - buf;
-    if (!fieldWidth || fieldWidth < numlen)
-        fieldWidth = numlen;
-    if (!leftPad) {
-        for (unsigned i = 0; i < fieldWidth - numlen; ++i) {
-            putch(bufptr, zeroPad ? '0' : ' ');
-        }
-    }
-    for (unsigned i = 0; i < numlen; ++i) {
-        putch(bufptr, buf[i]);
+struct PrintfSpec {
+    bool left_justify { false };
+    bool zero_pad { false };
+    bool plus_sign { false };
+    bool alternate_form { false };
+    int width { 0 };
+    int precision { -1 };
+    int long_qualifiers { 0 };
+    int short_qualifiers { 0 };
+};
+
+// h and hh narrow an argument that was promoted to int on its way through the varargs.
+inline int printf_narrow_signed(const PrintfSpec& spec, int number)
+{
+    if (spec.short_qualifiers >= 2)
+        return (signed char)number;
+    if (spec.short_qualifiers == 1)
+        return (short)number;
+    return number;
+}
+
+inline dword printf_narrow_unsigned(const PrintfSpec& spec, dword number)
+{
+    if (spec.short_qualifiers >= 2)
+        return (byte)number;
+    if (spec.short_qualifiers == 1)
+        return (word)number;
+    return number;
+}
+
+// One formatted field: [prefix][zeros][body][zeros][suffix], padded out to the field width.
+struct PrintfField {
+    const char* prefix { nullptr };
+    int prefix_length { 0 };
+    int leading_zeros { 0 };
+    const char* body { nullptr };
+    int body_length { 0 };
+    int trailing_zeros { 0 };
+    const char* suffix { nullptr };
+    int suffix_length { 0 };
+    bool zero_pad { false };
+};
+
+template<typename Sink>
+[[gnu::always_inline]] inline int print_field(Sink& sink, const PrintfSpec& spec, const PrintfField& field)
+{
+    int length = field.prefix_length + field.leading_zeros + field.body_length + field.trailing_zeros + field.suffix_length;
+    int padding = spec.width > length ? spec.width - length : 0;
+    bool zero_pad = field.zero_pad && !spec.left_justify;
+    if (padding && !spec.left_justify && !zero_pad)
+        sink.fill(' ', padding);
+    if (field.prefix_length)
+        sink.append(field.prefix, field.prefix_length);
+    if (padding && zero_pad)
+        sink.fill('0', padding);
+    if (field.leading_zeros)
+        sink.fill('0', field.leading_zeros);
+    if (field.body_length)
+        sink.append(field.body, field.body_length);
+    if (field.trailing_zeros)
+        sink.fill('0', field.trailing_zeros);
+    if (field.suffix_length)
+        sink.append(field.suffix, field.suffix_length);
+    if (padding && spec.left_justify)
+        sink.fill(' ', padding);
+    return length + padding;
+}
+
+template<typename Sink, typename T>
+[[gnu::always_inline]] inline int print_decimal(Sink& sink, const PrintfSpec& spec, T magnitude, bool is_negative, bool is_signed)
+{
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* start = format_decimal(end, magnitude);
+    // An explicit precision of zero prints nothing at all for zero.
+    if (!spec.precision && !magnitude)
+        start = end;
+
+    char sign = is_negative ? '-' : '+';
+    PrintfField field;
+    field.prefix = &sign;
+    // '+' only applies to signed conversions; %+u prints no sign.
+    field.prefix_length = is_negative || (is_signed && spec.plus_sign) ? 1 : 0;
+    field.body = start;
+    field.body_length = end - start;
+    field.leading_zeros = spec.precision > field.body_length ? spec.precision - field.body_length : 0;
+    field.zero_pad = spec.zero_pad && spec.precision < 0;
+    return print_field(sink, spec, field);
+}
+
+template<typename Sink>
+[[gnu::always_inline]] inline int print_signed_decimal(Sink& sink, const PrintfSpec& spec, int number)
+{
+    if (number < 0)
+        return print_decimal(sink, spec, 0 - (dword)number, true, true);
+    return print_decimal(sink, spec, (dword)number, false, true);
+}
+
+template<typename Sink>
+[[gnu::always_inline]] inline int print_signed_decimal(Sink& sink, const PrintfSpec& spec, long long number)
+{
+    if (number < 0)
+        return print_decimal(sink, spec, 0 - (qword)number, true, true);
+    return print_decimal(sink, spec, (qword)number, false, true);
+}
+
+// Unlike the C library's, our %x has always printed every nibble of its argument,
+// and plenty of addresses in logs are lined up on that. Keep it that way.
+template<typename Sink, typename T>
+[[gnu::always_inline]] inline int print_hex(Sink& sink, const PrintfSpec& spec, T number, int fields, bool upper_case, bool with_prefix)
+{
+    const char* table = upper_case ? printf_upper_hex_digits : printf_hex_digits;
+    char buffer[16];
+    for (int i = fields - 1; i >= 0; --i) {
+        buffer[i] = table[number & 0x0f];
+        number >>= 4;
     }
-    if (leftPad) {
-        for (unsigned i = 0; i < fieldWidth - numlen; ++i) {
-            putch(bufptr, ' ');
-        }
+    PrintfField field;
+    field.prefix = upper_case ? "0X" : "0x";
+    field.prefix_length = with_prefix ? 2 : 0;
+    field.body = buffer;
+    field.body_length = fields;
+    field.zero_pad = spec.zero_pad;
+    return print_field(sink, spec, field);
+}
+
+template<typename Sink>
+[[gnu::always_inline]] inline int print_octal_number(Sink& sink, const PrintfSpec& spec, dword number)
+{
+    char buffer[12];
+    char* end = buffer + sizeof(buffer);
+    char* start = end;
+    // Like decimal, an explicit precision of zero prints nothing at all for zero.
+    if (number || spec.precision) {
+        do {
+            *--start = '0' + (number & 7);
+            number >>= 3;
+        } while (number);
     }
+    PrintfField field;
+    field.body = start;
+    field.body_length = end - start;
+    field.leading_zeros = spec.precision > field.body_length ? spec.precision - field.body_length : 0;
+    // The alternate form only has to make the result start with a zero.
+    bool starts_with_zero = field.leading_zeros || (field.body_length && *start == '0');
+    field.prefix = "0";
+    field.prefix_length = spec.alternate_form && !starts_with_zero ? 1 : 0;
+    field.zero_pad = spec.zero_pad && spec.precision < 0;
+    return print_field(sink, spec, field);
+}
 
-    return fieldWidth;
+template<typename Sink>
+[[gnu::always_inline]] inline int print_string(Sink& sink, const PrintfSpec& spec, const char* str)
+{
+    int length = 0;
+    if (spec.precision < 0)
+        length = strlen(str);
+    else
+        while (length < spec.precision && str[length])
+            ++length;
+    PrintfField field;
+    field.body = str;
+    field.body_length = length;
+    return print_field(sink, spec, field);
 }
 
-template<typename PutChFunc>
-[[gnu::always_inline]] inline int print_qword(PutChFunc putch, char*& bufptr, qword number, bool leftPad, bool zeroPad, dword fieldWidth)
+#ifndef KERNEL
+
+// The exact decimal expansion of a finite double's magnitude. The integer part is converted
+// up front, and the fraction is kept as a fixed-point number (binary point above the top word)
+// and multiplied out one digit at a time, so every digit and every rounding decision is exact.
+struct PrintfFloatDigits {
+    static const int max_integer_digits = 309;
+    static const int max_words = 35;
+
+    // The integer part's digits, without leading zeros (so none at all if it's zero.)
+    char integer_digits[max_integer_digits + 1];
+    int integer_length { 0 };
+
+    dword fraction[max_words];
+    int fraction_words { 0 };
+    int fraction_low { 0 };
+
+    // The value is mantissa * 2^exponent.
+    PrintfFloatDigits(qword mantissa, int exponent);
+
+    void set_integer_part(qword mantissa, int shift);
+    int next_fraction_digit();
+    bool fraction_is_zero() const { return fraction_low >= fraction_words; }
+};
+
+inline PrintfFloatDigits::PrintfFloatDigits(qword mantissa, int exponent)
 {
-    qword divisor = 10000000000000000000LLU;
-    char ch;
-    char padding = 1;
-    char buf[16];
-    char* p = buf;
-
-    for (;;) {
-        ch = '0' + (number / divisor);
-        number %= divisor;
-        if (ch != '0')
-            padding = 0;
-        if (!padding || divisor == 1)
-            *(p++) = ch;
-        if (divisor == 1)
-            break;
-        divisor /= 10;
+    if (exponent >= 0) {
+        set_integer_part(mantissa, exponent);
+        return;
     }
-
-    size_t numlen = p - buf;
-    if (!fieldWidth || fieldWidth < numlen)
-        fieldWidth = numlen;
-    if (!leftPad) {
-        for (unsigned i = 0; i < fieldWidth - numlen; ++i) {
-            putch(bufptr, zeroPad ? '0' : ' ');
-        }
+    int fraction_bits = -exponent;
+    if (fraction_bits < 64) {
+        set_integer_part(mantissa >> fraction_bits, 0);
+        mantissa &= (1llu << fraction_bits) - 1;
     }
-    for (unsigned i = 0; i < numlen; ++i) {
-        putch(bufptr, buf[i]);
+    fraction_words = (fraction_bits + 31) / 32;
+    for (int i = 0; i < fraction_words; ++i)
+        fraction[i] = 0;
+    // Line the fraction's lowest bit up with its place below the binary point.
+    int shift = fraction_words * 32 - fraction_bits;
+    qword low = (mantissa & 0xffffffff) << shift;
+    qword high = ((mantissa >> 32) << shift) + (low >> 32);
+    fraction[0] = (dword)low;
+    if (fraction_words > 1)
+        fraction[1] = (dword)high;
+    if (fraction_words > 2)
+        fraction[2] = (dword)(high >> 32);
+    while (fraction_low < fraction_words && !fraction[fraction_low])
+        ++fraction_low;
+}
+
+inline void PrintfFloatDigits::set_integer_part(qword mantissa, int shift)
+{
+    char buffer[20];
+    char* end = buffer + sizeof(buffer);
+    // The mantissa has at most 53 bits, so small shifts still fit in a qword.
+    if (shift <= 11) {
+        qword value = mantissa << shift;
+        if (!value)
+            return;
+        char* start = format_decimal(end, value);
+        integer_length = end - start;
+        __builtin_memcpy(integer_digits, start, integer_length);
+        return;
     }
-    if (leftPad) {
-        for (unsigned i = 0; i < fieldWidth - numlen; ++i) {
-            putch(bufptr, ' ');
+
+    // Otherwise, divide a multi-word number down nine digits at a time.
+    dword words[max_words];
+    for (int i = 0; i < max_words; ++i)
+        words[i] = 0;
+    int low_word = shift / 32;
+    qword low = (mantissa & 0xffffffff) << (shift % 32);
+    qword high = ((mantissa >> 32) << (shift % 32)) + (low >> 32);
+    words[low_word] = (dword)low;
+    words[low_word + 1] = (dword)high;
+    words[low_word + 2] = (dword)(high >> 32);
+
+    dword chunks[max_words + 5];
+    int chunk_count = 0;
+    int top = low_word + 2;
+    while (top >= 0 && !words[top])
+        --top;
+    while (top >= 0) {
+        qword remainder = 0;
+        for (int i = top; i >= 0; --i) {
+            qword current = (remainder << 32) | words[i];
+            words[i] = (dword)(current / 1000000000);
+            remainder = current % 1000000000;
         }
+        chunks[chunk_count++] = (dword)remainder;
+        while (top >= 0 && !words[top])
+            --top;
     }
 
-    return fieldWidth;
+    // The most significant chunk goes out as it is, the others zero-padded to nine digits.
+    char* out = integer_digits;
+    for (int i = chunk_count - 1; i >= 0; --i) {
+        char* start = format_decimal(end, chunks[i]);
+        if (i != chunk_count - 1) {
+            while (start > end - 9)
+                *--start = '0';
+        }
+        __builtin_memcpy(out, start, end - start);
+        out += end - start;
+    }
+    integer_length = out - integer_digits;
 }
 
-template<typename PutChFunc>
-[[gnu::always_inline]] inline int print_octal_number(PutChFunc putch, char*& bufptr, dword number, bool leftPad, bool zeroPad, dword fieldWidth)
+inline int PrintfFloatDigits::next_fraction_digit()
 {
-    dword divisor = 134217728;
-    char ch;
-    char padding = 1;
-    char buf[32];
-    char* p = buf;
-
-    for (;;) {
-        ch = '0' + (number / divisor);
-        number %= divisor;
-        if (ch != '0')
-            padding = 0;
-        if (!padding || divisor == 1)
-            *(p++) = ch;
-        if (divisor == 1)
-            break;
-        divisor /= 8;
+    // Zero words at the bottom stay zero, so skip them.
+    qword carry = 0;
+    for (int i = fraction_low; i < fraction_words; ++i) {
+        qword product = (qword)fraction[i] * 10 + carry;
+        fraction[i] = (dword)product;
+        carry = product >> 32;
     }
+    while (fraction_low < fraction_words && !fraction[fraction_low])
+        ++fraction_low;
+    return (int)carry;
+}
 
-    size_t numlen = p - buf;
-    if (!fieldWidth || fieldWidth < numlen)
-        fieldWidth = numlen;
-    if (!leftPad) {
-        for (unsigned i = 0; i < fieldWidth - numlen; ++i) {
-            putch(bufptr, zeroPad ? '0' : ' ');
+// Round half to even, on the exact value.
+inline bool printf_should_round_up(int next_digit, bool rest_is_zero, char last_digit)
+{
+    if (next_digit != 5)
+        return next_digit > 5;
+    if (!rest_is_zero)
+        return true;
+    return (last_digit - '0') & 1;
+}
+
+// Adds one in the last place of the digits in [start, end), skipping over a decimal point.
+// Returns true if that carried out of the first digit.
+inline bool printf_round_up(char* start, char* end)
+{
+    for (char* p = end; p > start;) {
+        --p;
+        if (*p == '.')
+            continue;
+        if (*p != '9') {
+            ++*p;
+            return false;
         }
+        *p = '0';
     }
-    for (unsigned i = 0; i < numlen; ++i) {
-        putch(bufptr, buf[i]);
-    }
-    if (leftPad) {
-        for (unsigned i = 0; i < fieldWidth - numlen; ++i) {
-            putch(bufptr, ' ');
+    return true;
+}
+
+// No double has more than this many significant digits (or 1074 fractional ones),
+// so anything past it is zeros that don't need computing.
+static const int printf_max_float_digits = 1100;
+
+// Puts the first count significant digits of the value, rounded, in out.
+// Returns the decimal exponent of the first one.
+inline int printf_significant_digits(PrintfFloatDigits& digits, int count, char* out)
+{
+    int exponent;
+    int produced = 0;
+    int next_digit;
+    bool rest_is_zero;
+    if (digits.integer_length) {
+        exponent = digits.integer_length - 1;
+        int from_integer = count < digits.integer_length ? count : digits.integer_length;
+        __builtin_memcpy(out, digits.integer_digits, from_integer);
+        produced = from_integer;
+        while (produced < count)
+            out[produced++] = '0' + digits.next_fraction_digit();
+        if (count < digits.integer_length) {
+            next_digit = digits.integer_digits[count] - '0';
+            rest_is_zero = digits.fraction_is_zero();
+            for (int i = count + 1; i < digits.integer_length && rest_is_zero; ++i)
+                rest_is_zero = digits.integer_digits[i] == '0';
+        } else {
+            next_digit = digits.next_fraction_digit();
+            rest_is_zero = digits.fraction_is_zero();
         }
+    } else if (digits.fraction_is_zero()) {
+        for (int i = 0; i < count; ++i)
+            out[i] = '0';
+        return 0;
+    } else {
+        exponent = -1;
+        int digit;
+        while (!(digit = digits.next_fraction_digit()))
+            --exponent;
+        out[produced++] = '0' + digit;
+        while (produced < count)
+            out[produced++] = '0' + digits.next_fraction_digit();
+        next_digit = digits.next_fraction_digit();
+        rest_is_zero = digits.fraction_is_zero();
     }
 
-    return fieldWidth;
+    if (printf_should_round_up(next_digit, rest_is_zero, out[count - 1]) && printf_round_up(out, out + count)) {
+        // 9.99... became 10.0...: the digits are all zeros now.
+        out[0] = '1';
+        ++exponent;
+    }
+    return exponent;
 }
 
-template<typename PutChFunc>
-[[gnu::always_inline]] inline int print_string(PutChFunc putch, char*& bufptr, const char* str, bool leftPad, dword fieldWidth)
+// A formatted floating-point number, minus its sign: body, then zeros, then the exponent.
+struct PrintfFloatText {
+    char buffer[PrintfFloatDigits::max_integer_digits + printf_max_float_digits + 8];
+    const char* body { nullptr };
+    int body_length { 0 };
+    int trailing_zeros { 0 };
+    char suffix[8];
+    int suffix_length { 0 };
+};
+
+inline void printf_format_exponent(PrintfFloatText& text, int exponent, bool upper_case)
 {
-    size_t len = strlen(str);
-    if (!fieldWidth || fieldWidth < len)
-        fieldWidth = len;
-    if (!leftPad) {
-        for (unsigned i = 0; i < fieldWidth - len; ++i)
-            putch(bufptr, ' ');
-    }
-    for (unsigned i = 0; i < len; ++i) {
-        putch(bufptr, str[i]);
-    }
-    if (leftPad) {
-        for (unsigned i = 0; i < fieldWidth - len; ++i)
-            putch(bufptr, ' ');
+    text.suffix[0] = upper_case ? 'E' : 'e';
+    text.suffix[1] = exponent < 0 ? '-' : '+';
+    dword magnitude = exponent < 0 ? -exponent : exponent;
+    char* end = text.suffix + sizeof(text.suffix);
+    char* start = format_decimal(end, magnitude);
+    if (end - start < 2)
+        *--start = '0';
+    __builtin_memmove(text.suffix + 2, start, end - start);
+    text.suffix_length = 2 + (end - start);
+}
+
+// %f: precision digits after the point.
+inline void printf_format_fixed(PrintfFloatText& text, PrintfFloatDigits& digits, int precision, bool alternate_form)
+{
+    int computed_precision = precision < printf_max_float_digits ? precision : printf_max_float_digits;
+    text.trailing_zeros = precision - computed_precision;
+
+    // Leave room in front for a carry.
+    char* start = text.buffer + 1;
+    char* out = start;
+    if (digits.integer_length) {
+        __builtin_memcpy(out, digits.integer_digits, digits.integer_length);
+        out += digits.integer_length;
+    } else {
+        *out++ = '0';
     }
-    return fieldWidth;
+    if (precision || alternate_form)
+        *out++ = '.';
+    for (int i = 0; i < computed_precision; ++i)
+        *out++ = '0' + digits.next_fraction_digit();
+
+    int next_digit = digits.next_fraction_digit();
+    char last_digit = out[-1] == '.' ? out[-2] : out[-1];
+    if (printf_should_round_up(next_digit, digits.fraction_is_zero(), last_digit) && printf_round_up(start, out))
+        *--start = '1';
+
+    text.body = start;
+    text.body_length = out - start;
 }
 
+// %e: one digit, the point, precision digits and an exponent.
+inline void printf_format_exponential(PrintfFloatText& text, PrintfFloatDigits& digits, int precision, bool alternate_form, bool upper_case)
+{
+    int computed_precision = precision < printf_max_float_digits ? precision : printf_max_float_digits;
+    text.trailing_zeros = precision - computed_precision;
+
+    char* significant = text.buffer + 1;
+    int exponent = printf_significant_digits(digits, computed_precision + 1, significant);
+    text.buffer[0] = significant[0];
+    if (precision || alternate_form)
+        significant[0] = '.';
+    else
+        --computed_precision;
+    text.body = text.buffer;
+    text.body_length = computed_precision + 2;
+    printf_format_exponent(text, exponent, upper_case);
+}
 
-template<typename PutChFunc>
-[[gnu::always_inline]] inline int print_signed_number(PutChFunc putch, char*& bufptr, int number, bool leftPad, bool zeroPad, dword fieldWidth)
+// %g: precision significant digits, laid out like %f or %e depending on the exponent,
+// and with trailing zeros removed unless the alternate form was asked for.
+inline void printf_format_general(PrintfFloatText& text, PrintfFloatDigits& digits, int precision, bool alternate_form, bool upper_case)
 {
-    if (number < 0) {
-        putch(bufptr, '-');
-        return print_number(putch, bufptr, 0 - number, leftPad, zeroPad, fieldWidth) + 1;
+    if (!precision)
+        precision = 1;
+    if (precision > printf_max_float_digits)
+        precision = printf_max_float_digits;
+
+    char significant[printf_max_float_digits];
+    int exponent = printf_significant_digits(digits, precision, significant);
+
+    char* out = text.buffer;
+    if (exponent < -4 || exponent >= precision) {
+        *out++ = significant[0];
+        *out++ = '.';
+        __builtin_memcpy(out, significant + 1, precision - 1);
+        out += precision - 1;
+        printf_format_exponent(text, exponent, upper_case);
+    } else if (exponent >= 0) {
+        __builtin_memcpy(out, significant, exponent + 1);
+        out += exponent + 1;
+        *out++ = '.';
+        __builtin_memcpy(out, significant + exponent + 1, precision - exponent - 1);
+        out += precision - exponent - 1;
+    } else {
+        *out++ = '0';
+        *out++ = '.';
+        for (int i = 0; i < -exponent - 1; ++i)
+            *out++ = '0';
+        __builtin_memcpy(out, significant, precision);
+        out += precision;
     }
-    return print_number(putch, bufptr, number, leftPad, zeroPad, fieldWidth);
+
+    if (!alternate_form) {
+        while (out[-1] == '0')
+            --out;
+        if (out[-1] == '.')
+            --out;
+    }
+    text.body = text.buffer;
+    text.body_length = out - text.buffer;
 }
 
-template<typename PutChFunc>
-[[gnu::always_inline]] inline int printf_internal(PutChFunc putch, char* buffer, const char*& fmt, char*& ap)
+template<typename Sink>
+[[gnu::noinline]] int print_double(Sink& sink, const PrintfSpec& spec, double value, char conversion)
 {
-    const char *p;
+    qword bits;
+    __builtin_memcpy(&bits, &value, sizeof(bits));
+    bool is_negative = bits >> 63;
+    int biased_exponent = (bits >> 52) & 0x7ff;
+    qword mantissa = bits & ((1llu << 52) - 1);
+    bool upper_case = conversion == 'F' || conversion == 'E' || conversion == 'G';
+
+    char sign = is_negative ? '-' : '+';
+    PrintfField field;
+    field.prefix = &sign;
+    field.prefix_length = is_negative || spec.plus_sign ? 1 : 0;
+
+    if (biased_exponent == 0x7ff) {
+        field.body = mantissa ? (upper_case ? "NAN" : "nan") : (upper_case ? "INF" : "inf");
+        field.body_length = 3;
+        return print_field(sink, spec, field);
+    }
+
+    int exponent;
+    if (biased_exponent) {
+        mantissa |= 1llu << 52;
+        exponent = biased_exponent - 1075;
+    } else {
+        exponent = -1074;
+    }
+
+    PrintfFloatDigits digits(mantissa, exponent);
+    PrintfFloatText text;
+    int precision = spec.precision < 0 ? 6 : spec.precision;
+    switch (conversion) {
+    case 'f':
+    case 'F':
+        printf_format_fixed(text, digits, precision, spec.alternate_form);
+        break;
+    case 'e':
+    case 'E':
+        printf_format_exponential(text, digits, precision, spec.alternate_form, upper_case);
+        break;
+    default:
+        printf_format_general(text, digits, precision, spec.alternate_form, upper_case);
+        break;
+    }
 
+    field.body = text.body;
+    field.body_length = text.body_length;
+    field.trailing_zeros = text.trailing_zeros;
+    field.suffix = text.suffix;
+    field.suffix_length = text.suffix_length;
+    field.zero_pad = spec.zero_pad;
+    return print_field(sink, spec, field);
+}
+
+#endif
+
+template<typename Sink>
+[[gnu::always_inline]] inline int printf_internal(Sink& sink, const char*& fmt, char*& ap)
+{
     int ret = 0;
-    char* bufptr = buffer;
-
-    for (p = fmt; *p; ++p) {
-        bool leftPad = false;
-        bool zeroPad = false;
-        unsigned fieldWidth = 0;
-        unsigned long_qualifiers = 0;
-        bool alternate_form = 0;
-        if (*p == '%' && *(p + 1)) {
-one_more:
-            ++p;
-            if (*p == ' ') {
-                leftPad = true;
-                if (*(p + 1))
-                    goto one_more;
-            }
-            if (!zeroPad && !fieldWidth && *p == '0') {
-                zeroPad = true;
-                if (*(p + 1))
-                    goto one_more;
-            }
-            if (*p >= '0' && *p <= '9') {
-                fieldWidth *= 10;
-                fieldWidth += *p - '0';
-                if (*(p + 1))
-                    goto one_more;
-            }
-            if (*p == 'l') {
-                ++long_qualifiers;
-                if (*(p + 1))
-                    goto one_more;
+    const char* p = fmt;
+
+    while (*p) {
+        if (*p != '%' || !*(p + 1)) {
+            const char* run = p++;
+            while (*p && *p != '%')
+                ++p;
+            sink.append(run, p - run);
+            ret += p - run;
+            continue;
+        }
+        ++p;
+
+        PrintfSpec spec;
+        for (;; ++p) {
+            // A space has always meant "left-justify" here, and callers rely on it.
+            if (*p == '-' || *p == ' ')
+                spec.left_justify = true;
+            else if (*p == '0')
+                spec.zero_pad = true;
+            else if (*p == '+')
+                spec.plus_sign = true;
+            else if (*p == '#')
+                spec.alternate_form = true;
+            else
+                break;
+        }
+
+        if (*p == '*') {
+            spec.width = va_arg(ap, int);
+            if (spec.width < 0) {
+                spec.left_justify = true;
+                spec.width = -spec.width;
             }
-            if (*p == '#') {
-                alternate_form = true;
-                if (*(p + 1))
-                    goto one_more;
+            ++p;
+        } else {
+            while (*p >= '0' && *p <= '9')
+                spec.width = spec.width * 10 + (*p++ - '0');
+        }
+
+        if (*p == '.') {
+            ++p;
+            spec.precision = 0;
+            if (*p == '*') {
+                spec.precision = va_arg(ap, int);
+                ++p;
+            } else {
+                while (*p >= '0' && *p <= '9')
+                    spec.precision = spec.precision * 10 + (*p++ - '0');
             }
-            switch( *p )
-            {
-                case 's':
-                    {
-                        const char* sp = va_arg(ap, const char*);
-                        ret += print_string(putch, bufptr, sp ? sp : "(null)", leftPad, fieldWidth);
-                    }
-                    break;
-
-                case 'd':
-                    ret += print_signed_number(putch, bufptr, va_arg(ap, int), leftPad, zeroPad, fieldWidth);
-                    break;
-
-                case 'u':
-                    ret += print_number(putch, bufptr, va_arg(ap, dword), leftPad, zeroPad, fieldWidth);
-                    break;
-
-                case 'Q':
-                    ret += print_qword(putch, bufptr, va_arg(ap, qword), leftPad, zeroPad, fieldWidth);
-                    break;
-
-                case 'q':
-                    ret += print_hex(putch, bufptr, va_arg(ap, qword), 16);
-                    break;
+        }
+
+        bool is_long_double = false;
+        for (;; ++p) {
+            if (*p == 'l')
+                ++spec.long_qualifiers;
+            else if (*p == 'h')
+                ++spec.short_qualifiers;
+            else if (*p == 'L')
+                is_long_double = true;
+            else if (*p != 'z' && *p != 'j' && *p != 't')
+                break;
+        }
+        (void)is_long_double;
+
+        switch (*p) {
+        case 's': {
+            const char* sp = va_arg(ap, const char*);
+            ret += print_string(sink, spec, sp ? sp : "(null)");
+            break;
+        }
+
+        case 'd':
+        case 'i':
+            if (spec.long_qualifiers >= 2)
+                ret += print_signed_decimal(sink, spec, va_arg(ap, long long));
+            else
+                ret += print_signed_decimal(sink, spec, printf_narrow_signed(spec, va_arg(ap, int)));
+            break;
+
+        case 'u':
+            if (spec.long_qualifiers >= 2)
+                ret += print_decimal(sink, spec, va_arg(ap, qword), false, false);
+            else
+                ret += print_decimal(sink, spec, printf_narrow_unsigned(spec, va_arg(ap, dword)), false, false);
+            break;
+
+        case 'Q':
+            ret += print_decimal(sink, spec, va_arg(ap, qword), false, false);
+            break;
+
+        case 'q':
+            ret += print_hex(sink, spec, va_arg(ap, qword), 16, false, false);
+            break;
 
 #ifndef KERNEL
-                case 'f':
-                    // FIXME: Print as float!
-                    ret += print_number(putch, bufptr, (int)va_arg(ap, double), leftPad, zeroPad, fieldWidth);
-                    break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G': {
+            double value = is_long_double ? (double)va_arg(ap, long double) : va_arg(ap, double);
+            ret += print_double(sink, spec, value, *p);
+            break;
+        }
 #endif
 
-                case 'o':
-                    if (alternate_form) {
-                        putch(bufptr, '0');
-                        ++ret;
-                    }
-                    ret += print_octal_number(putch, bufptr, va_arg(ap, dword), leftPad, zeroPad, fieldWidth);
-                    break;
-
-                case 'x':
-                    if (alternate_form) {
-                        putch(bufptr, '0');
-                        putch(bufptr, 'x');
-                        ret += 2;
-                    }
-                    ret += print_hex(putch, bufptr, va_arg(ap, dword), 8);
-                    break;
-
-                case 'w':
-                    ret += print_hex(putch, bufptr, va_arg(ap, int), 4);
-                    break;
-
-                case 'b':
-                    ret += print_hex(putch, bufptr, va_arg(ap, int), 2);
-                    break;
-
-                case 'c':
-                    putch(bufptr, (char)va_arg(ap, int));
-                    ++ret;
-                    break;
-
-                case '%':
-                    putch(bufptr, '%');
-                    ++ret;
-                    break;
-
-                case 'p':
-                    putch(bufptr, '0');
-                    putch(bufptr, 'x');
-                    ret += 2;
-                    ret += print_hex(putch, bufptr, va_arg(ap, dword), 8);
-                    break;
-            }
+        case 'o':
+            ret += print_octal_number(sink, spec, printf_narrow_unsigned(spec, va_arg(ap, dword)));
+            break;
+
+        case 'x':
+        case 'X':
+            if (spec.long_qualifiers >= 2)
+                ret += print_hex(sink, spec, va_arg(ap, qword), 16, *p == 'X', spec.alternate_form);
+            else if (spec.short_qualifiers)
+                ret += print_hex(sink, spec, printf_narrow_unsigned(spec, va_arg(ap, dword)), spec.short_qualifiers >= 2 ? 2 : 4, *p == 'X', spec.alternate_form);
+            else
+                ret += print_hex(sink, spec, va_arg(ap, dword), 8, *p == 'X', spec.alternate_form);
+            break;
+
+        case 'w':
+            ret += print_hex(sink, spec, (dword)va_arg(ap, int), 4, false, false);
+            break;
+
+        case 'b':
+            ret += print_hex(sink, spec, (dword)va_arg(ap, int), 2, false, false);
+            break;
+
+        case 'c': {
+            char ch = (char)va_arg(ap, int);
+            PrintfField field;
+            field.body = &ch;
+            field.body_length = 1;
+            ret += print_field(sink, spec, field);
+            break;
         }
-        else {
-            putch(bufptr, *p);
+
+        case '%':
+            sink.append("%", 1);
             ++ret;
+            break;
+
+        case 'p':
+            ret += print_hex(sink, spec, va_arg(ap, dword), 8, false, true);
+            break;
         }
+
+        if (!*p)
+            break;
+        ++p;
     }
     return ret;
 }
-
-
@@ -806,18 +806,27 @@ void Terminal::paint_event(GPaintEvent& event)
         if (has_only_one_background_color) {
             painter.fill_rect(row_rect(row), lookup_color(line.attributes[0].background_color).with_alpha(255 * m_opacity));
         }
+        auto should_reverse_fill_for_cursor = [&] (word column) {
+            return m_cursor_blink_state && m_in_active_window && row == m_cursor_row && column == m_cursor_column;
+        };
+        auto text_color_index = [&] (word column) {
+            auto& attribute = line.attributes[column];
+            return should_reverse_fill_for_cursor(column) ? attribute.background_color : attribute.foreground_color;
+        };
         for (word column = 0; column < m_columns; ++column) {
-            bool should_reverse_fill_for_cursor = m_cursor_blink_state && m_in_active_window && row == m_cursor_row && column == m_cursor_column;
             auto& attribute = line.attributes[column];
-            char ch = line.characters[column];
-            auto character_rect = glyph_rect(row, column);
-            if (!has_only_one_background_color || should_reverse_fill_for_cursor) {
-                auto cell_rect = character_rect.inflated(0, m_line_spacing);
-                painter.fill_rect(cell_rect, lookup_color(should_reverse_fill_for_cursor ? attribute.foreground_color : attribute.background_color).with_alpha(255 * m_opacity));
+            if (!has_only_one_background_color || should_reverse_fill_for_cursor(column)) {
+                auto cell_rect = glyph_rect(row, column).inflated(0, m_line_spacing);
+                painter.fill_rect(cell_rect, lookup_color(should_reverse_fill_for_cursor(column) ? attribute.foreground_color : attribute.background_color).with_alpha(255 * m_opacity));
             }
-            if (ch == ' ')
-                continue;
-            painter.draw_glyph(character_rect.location(), ch, lookup_color(should_reverse_fill_for_cursor ? attribute.background_color : attribute.foreground_color));
+        }
+        // The font is fixed-width, so each run of same-colored cells can be drawn in one go.
+        for (word column = 0; column < m_columns;) {
+            word run_start = column;
+            auto color_index = text_color_index(column);
+            while (column < m_columns && text_color_index(column) == color_index)
+                ++column;
+            painter.draw_text_run(glyph_rect(row, run_start).location(), (const char*)&line.characters[run_start], column - run_start, font(), lookup_color(color_index));
         }
     }
 
@@ -107,7 +107,9 @@ int BXVGADevice::ioctl(FileDescriptor&, unsigned request, unsigned arg)
 {
     switch (request) {
     case BXVGA_DEV_IOCTL_SET_Y_OFFSET:
-        if (arg > (unsigned)m_framebuffer_size.height() * 2)
+        // The virtual framebuffer is two screens tall, so the visible area can start
+        // anywhere from the top of the first screen to the top of the second.
+        if (arg > (unsigned)m_framebuffer_size.height())
             return -EINVAL;
         set_y_offset((int)arg);
         return 0;
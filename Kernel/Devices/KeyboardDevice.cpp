@@ -132,6 +132,7 @@ void KeyboardDevice::key_state_changed(byte raw, bool pressed)
     if (m_client)
         m_client->on_key_pressed(event);
     m_queue.enqueue(event);
+    did_change_readiness();
 }
 
 void KeyboardDevice::handle_irq()
@@ -1,5 +1,6 @@
 #include <Kernel/File.h>
 #include <Kernel/FileSystem/FileDescriptor.h>
+#include <Kernel/ReadinessQueue.h>
 
 File::File()
 {
@@ -24,6 +25,31 @@ int File::ioctl(FileDescriptor&, unsigned, unsigned)
     return -ENOTTY;
 }
 
+void File::add_readiness_watch(ReadinessWatch& watch)
+{
+    InterruptDisabler disabler;
+    m_readiness_watches.append(&watch);
+}
+
+void File::remove_readiness_watch(ReadinessWatch& watch)
+{
+    InterruptDisabler disabler;
+    for (int i = 0; i < m_readiness_watches.size(); ++i) {
+        if (m_readiness_watches[i] == &watch) {
+            m_readiness_watches.remove(i);
+            return;
+        }
+    }
+}
+
+void File::notify_readiness_watches()
+{
+    // This may run in an IRQ handler, so the watch lists are only ever touched with interrupts disabled.
+    InterruptDisabler disabler;
+    for (auto* watch : m_readiness_watches)
+        watch->queue->watch_did_change(*watch);
+}
+
 KResultOr<Region*> File::mmap(Process&, LinearAddress, size_t, size_t)
 {
     return KResult(-ENODEV);
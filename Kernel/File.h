@@ -4,12 +4,14 @@
 #include <AK/Retainable.h>
 #include <AK/Retained.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <Kernel/KResult.h>
 #include <Kernel/LinearAddress.h>
 
 class FileDescriptor;
 class Process;
 class Region;
+struct ReadinessWatch;
 
 class File : public Retainable<File> {
 public:
@@ -40,7 +42,24 @@ public:
     virtual bool is_block_device() const { return false; }
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
+    virtual bool is_readiness_queue() const { return false; }
+
+    // Lets any ReadinessQueue watching this file know that it may have become
+    // readable or writable. Spurious calls are fine; the queue re-checks.
+    void did_change_readiness()
+    {
+        if (!m_readiness_watches.is_empty())
+            notify_readiness_watches();
+    }
+
+    void add_readiness_watch(ReadinessWatch&);
+    void remove_readiness_watch(ReadinessWatch&);
 
 protected:
     File();
+
+private:
+    void notify_readiness_watches();
+
+    Vector<ReadinessWatch*> m_readiness_watches;
 };
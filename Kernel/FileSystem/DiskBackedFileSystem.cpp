@@ -55,9 +55,14 @@ DiskBackedFS::~DiskBackedFS()
 }
 
 bool DiskBackedFS::write_block(unsigned index, const ByteBuffer& data)
+{
+    return write_block_shared(index, data.isolated_copy());
+}
+
+bool DiskBackedFS::write_block_shared(unsigned index, const ByteBuffer& data)
 {
 #ifdef DBFS_DEBUG
-    kprintf("DiskBackedFileSystem::write_block %u, size=%u\n", index, data.size());
+    kprintf("DiskBackedFileSystem::write_block_shared %u, size=%u\n", index, data.size());
 #endif
     ASSERT(data.size() == block_size());
 
@@ -68,7 +73,7 @@ bool DiskBackedFS::write_block(unsigned index, const ByteBuffer& data)
     }
 
     LOCKER(m_lock);
-    m_write_cache.set(index, data.isolated_copy());
+    m_write_cache.set(index, data);
 
     if (m_write_cache.size() >= 32)
         flush_writes();
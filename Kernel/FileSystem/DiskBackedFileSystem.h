@@ -23,6 +23,9 @@ protected:
     ByteBuffer read_blocks(unsigned index, unsigned count) const;
 
     bool write_block(unsigned index, const ByteBuffer&);
+    // Like write_block(), but the caches keep a reference to the buffer instead of a copy,
+    // so nobody may modify it afterwards. Blocks handed out by read_block() are shared the same way.
+    bool write_block_shared(unsigned index, const ByteBuffer&);
     bool write_blocks(unsigned index, unsigned count, const ByteBuffer&);
 
 private:
@@ -460,7 +460,7 @@ RetainPtr<Inode> Ext2FS::get_inode(InodeIdentifier inode) const
     return new_inode;
 }
 
-ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, byte* buffer, FileDescriptor*) const
+ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, byte* buffer, FileDescriptor* descriptor) const
 {
     Locker inode_locker(m_lock);
     ASSERT(offset >= 0);
@@ -475,6 +475,29 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, byte* buffer, FileD
         return nread;
     }
 
+    Vector<InodeSlice> slices;
+    ssize_t nread = read_slices(offset, count, slices, descriptor);
+    if (nread <= 0)
+        return nread;
+
+    byte* out = buffer;
+    for (auto& slice : slices) {
+        memcpy(out, slice.buffer.pointer() + slice.offset, slice.length);
+        out += slice.length;
+    }
+    return nread;
+}
+
+ssize_t Ext2FSInode::read_slices(off_t offset, ssize_t count, Vector<InodeSlice>& slices, FileDescriptor* descriptor) const
+{
+    Locker inode_locker(m_lock);
+    ASSERT(offset >= 0);
+    if (offset >= (off_t)size())
+        return 0;
+
+    if (is_symlink() && size() < max_inline_symlink_length)
+        return Inode::read_slices(offset, count, slices, descriptor);
+
     Locker fs_locker(fs().m_lock);
 
     if (m_block_list.is_empty()) {
@@ -484,7 +507,7 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, byte* buffer, FileD
     }
 
     if (m_block_list.is_empty()) {
-        kprintf("ext2fs: read_bytes: empty block list for inode %u\n", index());
+        kprintf("ext2fs: read_slices: empty block list for inode %u\n", index());
         return -EIO;
     }
 
@@ -499,26 +522,23 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, byte* buffer, FileD
 
     ssize_t nread = 0;
     int remaining_count = min((off_t)count, (off_t)size() - offset);
-    byte* out = buffer;
 
 #ifdef EXT2_DEBUG
-    kprintf("Ext2FS: Reading up to %u bytes %d bytes into inode %u:%u to %p\n", count, offset, identifier().fsid(), identifier().index(), buffer);
-    //kprintf("ok let's do it, read(%u, %u) -> blocks %u thru %u, oifb: %u\n", offset, count, first_block_logical_index, last_block_logical_index, offset_into_first_block);
+    kprintf("Ext2FS: Slicing up to %u bytes %d bytes into inode %u:%u\n", count, offset, identifier().fsid(), identifier().index());
 #endif
 
     for (int bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; ++bi) {
         auto block = fs().read_block(m_block_list[bi]);
         if (!block) {
-            kprintf("ext2fs: read_bytes: read_block(%u) failed (lbi: %u)\n", m_block_list[bi], bi);
+            kprintf("ext2fs: read_slices: read_block(%u) failed (lbi: %u)\n", m_block_list[bi], bi);
             return -EIO;
         }
 
         int offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
-        int num_bytes_to_copy = min(block_size - offset_into_block, remaining_count);
-        memcpy(out, block.pointer() + offset_into_block, num_bytes_to_copy);
-        remaining_count -= num_bytes_to_copy;
-        nread += num_bytes_to_copy;
-        out += num_bytes_to_copy;
+        int num_bytes_in_slice = min(block_size - offset_into_block, remaining_count);
+        slices.append({ move(block), offset_into_block, num_bytes_in_slice });
+        remaining_count -= num_bytes_in_slice;
+        nread += num_bytes_in_slice;
     }
 
     return nread;
@@ -611,11 +631,11 @@ ssize_t Ext2FSInode::write_bytes(off_t offset, ssize_t count, const byte* data,
     dbgprintf("Ext2FSInode::write_bytes: Writing %u bytes %d bytes into inode %u:%u from %p\n", count, offset, fsid(), index(), data);
 #endif
 
-    auto buffer_block = ByteBuffer::create_uninitialized(block_size);
     for (int bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; ++bi) {
         int offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         int num_bytes_to_copy = min(block_size - offset_into_block, remaining_count);
 
+        // Cached blocks may be shared (see read_slices()), so never modify one in place.
         ByteBuffer block;
         if (offset_into_block != 0 || num_bytes_to_copy != block_size) {
             block = fs().read_block(m_block_list[bi]);
@@ -623,8 +643,9 @@ ssize_t Ext2FSInode::write_bytes(off_t offset, ssize_t count, const byte* data,
                 kprintf("Ext2FSInode::write_bytes: read_block(%u) failed (lbi: %u)\n", m_block_list[bi], bi);
                 return -EIO;
             }
+            block = block.isolated_copy();
         } else
-            block = buffer_block;
+            block = ByteBuffer::create_uninitialized(block_size);
 
         memcpy(block.pointer() + offset_into_block, in, num_bytes_to_copy);
         if (bi == last_logical_block_index_in_file && num_bytes_to_copy < block_size) {
@@ -638,7 +659,7 @@ ssize_t Ext2FSInode::write_bytes(off_t offset, ssize_t count, const byte* data,
 #ifdef EXT2_DEBUG
         dbgprintf("Ext2FSInode::write_bytes: writing block %u (offset_into_block: %u)\n", m_block_list[bi], offset_into_block);
 #endif
-        bool success = fs().write_block(m_block_list[bi], block);
+        bool success = fs().write_block_shared(m_block_list[bi], block);
         if (!success) {
             kprintf("Ext2FSInode::write_bytes: write_block(%u) failed (lbi: %u)\n", m_block_list[bi], bi);
             ASSERT_NOT_REACHED();
@@ -659,6 +680,51 @@ ssize_t Ext2FSInode::write_bytes(off_t offset, ssize_t count, const byte* data,
     return nwritten;
 }
 
+int Ext2FSInode::shareable_block_size() const
+{
+    if (is_symlink())
+        return 0;
+    return fs().block_size();
+}
+
+ssize_t Ext2FSInode::write_shared_blocks(off_t offset, const Vector<ByteBuffer>& blocks)
+{
+    ASSERT(offset >= 0);
+    ASSERT(!is_symlink());
+
+    Locker inode_locker(m_lock);
+    Locker fs_locker(fs().m_lock);
+
+    const ssize_t block_size = fs().block_size();
+    ASSERT(!(offset % block_size));
+    ssize_t count = blocks.size() * block_size;
+    qword old_size = size();
+    qword new_size = max(static_cast<qword>(offset) + count, old_size);
+
+    if (!resize(new_size))
+        return -EIO;
+
+#ifdef EXT2_DEBUG
+    dbgprintf("Ext2FSInode::write_shared_blocks: Sharing %u blocks at offset %d into inode %u:%u\n", blocks.size(), offset, fsid(), index());
+#endif
+
+    int first_block_logical_index = offset / block_size;
+    for (int i = 0; i < blocks.size(); ++i) {
+        ASSERT(blocks[i].size() == block_size);
+        bool success = fs().write_block_shared(m_block_list[first_block_logical_index + i], blocks[i]);
+        if (!success) {
+            kprintf("Ext2FSInode::write_shared_blocks: write_block_shared(%u) failed (lbi: %u)\n", m_block_list[first_block_logical_index + i], first_block_logical_index + i);
+            return -EIO;
+        }
+    }
+
+    if (old_size != new_size)
+        inode_size_changed(old_size, new_size);
+    for (int i = 0; i < blocks.size(); ++i)
+        inode_contents_changed(offset + i * block_size, block_size, blocks[i].pointer());
+    return count;
+}
+
 bool Ext2FSInode::traverse_as_directory(Function<bool(const FS::DirectoryEntry&)> callback) const
 {
     LOCKER(m_lock);
@@ -25,6 +25,9 @@ public:
 private:
     // ^Inode
     virtual ssize_t read_bytes(off_t, ssize_t, byte* buffer, FileDescriptor*) const override;
+    virtual ssize_t read_slices(off_t, ssize_t, Vector<InodeSlice>&, FileDescriptor*) const override;
+    virtual int shareable_block_size() const override;
+    virtual ssize_t write_shared_blocks(off_t, const Vector<ByteBuffer>&) override;
     virtual InodeMetadata metadata() const override;
     virtual bool traverse_as_directory(Function<bool(const FS::DirectoryEntry&)>) const override;
     virtual InodeIdentifier lookup(const String& name) override;
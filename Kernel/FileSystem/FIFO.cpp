@@ -79,6 +79,8 @@ void FIFO::detach(Direction direction)
         ASSERT(m_writers);
         --m_writers;
     }
+    // The other side may now see EOF or EPIPE.
+    did_change_readiness();
 }
 
 bool FIFO::can_read(FileDescriptor&) const
@@ -12,6 +12,7 @@
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/SharedMemory.h>
+#include <Kernel/ReadinessQueue.h>
 
 Retained<FileDescriptor> FileDescriptor::create(RetainPtr<Inode>&& inode)
 {
@@ -36,6 +37,10 @@ FileDescriptor::FileDescriptor(RetainPtr<File>&& file, SocketRole role)
 
 FileDescriptor::~FileDescriptor()
 {
+    while (!m_readiness_watches.is_empty()) {
+        auto* watch = m_readiness_watches.last();
+        watch->queue->forget(*watch);
+    }
     if (is_socket())
         socket()->detach(*this);
     if (is_fifo())
@@ -87,16 +92,8 @@ bool addition_would_overflow(off_t a, off_t b)
     return (ua + b) > OFF_T_MAX;
 }
 
-KResult FileDescriptor::fstat(stat& buffer)
+static void fill_stat(const InodeMetadata& metadata, stat& buffer)
 {
-    ASSERT(!is_fifo());
-    if (!m_inode && !m_file)
-        return KResult(-EBADF);
-
-    auto metadata = this->metadata();
-    if (!metadata.is_valid())
-        return KResult(-EIO);
-
     buffer.st_rdev = encoded_device(metadata.major_device, metadata.minor_device);
     buffer.st_ino = metadata.inode.index();
     buffer.st_mode = metadata.mode;
@@ -110,6 +107,19 @@ KResult FileDescriptor::fstat(stat& buffer)
     buffer.st_atime = metadata.atime;
     buffer.st_mtime = metadata.mtime;
     buffer.st_ctime = metadata.ctime;
+}
+
+KResult FileDescriptor::fstat(stat& buffer)
+{
+    ASSERT(!is_fifo());
+    if (!m_inode && !m_file)
+        return KResult(-EBADF);
+
+    auto metadata = this->metadata();
+    if (!metadata.is_valid())
+        return KResult(-EIO);
+
+    fill_stat(metadata, buffer);
     return KSuccess;
 }
 
@@ -165,6 +175,9 @@ ssize_t FileDescriptor::read(byte* buffer, ssize_t count)
         int nread = m_file->read(*this, buffer, count);
         if (!m_file->is_seekable())
             m_current_offset += nread;
+        // Draining a pipe, socket or PTY makes room for whoever writes into it.
+        if (nread > 0)
+            m_file->did_change_readiness();
         return nread;
     }
     ASSERT(inode());
@@ -179,6 +192,8 @@ ssize_t FileDescriptor::write(const byte* data, ssize_t size)
         int nwritten = m_file->write(*this, data, size);
         if (m_file->is_seekable())
             m_current_offset += nwritten;
+        if (nwritten > 0)
+            m_file->did_change_readiness();
         return nwritten;
     }
     ASSERT(m_inode);
@@ -187,6 +202,27 @@ ssize_t FileDescriptor::write(const byte* data, ssize_t size)
     return nwritten;
 }
 
+ssize_t FileDescriptor::read_at(off_t offset, byte* buffer, ssize_t count)
+{
+    ASSERT(m_inode && !m_file);
+    return m_inode->read_bytes(offset, count, buffer, this);
+}
+
+ssize_t FileDescriptor::write_at(off_t offset, const byte* data, ssize_t size)
+{
+    ASSERT(m_inode && !m_file);
+    return m_inode->write_bytes(offset, size, data, this);
+}
+
+ssize_t FileDescriptor::write_shared_blocks(const Vector<ByteBuffer>& blocks)
+{
+    ASSERT(m_inode && !m_file);
+    ssize_t nwritten = m_inode->write_shared_blocks(m_current_offset, blocks);
+    if (nwritten > 0)
+        m_current_offset += nwritten;
+    return nwritten;
+}
+
 bool FileDescriptor::can_write()
 {
     if (m_file)
@@ -253,6 +289,54 @@ ssize_t FileDescriptor::get_dir_entries(byte* buffer, ssize_t size)
     return stream.offset();
 }
 
+// Like get_dir_entries(), but each entry is preceded by what lstat() would say about it,
+// which saves ls -l and friends a path lookup and a syscall per entry.
+ssize_t FileDescriptor::get_dir_entries_with_stat(byte* buffer, ssize_t size)
+{
+    auto metadata = this->metadata();
+    if (!metadata.is_valid())
+        return -EIO;
+    if (!metadata.is_directory())
+        return -ENOTDIR;
+
+    static const ssize_t header_size = sizeof(stat) + sizeof(dword) + sizeof(byte) + sizeof(dword);
+    ssize_t needed_size = 0;
+    m_inode->traverse_as_directory([&needed_size] (auto& entry) {
+        needed_size += header_size + entry.name_length;
+        return true;
+    });
+    if (size < needed_size)
+        return -ERANGE;
+
+    ssize_t offset = 0;
+    auto& vfs = VFS::the();
+    m_inode->traverse_as_directory([&] (auto& entry) {
+        // The directory may have grown since we measured it.
+        if (offset + header_size + entry.name_length > size)
+            return false;
+        // Resolve mount points and ".." exactly like path lookup, so this agrees with lstat().
+        auto resolved_id = vfs.resolve_mounts(m_inode->identifier(), StringView(entry.name, entry.name_length), entry.inode);
+        stat entry_stat;
+        memset(&entry_stat, 0, sizeof(entry_stat));
+        entry_stat.st_ino = resolved_id.index();
+        if (auto inode = vfs.get_inode(resolved_id))
+            fill_stat(inode->metadata(), entry_stat);
+        memcpy(buffer + offset, &entry_stat, sizeof(entry_stat));
+        offset += sizeof(entry_stat);
+        dword index = resolved_id.index();
+        memcpy(buffer + offset, &index, sizeof(index));
+        offset += sizeof(index);
+        buffer[offset++] = entry.file_type;
+        dword name_length = entry.name_length;
+        memcpy(buffer + offset, &name_length, sizeof(name_length));
+        offset += sizeof(name_length);
+        memcpy(buffer + offset, entry.name, entry.name_length);
+        offset += entry.name_length;
+        return true;
+    });
+    return offset;
+}
+
 bool FileDescriptor::is_device() const
 {
     return m_file && m_file->is_device();
@@ -301,6 +385,23 @@ int FileDescriptor::close()
     return 0;
 }
 
+void FileDescriptor::add_readiness_watch(ReadinessWatch& watch)
+{
+    InterruptDisabler disabler;
+    m_readiness_watches.append(&watch);
+}
+
+void FileDescriptor::remove_readiness_watch(ReadinessWatch& watch)
+{
+    InterruptDisabler disabler;
+    for (int i = 0; i < m_readiness_watches.size(); ++i) {
+        if (m_readiness_watches[i] == &watch) {
+            m_readiness_watches.remove(i);
+            return;
+        }
+    }
+}
+
 bool FileDescriptor::is_fsfile() const
 {
     return !is_tty() && !is_fifo() && !is_device() && !is_socket() && !is_shared_memory();
@@ -18,6 +18,7 @@ class Process;
 class Region;
 class CharacterDevice;
 class SharedMemory;
+struct ReadinessWatch;
 
 class FileDescriptor : public Retainable<FileDescriptor> {
 public:
@@ -30,16 +31,24 @@ public:
     int close();
 
     off_t seek(off_t, int whence);
+    off_t offset() const { return m_current_offset; }
     ssize_t read(byte*, ssize_t);
     ssize_t write(const byte* data, ssize_t);
     KResult fstat(stat&);
 
+    // For inode-backed descriptors: I/O at an explicit offset, leaving the current one alone.
+    ssize_t read_at(off_t, byte*, ssize_t);
+    ssize_t write_at(off_t, const byte*, ssize_t);
+    // Stores whole blocks by reference at the current offset. See Inode::write_shared_blocks().
+    ssize_t write_shared_blocks(const Vector<ByteBuffer>&);
+
     KResult fchmod(mode_t);
 
     bool can_read();
     bool can_write();
 
     ssize_t get_dir_entries(byte* buffer, ssize_t);
+    ssize_t get_dir_entries_with_stat(byte* buffer, ssize_t);
 
     ByteBuffer read_entire_file();
 
@@ -99,6 +108,10 @@ public:
 
     KResult truncate(off_t);
 
+    // ReadinessQueues watching this descriptor; they're told when it goes away.
+    void add_readiness_watch(ReadinessWatch&);
+    void remove_readiness_watch(ReadinessWatch&);
+
 private:
     friend class VFS;
     FileDescriptor(RetainPtr<File>&&, SocketRole);
@@ -118,5 +131,7 @@ private:
     bool m_should_append { false };
     SocketRole m_socket_role { SocketRole::None };
     FIFO::Direction m_fifo_direction { FIFO::Direction::Neither };
+
+    Vector<ReadinessWatch*> m_readiness_watches;
 };
 
@@ -52,6 +52,17 @@ ByteBuffer Inode::read_entire(FileDescriptor* descriptor) const
     return builder.to_byte_buffer();
 }
 
+ssize_t Inode::read_slices(off_t offset, ssize_t count, Vector<InodeSlice>& slices, FileDescriptor* descriptor) const
+{
+    // Without a cache to share from, the best we can do is one freshly read slice.
+    auto buffer = ByteBuffer::create_uninitialized(count);
+    ssize_t nread = read_bytes(offset, count, buffer.pointer(), descriptor);
+    if (nread <= 0)
+        return nread;
+    slices.append({ move(buffer), 0, nread });
+    return nread;
+}
+
 unsigned Inode::fsid() const
 {
     return m_fs.fsid();
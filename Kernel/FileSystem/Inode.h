@@ -3,6 +3,7 @@
 #include <AK/Retainable.h>
 #include <AK/AKString.h>
 #include <AK/Function.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 #include <Kernel/FileSystem/InodeIdentifier.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
@@ -14,6 +15,13 @@ class FileDescriptor;
 class LocalSocket;
 class VMObject;
 
+// A run of an inode's contents, handed out by reference. See Inode::read_slices().
+struct InodeSlice {
+    ByteBuffer buffer;
+    int offset { 0 };
+    int length { 0 };
+};
+
 class Inode : public Retainable<Inode> {
     friend class VFS;
     friend class FS;
@@ -51,6 +59,17 @@ public:
     virtual KResult chown(uid_t, gid_t) = 0;
     virtual KResult truncate(off_t) { return KSuccess; }
 
+    // Hands out up to `count` bytes of contents from `offset` on by retaining the buffers
+    // they already live in (for a disk-backed FS, its block cache) instead of copying them.
+    // The buffers are shared, so they must be treated as read-only.
+    // Returns how many bytes the slices cover, or a negative error.
+    virtual ssize_t read_slices(off_t, ssize_t count, Vector<InodeSlice>&, FileDescriptor*) const;
+
+    // Inodes that can store whole blocks of contents by reference return the block size here.
+    virtual int shareable_block_size() const { return 0; }
+    // Stores the blocks (which the inode keeps a reference to) at a block-aligned offset.
+    virtual ssize_t write_shared_blocks(off_t, const Vector<ByteBuffer>&) { return -ENOTIMPL; }
+
     LocalSocket* socket() { return m_socket.ptr(); }
     const LocalSocket* socket() const { return m_socket.ptr(); }
     bool bind_socket(LocalSocket&);
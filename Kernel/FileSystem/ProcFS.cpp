@@ -9,6 +9,7 @@
 #include "Console.h"
 #include "Scheduler.h"
 #include <Kernel/PCI.h>
+#include <Kernel/Net/ARPCache.h>
 #include <Kernel/kmalloc.h>
 #include <AK/StringBuilder.h>
 #include <LibC/errno_numbers.h>
@@ -39,6 +40,7 @@ enum ProcFileType {
     FI_Root_dmesg,
     FI_Root_pci,
     FI_Root_uptime,
+    FI_Root_arp,
     FI_Root_self, // symlink
     FI_Root_sys, // directory
     __FI_Root_End,
@@ -256,6 +258,21 @@ ByteBuffer procfs$uptime(InodeIdentifier)
     return builder.to_byte_buffer();
 }
 
+ByteBuffer procfs$arp(InodeIdentifier)
+{
+    StringBuilder builder;
+    ARPCache::the().for_each_entry([&builder] (auto& ipv4_address, auto& mac_address, auto state, dword age, dword dropped_packets, const char* adapter_name) {
+        builder.appendf("%s,%s,%s,%u,%s,%u\n",
+            ipv4_address.to_string().characters(),
+            mac_address.to_string().characters(),
+            ARPCache::to_string(state),
+            age,
+            adapter_name,
+            dropped_packets);
+    });
+    return builder.to_byte_buffer();
+}
+
 ByteBuffer procfs$pid_vmo(InodeIdentifier identifier)
 {
     auto handle = ProcessInspectionHandle::from_pid(to_pid(identifier));
@@ -1158,6 +1175,7 @@ ProcFS::ProcFS()
     m_entries[FI_Root_self] = { "self", FI_Root_self, procfs$self };
     m_entries[FI_Root_pci] = { "pci", FI_Root_pci, procfs$pci };
     m_entries[FI_Root_uptime] = { "uptime", FI_Root_uptime, procfs$uptime };
+    m_entries[FI_Root_arp] = { "arp", FI_Root_arp, procfs$arp };
     m_entries[FI_Root_sys] = { "sys", FI_Root_sys };
 
     m_entries[FI_PID_vm] = { "vm", FI_PID_vm, procfs$pid_vm };
@@ -604,6 +604,28 @@ KResultOr<String> VFS::absolute_path(Inode& core_inode)
     return builder.to_string();
 }
 
+// Maps the inode that directory `dir_id` lists as `name` to the one path lookup lands on:
+// the root of anything mounted there, or for ".." at the root of a mount, the mount point's parent.
+InodeIdentifier VFS::resolve_mounts(InodeIdentifier dir_id, StringView name, InodeIdentifier child_id)
+{
+    if (auto mount = find_mount_for_host(child_id)) {
+#ifdef VFS_DEBUG
+        kprintf("  -- is host\n");
+#endif
+        child_id = mount->guest();
+    }
+    if (dir_id.is_root_inode() && child_id.is_root_inode() && !is_vfs_root(child_id) && name == "..") {
+#ifdef VFS_DEBUG
+        kprintf("  -- is guest\n");
+#endif
+        auto mount = find_mount_for_guest(child_id);
+        auto host_inode = get_inode(mount->host());
+        ASSERT(host_inode);
+        child_id = host_inode->lookup("..");
+    }
+    return child_id;
+}
+
 KResultOr<InodeIdentifier> VFS::resolve_path(StringView path, InodeIdentifier base, int options, InodeIdentifier* parent_id)
 {
     if (path.is_empty())
@@ -621,7 +643,6 @@ KResultOr<InodeIdentifier> VFS::resolve_path(StringView path, InodeIdentifier ba
         *parent_id = crumb_id;
 
     for (int i = 0; i < parts.size(); ++i) {
-        bool inode_was_root_at_head_of_loop = crumb_id.is_root_inode();
         auto& part = parts[i];
         if (part.is_empty())
             break;
@@ -652,21 +673,7 @@ KResultOr<InodeIdentifier> VFS::resolve_path(StringView path, InodeIdentifier ba
 #ifdef VFS_DEBUG
         kprintf("<%s> %u:%u\n", part.characters(), crumb_id.fsid(), crumb_id.index());
 #endif
-        if (auto mount = find_mount_for_host(crumb_id)) {
-#ifdef VFS_DEBUG
-            kprintf("  -- is host\n");
-#endif
-            crumb_id = mount->guest();
-        }
-        if (inode_was_root_at_head_of_loop && crumb_id.is_root_inode() && !is_vfs_root(crumb_id) && part == "..") {
-#ifdef VFS_DEBUG
-            kprintf("  -- is guest\n");
-#endif
-            auto mount = find_mount_for_guest(crumb_id);
-            auto dir_inode = get_inode(mount->host());
-            ASSERT(dir_inode);
-            crumb_id = dir_inode->lookup("..");
-        }
+        crumb_id = resolve_mounts(parent, part, crumb_id);
         crumb_inode = get_inode(crumb_id);
         ASSERT(crumb_inode);
         metadata = crumb_inode->metadata();
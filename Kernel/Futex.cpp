@@ -0,0 +1,125 @@
+#include <AK/HashMap.h>
+#include <AK/Vector.h>
+#include <Kernel/Futex.h>
+#include <Kernel/Process.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Thread.h>
+#include <Kernel/i8253.h>
+#include <LibC/errno_numbers.h>
+
+//#define FUTEX_DEBUG
+
+static HashMap<FutexKey, Vector<Thread*>>& futex_queues()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    static HashMap<FutexKey, Vector<Thread*>>* queues;
+    if (!queues)
+        queues = new HashMap<FutexKey, Vector<Thread*>>;
+    return *queues;
+}
+
+void Futex::dequeue(Thread& thread)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(thread.m_futex_queued);
+    auto it = futex_queues().find(thread.m_futex_key);
+    ASSERT(it != futex_queues().end());
+    auto& waiters = (*it).value;
+    for (int i = 0; i < waiters.size(); ++i) {
+        if (waiters[i] == &thread) {
+            waiters.remove(i);
+            break;
+        }
+    }
+    if (waiters.is_empty())
+        futex_queues().remove(it);
+    thread.m_futex_queued = false;
+}
+
+int Futex::wait(Thread& thread, const FutexKey& key, volatile int* word, int value, const timespec* timeout)
+{
+    ASSERT(&thread == current);
+    // Touch the word before disabling interrupts so it's paged in.
+    if (*word != value)
+        return -EAGAIN;
+
+    // Nothing else runs between the check and the block, in this process or
+    // any other sharing the memory, so a wake can't slip in and get lost.
+    InterruptDisabler disabler;
+    if (*word != value)
+        return -EAGAIN;
+    futex_queues().ensure(key).append(&thread);
+    thread.m_futex_key = key;
+    thread.m_futex_queued = true;
+    thread.m_futex_has_timeout = timeout != nullptr;
+    if (timeout)
+        thread.m_wakeup_time = g_uptime + timeout->tv_sec * TICKS_PER_SECOND + timeout->tv_nsec / (1000000000 / TICKS_PER_SECOND);
+#ifdef FUTEX_DEBUG
+    dbgprintf("Futex: %s(%u:%u) waiting on %p+%u\n", thread.process().name().characters(), thread.pid(), thread.tid(), key.vmo, key.offset);
+#endif
+    thread.block(Thread::BlockedFutex);
+
+    // Wakers take us off the queue, so if we're still on it we timed out or got a signal.
+    if (!thread.m_futex_queued)
+        return 0;
+    dequeue(thread);
+    if (thread.was_interrupted_while_blocked())
+        return -EINTR;
+    return -ETIMEDOUT;
+}
+
+int Futex::wake(const FutexKey& key, int count)
+{
+    InterruptDisabler disabler;
+    auto it = futex_queues().find(key);
+    if (it == futex_queues().end())
+        return 0;
+    auto& waiters = (*it).value;
+    int woken = 0;
+    while (woken < count && !waiters.is_empty()) {
+        auto* thread = waiters.take_first();
+        thread->m_futex_queued = false;
+        // It may have timed out already and just not run yet; it'll see a plain wakeup.
+        if (thread->state() == Thread::BlockedFutex)
+            thread->unblock();
+        ++woken;
+    }
+    if (waiters.is_empty())
+        futex_queues().remove(it);
+#ifdef FUTEX_DEBUG
+    dbgprintf("Futex: woke %d on %p+%u\n", woken, key.vmo, key.offset);
+#endif
+    return woken;
+}
+
+int Futex::requeue(const FutexKey& from, int wake_count, const FutexKey& to, int requeue_count)
+{
+    InterruptDisabler disabler;
+    int woken = wake(from, wake_count);
+    if (from == to || requeue_count <= 0 || !futex_queues().contains(from))
+        return woken;
+
+    // ensure() may rehash, so look the source up again afterwards.
+    futex_queues().ensure(to);
+    auto& source = (*futex_queues().find(from)).value;
+    auto& target = (*futex_queues().find(to)).value;
+    int moved = 0;
+    while (moved < requeue_count && !source.is_empty()) {
+        auto* thread = source.take_first();
+        thread->m_futex_key = to;
+        target.append(thread);
+        ++moved;
+    }
+    if (source.is_empty())
+        futex_queues().remove(from);
+    if (target.is_empty())
+        futex_queues().remove(to);
+    return woken + moved;
+}
+
+void Futex::remove_waiter(Thread& thread)
+{
+    InterruptDisabler disabler;
+    if (thread.m_futex_queued)
+        dequeue(thread);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <AK/Traits.h>
+#include <AK/Types.h>
+
+class Thread;
+class VMObject;
+struct timespec;
+
+// A futex is identified by the memory backing it rather than by its address,
+// so processes mapping the same VMObject (SharedBuffer, shm_open, MAP_SHARED)
+// meet in the same queue. Unlike a raw physical address, this stays put when
+// a private page gets copied on write.
+struct FutexKey {
+    const VMObject* vmo { nullptr };
+    dword offset { 0 };
+
+    bool is_null() const { return !vmo; }
+    bool operator==(const FutexKey& other) const { return vmo == other.vmo && offset == other.offset; }
+    bool operator!=(const FutexKey& other) const { return !(*this == other); }
+};
+
+namespace AK {
+
+template<>
+struct Traits<FutexKey> {
+    static unsigned hash(const FutexKey& key) { return pair_int_hash((dword)key.vmo, key.offset); }
+    static void dump(const FutexKey& key) { kprintf("[futex %p+%u]", key.vmo, key.offset); }
+};
+
+}
+
+class Futex {
+public:
+    static int wait(Thread&, const FutexKey&, volatile int* word, int value, const timespec* timeout);
+    static int wake(const FutexKey&, int count);
+    static int requeue(const FutexKey& from, int wake_count, const FutexKey& to, int requeue_count);
+
+    // Called when a thread dies while it's still queued.
+    static void remove_waiter(Thread&);
+
+private:
+    static void dequeue(Thread&);
+};
@@ -35,6 +35,11 @@ inline void out8(word port, byte value)
     asm volatile("outb %0, %1"::"a"(value), "Nd"(port));
 }
 
+inline void repeated_out8(word port, const byte* data, int data_size)
+{
+    asm volatile("rep outsb" : "+S"(data), "+c"(data_size) : "d"(port) : "memory");
+}
+
 inline void out16(word port, word value)
 {
     asm volatile("outw %0, %1"::"a"(value), "Nd"(port));
@@ -0,0 +1,259 @@
+#include <Kernel/Net/ARPCache.h>
+#include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/i8253.h>
+
+//#define ARP_DEBUG
+
+// Reachable entries are trusted for a minute, after which they're still used
+// but refreshed in the background. Entries nobody has confirmed for ten minutes
+// are forgotten. Unanswered requests are retried once a second (driven by tick()),
+// three times, after which the entry and the packets waiting on it are dropped.
+// Requests are always sent after letting go of the entry lock.
+static const qword reachable_time = 60 * TICKS_PER_SECOND;
+static const qword stale_time = 600 * TICKS_PER_SECOND;
+static const qword retransmit_time = 1 * TICKS_PER_SECOND;
+static const int max_requests = 3;
+static const int max_entries = 256;
+static const int max_pending_packets = 8;
+
+static const byte broadcast_mac[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+ARPCache& ARPCache::the()
+{
+    static ARPCache* the;
+    if (!the)
+        the = new ARPCache;
+    return *the;
+}
+
+const char* ARPCache::to_string(State state)
+{
+    switch (state) {
+    case State::Incomplete:
+        return "incomplete";
+    case State::Reachable:
+        return "reachable";
+    case State::Stale:
+        return "stale";
+    }
+    ASSERT_NOT_REACHED();
+}
+
+void ARPCache::send_request(NetworkAdapter& adapter, const IPv4Address& address)
+{
+#ifdef ARP_DEBUG
+    kprintf("ARPCache: Who has %s? Tell %s\n", address.to_string().characters(), adapter.ipv4_address().to_string().characters());
+#endif
+    ARPPacket request;
+    request.set_operation(ARPOperation::Request);
+    request.set_sender_hardware_address(adapter.mac_address());
+    request.set_sender_protocol_address(adapter.ipv4_address());
+    request.set_target_protocol_address(address);
+    adapter.send(MACAddress(broadcast_mac), request);
+}
+
+void ARPCache::send_gratuitous(NetworkAdapter& adapter)
+{
+    send_request(adapter, adapter.ipv4_address());
+}
+
+void ARPCache::expire_entries()
+{
+    auto now = g_uptime;
+    Vector<IPv4Address> dead_addresses;
+    for (auto& it : m_entries.resource()) {
+        auto& entry = *it.value;
+        switch (entry.state) {
+        case State::Incomplete:
+            if (entry.request_count >= max_requests && now - entry.requested_at >= retransmit_time) {
+#ifdef ARP_DEBUG
+                kprintf("ARPCache: No reply from %s, dropping %d packet(s)\n", it.key.to_string().characters(), entry.pending_packet_count);
+#endif
+                dead_addresses.append(it.key);
+            }
+            break;
+        case State::Reachable:
+            if (now - entry.updated_at >= reachable_time)
+                entry.state = State::Stale;
+            break;
+        case State::Stale:
+            if (now - entry.updated_at >= stale_time)
+                dead_addresses.append(it.key);
+            break;
+        }
+    }
+    for (auto& address : dead_addresses) {
+#ifdef ARP_DEBUG
+        kprintf("ARPCache: Expiring %s\n", address.to_string().characters());
+#endif
+        m_entries.resource().remove(address);
+    }
+}
+
+void ARPCache::make_room()
+{
+    if (m_entries.resource().size() < max_entries)
+        return;
+    // Evict the least recently confirmed resolved entry. Incomplete entries have
+    // packets waiting on them and expire on their own soon enough.
+    IPv4Address victim;
+    qword victim_updated_at = 0;
+    bool found = false;
+    for (auto& it : m_entries.resource()) {
+        if (it.value->state == State::Incomplete)
+            continue;
+        if (!found || it.value->updated_at < victim_updated_at) {
+            victim = it.key;
+            victim_updated_at = it.value->updated_at;
+            found = true;
+        }
+    }
+    if (found)
+        m_entries.resource().remove(victim);
+    else
+        m_entries.resource().remove_one_randomly();
+}
+
+void ARPCache::send_ipv4(NetworkAdapter& adapter, const IPv4Address& destination, IPv4Protocol protocol, ByteBuffer&& payload)
+{
+    if (destination == IPv4Address(255, 255, 255, 255)) {
+        adapter.send_ipv4(MACAddress(broadcast_mac), destination, protocol, move(payload));
+        return;
+    }
+
+    MACAddress mac_address;
+    bool resolved = false;
+    bool should_request = false;
+    {
+        LOCKER(m_entries.lock());
+        expire_entries();
+        auto now = g_uptime;
+        auto it = m_entries.resource().find(destination);
+        if (it == m_entries.resource().end()) {
+            make_room();
+            auto entry = make<Entry>();
+            entry->adapter = &adapter;
+            // Not confirmed yet, but /proc/arp should show the entry's age, not the uptime.
+            entry->updated_at = now;
+            entry->requested_at = now;
+            entry->request_count = 1;
+            entry->pending_packets.append({ protocol, move(payload) });
+            entry->pending_packet_count = 1;
+            m_entries.resource().set(destination, move(entry));
+            should_request = true;
+        } else {
+            auto& entry = *it->value;
+            switch (entry.state) {
+            case State::Incomplete:
+                // Only one request is outstanding per address; everyone else waits on it.
+                // tick() takes care of retransmitting it.
+                if (entry.pending_packet_count < max_pending_packets) {
+                    entry.pending_packets.append({ protocol, move(payload) });
+                    ++entry.pending_packet_count;
+                } else {
+                    ++entry.dropped_packet_count;
+#ifdef ARP_DEBUG
+                    kprintf("ARPCache: Too many packets waiting on %s, dropping one\n", destination.to_string().characters());
+#endif
+                }
+                break;
+            case State::Stale:
+                // Keep using the old address, but ask again so it can become reachable.
+                if (now - entry.requested_at >= retransmit_time) {
+                    entry.requested_at = now;
+                    should_request = true;
+                }
+                mac_address = entry.mac_address;
+                resolved = true;
+                break;
+            case State::Reachable:
+                mac_address = entry.mac_address;
+                resolved = true;
+                break;
+            }
+        }
+    }
+    if (should_request)
+        send_request(adapter, destination);
+    if (resolved)
+        adapter.send_ipv4(mac_address, destination, protocol, move(payload));
+}
+
+void ARPCache::tick()
+{
+    struct Request {
+        NetworkAdapter* adapter;
+        IPv4Address address;
+    };
+    Vector<Request> requests;
+    {
+        LOCKER(m_entries.lock());
+        expire_entries();
+        auto now = g_uptime;
+        for (auto& it : m_entries.resource()) {
+            auto& entry = *it.value;
+            if (entry.state != State::Incomplete || entry.request_count >= max_requests)
+                continue;
+            if (now - entry.requested_at < retransmit_time)
+                continue;
+            entry.requested_at = now;
+            ++entry.request_count;
+            requests.append({ entry.adapter, it.key });
+        }
+    }
+    for (auto& request : requests)
+        send_request(*request.adapter, request.address);
+}
+
+void ARPCache::did_receive(const ARPPacket& packet, NetworkAdapter* adapter)
+{
+    auto& sender_ipv4 = packet.sender_protocol_address();
+    auto& sender_mac = packet.sender_hardware_address();
+    if (sender_mac.is_zero() || sender_ipv4 == IPv4Address())
+        return;
+
+    SinglyLinkedList<PendingPacket> pending_packets;
+    NetworkAdapter* pending_adapter = nullptr;
+    {
+        LOCKER(m_entries.lock());
+        expire_entries();
+        if (!m_entries.resource().contains(sender_ipv4)) {
+            // Only learn about new hosts from packets that were meant for us.
+            if (!adapter)
+                return;
+            make_room();
+            auto new_entry = make<Entry>();
+            new_entry->adapter = adapter;
+            m_entries.resource().set(sender_ipv4, move(new_entry));
+        }
+        auto& entry = *m_entries.resource().ensure(sender_ipv4);
+        entry.mac_address = sender_mac;
+        entry.state = State::Reachable;
+        entry.updated_at = g_uptime;
+        entry.request_count = 0;
+        while (!entry.pending_packets.is_empty())
+            pending_packets.append(entry.pending_packets.take_first());
+        entry.pending_packet_count = 0;
+        pending_adapter = entry.adapter;
+#ifdef ARP_DEBUG
+        kprintf("ARPCache: %s is at %s\n", sender_ipv4.to_string().characters(), sender_mac.to_string().characters());
+#endif
+    }
+
+    while (!pending_packets.is_empty()) {
+        auto pending = pending_packets.take_first();
+        pending_adapter->send_ipv4(sender_mac, sender_ipv4, pending.protocol, move(pending.payload));
+    }
+}
+
+void ARPCache::for_each_entry(Function<void(const IPv4Address&, const MACAddress&, State, dword, dword, const char*)> callback)
+{
+    LOCKER(m_entries.lock());
+    expire_entries();
+    auto now = g_uptime;
+    for (auto& it : m_entries.resource()) {
+        auto& entry = *it.value;
+        callback(it.key, entry.mac_address, entry.state, (dword)((now - entry.updated_at) / TICKS_PER_SECOND), entry.dropped_packet_count, entry.adapter->class_name());
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/OwnPtr.h>
+#include <AK/SinglyLinkedList.h>
+#include <Kernel/Lock.h>
+#include <Kernel/Net/ARP.h>
+#include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/MACAddress.h>
+
+class NetworkAdapter;
+
+class ARPCache {
+public:
+    enum class State {
+        Incomplete,
+        Reachable,
+        Stale,
+    };
+
+    static ARPCache& the();
+
+    // Sends an IPv4 packet to a host on the adapter's local network. If the host's
+    // hardware address isn't known yet, the packet is held until it's resolved.
+    void send_ipv4(NetworkAdapter&, const IPv4Address& destination, IPv4Protocol, ByteBuffer&& payload);
+
+    // Feeds an incoming ARP packet into the cache. The adapter is the one the packet
+    // was addressed to, or null if it wasn't addressed to us (e.g a gratuitous ARP.)
+    void did_receive(const ARPPacket&, NetworkAdapter*);
+
+    // Announces the adapter's address so that neighbors can update stale entries.
+    void send_gratuitous(NetworkAdapter&);
+
+    // Retransmits unanswered requests and expires old entries. Called periodically by the NetworkTask.
+    void tick();
+
+    void for_each_entry(Function<void(const IPv4Address&, const MACAddress&, State, dword age_in_seconds, dword dropped_packets, const char* adapter_name)>);
+
+    static const char* to_string(State);
+
+private:
+    ARPCache() { }
+
+    struct PendingPacket {
+        IPv4Protocol protocol;
+        ByteBuffer payload;
+    };
+
+    struct Entry {
+        MACAddress mac_address;
+        State state { State::Incomplete };
+        NetworkAdapter* adapter { nullptr };
+        qword updated_at { 0 };
+        qword requested_at { 0 };
+        int request_count { 0 };
+        SinglyLinkedList<PendingPacket> pending_packets;
+        int pending_packet_count { 0 };
+        dword dropped_packet_count { 0 };
+    };
+
+    void send_request(NetworkAdapter&, const IPv4Address&);
+    void expire_entries();
+    void make_room();
+
+    Lockable<HashMap<IPv4Address, OwnPtr<Entry>>> m_entries;
+};
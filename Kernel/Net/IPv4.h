@@ -42,6 +42,8 @@ public:
         return String::format("%u.%u.%u.%u", m_data[0], m_data[1], m_data[2], m_data[3]);
     }
 
+    dword to_dword() const { return m_data_as_dword; }
+
     bool operator==(const IPv4Address& other) const { return m_data_as_dword == other.m_data_as_dword; }
     bool operator!=(const IPv4Address& other) const { return m_data_as_dword != other.m_data_as_dword; }
 
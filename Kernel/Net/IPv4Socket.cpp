@@ -23,6 +23,16 @@ Lockable<HashTable<IPv4Socket*>>& IPv4Socket::all_sockets()
     return *s_table;
 }
 
+Lockable<HashTable<IPv4Socket*>>& IPv4Socket::raw_sockets_for_protocol(byte protocol)
+{
+    // Each protocol gets its own table (and lock) so that delivering e.g. ICMP
+    // only has to visit sockets that actually asked for ICMP.
+    static Lockable<HashTable<IPv4Socket*>>* s_tables[256];
+    if (!s_tables[protocol])
+        s_tables[protocol] = new Lockable<HashTable<IPv4Socket*>>;
+    return *s_tables[protocol];
+}
+
 Retained<IPv4Socket> IPv4Socket::create(int type, int protocol)
 {
     if (type == SOCK_STREAM)
@@ -36,12 +46,24 @@ IPv4Socket::IPv4Socket(int type, int protocol)
     : Socket(AF_INET, type, protocol)
 {
     kprintf("%s(%u) IPv4Socket{%p} created with type=%u, protocol=%d\n", current->process().name().characters(), current->pid(), this, type, protocol);
-    LOCKER(all_sockets().lock());
-    all_sockets().resource().set(this);
+    {
+        LOCKER(all_sockets().lock());
+        all_sockets().resource().set(this);
+    }
+    if (type == SOCK_RAW) {
+        auto& raw_sockets = raw_sockets_for_protocol((byte)protocol);
+        LOCKER(raw_sockets.lock());
+        raw_sockets.resource().set(this);
+    }
 }
 
 IPv4Socket::~IPv4Socket()
 {
+    if (type() == SOCK_RAW) {
+        auto& raw_sockets = raw_sockets_for_protocol((byte)protocol());
+        LOCKER(raw_sockets.lock());
+        raw_sockets.resource().remove(this);
+    }
     LOCKER(all_sockets().lock());
     all_sockets().resource().remove(this);
 }
@@ -256,6 +278,7 @@ void IPv4Socket::did_receive(const IPv4Address& source_address, word source_port
     m_receive_queue.append({ source_address, source_port, move(packet) });
     m_can_read = true;
     m_bytes_received += packet_size;
+    did_change_readiness();
 #ifdef IPV4_SOCKET_DEBUG
     kprintf("IPv4Socket(%p): did_receive %d bytes, total_received=%u, packets in queue: %d\n", this, packet_size, m_bytes_received, m_receive_queue.size_slow());
 #endif
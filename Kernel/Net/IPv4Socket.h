@@ -3,6 +3,7 @@
 #include <Kernel/Net/Socket.h>
 #include <Kernel/DoubleBuffer.h>
 #include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/IPv4SocketTuple.h>
 #include <AK/HashMap.h>
 #include <Kernel/Lock.h>
 #include <AK/SinglyLinkedList.h>
@@ -19,6 +20,7 @@ public:
     virtual ~IPv4Socket() override;
 
     static Lockable<HashTable<IPv4Socket*>>& all_sockets();
+    static Lockable<HashTable<IPv4Socket*>>& raw_sockets_for_protocol(byte protocol);
 
     virtual KResult bind(const sockaddr*, socklen_t) override;
     virtual KResult connect(FileDescriptor&, const sockaddr*, socklen_t, ShouldBlock = ShouldBlock::Yes) override;
@@ -35,7 +37,8 @@ public:
 
     void did_receive(const IPv4Address& peer_address, word peer_port, ByteBuffer&&);
 
-    const IPv4Address& local_address() const;
+    const IPv4Address& local_address() const { return m_local_address; }
+    void set_local_address(const IPv4Address& address) { m_local_address = address; }
     word local_port() const { return m_local_port; }
     void set_local_port(word port) { m_local_port = port; }
 
@@ -43,6 +46,8 @@ public:
     word peer_port() const { return m_peer_port; }
     void set_peer_port(word port) { m_peer_port = port; }
 
+    IPv4SocketTuple tuple() const { return { m_local_address, m_local_port, m_peer_address, m_peer_port }; }
+
 protected:
     IPv4Socket(int type, int protocol);
     virtual const char* class_name() const override { return "IPv4Socket"; }
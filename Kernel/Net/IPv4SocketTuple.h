@@ -0,0 +1,62 @@
+#pragma once
+
+#include <AK/HashFunctions.h>
+#include <Kernel/Net/IPv4.h>
+
+// An IPv4SocketTuple identifies one end of a connection by its full
+// (local address, local port, peer address, peer port) 4-tuple.
+// It's used as the key when demultiplexing incoming packets to sockets.
+class IPv4SocketTuple {
+public:
+    IPv4SocketTuple() { }
+    IPv4SocketTuple(const IPv4Address& local_address, word local_port, const IPv4Address& peer_address, word peer_port)
+        : m_local_address(local_address)
+        , m_local_port(local_port)
+        , m_peer_address(peer_address)
+        , m_peer_port(peer_port)
+    {
+    }
+
+    const IPv4Address& local_address() const { return m_local_address; }
+    word local_port() const { return m_local_port; }
+    const IPv4Address& peer_address() const { return m_peer_address; }
+    word peer_port() const { return m_peer_port; }
+
+    bool operator==(const IPv4SocketTuple& other) const
+    {
+        return m_local_address == other.m_local_address
+            && m_local_port == other.m_local_port
+            && m_peer_address == other.m_peer_address
+            && m_peer_port == other.m_peer_port;
+    }
+
+    String to_string() const
+    {
+        return String::format("%s:%u -> %s:%u",
+            m_local_address.to_string().characters(),
+            m_local_port,
+            m_peer_address.to_string().characters(),
+            m_peer_port);
+    }
+
+private:
+    IPv4Address m_local_address;
+    word m_local_port { 0 };
+    IPv4Address m_peer_address;
+    word m_peer_port { 0 };
+};
+
+namespace AK {
+
+template<>
+struct Traits<IPv4SocketTuple> {
+    static unsigned hash(const IPv4SocketTuple& tuple)
+    {
+        auto local = pair_int_hash(tuple.local_address().to_dword(), tuple.local_port());
+        auto peer = pair_int_hash(tuple.peer_address().to_dword(), tuple.peer_port());
+        return pair_int_hash(local, peer);
+    }
+    static void dump(const IPv4SocketTuple& tuple) { kprintf("%s", tuple.to_string().characters()); }
+};
+
+}
@@ -15,6 +15,7 @@ Retained<LocalSocket> LocalSocket::create(int type)
 LocalSocket::LocalSocket(int type)
     : Socket(AF_LOCAL, type, 0)
 {
+    ASSERT(type == SOCK_STREAM || type == SOCK_SEQPACKET);
 #ifdef DEBUG_LOCAL_SOCKET
     kprintf("%s(%u) LocalSocket{%p} created with type=%u\n", current->process().name().characters(), current->pid(), this, type);
 #endif
@@ -121,6 +122,7 @@ void LocalSocket::attach(FileDescriptor& descriptor)
     default:
         break;
     }
+    did_change_readiness();
 }
 
 void LocalSocket::detach(FileDescriptor& descriptor)
@@ -141,6 +143,36 @@ void LocalSocket::detach(FileDescriptor& descriptor)
     default:
         break;
     }
+    // The other end may now see EOF, or have nobody left to block on.
+    did_change_readiness();
+}
+
+LocalSocket::Channel& LocalSocket::send_channel(const FileDescriptor& descriptor)
+{
+    if (descriptor.socket_role() == SocketRole::Accepted)
+        return m_for_client;
+    if (descriptor.socket_role() == SocketRole::Connected)
+        return m_for_server;
+    ASSERT_NOT_REACHED();
+}
+
+LocalSocket::Channel& LocalSocket::receive_channel(const FileDescriptor& descriptor)
+{
+    if (descriptor.socket_role() == SocketRole::Accepted)
+        return m_for_server;
+    if (descriptor.socket_role() == SocketRole::Connected)
+        return m_for_client;
+    ASSERT_NOT_REACHED();
+}
+
+const LocalSocket::Channel& LocalSocket::send_channel(const FileDescriptor& descriptor) const
+{
+    return const_cast<LocalSocket&>(*this).send_channel(descriptor);
+}
+
+const LocalSocket::Channel& LocalSocket::receive_channel(const FileDescriptor& descriptor) const
+{
+    return const_cast<LocalSocket&>(*this).receive_channel(descriptor);
 }
 
 bool LocalSocket::can_read(FileDescriptor& descriptor) const
@@ -148,31 +180,22 @@ bool LocalSocket::can_read(FileDescriptor& descriptor) const
     auto role = descriptor.socket_role();
     if (role == SocketRole::Listener)
         return can_accept();
-    if (role == SocketRole::Accepted)
-        return !has_attached_peer(descriptor) || !m_for_server.is_empty();
-    if (role == SocketRole::Connected)
-        return !has_attached_peer(descriptor) || !m_for_client.is_empty();
+    if (role == SocketRole::Accepted || role == SocketRole::Connected)
+        return !has_attached_peer(descriptor) || !receive_channel(descriptor).buffer.is_empty();
     ASSERT_NOT_REACHED();
 }
 
 ssize_t LocalSocket::read(FileDescriptor& descriptor, byte* buffer, ssize_t size)
 {
     auto role = descriptor.socket_role();
-    if (role == SocketRole::Accepted) {
-        if (!descriptor.is_blocking()) {
-            if (m_for_server.is_empty())
-                return -EAGAIN;
-        }
-        return m_for_server.read(buffer, size);
-    }
-    if (role == SocketRole::Connected) {
-        if (!descriptor.is_blocking()) {
-            if (m_for_client.is_empty())
-                return -EAGAIN;
-        }
-        return m_for_client.read(buffer, size);
+    if (role != SocketRole::Accepted && role != SocketRole::Connected)
+        ASSERT_NOT_REACHED();
+    if (!descriptor.is_blocking()) {
+        if (receive_channel(descriptor).buffer.is_empty())
+            return -EAGAIN;
     }
-    ASSERT_NOT_REACHED();
+    // Descriptors passed along with data consumed by a plain read() are dropped, just like other systems do.
+    return receive_with_descriptors(descriptor, buffer, size, nullptr);
 }
 
 bool LocalSocket::has_attached_peer(const FileDescriptor& descriptor) const
@@ -188,28 +211,136 @@ ssize_t LocalSocket::write(FileDescriptor& descriptor, const byte* data, ssize_t
 {
     if (!has_attached_peer(descriptor))
         return -EPIPE;
-    if (descriptor.socket_role() == SocketRole::Accepted)
-        return m_for_client.write(data, size);
-    if (descriptor.socket_role() == SocketRole::Connected)
-        return m_for_server.write(data, size);
-    ASSERT_NOT_REACHED();
+    auto& channel = send_channel(descriptor);
+    if (is_seqpacket()) {
+        if ((size_t)size > max_message_size)
+            return -EMSGSIZE;
+        if (!channel.buffer.write_message(data, size))
+            return -EAGAIN;
+        did_change_readiness();
+        return size;
+    }
+    ssize_t nwritten = channel.buffer.write(data, size);
+    if (nwritten > 0)
+        did_change_readiness();
+    return nwritten;
 }
 
 bool LocalSocket::can_write(FileDescriptor& descriptor) const
 {
-    if (descriptor.socket_role() == SocketRole::Accepted)
-        return !has_attached_peer(descriptor) || m_for_client.bytes_in_write_buffer() < 16384;
-    if (descriptor.socket_role() == SocketRole::Connected)
-        return !has_attached_peer(descriptor) || m_for_server.bytes_in_write_buffer() < 16384;
-    ASSERT_NOT_REACHED();
+    if (descriptor.socket_role() != SocketRole::Accepted && descriptor.socket_role() != SocketRole::Connected)
+        ASSERT_NOT_REACHED();
+    if (!has_attached_peer(descriptor))
+        return true;
+    auto& buffer = send_channel(descriptor).buffer;
+    // A SOCK_SEQPACKET message is written all at once, so only report writability
+    // once the largest possible message would fit.
+    if (is_seqpacket())
+        return buffer.space_for_writing() >= RingBuffer::message_header_size + max_message_size;
+    return buffer.space_for_writing() > 0;
 }
 
 ssize_t LocalSocket::sendto(FileDescriptor& descriptor, const void* data, size_t data_size, int, const sockaddr*, socklen_t)
 {
-    return write(descriptor, (const byte*)data, data_size);
+    return send_with_descriptors(descriptor, (const byte*)data, data_size, { });
 }
 
 ssize_t LocalSocket::recvfrom(FileDescriptor& descriptor, void* buffer, size_t buffer_size, int, sockaddr*, socklen_t*)
 {
-    return read(descriptor, (byte*)buffer, buffer_size);
+    return receive_with_descriptors(descriptor, (byte*)buffer, buffer_size, nullptr);
+}
+
+ssize_t LocalSocket::send_with_descriptors(FileDescriptor& descriptor, const byte* data, ssize_t size, Vector<RetainPtr<FileDescriptor>>&& descriptors)
+{
+    if (!has_attached_peer(descriptor))
+        return -EPIPE;
+    if (is_seqpacket() && (size_t)size > max_message_size)
+        return -EMSGSIZE;
+    // Descriptors are delivered with the byte they're queued at, so they need at least one.
+    if (!size && !descriptors.is_empty())
+        return -EINVAL;
+
+    auto& channel = send_channel(descriptor);
+
+    // Hold the write lock across the whole send so the stream offset we record
+    // for the passed descriptors is where our data actually ends up. They have to be
+    // queued before the first byte goes in, or a reader could consume it without them.
+    LOCKER(channel.buffer.write_lock());
+    bool queued_descriptors = !descriptors.is_empty();
+    if (queued_descriptors) {
+        LOCKER(lock());
+        channel.passed_descriptors.append({ channel.buffer.total_written(), move(descriptors) });
+    }
+
+    // If nothing gets written, take the descriptors back out, or they'd ride along
+    // with whatever is sent next. Nobody can have read up to them, and we hold the
+    // write lock, so they're still the last entry.
+    auto fail = [&](ssize_t error) -> ssize_t {
+        if (queued_descriptors) {
+            LOCKER(lock());
+            channel.passed_descriptors.take_last();
+        }
+        return error;
+    };
+
+    ssize_t nwritten = 0;
+    do {
+        if (!can_write(descriptor)) {
+            if (!descriptor.is_blocking())
+                return nwritten ? nwritten : fail(-EAGAIN);
+            current->block(Thread::State::BlockedWrite, descriptor);
+            if (!has_attached_peer(descriptor))
+                return nwritten ? nwritten : fail(-EPIPE);
+        }
+        ssize_t rc = write(descriptor, data + nwritten, size - nwritten);
+        if (rc < 0)
+            return nwritten ? nwritten : fail(rc);
+        nwritten += rc;
+    } while (nwritten < size);
+    return nwritten;
+}
+
+void LocalSocket::take_passed_descriptors(Channel& channel, dword read_up_to, Vector<RetainPtr<FileDescriptor>>* descriptors)
+{
+    LOCKER(lock());
+    while (!channel.passed_descriptors.is_empty()) {
+        // The offsets are free-running, so compare them as a signed distance.
+        if ((signed_dword)(channel.passed_descriptors.first().stream_offset - read_up_to) >= 0)
+            break;
+        auto passed = channel.passed_descriptors.take_first();
+        if (!descriptors)
+            continue;
+        for (auto& passed_descriptor : passed.descriptors)
+            descriptors->append(move(passed_descriptor));
+    }
+}
+
+ssize_t LocalSocket::receive_with_descriptors(FileDescriptor& descriptor, byte* buffer, ssize_t size, Vector<RetainPtr<FileDescriptor>>* descriptors, bool* truncated)
+{
+    auto& channel = receive_channel(descriptor);
+
+    if (channel.buffer.is_empty()) {
+        if (!has_attached_peer(descriptor))
+            return 0;
+        if (!descriptor.is_blocking())
+            return -EAGAIN;
+        current->block(Thread::State::BlockedRead, descriptor);
+        if (current->was_interrupted_while_blocked())
+            return -EINTR;
+    }
+
+    LOCKER(channel.buffer.read_lock());
+    ssize_t nread;
+    if (is_seqpacket()) {
+        ssize_t message_size = channel.buffer.read_message(buffer, size);
+        if (truncated)
+            *truncated = message_size > size;
+        nread = min(message_size, size);
+    } else {
+        nread = channel.buffer.read(buffer, size);
+    }
+    take_passed_descriptors(channel, channel.buffer.total_read(), descriptors);
+    if (nread > 0)
+        did_change_readiness();
+    return nread;
 }
@@ -1,7 +1,8 @@
 #pragma once
 
 #include <Kernel/Net/Socket.h>
-#include <Kernel/DoubleBuffer.h>
+#include <AK/SinglyLinkedList.h>
+#include <Kernel/RingBuffer.h>
 
 class FileDescriptor;
 
@@ -23,10 +24,39 @@ public:
     virtual ssize_t sendto(FileDescriptor&, const void*, size_t, int, const sockaddr*, socklen_t) override;
     virtual ssize_t recvfrom(FileDescriptor&, void*, size_t, int flags, sockaddr*, socklen_t*) override;
 
+    // Like sendto()/recvfrom(), but also carries file descriptors (SCM_RIGHTS) along with the data.
+    // Passed descriptors are delivered to the receiver together with the first byte sent alongside them,
+    // so sending them with no data fails with EINVAL.
+    ssize_t send_with_descriptors(FileDescriptor&, const byte*, ssize_t, Vector<RetainPtr<FileDescriptor>>&&);
+    ssize_t receive_with_descriptors(FileDescriptor&, byte*, ssize_t, Vector<RetainPtr<FileDescriptor>>*, bool* truncated = nullptr);
+
+    static const size_t buffer_capacity = 16 * KB;
+    static const size_t max_message_size = 4 * KB;
+
 private:
+    struct PassedDescriptors {
+        dword stream_offset { 0 };
+        Vector<RetainPtr<FileDescriptor>> descriptors;
+    };
+
+    struct Channel {
+        explicit Channel(String&& name)
+            : buffer(move(name), buffer_capacity)
+        {
+        }
+        RingBuffer buffer;
+        SinglyLinkedList<PassedDescriptors> passed_descriptors;
+    };
+
     explicit LocalSocket(int type);
     virtual bool is_local() const override { return true; }
     bool has_attached_peer(const FileDescriptor&) const;
+    bool is_seqpacket() const { return type() == SOCK_SEQPACKET; }
+    Channel& send_channel(const FileDescriptor&);
+    Channel& receive_channel(const FileDescriptor&);
+    const Channel& send_channel(const FileDescriptor&) const;
+    const Channel& receive_channel(const FileDescriptor&) const;
+    void take_passed_descriptors(Channel&, dword read_up_to, Vector<RetainPtr<FileDescriptor>>*);
 
     RetainPtr<FileDescriptor> m_file;
 
@@ -36,7 +66,7 @@ private:
     int m_connecting_fds_open { 0 };
     sockaddr_un m_address;
 
-    DoubleBuffer m_for_client;
-    DoubleBuffer m_for_server;
+    Channel m_for_client { "LocalSocket: Client" };
+    Channel m_for_server { "LocalSocket: Server" };
 };
 
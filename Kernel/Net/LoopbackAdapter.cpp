@@ -1,4 +1,7 @@
+#include <Kernel/FileSystem/ProcFS.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/NetworkTask.h>
+#include <Kernel/Thread.h>
 
 LoopbackAdapter& LoopbackAdapter::the()
 {
@@ -11,6 +14,8 @@ LoopbackAdapter& LoopbackAdapter::the()
 LoopbackAdapter::LoopbackAdapter()
 {
     set_ipv4_address({ 127, 0, 0, 1 });
+    m_fast_path_enabled.resource() = true;
+    ProcFS::the().add_sys_bool("loopback_fast_path", m_fast_path_enabled);
 }
 
 LoopbackAdapter::~LoopbackAdapter()
@@ -22,3 +27,33 @@ void LoopbackAdapter::send_raw(const byte* data, int size)
     dbgprintf("LoopbackAdapter: Sending %d byte(s) to myself.\n", size);
     did_receive(data, size);
 }
+
+void LoopbackAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, ByteBuffer&& payload)
+{
+    // If this thread is already delivering a loopback packet (e.g the receiver is
+    // replying from inside its packet handler), go through the NetworkTask queue
+    // instead so the two ends can't recurse into each other. That's a property of
+    // the thread, not the adapter: other threads keep taking the fast path meanwhile.
+    if (!m_fast_path_enabled.resource() || !current || current->loopback_delivery_depth()) {
+        NetworkAdapter::send_ipv4(destination_mac, destination_ipv4, protocol, move(payload));
+        return;
+    }
+
+    // Fast path: No Ethernet framing, no checksum and no trip through the NetworkTask.
+    // The packet is handed to the IPv4 layer right here, in the sender's context.
+    auto buffer = ByteBuffer::create_uninitialized(sizeof(IPv4Packet) + payload.size());
+    memset(buffer.pointer(), 0, sizeof(IPv4Packet));
+    auto& ipv4 = *(IPv4Packet*)buffer.pointer();
+    ipv4.set_version(4);
+    ipv4.set_internet_header_length(5);
+    ipv4.set_source(ipv4_address());
+    ipv4.set_destination(destination_ipv4);
+    ipv4.set_protocol((byte)protocol);
+    ipv4.set_length(sizeof(IPv4Packet) + payload.size());
+    ipv4.set_ttl(64);
+    memcpy(ipv4.payload(), payload.pointer(), payload.size());
+
+    current->set_loopback_delivery_depth(current->loopback_delivery_depth() + 1);
+    deliver_ipv4_packet(ipv4, mac_address());
+    current->set_loopback_delivery_depth(current->loopback_delivery_depth() - 1);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <Kernel/Lock.h>
 #include <Kernel/Net/NetworkAdapter.h>
 
 class LoopbackAdapter final : public NetworkAdapter {
@@ -10,8 +11,12 @@ public:
     virtual ~LoopbackAdapter() override;
 
     virtual void send_raw(const byte*, int) override;
+    virtual void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, ByteBuffer&& payload) override;
     virtual const char* class_name() const override { return "LoopbackAdapter"; }
+    virtual bool is_loopback() const override { return true; }
 
 private:
     LoopbackAdapter();
+
+    Lockable<bool> m_fast_path_enabled;
 };
@@ -25,13 +25,18 @@ public:
         return !memcmp(m_data, other.m_data, sizeof(m_data));
     }
 
+    bool is_zero() const
+    {
+        return !m_data[0] && !m_data[1] && !m_data[2] && !m_data[3] && !m_data[4] && !m_data[5];
+    }
+
     String to_string() const
     {
         return String::format("%b:%b:%b:%b:%b:%b", m_data[0], m_data[1], m_data[2], m_data[3], m_data[4], m_data[5]);
     }
 
 private:
-    byte m_data[6];
+    byte m_data[6] { 0 };
 };
 
 static_assert(sizeof(MACAddress) == 6);
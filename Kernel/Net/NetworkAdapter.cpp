@@ -1,6 +1,8 @@
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/ARPCache.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/EtherType.h>
+#include <Kernel/Net/NetworkTask.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/kmalloc.h>
 #include <AK/HashTable.h>
@@ -46,11 +48,16 @@ void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet
     eth->set_destination(destination);
     eth->set_ether_type(EtherType::ARP);
     memcpy(eth->payload(), &packet, sizeof(ARPPacket));
-    send_raw((byte*)eth, size_in_bytes);
+    transmit(move(buffer));
 }
 
 void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, ByteBuffer&& payload)
 {
+    // Callers that don't know the destination's hardware address pass a zero one.
+    if (destination_mac.is_zero() && !is_loopback()) {
+        ARPCache::the().send_ipv4(*this, destination_ipv4, protocol, move(payload));
+        return;
+    }
     size_t size_in_bytes = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + payload.size();
     auto buffer = ByteBuffer::create_zeroed(size_in_bytes);
     auto& eth = *(EthernetFrameHeader*)buffer.pointer();
@@ -68,21 +75,29 @@ void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Addr
     ipv4.set_ttl(64);
     ipv4.set_checksum(ipv4.compute_checksum());
     memcpy(ipv4.payload(), payload.pointer(), payload.size());
-    send_raw((const byte*)&eth, size_in_bytes);
+    transmit(move(buffer));
+}
+
+void NetworkAdapter::transmit(ByteBuffer&& frame)
+{
+    if (defer_send_if_receiving(*this, frame))
+        return;
+    send_raw(frame.pointer(), frame.size());
 }
 
 void NetworkAdapter::did_receive(const byte* data, int length)
 {
+    // The queue only supports a single producer. Hardware adapters call us from
+    // their IRQ handler, but the loopback adapter calls us from whichever thread
+    // is sending, so keep interrupts off to serialize producers.
     InterruptDisabler disabler;
-    m_packet_queue.append(ByteBuffer::copy(data, length));
+    if (!m_packet_queue.enqueue(ByteBuffer::copy(data, length)))
+        ++m_packets_dropped;
 }
 
-ByteBuffer NetworkAdapter::dequeue_packet()
+bool NetworkAdapter::dequeue_packet(ByteBuffer& packet)
 {
-    InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
-        return { };
-    return m_packet_queue.take_first();
+    return m_packet_queue.dequeue(packet);
 }
 
 void NetworkAdapter::set_ipv4_address(const IPv4Address& address)
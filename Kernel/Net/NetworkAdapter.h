@@ -1,13 +1,13 @@
 #pragma once
 
 #include <AK/ByteBuffer.h>
-#include <AK/SinglyLinkedList.h>
 #include <AK/Types.h>
 #include <Kernel/Net/MACAddress.h>
 #include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Alarm.h>
+#include <Kernel/SPSCQueue.h>
 
 class NetworkAdapter;
 
@@ -26,19 +26,26 @@ public:
     virtual ~NetworkAdapter();
 
     virtual const char* class_name() const = 0;
+    virtual bool is_loopback() const { return false; }
     MACAddress mac_address() { return m_mac_address; }
     IPv4Address ipv4_address() const { return m_ipv4_address; }
 
     void set_ipv4_address(const IPv4Address&);
 
     void send(const MACAddress&, const ARPPacket&);
-    void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, ByteBuffer&& payload);
+    virtual void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, ByteBuffer&& payload);
 
-    ByteBuffer dequeue_packet();
+    // Hands a complete Ethernet frame to the hardware. If called from an RX worker
+    // in the middle of a batch, the frame is queued and sent once the batch is done.
+    void transmit(ByteBuffer&&);
+    void transmit_immediately(const ByteBuffer& frame) { send_raw(frame.pointer(), frame.size()); }
+
+    bool dequeue_packet(ByteBuffer&);
 
     Alarm& packet_queue_alarm() { return m_packet_queue_alarm; }
 
     bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
+    dword packets_dropped() const { return m_packets_dropped; }
 
 protected:
     NetworkAdapter();
@@ -50,5 +57,6 @@ private:
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
     PacketQueueAlarm m_packet_queue_alarm;
-    SinglyLinkedList<ByteBuffer> m_packet_queue;
+    SPSCQueue<ByteBuffer, 256> m_packet_queue;
+    dword m_packets_dropped { 0 };
 };
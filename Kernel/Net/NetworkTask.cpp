@@ -1,6 +1,7 @@
 #include <Kernel/Net/E1000NetworkAdapter.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ARP.h>
+#include <Kernel/Net/ARPCache.h>
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Net/UDP.h>
 #include <Kernel/Net/TCP.h>
@@ -9,9 +10,11 @@
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Process.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Lock.h>
+#include <Kernel/i8253.h>
 
 
 //#define ETHERNET_DEBUG
@@ -22,90 +25,147 @@
 
 static void handle_arp(const EthernetFrameHeader&, int frame_size);
 static void handle_ipv4(const EthernetFrameHeader&, int frame_size);
-static void handle_icmp(const EthernetFrameHeader&, int frame_size);
-static void handle_udp(const EthernetFrameHeader&, int frame_size);
-static void handle_tcp(const EthernetFrameHeader&, int frame_size);
+static void handle_icmp(const IPv4Packet&, const MACAddress& source_mac);
+static void handle_udp(const IPv4Packet&);
+static void handle_tcp(const IPv4Packet&);
 
-Lockable<HashMap<IPv4Address, MACAddress>>& arp_table()
+struct DeferredSend {
+    NetworkAdapter* adapter { nullptr };
+    ByteBuffer frame;
+};
+
+// Each adapter gets its own RX worker thread. Workers are set up once by
+// NetworkTask_main() before any of them run, so the list itself never changes
+// afterwards and can be scanned without locking.
+struct RXWorker {
+    NetworkAdapter* adapter { nullptr };
+    Thread* thread { nullptr };
+    bool in_batch { false };
+    SinglyLinkedList<DeferredSend> deferred_sends;
+};
+
+static const int max_rx_workers = 4;
+static const int rx_batch_size = 32;
+
+static RXWorker* s_rx_workers[max_rx_workers];
+static int s_rx_worker_count;
+
+static RXWorker& rx_worker_for(NetworkAdapter& adapter)
 {
-    static Lockable<HashMap<IPv4Address, MACAddress>>* the;
-    if (!the)
-        the = new Lockable<HashMap<IPv4Address, MACAddress>>;
-    return *the;
+    for (int i = 0; i < s_rx_worker_count; ++i) {
+        if (s_rx_workers[i]->adapter == &adapter)
+            return *s_rx_workers[i];
+    }
+    ASSERT_NOT_REACHED();
 }
 
-class CombinedPacketQueueAlarm : public Alarm {
-public:
-    CombinedPacketQueueAlarm() { }
+static void add_rx_worker(NetworkAdapter& adapter)
+{
+    ASSERT(s_rx_worker_count < max_rx_workers);
+    auto* worker = new RXWorker;
+    worker->adapter = &adapter;
+    s_rx_workers[s_rx_worker_count++] = worker;
+}
 
-    virtual bool is_ringing() const override
-    {
-        if (LoopbackAdapter::the().has_queued_packets())
-            return true;
-        if (auto* e1000 = E1000NetworkAdapter::the()) {
-            if (e1000->has_queued_packets())
-                return true;
-        }
-        return false;
+bool defer_send_if_receiving(NetworkAdapter& adapter, ByteBuffer& frame)
+{
+    for (int i = 0; i < s_rx_worker_count; ++i) {
+        auto& worker = *s_rx_workers[i];
+        if (worker.thread != current || !worker.in_batch)
+            continue;
+        worker.deferred_sends.append({ &adapter, move(frame) });
+        return true;
     }
-};
+    return false;
+}
 
-void NetworkTask_main()
+static void handle_packet(const ByteBuffer& packet)
 {
-    LoopbackAdapter::the();
-
-    auto* adapter = E1000NetworkAdapter::the();
-    if (!adapter)
-        dbgprintf("E1000 network card not found!\n");
+    if (packet.size() < (int)(sizeof(EthernetFrameHeader))) {
+        kprintf("NetworkTask: Packet is too small to be an Ethernet packet! (%d)\n", packet.size());
+        return;
+    }
+    auto& eth = *(const EthernetFrameHeader*)packet.pointer();
+#ifdef ETHERNET_DEBUG
+    kprintf("NetworkTask: From %s to %s, ether_type=%w, packet_length=%u\n",
+        eth.source().to_string().characters(),
+        eth.destination().to_string().characters(),
+        eth.ether_type(),
+        packet.size()
+    );
+#endif
 
-    if (adapter)
-        adapter->set_ipv4_address(IPv4Address(192, 168, 5, 2));
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, packet.size());
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(eth, packet.size());
+        break;
+    }
+}
 
-    auto dequeue_packet = [&] () -> ByteBuffer {
-        auto packet = LoopbackAdapter::the().dequeue_packet();
-        if (!packet.is_null()) {
-            dbgprintf("Receive loopback packet (%d bytes)\n", packet.size());
-            return packet;
-        }
-        if (adapter && adapter->has_queued_packets())
-            return adapter->dequeue_packet();
-        return { };
-    };
+static void run_rx_worker(NetworkAdapter& adapter)
+{
+    auto& worker = rx_worker_for(adapter);
+    worker.thread = current;
 
-    CombinedPacketQueueAlarm queue_alarm;
+    ByteBuffer batch[rx_batch_size];
 
-    kprintf("NetworkTask: Enter main loop.\n");
+    kprintf("NetworkTask: %s RX worker entering main loop.\n", adapter.class_name());
     for (;;) {
-        auto packet = dequeue_packet();
-        if (packet.is_null()) {
-            current->snooze_until(queue_alarm);
+        int count = 0;
+        while (count < rx_batch_size && adapter.dequeue_packet(batch[count]))
+            ++count;
+        if (!count) {
+            current->snooze_until(adapter.packet_queue_alarm());
             continue;
         }
-        if (packet.size() < (int)(sizeof(EthernetFrameHeader))) {
-            kprintf("NetworkTask: Packet is too small to be an Ethernet packet! (%d)\n", packet.size());
-            continue;
+
+        // Anything we send while handling the batch (ARP replies, ACKs, echo replies)
+        // is held back until the whole batch has been processed.
+        worker.in_batch = true;
+        for (int i = 0; i < count; ++i) {
+            handle_packet(batch[i]);
+            batch[i].clear();
         }
-        auto& eth = *(const EthernetFrameHeader*)packet.pointer();
-#ifdef ETHERNET_DEBUG
-        kprintf("NetworkTask: From %s to %s, ether_type=%w, packet_length=%u\n",
-            eth.source().to_string().characters(),
-            eth.destination().to_string().characters(),
-            eth.ether_type(),
-            packet.size()
-        );
-#endif
+        worker.in_batch = false;
 
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet.size());
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet.size());
-            break;
+        while (!worker.deferred_sends.is_empty()) {
+            auto send = worker.deferred_sends.take_first();
+            send.adapter->transmit_immediately(send.frame);
         }
     }
 }
 
+void NetworkTask_main()
+{
+    add_rx_worker(LoopbackAdapter::the());
+
+    auto* adapter = E1000NetworkAdapter::the();
+    if (!adapter)
+        dbgprintf("E1000 network card not found!\n");
+
+    if (adapter) {
+        adapter->set_ipv4_address(IPv4Address(192, 168, 5, 2));
+        ARPCache::the().send_gratuitous(*adapter);
+        add_rx_worker(*adapter);
+        Process::create_kernel_process("NetworkTask:E1000", [] {
+            run_rx_worker(*E1000NetworkAdapter::the());
+        });
+    }
+
+    Process::create_kernel_process("NetworkTask:ARP", [] {
+        for (;;) {
+            current->sleep(TICKS_PER_SECOND / 2);
+            ARPCache::the().tick();
+        }
+    });
+
+    // This thread becomes the loopback RX worker.
+    run_rx_worker(LoopbackAdapter::the());
+}
+
 void handle_arp(const EthernetFrameHeader& eth, int frame_size)
 {
     constexpr int minimum_arp_frame_size = sizeof(EthernetFrameHeader) + sizeof(ARPPacket);
@@ -139,35 +199,26 @@ void handle_arp(const EthernetFrameHeader& eth, int frame_size)
     );
 #endif
 
-    if (packet.operation() == ARPOperation::Request) {
-        // Who has this IP address?
-        if (auto* adapter = NetworkAdapter::from_ipv4_address(packet.target_protocol_address())) {
-            // We do!
-            kprintf("handle_arp: Responding to ARP request for my IPv4 address (%s)\n",
-                    adapter->ipv4_address().to_string().characters());
-            ARPPacket response;
-            response.set_operation(ARPOperation::Response);
-            response.set_target_hardware_address(packet.sender_hardware_address());
-            response.set_target_protocol_address(packet.sender_protocol_address());
-            response.set_sender_hardware_address(adapter->mac_address());
-            response.set_sender_protocol_address(adapter->ipv4_address());
-
-            adapter->send(packet.sender_hardware_address(), response);
-        }
-        return;
-    }
-
-    if (packet.operation() == ARPOperation::Response) {
-        // Someone has this IPv4 address. I guess we can try to remember that.
-        // FIXME: Protect against ARP spamming.
-        // FIXME: Support static ARP table entries.
-        LOCKER(arp_table().lock());
-        arp_table().resource().set(packet.sender_protocol_address(), packet.sender_hardware_address());
-
-        kprintf("ARP table (%d entries):\n", arp_table().resource().size());
-        for (auto& it : arp_table().resource()) {
-            kprintf("%s :: %s\n", it.value.to_string().characters(), it.key.to_string().characters());
-        }
+    // If the request or reply is addressed to one of our adapters, we'll remember the sender.
+    // Otherwise we only refresh what we already know (e.g from a gratuitous ARP.)
+    auto* adapter = NetworkAdapter::from_ipv4_address(packet.target_protocol_address());
+    if (adapter && adapter->is_loopback())
+        adapter = nullptr;
+
+    ARPCache::the().did_receive(packet, adapter);
+
+    if (packet.operation() == ARPOperation::Request && adapter) {
+        // Who has this IP address? We do!
+        kprintf("handle_arp: Responding to ARP request for my IPv4 address (%s)\n",
+                adapter->ipv4_address().to_string().characters());
+        ARPPacket response;
+        response.set_operation(ARPOperation::Response);
+        response.set_target_hardware_address(packet.sender_hardware_address());
+        response.set_target_protocol_address(packet.sender_protocol_address());
+        response.set_sender_hardware_address(adapter->mac_address());
+        response.set_sender_protocol_address(adapter->ipv4_address());
+
+        adapter->send(packet.sender_hardware_address(), response);
     }
 }
 
@@ -178,7 +229,11 @@ void handle_ipv4(const EthernetFrameHeader& eth, int frame_size)
         kprintf("handle_ipv4: Frame too small (%d, need %d)\n", frame_size, minimum_ipv4_frame_size);
         return;
     }
-    auto& packet = *static_cast<const IPv4Packet*>(eth.payload());
+    deliver_ipv4_packet(*static_cast<const IPv4Packet*>(eth.payload()), eth.source());
+}
+
+void deliver_ipv4_packet(const IPv4Packet& packet, const MACAddress& source_mac)
+{
 
 #ifdef IPV4_DEBUG
     kprintf("handle_ipv4: source=%s, target=%s\n",
@@ -187,23 +242,28 @@ void handle_ipv4(const EthernetFrameHeader& eth, int frame_size)
     );
 #endif
 
+    {
+        auto& raw_sockets = IPv4Socket::raw_sockets_for_protocol(packet.protocol());
+        LOCKER(raw_sockets.lock());
+        for (auto* socket : raw_sockets.resource())
+            socket->did_receive(packet.source(), 0, ByteBuffer::copy(&packet, sizeof(IPv4Packet) + packet.payload_size()));
+    }
+
     switch ((IPv4Protocol)packet.protocol()) {
     case IPv4Protocol::ICMP:
-        return handle_icmp(eth, frame_size);
+        return handle_icmp(packet, source_mac);
     case IPv4Protocol::UDP:
-        return handle_udp(eth, frame_size);
+        return handle_udp(packet);
     case IPv4Protocol::TCP:
-        return handle_tcp(eth, frame_size);
+        return handle_tcp(packet);
     default:
         kprintf("handle_ipv4: Unhandled protocol %u\n", packet.protocol());
         break;
     }
 }
 
-void handle_icmp(const EthernetFrameHeader& eth, int frame_size)
+void handle_icmp(const IPv4Packet& ipv4_packet, const MACAddress& source_mac)
 {
-    (void)frame_size;
-    auto& ipv4_packet = *static_cast<const IPv4Packet*>(eth.payload());
     auto& icmp_header = *static_cast<const ICMPHeader*>(ipv4_packet.payload());
 #ifdef ICMP_DEBUG
     kprintf("handle_icmp: source=%s, destination=%s, type=%b, code=%b\n",
@@ -214,16 +274,6 @@ void handle_icmp(const EthernetFrameHeader& eth, int frame_size)
     );
 #endif
 
-    {
-        LOCKER(IPv4Socket::all_sockets().lock());
-        for (RetainPtr<IPv4Socket> socket : IPv4Socket::all_sockets().resource()) {
-            LOCKER(socket->lock());
-            if (socket->protocol() != (unsigned)IPv4Protocol::ICMP)
-                continue;
-            socket->did_receive(ipv4_packet.source(), 0, ByteBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
-        }
-    }
-
     auto* adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
     if (!adapter)
         return;
@@ -245,14 +295,12 @@ void handle_icmp(const EthernetFrameHeader& eth, int frame_size)
         if (size_t icmp_payload_size = icmp_packet_size - sizeof(ICMPEchoPacket))
             memcpy(response.payload(), request.payload(), icmp_payload_size);
         response.header.set_checksum(internet_checksum(&response, icmp_packet_size));
-        adapter->send_ipv4(eth.source(), ipv4_packet.source(), IPv4Protocol::ICMP, move(buffer));
+        adapter->send_ipv4(source_mac, ipv4_packet.source(), IPv4Protocol::ICMP, move(buffer));
     }
 }
 
-void handle_udp(const EthernetFrameHeader& eth, int frame_size)
+void handle_udp(const IPv4Packet& ipv4_packet)
 {
-    (void)frame_size;
-    auto& ipv4_packet = *static_cast<const IPv4Packet*>(eth.payload());
 
     auto* adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
     if (!adapter) {
@@ -282,10 +330,8 @@ void handle_udp(const EthernetFrameHeader& eth, int frame_size)
     socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), ByteBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
 }
 
-void handle_tcp(const EthernetFrameHeader& eth, int frame_size)
+void handle_tcp(const IPv4Packet& ipv4_packet)
 {
-    (void)frame_size;
-    auto& ipv4_packet = *static_cast<const IPv4Packet*>(eth.payload());
 
     auto* adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
     if (!adapter) {
@@ -312,9 +358,10 @@ void handle_tcp(const EthernetFrameHeader& eth, int frame_size)
     );
 #endif
 
-    auto socket = TCPSocket::from_port(tcp_packet.destination_port());
+    IPv4SocketTuple tuple(ipv4_packet.destination(), tcp_packet.destination_port(), ipv4_packet.source(), tcp_packet.source_port());
+    auto socket = TCPSocket::from_tuple(tuple);
     if (!socket) {
-        kprintf("handle_tcp: No TCP socket for port %u\n", tcp_packet.destination_port());
+        kprintf("handle_tcp: No TCP socket for tuple %s\n", tuple.to_string().characters());
         return;
     }
 
@@ -1,3 +1,10 @@
 #pragma once
 
+class ByteBuffer;
+class IPv4Packet;
+class MACAddress;
+class NetworkAdapter;
+
 void NetworkTask_main();
+void deliver_ipv4_packet(const IPv4Packet&, const MACAddress& source_mac);
+bool defer_send_if_receiving(NetworkAdapter&, ByteBuffer& frame);
@@ -11,6 +11,8 @@ KResultOr<Retained<Socket>> Socket::create(int domain, int type, int protocol)
     (void)protocol;
     switch (domain) {
     case AF_LOCAL:
+        if ((type & SOCK_TYPE_MASK) != SOCK_STREAM && (type & SOCK_TYPE_MASK) != SOCK_SEQPACKET)
+            return KResult(-EPROTONOSUPPORT);
         return LocalSocket::create(type & SOCK_TYPE_MASK);
     case AF_INET:
         return IPv4Socket::create(type & SOCK_TYPE_MASK, protocol);
@@ -24,7 +26,7 @@ Socket::Socket(int domain, int type, int protocol)
     , m_type(type)
     , m_protocol(protocol)
 {
-    m_origin_pid = current->pid();
+    m_origin = { current->pid(), current->process().uid(), current->process().gid() };
 }
 
 Socket::~Socket()
@@ -34,7 +36,7 @@ Socket::~Socket()
 KResult Socket::listen(int backlog)
 {
     LOCKER(m_lock);
-    if (m_type != SOCK_STREAM)
+    if (m_type != SOCK_STREAM && m_type != SOCK_SEQPACKET)
         return KResult(-EOPNOTSUPP);
     m_backlog = backlog;
     kprintf("Socket{%p} listening with backlog=%d\n", this, m_backlog);
@@ -49,6 +51,8 @@ RetainPtr<Socket> Socket::accept()
     auto client = m_pending.take_first();
     ASSERT(!client->is_connected());
     client->m_connected = true;
+    client->m_acceptor = { current->pid(), current->process().uid(), current->process().gid() };
+    client->did_change_readiness();
     return client;
 }
 
@@ -58,6 +62,7 @@ KResult Socket::queue_connection_from(Socket& peer)
     if (m_pending.size() >= m_backlog)
         return KResult(-ECONNREFUSED);
     m_pending.append(peer);
+    did_change_readiness();
     return KSuccess;
 }
 
@@ -81,7 +86,7 @@ KResult Socket::setsockopt(int level, int option, const void* value, socklen_t v
     }
 }
 
-KResult Socket::getsockopt(int level, int option, void* value, socklen_t* value_size)
+KResult Socket::getsockopt(FileDescriptor& descriptor, int level, int option, void* value, socklen_t* value_size)
 {
     ASSERT(level == SOL_SOCKET);
     switch (option) {
@@ -97,6 +102,21 @@ KResult Socket::getsockopt(int level, int option, void* value, socklen_t* value_
         *(timeval*)value = m_receive_timeout;
         *value_size = sizeof(timeval);
         return KSuccess;
+    case SO_PEERCRED:
+        if (m_domain != AF_LOCAL)
+            return KResult(-ENOPROTOOPT);
+        if (*value_size < sizeof(ucred))
+            return KResult(-EINVAL);
+        // The socket object is shared by both ends, so which credentials belong
+        // to the peer depends on which end is asking.
+        if (descriptor.socket_role() == SocketRole::Accepted)
+            *(ucred*)value = m_origin;
+        else if (descriptor.socket_role() == SocketRole::Connected)
+            *(ucred*)value = m_acceptor;
+        else
+            return KResult(-ENOTCONN);
+        *value_size = sizeof(ucred);
+        return KSuccess;
     default:
         kprintf("%s(%u): getsockopt() at SOL_SOCKET with unimplemented option %d\n", option);
         return KResult(-ENOPROTOOPT);
@@ -40,14 +40,18 @@ public:
     virtual ssize_t recvfrom(FileDescriptor&, void*, size_t, int flags, sockaddr*, socklen_t*) = 0;
 
     KResult setsockopt(int level, int option, const void*, socklen_t);
-    KResult getsockopt(int level, int option, void*, socklen_t*);
+    KResult getsockopt(FileDescriptor&, int level, int option, void*, socklen_t*);
 
-    pid_t origin_pid() const { return m_origin_pid; }
+    pid_t origin_pid() const { return m_origin.pid; }
 
     timeval receive_deadline() const { return m_receive_deadline; }
     timeval send_deadline() const { return m_send_deadline; }
 
-    void set_connected(bool connected) { m_connected = connected; }
+    void set_connected(bool connected)
+    {
+        m_connected = connected;
+        did_change_readiness();
+    }
 
     Lock& lock() { return m_lock; }
 
@@ -67,7 +71,8 @@ private:
     virtual bool is_socket() const final { return true; }
 
     Lock m_lock { "Socket" };
-    pid_t m_origin_pid { 0 };
+    ucred m_origin { 0, 0, 0 };
+    ucred m_acceptor { 0, 0, 0 };
     int m_domain { 0 };
     int m_type { 0 };
     int m_protocol { 0 };
@@ -13,6 +13,45 @@ Lockable<HashMap<word, TCPSocket*>>& TCPSocket::sockets_by_port()
     return *s_map;
 }
 
+Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple()
+{
+    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>* s_map;
+    if (!s_map)
+        s_map = new Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>;
+    return *s_map;
+}
+
+TCPSocketHandle TCPSocket::from_tuple(const IPv4SocketTuple& tuple)
+{
+    RetainPtr<TCPSocket> socket;
+    {
+        LOCKER(sockets_by_tuple().lock());
+        auto it = sockets_by_tuple().resource().find(tuple);
+        if (it != sockets_by_tuple().resource().end()) {
+            socket = (*it).value;
+            ASSERT(socket);
+        }
+    }
+    if (socket)
+        return { move(socket) };
+
+    // No established connection matches, fall back to a socket that's bound
+    // to the local port without a peer (i.e a listening socket.)
+    {
+        LOCKER(sockets_by_port().lock());
+        auto it = sockets_by_port().resource().find(tuple.local_port());
+        if (it == sockets_by_port().resource().end())
+            return { };
+        auto* bound_socket = (*it).value;
+        if (bound_socket->peer_port() != 0)
+            return { };
+        if (bound_socket->local_address() != IPv4Address() && bound_socket->local_address() != tuple.local_address())
+            return { };
+        socket = bound_socket;
+    }
+    return { move(socket) };
+}
+
 TCPSocketHandle TCPSocket::from_port(word port)
 {
     RetainPtr<TCPSocket> socket;
@@ -35,8 +74,16 @@ TCPSocket::TCPSocket(int protocol)
 
 TCPSocket::~TCPSocket()
 {
+    {
+        LOCKER(sockets_by_tuple().lock());
+        auto it = sockets_by_tuple().resource().find(tuple());
+        if (it != sockets_by_tuple().resource().end() && (*it).value == this)
+            sockets_by_tuple().resource().remove(tuple());
+    }
     LOCKER(sockets_by_port().lock());
-    sockets_by_port().resource().remove(local_port());
+    auto it = sockets_by_port().resource().find(local_port());
+    if (it != sockets_by_port().resource().end() && (*it).value == this)
+        sockets_by_port().resource().remove(local_port());
 }
 
 Retained<TCPSocket> TCPSocket::create(int protocol)
@@ -93,7 +140,9 @@ void TCPSocket::send_tcp_packet(word flags, const void* payload, int payload_siz
     }
 
     memcpy(tcp_packet.payload(), payload, payload_size);
-    tcp_packet.set_checksum(compute_tcp_checksum(adapter->ipv4_address(), peer_address(), tcp_packet, payload_size));
+    // Nothing can corrupt a packet that never leaves the machine.
+    if (!adapter->is_loopback())
+        tcp_packet.set_checksum(compute_tcp_checksum(adapter->ipv4_address(), peer_address(), tcp_packet, payload_size));
     kprintf("sending tcp packet from %s:%u to %s:%u with (%s %s) seq_no=%u, ack_no=%u\n",
         adapter->ipv4_address().to_string().characters(),
         local_port(),
@@ -154,7 +203,17 @@ KResult TCPSocket::protocol_connect(FileDescriptor& descriptor, ShouldBlock shou
     if (!adapter)
         return KResult(-EHOSTUNREACH);
 
-    allocate_local_port_if_needed();
+    set_local_address(adapter->ipv4_address());
+    int rc = allocate_local_port_if_needed();
+    if (rc < 0)
+        return KResult(rc);
+
+    {
+        LOCKER(sockets_by_tuple().lock());
+        if (sockets_by_tuple().resource().contains(tuple()))
+            return KResult(-EADDRINUSE);
+        sockets_by_tuple().resource().set(tuple(), this);
+    }
 
     m_sequence_number = 0;
     m_ack_number = 0;
@@ -25,6 +25,8 @@ public:
     void send_tcp_packet(word flags, const void* = nullptr, int = 0);
 
     static Lockable<HashMap<word, TCPSocket*>>& sockets_by_port();
+    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
+    static TCPSocketHandle from_tuple(const IPv4SocketTuple&);
     static TCPSocketHandle from_port(word);
 
 private:
@@ -36,7 +36,9 @@ UDPSocket::UDPSocket(int protocol)
 UDPSocket::~UDPSocket()
 {
     LOCKER(sockets_by_port().lock());
-    sockets_by_port().resource().remove(local_port());
+    auto it = sockets_by_port().resource().find(local_port());
+    if (it != sockets_by_port().resource().end() && (*it).value == this)
+        sockets_by_port().resource().remove(local_port());
 }
 
 Retained<UDPSocket> UDPSocket::create(int protocol)
@@ -17,6 +17,7 @@
 #include <Kernel/FileSystem/FIFO.h>
 #include "KSyms.h"
 #include <Kernel/Net/Socket.h>
+#include <Kernel/Net/LocalSocket.h>
 #include <Kernel/TTY/MasterPTY.h>
 #include <AK/ELF/exec_elf.h>
 #include <AK/ELF/ELFLoader.h>
@@ -24,6 +25,8 @@
 #include <AK/Time.h>
 #include <Kernel/SharedMemory.h>
 #include <Kernel/ProcessTracer.h>
+#include <Kernel/Futex.h>
+#include <Kernel/ReadinessQueue.h>
 
 //#define DEBUG_POLL_SELECT
 //#define DEBUG_IO
@@ -252,6 +255,7 @@ Process* Process::fork(RegisterDump& regs)
     child_tss.fs = regs.fs;
     child_tss.gs = regs.gs;
     child_tss.ss = regs.ss_if_crossRing;
+    child->main_thread().set_thread_specific_data(current->thread_specific_data());
 
 #ifdef FORK_DEBUG
     dbgprintf("fork: child will begin executing at %w:%x with stack %w:%x, kstack %w:%x\n", child_tss.cs, child_tss.eip, child_tss.ss, child_tss.esp, child_tss.ss0, child_tss.esp0);
@@ -402,8 +406,10 @@ int Process::do_exec(String path, Vector<String> arguments, Vector<String> envir
     main_thread().m_tss.ds = 0x23;
     main_thread().m_tss.es = 0x23;
     main_thread().m_tss.fs = 0x23;
-    main_thread().m_tss.gs = 0x23;
+    main_thread().m_tss.gs = GDT_SELECTOR_THREAD_SPECIFIC | 3;
     main_thread().m_tss.ss = 0x23;
+    main_thread().set_thread_specific_data({ });
+    main_thread().set_tid_address({ });
     main_thread().m_tss.cr3 = page_directory().cr3();
     main_thread().make_userspace_stack_for_main_thread(move(arguments), move(environment));
     main_thread().m_tss.ss0 = 0x10;
@@ -774,6 +780,18 @@ ssize_t Process::sys$get_dir_entries(int fd, void* buffer, ssize_t size)
     return descriptor->get_dir_entries((byte*)buffer, size);
 }
 
+ssize_t Process::sys$get_dir_entries_with_stat(int fd, void* buffer, ssize_t size)
+{
+    if (size < 0)
+        return -EINVAL;
+    if (!validate_write(buffer, size))
+        return -EFAULT;
+    auto* descriptor = file_descriptor(fd);
+    if (!descriptor)
+        return -EBADF;
+    return descriptor->get_dir_entries_with_stat((byte*)buffer, size);
+}
+
 int Process::sys$lseek(int fd, off_t offset, int whence)
 {
     auto* descriptor = file_descriptor(fd);
@@ -853,6 +871,139 @@ ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
     return nwritten;
 }
 
+// Checks the iovecs themselves and the memory they point to, returning the total length.
+static ssize_t validate_iovecs(Process& process, const struct iovec* iov, int iov_count, bool for_writing)
+{
+    if (iov_count < 0)
+        return -EINVAL;
+    if (!process.validate_read_typed(iov, iov_count))
+        return -EFAULT;
+    ssize_t total_length = 0;
+    for (int i = 0; i < iov_count; ++i) {
+        ssize_t length = iov[i].iov_len;
+        if (length < 0 || total_length + length < total_length)
+            return -EINVAL;
+        if (for_writing ? !process.validate_write(iov[i].iov_base, length) : !process.validate_read(iov[i].iov_base, length))
+            return -EFAULT;
+        total_length += length;
+    }
+    return total_length;
+}
+
+ssize_t Process::sys$readv(int fd, const struct iovec* iov, int iov_count)
+{
+    ssize_t total_length = validate_iovecs(*this, iov, iov_count, true);
+    if (total_length < 0)
+        return total_length;
+    if (total_length == 0)
+        return 0;
+    auto* descriptor = file_descriptor(fd);
+    if (!descriptor)
+        return -EBADF;
+    if (descriptor->is_blocking()) {
+        if (!descriptor->can_read()) {
+            current->block(Thread::State::BlockedRead, *descriptor);
+            if (current->m_was_interrupted_while_blocked)
+                return -EINTR;
+        }
+    }
+
+    if (descriptor->is_file()) {
+        // Pipes, sockets and devices have to see a single read, or a SOCK_SEQPACKET
+        // message would be split (and truncated) across the iovecs. Bounce it.
+        static const ssize_t max_bounce_size = 64 * KB;
+        auto buffer = ByteBuffer::create_uninitialized(min(total_length, max_bounce_size));
+        ssize_t nread = descriptor->read(buffer.pointer(), buffer.size());
+        if (nread <= 0)
+            return nread;
+        ssize_t offset = 0;
+        for (int i = 0; i < iov_count && offset < nread; ++i) {
+            ssize_t chunk = min((ssize_t)iov[i].iov_len, nread - offset);
+            memcpy(iov[i].iov_base, buffer.pointer() + offset, chunk);
+            offset += chunk;
+        }
+        return nread;
+    }
+
+    ssize_t nread = 0;
+    for (int i = 0; i < iov_count; ++i) {
+        ssize_t rc = descriptor->read((byte*)iov[i].iov_base, iov[i].iov_len);
+        if (rc < 0)
+            return nread ? nread : rc;
+        nread += rc;
+        if (rc < (ssize_t)iov[i].iov_len)
+            break;
+    }
+    return nread;
+}
+
+// preadv() and pwritev() only make sense for files with an offset, and never move it.
+static KResultOr<FileDescriptor*> positional_descriptor(Process& process, int fd, off_t offset)
+{
+    if (offset < 0)
+        return KResult(-EINVAL);
+    auto* descriptor = process.file_descriptor(fd);
+    if (!descriptor)
+        return KResult(-EBADF);
+    if (descriptor->is_file() || !descriptor->inode())
+        return KResult(-ESPIPE);
+    if (descriptor->is_directory())
+        return KResult(-EISDIR);
+    return descriptor;
+}
+
+ssize_t Process::sys$preadv(const Syscall::SC_preadv_params* params)
+{
+    if (!validate_read_typed(params))
+        return -EFAULT;
+    ssize_t total_length = validate_iovecs(*this, params->iov, params->iov_count, true);
+    if (total_length < 0)
+        return total_length;
+    auto descriptor_or_error = positional_descriptor(*this, params->fd, params->offset);
+    if (descriptor_or_error.is_error())
+        return descriptor_or_error.error();
+    auto& descriptor = *descriptor_or_error.value();
+
+    off_t offset = params->offset;
+    ssize_t nread = 0;
+    for (int i = 0; i < params->iov_count; ++i) {
+        auto& iov = params->iov[i];
+        ssize_t rc = descriptor.read_at(offset + nread, (byte*)iov.iov_base, iov.iov_len);
+        if (rc < 0)
+            return nread ? nread : rc;
+        nread += rc;
+        if (rc < (ssize_t)iov.iov_len)
+            break;
+    }
+    return nread;
+}
+
+ssize_t Process::sys$pwritev(const Syscall::SC_pwritev_params* params)
+{
+    if (!validate_read_typed(params))
+        return -EFAULT;
+    ssize_t total_length = validate_iovecs(*this, params->iov, params->iov_count, false);
+    if (total_length < 0)
+        return total_length;
+    auto descriptor_or_error = positional_descriptor(*this, params->fd, params->offset);
+    if (descriptor_or_error.is_error())
+        return descriptor_or_error.error();
+    auto& descriptor = *descriptor_or_error.value();
+
+    off_t offset = params->offset;
+    ssize_t nwritten = 0;
+    for (int i = 0; i < params->iov_count; ++i) {
+        auto& iov = params->iov[i];
+        ssize_t rc = descriptor.write_at(offset + nwritten, (const byte*)iov.iov_base, iov.iov_len);
+        if (rc < 0)
+            return nwritten ? nwritten : rc;
+        nwritten += rc;
+        if (rc < (ssize_t)iov.iov_len)
+            break;
+    }
+    return nwritten;
+}
+
 ssize_t Process::do_write(FileDescriptor& descriptor, const byte* data, int data_size)
 {
     ssize_t nwritten = 0;
@@ -873,6 +1024,9 @@ ssize_t Process::do_write(FileDescriptor& descriptor, const byte* data, int data
         dbgprintf("while %u < %u\n", nwritten, size);
 #endif
         if (!descriptor.can_write()) {
+            // Sockets have a bounded buffer, so a non-blocking write may come up short.
+            if (!descriptor.is_blocking())
+                break;
 #ifdef IO_DEBUG
             dbgprintf("block write on %d\n", fd);
 #endif
@@ -899,6 +1053,97 @@ ssize_t Process::do_write(FileDescriptor& descriptor, const byte* data, int data
     return nwritten;
 }
 
+// Writes out what Inode::read_slices() handed us. Runs of whole blocks go by reference to
+// a filesystem that can take them that way; everything else (including sockets and pipes)
+// is written straight out of the slice, so the data is copied at most once.
+ssize_t Process::send_slices(FileDescriptor& destination, const Vector<InodeSlice>& slices)
+{
+    int block_size = 0;
+    if (!destination.is_file() && destination.inode() && !destination.should_append())
+        block_size = destination.inode()->shareable_block_size();
+
+    auto is_whole_block = [block_size](const InodeSlice& slice) {
+        return slice.offset == 0 && slice.length == block_size && slice.buffer.size() == block_size;
+    };
+
+    ssize_t nwritten = 0;
+    int i = 0;
+    while (i < slices.size()) {
+        if (block_size && !(destination.offset() % block_size) && is_whole_block(slices[i])) {
+            Vector<ByteBuffer> blocks;
+            while (i < slices.size() && is_whole_block(slices[i]))
+                blocks.append(slices[i++].buffer);
+            ssize_t rc = destination.write_shared_blocks(blocks);
+            if (rc < 0)
+                return nwritten ? nwritten : rc;
+            nwritten += rc;
+            continue;
+        }
+        auto& slice = slices[i++];
+        ssize_t rc = do_write(destination, slice.buffer.pointer() + slice.offset, slice.length);
+        if (rc < 0)
+            return nwritten ? nwritten : rc;
+        nwritten += rc;
+        if (rc < slice.length)
+            break;
+    }
+    return nwritten;
+}
+
+ssize_t Process::sys$sendfile(const Syscall::SC_sendfile_params* params)
+{
+    if (!validate_read_typed(params))
+        return -EFAULT;
+    auto* user_offset = params->offset;
+    if (user_offset && !validate_write_typed(user_offset))
+        return -EFAULT;
+    ssize_t count = min(params->count, (size_t)0x7fffffff);
+    auto* source = file_descriptor(params->in_fd);
+    auto* destination = file_descriptor(params->out_fd);
+    if (!source || !destination)
+        return -EBADF;
+    // The source has to be something we can read at an offset: a regular file.
+    // Pipes and sockets aren't, and callers are expected to fall back to read() and write().
+    if (source->is_file() || !source->inode())
+        return -EINVAL;
+    if (source->is_directory())
+        return -EISDIR;
+
+    off_t offset = user_offset ? *user_offset : source->offset();
+    if (offset < 0)
+        return -EINVAL;
+
+    static const ssize_t max_chunk_size = 64 * KB;
+    auto& inode = *source->inode();
+    ssize_t nsent = 0;
+    ssize_t error = 0;
+    while (nsent < count) {
+        Vector<InodeSlice> slices;
+        ssize_t nread = inode.read_slices(offset, min(count - nsent, max_chunk_size), slices, source);
+        if (nread <= 0) {
+            error = nread;
+            break;
+        }
+        ssize_t nwritten = send_slices(*destination, slices);
+        if (nwritten < 0) {
+            error = nwritten;
+            break;
+        }
+        offset += nwritten;
+        nsent += nwritten;
+        if (nwritten < nread || current->has_unmasked_pending_signals())
+            break;
+    }
+
+    if (user_offset)
+        *user_offset = offset;
+    else
+        source->seek(offset, SEEK_SET);
+    if (!nsent && error < 0)
+        return error;
+    return nsent;
+}
+
 ssize_t Process::sys$write(int fd, const byte* data, ssize_t size)
 {
     if (size < 0)
@@ -2228,6 +2473,217 @@ ssize_t Process::sys$recvfrom(const Syscall::SC_recvfrom_params* params)
     return nrecv;
 }
 
+// sendmsg() and recvmsg() copy through a kernel buffer of at most this size, however
+// much memory the caller's iovecs describe.
+static const size_t msg_bounce_buffer_size = LocalSocket::max_message_size;
+
+// Walks a validated iovec array, copying a contiguous run of bytes to or from it.
+class IovecCursor {
+public:
+    explicit IovecCursor(const struct iovec* iov)
+        : m_iov(iov)
+    {
+    }
+
+    void gather(byte* buffer, size_t size)
+    {
+        walk(size, [&](byte* iov_data, size_t offset, size_t chunk) { memcpy(buffer + offset, iov_data, chunk); });
+    }
+
+    void scatter(const byte* buffer, size_t size)
+    {
+        walk(size, [&](byte* iov_data, size_t offset, size_t chunk) { memcpy(iov_data, buffer + offset, chunk); });
+    }
+
+private:
+    template<typename Callback>
+    void walk(size_t size, Callback callback)
+    {
+        size_t done = 0;
+        while (done < size) {
+            auto& iov = *m_iov;
+            size_t chunk = min(iov.iov_len - m_offset, size - done);
+            callback((byte*)iov.iov_base + m_offset, done, chunk);
+            done += chunk;
+            m_offset += chunk;
+            if (m_offset == iov.iov_len) {
+                ++m_iov;
+                m_offset = 0;
+            }
+        }
+    }
+
+    const struct iovec* m_iov { nullptr };
+    size_t m_offset { 0 };
+};
+
+ssize_t Process::sys$sendmsg(int sockfd, const struct msghdr* msg, int flags)
+{
+    if (!validate_read_typed(msg))
+        return -EFAULT;
+    if (msg->msg_name && !validate_read(msg->msg_name, msg->msg_namelen))
+        return -EFAULT;
+    if (msg->msg_control && !validate_read(msg->msg_control, msg->msg_controllen))
+        return -EFAULT;
+    ssize_t total_length = validate_iovecs(*this, msg->msg_iov, msg->msg_iovlen, false);
+    if (total_length < 0)
+        return total_length;
+    size_t total_size = total_length;
+
+    auto* descriptor = file_descriptor(sockfd);
+    if (!descriptor)
+        return -EBADF;
+    if (!descriptor->is_socket())
+        return -ENOTSOCK;
+    auto& socket = *descriptor->socket();
+
+    Vector<RetainPtr<FileDescriptor>> passed_descriptors;
+    if (msg->msg_control) {
+        auto* control = (const byte*)msg->msg_control;
+        size_t offset = 0;
+        while (offset + sizeof(cmsghdr) <= msg->msg_controllen) {
+            auto& cmsg = *(const cmsghdr*)(control + offset);
+            if (cmsg.cmsg_len < sizeof(cmsghdr) || offset + cmsg.cmsg_len > msg->msg_controllen)
+                return -EINVAL;
+            if (cmsg.cmsg_level != SOL_SOCKET || cmsg.cmsg_type != SCM_RIGHTS)
+                return -EINVAL;
+            auto* fds = (const int*)((const byte*)&cmsg + CMSG_LEN(0));
+            int fd_count = (cmsg.cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (int i = 0; i < fd_count; ++i) {
+                auto* passed_descriptor = file_descriptor(fds[i]);
+                if (!passed_descriptor)
+                    return -EBADF;
+                passed_descriptors.append(passed_descriptor);
+            }
+            offset += CMSG_ALIGN(cmsg.cmsg_len);
+        }
+    }
+    if (!passed_descriptors.is_empty() && !socket.is_local())
+        return -EOPNOTSUPP;
+
+    // The message goes through a bounded bounce buffer. Anything but a stream has to
+    // reach the socket in one piece, so it has to fit; streams go out a chunk at a time.
+    if (socket.type() != SOCK_STREAM && total_size > msg_bounce_buffer_size)
+        return -EMSGSIZE;
+    auto buffer = ByteBuffer::create_uninitialized(min(total_size, msg_bounce_buffer_size));
+    IovecCursor cursor(msg->msg_iov);
+
+    bool original_blocking = descriptor->is_blocking();
+    if (flags & MSG_DONTWAIT)
+        descriptor->set_blocking(false);
+
+    ssize_t nsent = 0;
+    do {
+        size_t chunk_size = min(total_size - nsent, (size_t)buffer.size());
+        cursor.gather(buffer.pointer(), chunk_size);
+        ssize_t rc;
+        if (socket.is_local()) {
+            // The descriptors travel with the first chunk only.
+            Vector<RetainPtr<FileDescriptor>> descriptors_for_chunk;
+            if (!nsent)
+                descriptors_for_chunk = move(passed_descriptors);
+            rc = static_cast<LocalSocket&>(socket).send_with_descriptors(*descriptor, buffer.pointer(), chunk_size, move(descriptors_for_chunk));
+        } else {
+            rc = socket.sendto(*descriptor, buffer.pointer(), chunk_size, flags, (const sockaddr*)msg->msg_name, msg->msg_namelen);
+        }
+        if (rc < 0) {
+            if (!nsent)
+                nsent = rc;
+            break;
+        }
+        nsent += rc;
+        if ((size_t)rc < chunk_size)
+            break;
+    } while ((size_t)nsent < total_size);
+
+    if (flags & MSG_DONTWAIT)
+        descriptor->set_blocking(original_blocking);
+    return nsent;
+}
+
+ssize_t Process::sys$recvmsg(int sockfd, struct msghdr* msg, int flags)
+{
+    if (!validate_write_typed(msg))
+        return -EFAULT;
+    if (msg->msg_name && !validate_write(msg->msg_name, msg->msg_namelen))
+        return -EFAULT;
+    if (msg->msg_control && !validate_write(msg->msg_control, msg->msg_controllen))
+        return -EFAULT;
+    ssize_t total_length = validate_iovecs(*this, msg->msg_iov, msg->msg_iovlen, true);
+    if (total_length < 0)
+        return total_length;
+    size_t total_size = total_length;
+
+    auto* descriptor = file_descriptor(sockfd);
+    if (!descriptor)
+        return -EBADF;
+    if (!descriptor->is_socket())
+        return -ENOTSOCK;
+    auto& socket = *descriptor->socket();
+
+    bool original_blocking = descriptor->is_blocking();
+    if (flags & MSG_DONTWAIT)
+        descriptor->set_blocking(false);
+
+    // No socket hands out more than msg_bounce_buffer_size in one go (a SOCK_SEQPACKET
+    // message is at most LocalSocket::max_message_size), so a stream just sees a short read.
+    auto buffer = ByteBuffer::create_uninitialized(min(total_size, msg_bounce_buffer_size));
+    Vector<RetainPtr<FileDescriptor>> passed_descriptors;
+    bool truncated = false;
+    ssize_t nrecv;
+    if (socket.is_local()) {
+        nrecv = static_cast<LocalSocket&>(socket).receive_with_descriptors(*descriptor, buffer.pointer(), buffer.size(), &passed_descriptors, &truncated);
+    } else {
+        auto* addr = (sockaddr*)msg->msg_name;
+        socklen_t addr_length = msg->msg_namelen;
+        nrecv = socket.recvfrom(*descriptor, buffer.pointer(), buffer.size(), flags, addr, addr ? &addr_length : nullptr);
+        if (addr)
+            msg->msg_namelen = addr_length;
+    }
+
+    if (flags & MSG_DONTWAIT)
+        descriptor->set_blocking(original_blocking);
+    if (nrecv < 0)
+        return nrecv;
+
+    // Scatter the received data back over the caller's buffers.
+    IovecCursor(msg->msg_iov).scatter(buffer.pointer(), nrecv);
+
+    msg->msg_flags = truncated ? MSG_TRUNC : 0;
+
+    socklen_t control_size = 0;
+    if (!passed_descriptors.is_empty()) {
+        int fd_capacity = 0;
+        if (msg->msg_control && msg->msg_controllen >= CMSG_LEN(0))
+            fd_capacity = (msg->msg_controllen - CMSG_LEN(0)) / sizeof(int);
+        int fd_count = min(fd_capacity, passed_descriptors.size());
+        if (fd_count < passed_descriptors.size())
+            msg->msg_flags |= MSG_CTRUNC;
+        if (fd_count) {
+            auto& cmsg = *(cmsghdr*)msg->msg_control;
+            auto* fds = (int*)CMSG_DATA(&cmsg);
+            int installed = 0;
+            for (; installed < fd_count; ++installed) {
+                int fd = alloc_fd();
+                if (fd < 0) {
+                    msg->msg_flags |= MSG_CTRUNC;
+                    break;
+                }
+                m_fds[fd].set(*passed_descriptors[installed]);
+                fds[installed] = fd;
+            }
+            cmsg.cmsg_level = SOL_SOCKET;
+            cmsg.cmsg_type = SCM_RIGHTS;
+            cmsg.cmsg_len = CMSG_LEN(installed * sizeof(int));
+            control_size = cmsg.cmsg_len;
+        }
+    }
+    if (msg->msg_control)
+        msg->msg_controllen = control_size;
+
+    return nrecv;
+}
+
 int Process::sys$getsockname(int sockfd, sockaddr* addr, socklen_t* addrlen)
 {
     if (!validate_read_typed(addrlen))
@@ -2302,7 +2758,7 @@ int Process::sys$getsockopt(const Syscall::SC_getsockopt_params* params)
     if (!descriptor->is_socket())
         return -ENOTSOCK;
     auto& socket = *descriptor->socket();
-    return socket.getsockopt(level, option, value, value_size);
+    return socket.getsockopt(*descriptor, level, option, value, value_size);
 }
 
 int Process::sys$setsockopt(const Syscall::SC_setsockopt_params* params)
@@ -2335,6 +2791,14 @@ struct SharedBuffer {
         ASSERT(pid1 != pid2);
     }
 
+    SharedBuffer(pid_t pid1, pid_t pid2, Retained<VMObject>&& vmo)
+        : m_pid1(pid1)
+        , m_pid2(pid2)
+        , m_vmo(move(vmo))
+    {
+        ASSERT(pid1 != pid2);
+    }
+
     void* retain(Process& process)
     {
         if (m_pid1 == process.pid()) {
@@ -2486,6 +2950,36 @@ int Process::sys$create_shared_buffer(pid_t peer_pid, int size, void** buffer)
     return shared_buffer_id;
 }
 
+// Hands out another buffer ID for the same memory, for sharing with a third process.
+// The new buffer is read-only for the peer, and the caller's side of it is not mapped,
+// since the caller already has the memory mapped through the original buffer.
+int Process::sys$share_buffer_with(int shared_buffer_id, pid_t peer_pid)
+{
+    if (!peer_pid || peer_pid < 0 || peer_pid == m_pid)
+        return -EINVAL;
+    {
+        InterruptDisabler disabler;
+        auto* peer = Process::from_pid(peer_pid);
+        if (!peer)
+            return -ESRCH;
+    }
+    LOCKER(shared_buffers().lock());
+    auto it = shared_buffers().resource().find(shared_buffer_id);
+    if (it == shared_buffers().resource().end())
+        return -EINVAL;
+    auto& original = *(*it).value;
+    if (original.pid1() != m_pid && original.pid2() != m_pid)
+        return -EINVAL;
+    int new_shared_buffer_id = ++s_next_shared_buffer_id;
+    auto shared_buffer = make<SharedBuffer>(m_pid, peer_pid, original.m_vmo.copy_ref());
+    shared_buffer->m_shared_buffer_id = new_shared_buffer_id;
+#ifdef SHARED_BUFFER_DEBUG
+    kprintf("%s(%u): Shared buffer %d with %d as %d\n", name().characters(), pid(), shared_buffer_id, peer_pid, new_shared_buffer_id);
+#endif
+    shared_buffers().resource().set(new_shared_buffer_id, move(shared_buffer));
+    return new_shared_buffer_id;
+}
+
 int Process::sys$release_shared_buffer(int shared_buffer_id)
 {
     LOCKER(shared_buffers().lock());
@@ -2585,23 +3079,54 @@ int Process::thread_count() const
     return count;
 }
 
-int Process::sys$create_thread(int(*entry)(void*), void* argument)
+int Process::sys$create_thread(int(*entry)(void*), void* argument, const Syscall::SC_create_thread_params* params)
 {
     if (!validate_read((const void*)entry, sizeof(void*)))
         return -EFAULT;
+    if (params) {
+        if (!validate_read_typed(params))
+            return -EFAULT;
+        if (params->stack_location) {
+            if (params->stack_size < 64 || !validate_write(params->stack_location, params->stack_size))
+                return -EFAULT;
+        }
+        if (params->tid_address && !validate_write_typed(params->tid_address))
+            return -EFAULT;
+    }
     auto* thread = new Thread(*this);
     auto& tss = thread->tss();
     tss.eip = (dword)entry;
     tss.eflags = 0x0202;
     tss.cr3 = page_directory().cr3();
-    thread->make_userspace_stack_for_secondary_thread(argument);
+    if (params && params->stack_location)
+        thread->make_userspace_stack_for_secondary_thread(argument, LinearAddress((dword)params->stack_location), params->stack_size);
+    else
+        thread->make_userspace_stack_for_secondary_thread(argument);
+
+    if (params) {
+        thread->set_thread_specific_data(LinearAddress((dword)params->thread_specific_data));
+        if (params->tid_address) {
+            // Publish the TID before the thread can run, so a joiner never sees a stale 0.
+            *params->tid_address = thread->tid();
+            thread->set_tid_address(LinearAddress((dword)params->tid_address));
+        }
+    }
 
     thread->set_state(Thread::State::Runnable);
-    return 0;
+    return thread->tid();
 }
 
 void Process::sys$exit_thread(int code)
 {
+    auto tid_address = current->tid_address();
+    if (!tid_address.is_null()) {
+        if (validate_write_typed((int*)tid_address.as_ptr())) {
+            *(int*)tid_address.as_ptr() = 0;
+            auto key = futex_key_for(tid_address);
+            if (!key.is_null())
+                Futex::wake(key, 1);
+        }
+    }
     cli();
     if (&current->process().main_thread() == current) {
         sys$exit(code);
@@ -2613,6 +3138,133 @@ void Process::sys$exit_thread(int code)
     ASSERT_NOT_REACHED();
 }
 
+int Process::sys$set_thread_specific_data(void* data)
+{
+    InterruptDisabler disabler;
+    current->set_thread_specific_data(LinearAddress((dword)data));
+    // The syscall return path reloads %gs, picking up the new base right away.
+    Scheduler::load_thread_specific_data(*current);
+    return 0;
+}
+
+FutexKey Process::futex_key_for(LinearAddress laddr)
+{
+    for (auto& region : m_regions) {
+        if (region->contains(laddr))
+            return { &region->vmo(), (dword)(region->first_page_index() * PAGE_SIZE) + (laddr - region->laddr()).get() };
+    }
+    return { };
+}
+
+int Process::sys$futex(const Syscall::SC_futex_params* params)
+{
+    if (!validate_read_typed(params))
+        return -EFAULT;
+    int* userspace_address = params->userspace_address;
+    if (!validate_read_typed(userspace_address))
+        return -EFAULT;
+    if ((dword)userspace_address & 3)
+        return -EINVAL;
+    auto key = futex_key_for(LinearAddress((dword)userspace_address));
+    if (key.is_null())
+        return -EFAULT;
+
+    switch (params->futex_op) {
+    case FUTEX_WAIT:
+        if (params->timeout && !validate_read_typed(params->timeout))
+            return -EFAULT;
+        return Futex::wait(*current, key, userspace_address, params->val, params->timeout);
+    case FUTEX_WAKE:
+        return Futex::wake(key, params->val);
+    case FUTEX_REQUEUE: {
+        int* userspace_address2 = params->userspace_address2;
+        if (!validate_read_typed(userspace_address2))
+            return -EFAULT;
+        if ((dword)userspace_address2 & 3)
+            return -EINVAL;
+        auto key2 = futex_key_for(LinearAddress((dword)userspace_address2));
+        if (key2.is_null())
+            return -EFAULT;
+        return Futex::requeue(key, params->val, key2, params->val2);
+    }
+    }
+    return -ENOSYS;
+}
+
+int Process::sys$epoll_create(int flags)
+{
+    if (flags & ~EPOLL_CLOEXEC)
+        return -EINVAL;
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+    auto descriptor = FileDescriptor::create(ReadinessQueue::create().ptr());
+    m_fds[fd].set(move(descriptor), (flags & EPOLL_CLOEXEC) ? FD_CLOEXEC : 0);
+    return fd;
+}
+
+int Process::sys$epoll_ctl(const Syscall::SC_epoll_ctl_params* params)
+{
+    if (!validate_read_typed(params))
+        return -EFAULT;
+    auto* queue_descriptor = file_descriptor(params->epfd);
+    if (!queue_descriptor)
+        return -EBADF;
+    auto* file = queue_descriptor->file();
+    if (!file || !file->is_readiness_queue())
+        return -EINVAL;
+    auto& queue = static_cast<ReadinessQueue&>(*file);
+
+    int fd = params->fd;
+    auto* descriptor = file_descriptor(fd);
+    if (!descriptor)
+        return -EBADF;
+
+    if (params->op == EPOLL_CTL_DEL)
+        return queue.remove(fd);
+
+    if (!validate_read_typed(params->event))
+        return -EFAULT;
+    epoll_event event = *params->event;
+    switch (params->op) {
+    case EPOLL_CTL_ADD:
+        return queue.add(fd, *descriptor, event);
+    case EPOLL_CTL_MOD:
+        return queue.modify(fd, *descriptor, event);
+    }
+    return -EINVAL;
+}
+
+int Process::sys$epoll_wait(const Syscall::SC_epoll_wait_params* params)
+{
+    if (!validate_read_typed(params))
+        return -EFAULT;
+    int max_events = params->max_events;
+    if (max_events <= 0)
+        return -EINVAL;
+    // Anything that's still ready will be reported again on the next call.
+    if (max_events > 1024)
+        max_events = 1024;
+    if (!validate_write_typed(params->events, max_events))
+        return -EFAULT;
+    auto* queue_descriptor = file_descriptor(params->epfd);
+    if (!queue_descriptor)
+        return -EBADF;
+    auto* file = queue_descriptor->file();
+    if (!file || !file->is_readiness_queue())
+        return -EINVAL;
+    // Keep the queue alive across the block, even if another thread closes it.
+    Retained<File> retained_file(*file);
+    auto& queue = static_cast<ReadinessQueue&>(*file);
+
+    Vector<epoll_event> events;
+    events.resize(max_events);
+    int count = queue.wait(*current, events.data(), max_events, params->timeout);
+    if (count > 0)
+        memcpy(params->events, events.data(), count * sizeof(epoll_event));
+    return count;
+}
+
 int Process::sys$gettid()
 {
     return current->tid();
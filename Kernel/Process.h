@@ -21,6 +21,7 @@ class PageDirectory;
 class Region;
 class VMObject;
 class ProcessTracer;
+struct InodeSlice;
 
 void kgettimeofday(timeval&);
 
@@ -178,9 +179,21 @@ public:
     int sys$setsockopt(const Syscall::SC_setsockopt_params*);
     int sys$getsockname(int sockfd, sockaddr* addr, socklen_t* addrlen);
     int sys$getpeername(int sockfd, sockaddr* addr, socklen_t* addrlen);
+    ssize_t sys$sendmsg(int sockfd, const struct msghdr*, int flags);
+    ssize_t sys$recvmsg(int sockfd, struct msghdr*, int flags);
     int sys$restore_signal_mask(dword mask);
-    int sys$create_thread(int(*)(void*), void*);
+    int sys$create_thread(int(*)(void*), void*, const Syscall::SC_create_thread_params*);
     void sys$exit_thread(int code);
+    int sys$set_thread_specific_data(void*);
+    int sys$futex(const Syscall::SC_futex_params*);
+    int sys$epoll_create(int flags);
+    int sys$epoll_ctl(const Syscall::SC_epoll_ctl_params*);
+    int sys$epoll_wait(const Syscall::SC_epoll_wait_params*);
+    ssize_t sys$readv(int fd, const struct iovec* iov, int iov_count);
+    ssize_t sys$preadv(const Syscall::SC_preadv_params*);
+    ssize_t sys$pwritev(const Syscall::SC_pwritev_params*);
+    ssize_t sys$get_dir_entries_with_stat(int fd, void*, ssize_t);
+    ssize_t sys$sendfile(const Syscall::SC_sendfile_params*);
     int sys$rename(const char* oldpath, const char* newpath);
     int sys$systrace(pid_t);
     int sys$mknod(const char* pathname, mode_t, dev_t);
@@ -189,6 +202,7 @@ public:
     int sys$release_shared_buffer(int shared_buffer_id);
     int sys$seal_shared_buffer(int shared_buffer_id);
     int sys$get_shared_buffer_size(int shared_buffer_id);
+    int sys$share_buffer_with(int shared_buffer_id, pid_t peer_pid);
 
     static void initialize();
 
@@ -265,6 +279,7 @@ private:
 
     int do_exec(String path, Vector<String> arguments, Vector<String> environment);
     ssize_t do_write(FileDescriptor&, const byte*, int data_size);
+    ssize_t send_slices(FileDescriptor&, const Vector<InodeSlice>&);
 
     int alloc_fd(int first_candidate_fd = 0);
     void disown_all_shared_buffers();
@@ -311,6 +326,7 @@ private:
     TTY* m_tty { nullptr };
 
     Region* region_from_range(LinearAddress, size_t);
+    FutexKey futex_key_for(LinearAddress);
 
     Vector<Retained<Region>> m_regions;
 
@@ -0,0 +1,217 @@
+#include <Kernel/FileSystem/FileDescriptor.h>
+#include <Kernel/Process.h>
+#include <Kernel/ReadinessQueue.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Thread.h>
+#include <Kernel/i8253.h>
+#include <LibC/errno_numbers.h>
+
+//#define READINESS_QUEUE_DEBUG
+
+Retained<ReadinessQueue> ReadinessQueue::create()
+{
+    return adopt(*new ReadinessQueue);
+}
+
+ReadinessQueue::ReadinessQueue()
+{
+}
+
+ReadinessQueue::~ReadinessQueue()
+{
+    // Nobody can be waiting on us; they'd be holding a reference.
+    ASSERT(m_waiters.is_empty());
+    while (!m_watches.is_empty())
+        detach(*(*m_watches.begin()).value);
+}
+
+void ReadinessQueue::list(ReadinessWatch& watch)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (watch.is_listed)
+        return;
+    m_ready.append(&watch);
+    watch.is_listed = true;
+}
+
+void ReadinessQueue::unlist(ReadinessWatch& watch)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (!watch.is_listed)
+        return;
+    m_ready.remove(&watch);
+    watch.is_listed = false;
+}
+
+// Unhooks the watch from everything and frees it.
+void ReadinessQueue::detach(ReadinessWatch& watch)
+{
+    InterruptDisabler disabler;
+    unlist(watch);
+    watch.descriptor->remove_readiness_watch(watch);
+    if (auto* file = watch.descriptor->file())
+        file->remove_readiness_watch(watch);
+    m_watches.remove(watch.fd);
+}
+
+KResult ReadinessQueue::add(int fd, FileDescriptor& descriptor, const epoll_event& event)
+{
+    if (descriptor.file() == this)
+        return KResult(-EINVAL);
+    auto it = m_watches.find(fd);
+    if (it != m_watches.end()) {
+        if ((*it).value->descriptor == &descriptor)
+            return KResult(-EEXIST);
+        // The fd was closed and reused, but the old description lives on elsewhere (say, in a child.)
+        // That watch is stale, so replace it.
+        detach(*(*it).value);
+    }
+
+    auto watch = make<ReadinessWatch>();
+    watch->queue = this;
+    watch->descriptor = &descriptor;
+    watch->fd = fd;
+    watch->events = event.events;
+    watch->data = event.data;
+    auto& watch_ref = *watch;
+    m_watches.set(fd, move(watch));
+    descriptor.add_readiness_watch(watch_ref);
+    if (auto* file = descriptor.file())
+        file->add_readiness_watch(watch_ref);
+
+    // Have the next wait look at it, in case it's already ready.
+    watch_did_change(watch_ref);
+#ifdef READINESS_QUEUE_DEBUG
+    dbgprintf("ReadinessQueue{%p}: watching fd %d for %x\n", this, fd, event.events);
+#endif
+    return KSuccess;
+}
+
+KResult ReadinessQueue::modify(int fd, FileDescriptor& descriptor, const epoll_event& event)
+{
+    auto it = m_watches.find(fd);
+    if (it == m_watches.end())
+        return KResult(-ENOENT);
+    auto& watch = *(*it).value;
+    if (watch.descriptor != &descriptor)
+        return add(fd, descriptor, event);
+    {
+        InterruptDisabler disabler;
+        watch.events = event.events;
+        watch.data = event.data;
+    }
+    watch_did_change(watch);
+    return KSuccess;
+}
+
+KResult ReadinessQueue::remove(int fd)
+{
+    auto it = m_watches.find(fd);
+    if (it == m_watches.end())
+        return KResult(-ENOENT);
+    detach(*(*it).value);
+    return KSuccess;
+}
+
+void ReadinessQueue::forget(ReadinessWatch& watch)
+{
+    ASSERT(watch.queue == this);
+#ifdef READINESS_QUEUE_DEBUG
+    dbgprintf("ReadinessQueue{%p}: fd %d went away\n", this, watch.fd);
+#endif
+    detach(watch);
+}
+
+void ReadinessQueue::watch_did_change(ReadinessWatch& watch)
+{
+    InterruptDisabler disabler;
+    bool was_empty = m_ready.is_empty();
+    list(watch);
+    for (auto* thread : m_waiters) {
+        if (thread->state() == Thread::BlockedReadiness)
+            thread->unblock();
+    }
+    // We may be watched ourselves.
+    if (was_empty)
+        did_change_readiness();
+}
+
+bool ReadinessQueue::can_read(FileDescriptor&) const
+{
+    return !m_ready.is_empty();
+}
+
+// Level-triggered: a watch stays on the ready list for as long as it's found to be ready.
+int ReadinessQueue::collect(epoll_event* events, int max_events)
+{
+    InterruptDisabler disabler;
+    InlineLinkedList<ReadinessWatch> still_ready;
+    int count = 0;
+    while (count < max_events && !m_ready.is_empty()) {
+        auto* watch = m_ready.remove_head();
+        dword ready_events = 0;
+        if ((watch->events & EPOLLIN) && watch->descriptor->can_read())
+            ready_events |= EPOLLIN;
+        if ((watch->events & EPOLLOUT) && watch->descriptor->can_write())
+            ready_events |= EPOLLOUT;
+        if (!ready_events) {
+            watch->is_listed = false;
+            continue;
+        }
+        events[count].events = ready_events;
+        events[count].data = watch->data;
+        ++count;
+        still_ready.append(watch);
+    }
+    // Put the ones we reported at the back, so a busy descriptor can't starve the others.
+    m_ready.append(still_ready);
+    return count;
+}
+
+int ReadinessQueue::wait(Thread& thread, epoll_event* events, int max_events, int timeout)
+{
+    ASSERT(&thread == current);
+    qword deadline = 0;
+    if (timeout > 0)
+        deadline = g_uptime + (timeout * TICKS_PER_SECOND + 999) / 1000;
+
+    for (;;) {
+        int count = collect(events, max_events);
+        if (count || !timeout)
+            return count;
+        if (timeout > 0 && g_uptime >= deadline)
+            return 0;
+
+        {
+            // Anything that makes a watch ready does so with interrupts disabled,
+            // so it can't slip in between the check and the block.
+            InterruptDisabler disabler;
+            if (!m_ready.is_empty())
+                continue;
+            m_waiters.append(&thread);
+            thread.m_waiting_readiness_queue = this;
+            thread.m_readiness_has_timeout = timeout > 0;
+            thread.m_wakeup_time = deadline;
+            thread.block(Thread::BlockedReadiness);
+            m_waiters.remove_first_matching([&](auto* waiter) { return waiter == &thread; });
+            thread.m_waiting_readiness_queue = nullptr;
+        }
+        if (thread.was_interrupted_while_blocked())
+            return -EINTR;
+    }
+}
+
+void ReadinessQueue::remove_waiter(Thread& thread)
+{
+    InterruptDisabler disabler;
+    auto* queue = thread.m_waiting_readiness_queue;
+    if (!queue)
+        return;
+    queue->m_waiters.remove_first_matching([&](auto* waiter) { return waiter == &thread; });
+    thread.m_waiting_readiness_queue = nullptr;
+}
+
+String ReadinessQueue::absolute_path(FileDescriptor&) const
+{
+    return String::format("epoll:%p", this);
+}
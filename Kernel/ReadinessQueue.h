@@ -0,0 +1,75 @@
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/InlineLinkedList.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/File.h>
+#include <Kernel/UnixTypes.h>
+
+class FileDescriptor;
+class ReadinessQueue;
+class Thread;
+
+// One file descriptor being watched by a ReadinessQueue.
+// It's linked into the queue's ready list whenever its File says its state
+// may have changed; the queue checks whether it's actually ready at wait time.
+struct ReadinessWatch : public InlineLinkedListNode<ReadinessWatch> {
+    ReadinessQueue* queue { nullptr };
+    FileDescriptor* descriptor { nullptr };
+    int fd { -1 };
+    dword events { 0 };
+    epoll_data_t data;
+    bool is_listed { false };
+
+    ReadinessWatch* m_prev { nullptr };
+    ReadinessWatch* m_next { nullptr };
+};
+
+// The kernel side of epoll: a set of watched file descriptors, and a list of
+// the ones that may be ready. Waiting costs O(ready) instead of the O(watched)
+// that select() and poll() pay on every call (and the scheduler on every tick.)
+// Only level-triggered EPOLLIN/EPOLLOUT are supported.
+class ReadinessQueue final : public File {
+public:
+    static Retained<ReadinessQueue> create();
+    virtual ~ReadinessQueue() override;
+
+    KResult add(int fd, FileDescriptor&, const epoll_event&);
+    KResult modify(int fd, FileDescriptor&, const epoll_event&);
+    KResult remove(int fd);
+
+    // Returns how many events were stored, or a negative error.
+    // A negative timeout (in milliseconds) waits forever.
+    int wait(Thread&, epoll_event* events, int max_events, int timeout);
+
+    // Called by File when a watched descriptor's state may have changed.
+    void watch_did_change(ReadinessWatch&);
+
+    // Called by FileDescriptor when a watched descriptor goes away.
+    void forget(ReadinessWatch&);
+
+    // Called when a thread dies while it's waiting.
+    static void remove_waiter(Thread&);
+
+    // ^File
+    virtual bool can_read(FileDescriptor&) const override;
+    virtual bool can_write(FileDescriptor&) const override { return false; }
+    virtual ssize_t read(FileDescriptor&, byte*, ssize_t) override { return -EINVAL; }
+    virtual ssize_t write(FileDescriptor&, const byte*, ssize_t) override { return -EINVAL; }
+    virtual String absolute_path(FileDescriptor&) const override;
+    virtual const char* class_name() const override { return "ReadinessQueue"; }
+    virtual bool is_readiness_queue() const override { return true; }
+
+private:
+    ReadinessQueue();
+
+    void list(ReadinessWatch&);
+    void unlist(ReadinessWatch&);
+    void detach(ReadinessWatch&);
+    int collect(epoll_event* events, int max_events);
+
+    HashMap<int, OwnPtr<ReadinessWatch>> m_watches;
+    InlineLinkedList<ReadinessWatch> m_ready;
+    Vector<Thread*> m_waiters;
+};
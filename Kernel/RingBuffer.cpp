@@ -0,0 +1,104 @@
+#include <Kernel/RingBuffer.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <LibC/errno_numbers.h>
+
+RingBuffer::RingBuffer(String&& name, size_t capacity)
+    : m_name(move(name))
+    , m_capacity(capacity)
+{
+    ASSERT(!(capacity % PAGE_SIZE));
+    ASSERT(!(capacity & (capacity - 1)));
+}
+
+RingBuffer::~RingBuffer()
+{
+}
+
+bool RingBuffer::ensure_storage()
+{
+    if (m_data)
+        return true;
+    m_region = MM.allocate_kernel_region(m_capacity, String(m_name));
+    if (!m_region)
+        return false;
+    m_data = m_region->laddr().as_ptr();
+    return true;
+}
+
+void RingBuffer::copy_in(dword position, const byte* data, size_t size)
+{
+    size_t offset = position & (m_capacity - 1);
+    size_t first_chunk = min(size, m_capacity - offset);
+    memcpy(m_data + offset, data, first_chunk);
+    if (first_chunk < size)
+        memcpy(m_data, data + first_chunk, size - first_chunk);
+}
+
+void RingBuffer::copy_out(dword position, byte* data, size_t size) const
+{
+    size_t offset = position & (m_capacity - 1);
+    size_t first_chunk = min(size, m_capacity - offset);
+    memcpy(data, m_data + offset, first_chunk);
+    if (first_chunk < size)
+        memcpy(data + first_chunk, m_data, size - first_chunk);
+}
+
+ssize_t RingBuffer::write(const byte* data, ssize_t size)
+{
+    if (size <= 0)
+        return 0;
+    LOCKER(m_write_lock);
+    if (!ensure_storage())
+        return -ENOMEM;
+    size_t nwritten = min((size_t)size, space_for_writing());
+    copy_in(m_total_written, data, nwritten);
+    memory_barrier();
+    m_total_written += nwritten;
+    return nwritten;
+}
+
+ssize_t RingBuffer::read(byte* data, ssize_t size)
+{
+    if (size <= 0)
+        return 0;
+    LOCKER(m_read_lock);
+    size_t nread = min((size_t)size, used_bytes());
+    if (!nread)
+        return 0;
+    copy_out(m_total_read, data, nread);
+    memory_barrier();
+    m_total_read += nread;
+    return nread;
+}
+
+bool RingBuffer::write_message(const byte* data, ssize_t size)
+{
+    ASSERT(size >= 0);
+    LOCKER(m_write_lock);
+    if (!ensure_storage())
+        return false;
+    if (message_header_size + size > space_for_writing())
+        return false;
+    dword header = size;
+    copy_in(m_total_written, (const byte*)&header, message_header_size);
+    copy_in(m_total_written + message_header_size, data, size);
+    // Publish the header and payload together, so a reader never sees half a message.
+    memory_barrier();
+    m_total_written += message_header_size + size;
+    return true;
+}
+
+ssize_t RingBuffer::read_message(byte* data, ssize_t size)
+{
+    LOCKER(m_read_lock);
+    if (is_empty())
+        return 0;
+    ASSERT(used_bytes() >= message_header_size);
+    dword message_size;
+    copy_out(m_total_read, (byte*)&message_size, message_header_size);
+    ASSERT(used_bytes() >= message_header_size + message_size);
+    copy_out(m_total_read + message_header_size, data, min((size_t)size, (size_t)message_size));
+    memory_barrier();
+    m_total_read += message_header_size + message_size;
+    return message_size;
+}
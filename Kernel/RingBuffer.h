@@ -0,0 +1,57 @@
+#pragma once
+
+#include <AK/AKString.h>
+#include <AK/RetainPtr.h>
+#include <AK/Types.h>
+#include <Kernel/Lock.h>
+
+class Region;
+
+// A fixed-capacity single-reader/single-writer byte ring.
+// Readers and writers take separate locks, so a reader never has to wait for a writer
+// (and vice versa.) The read and write positions are free-running 32-bit counters;
+// the storage is only allocated on first write.
+//
+// Besides plain bytes, the ring can carry length-prefixed messages, which lets
+// SOCK_SEQPACKET sockets preserve message boundaries.
+class RingBuffer {
+public:
+    RingBuffer(String&& name, size_t capacity);
+    ~RingBuffer();
+
+    ssize_t write(const byte*, ssize_t);
+    ssize_t read(byte*, ssize_t);
+
+    // Writes the whole message or nothing. Returns false if there's not enough space.
+    bool write_message(const byte*, ssize_t);
+    // Reads one message, discarding whatever doesn't fit in the buffer. Returns the
+    // size of the message, which may be larger than the number of bytes copied.
+    ssize_t read_message(byte*, ssize_t);
+
+    static constexpr size_t message_header_size = sizeof(dword);
+
+    bool is_empty() const { return m_total_written == m_total_read; }
+    size_t capacity() const { return m_capacity; }
+    size_t used_bytes() const { return m_total_written - m_total_read; }
+    size_t space_for_writing() const { return m_capacity - used_bytes(); }
+
+    dword total_written() const { return m_total_written; }
+    dword total_read() const { return m_total_read; }
+
+    Lock& write_lock() { return m_write_lock; }
+    Lock& read_lock() { return m_read_lock; }
+
+private:
+    bool ensure_storage();
+    void copy_in(dword position, const byte*, size_t);
+    void copy_out(dword position, byte*, size_t) const;
+
+    String m_name;
+    RetainPtr<Region> m_region;
+    byte* m_data { nullptr };
+    size_t m_capacity { 0 };
+    volatile dword m_total_written { 0 };
+    volatile dword m_total_read { 0 };
+    Lock m_write_lock { "RingBuffer:write" };
+    Lock m_read_lock { "RingBuffer:read" };
+};
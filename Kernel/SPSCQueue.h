@@ -0,0 +1,52 @@
+#pragma once
+
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <Kernel/i386.h>
+
+// A fixed-capacity, lock-free queue for exactly one producer and one consumer.
+// The producer only ever writes m_tail and the consumer only ever writes m_head,
+// so an IRQ handler can enqueue while a kernel thread is dequeueing.
+template<typename T, int Capacity>
+class SPSCQueue {
+public:
+    static_assert((Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+    SPSCQueue() { }
+    ~SPSCQueue() { }
+
+    bool is_empty() const { return m_head == m_tail; }
+    bool is_full() const { return m_tail - m_head == Capacity; }
+    int size() const { return m_tail - m_head; }
+    int capacity() const { return Capacity; }
+
+    // Producer side. Returns false (and leaves the value alone) if the queue is full.
+    bool enqueue(T&& value)
+    {
+        dword tail = m_tail;
+        if (tail - m_head == Capacity)
+            return false;
+        m_slots[tail & (Capacity - 1)] = move(value);
+        memory_barrier();
+        m_tail = tail + 1;
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool dequeue(T& out)
+    {
+        dword head = m_head;
+        if (head == m_tail)
+            return false;
+        memory_barrier();
+        out = move(m_slots[head & (Capacity - 1)]);
+        memory_barrier();
+        m_head = head + 1;
+        return true;
+    }
+
+private:
+    T m_slots[Capacity];
+    volatile dword m_head { 0 };
+    volatile dword m_tail { 0 };
+};
@@ -2,6 +2,7 @@
 #include "Process.h"
 #include "RTC.h"
 #include "i8253.h"
+#include "Syscall.h"
 #include <AK/TemporaryChange.h>
 #include <Kernel/Alarm.h>
 #include <Kernel/FileSystem/FileDescriptor.h>
@@ -152,6 +153,19 @@ bool Scheduler::pick_next()
             return IterationDecision::Continue;
         }
 
+        if (thread.state() == Thread::BlockedFutex) {
+            if (thread.m_futex_has_timeout && thread.wakeup_time() <= g_uptime)
+                thread.unblock();
+            return IterationDecision::Continue;
+        }
+
+        // Readiness changes unblock the thread directly; only the timeout is ours to check.
+        if (thread.state() == Thread::BlockedReadiness) {
+            if (thread.m_readiness_has_timeout && thread.wakeup_time() <= g_uptime)
+                thread.unblock();
+            return IterationDecision::Continue;
+        }
+
         if (thread.state() == Thread::BlockedSnoozing) {
             if (thread.m_snoozing_alarm->is_ringing()) {
                 thread.m_snoozing_alarm = nullptr;
@@ -317,6 +331,9 @@ bool Scheduler::context_switch(Thread& thread)
     thread.set_ticks_left(time_slice_for(thread.process().priority()));
     thread.did_schedule();
 
+    // Even if we're staying put, dispatching a signal may have moved our kernel stack.
+    Syscall::set_sysenter_stack(thread.tss().esp0);
+
     if (current == &thread)
         return false;
 
@@ -352,10 +369,20 @@ bool Scheduler::context_switch(Thread& thread)
 
     auto& descriptor = get_gdt_entry(thread.selector());
     descriptor.type = 11; // Busy TSS
+    load_thread_specific_data(thread);
     flush_gdt();
     return true;
 }
 
+void Scheduler::load_thread_specific_data(Thread& thread)
+{
+    // %gs is reloaded from the GDT by the task switch, so moving the base here
+    // gives every thread its own view through the same selector.
+    auto& descriptor = get_gdt_entry(GDT_SELECTOR_THREAD_SPECIFIC);
+    descriptor.set_base(thread.thread_specific_data().as_ptr());
+    descriptor.set_limit(0xfffff);
+}
+
 static void initialize_redirection()
 {
     auto& descriptor = get_gdt_entry(s_redirection.selector);
@@ -23,6 +23,7 @@ public:
     static bool donate_to(Thread*, const char* reason);
     static bool context_switch(Thread&);
     static void prepare_to_modify_tss(Thread&);
+    static void load_thread_specific_data(Thread&);
     static Process* colonel();
     static bool is_active();
     static void beep();
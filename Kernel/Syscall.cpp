@@ -7,6 +7,7 @@
 
 extern "C" void syscall_trap_entry(RegisterDump&);
 extern "C" void syscall_trap_handler();
+extern "C" void sysenter_trap_handler();
 extern volatile RegisterDump* syscallRegDump;
 
 asm(
@@ -37,12 +38,91 @@ asm(
     "    iret\n"
 );
 
+// The sysenter fast path. The CPU puts us on the current thread's kernel stack
+// (MSR_SYSENTER_ESP) with interrupts disabled, but saves nothing; userspace passes
+// its return address in %edi and its stack pointer in %esi. We build the frame that
+// int 0x82 would have pushed, so the rest of the kernel (fork, signals, tracers)
+// can't tell the difference, and leave with sysexit instead of iret.
+// Unlike an interrupt gate, sysenter leaves EFLAGS alone apart from IF, so the
+// user's TF/NT/DF/AC come in with us. We load clean flags as soon as the frame is
+// built; a single-step trap on the way in is handled in exception_1_handler().
+asm(
+    ".globl sysenter_trap_handler \n"
+    "sysenter_trap_handler:\n"
+    "    pushl $0x23\n"
+    "    pushl %esi\n"
+    "    pushl $0x202\n"
+    "    pushl $0x1b\n"
+    "    pushl %edi\n"
+    "    pushl $0x202\n"
+    "    popfl\n"
+    "    pusha\n"
+    "    pushw %ds\n"
+    "    pushw %es\n"
+    "    pushw %fs\n"
+    "    pushw %gs\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    popw %ds\n"
+    "    popw %es\n"
+    "    popw %fs\n"
+    "    popw %gs\n"
+    "    mov %esp, %eax\n"
+    "    call syscall_trap_entry\n"
+    "    popw %gs\n"
+    "    popw %gs\n"
+    "    popw %fs\n"
+    "    popw %es\n"
+    "    popw %ds\n"
+    "    popa\n"
+    "    movl (%esp), %edx\n"
+    "    movl 12(%esp), %ecx\n"
+    "    addl $8, %esp\n"
+    "    popfl\n"
+    "    addl $8, %esp\n"
+    "    sysexit\n"
+    ".globl sysenter_trap_handler_end \n"
+    "sysenter_trap_handler_end:\n"
+);
+
 namespace Syscall {
 
+static bool s_sysenter_enabled;
+
+static bool cpu_has_sysenter()
+{
+    CPUID cpuid(1);
+    if (!(cpuid.edx() & (1 << 11)))
+        return false;
+    // The original Pentium Pro claims SEP without actually having it.
+    dword family = (cpuid.eax() >> 8) & 0xf;
+    dword model = (cpuid.eax() >> 4) & 0xf;
+    dword stepping = cpuid.eax() & 0xf;
+    return !(family == 6 && model < 3 && stepping < 3);
+}
+
 void initialize()
 {
     register_user_callable_interrupt_handler(0x82, syscall_trap_handler);
     kprintf("Syscall: int 0x82 handler installed\n");
+
+    if (cpu_has_sysenter()) {
+        // sysenter/sysexit derive the other three selectors from this one, which works out
+        // with our GDT layout: kernel code, kernel data, user code, user data.
+        write_msr(MSR_SYSENTER_CS, 0x08);
+        write_msr(MSR_SYSENTER_EIP, (dword)sysenter_trap_handler);
+        s_sysenter_enabled = true;
+        kprintf("Syscall: sysenter handler installed\n");
+    }
+}
+
+void set_sysenter_stack(dword kernel_stack_top)
+{
+    if (s_sysenter_enabled)
+        write_msr(MSR_SYSENTER_ESP, kernel_stack_top);
 }
 
 int sync()
@@ -248,6 +328,8 @@ static dword handle(RegisterDump& regs, dword function, dword arg1, dword arg2,
         return current->process().sys$seal_shared_buffer((int)arg1);
     case Syscall::SC_get_shared_buffer_size:
         return current->process().sys$get_shared_buffer_size((int)arg1);
+    case Syscall::SC_share_buffer_with:
+        return current->process().sys$share_buffer_with((int)arg1, (pid_t)arg2);
     case Syscall::SC_sendto:
         return current->process().sys$sendto((const SC_sendto_params*)arg1);
     case Syscall::SC_recvfrom:
@@ -257,7 +339,7 @@ static dword handle(RegisterDump& regs, dword function, dword arg1, dword arg2,
     case Syscall::SC_setsockopt:
         return current->process().sys$setsockopt((const SC_setsockopt_params*)arg1);
     case Syscall::SC_create_thread:
-        return current->process().sys$create_thread((int(*)(void*))arg1, (void*)arg2);
+        return current->process().sys$create_thread((int(*)(void*))arg1, (void*)arg2, (const SC_create_thread_params*)arg3);
     case Syscall::SC_rename:
         return current->process().sys$rename((const char*)arg1, (const char*)arg2);
     case Syscall::SC_shm_open:
@@ -276,6 +358,30 @@ static dword handle(RegisterDump& regs, dword function, dword arg1, dword arg2,
         return current->process().sys$getsockname((int)arg1, (sockaddr*)arg2, (socklen_t*)arg3);
     case Syscall::SC_getpeername:
         return current->process().sys$getpeername((int)arg1, (sockaddr*)arg2, (socklen_t*)arg3);
+    case Syscall::SC_sendmsg:
+        return current->process().sys$sendmsg((int)arg1, (const struct msghdr*)arg2, (int)arg3);
+    case Syscall::SC_recvmsg:
+        return current->process().sys$recvmsg((int)arg1, (struct msghdr*)arg2, (int)arg3);
+    case Syscall::SC_set_thread_specific_data:
+        return current->process().sys$set_thread_specific_data((void*)arg1);
+    case Syscall::SC_futex:
+        return current->process().sys$futex((const SC_futex_params*)arg1);
+    case Syscall::SC_epoll_create:
+        return current->process().sys$epoll_create((int)arg1);
+    case Syscall::SC_epoll_ctl:
+        return current->process().sys$epoll_ctl((const SC_epoll_ctl_params*)arg1);
+    case Syscall::SC_epoll_wait:
+        return current->process().sys$epoll_wait((const SC_epoll_wait_params*)arg1);
+    case Syscall::SC_readv:
+        return current->process().sys$readv((int)arg1, (const struct iovec*)arg2, (int)arg3);
+    case Syscall::SC_preadv:
+        return current->process().sys$preadv((const SC_preadv_params*)arg1);
+    case Syscall::SC_pwritev:
+        return current->process().sys$pwritev((const SC_pwritev_params*)arg1);
+    case Syscall::SC_get_dir_entries_with_stat:
+        return current->process().sys$get_dir_entries_with_stat((int)arg1, (void*)arg2, (size_t)arg3);
+    case Syscall::SC_sendfile:
+        return current->process().sys$sendfile((const SC_sendfile_params*)arg1);
     default:
         kprintf("<%u> int0x82: Unknown function %u requested {%x, %x, %x}\n", current->process().pid(), function, arg1, arg2, arg3);
         return -ENOSYS;
@@ -3,6 +3,15 @@
 #include <AK/Types.h>
 #include <LibC/fd_set.h>
 
+struct timespec;
+struct epoll_event;
+struct iovec;
+
+#if defined(__serenity__) && !defined(KERNEL)
+// Set by LibC at startup if the CPU (and so the kernel) supports the sysenter fast path.
+extern "C" bool __syscall_use_sysenter;
+#endif
+
 #define ENUMERATE_SYSCALLS \
     __ENUMERATE_SYSCALL(sleep) \
     __ENUMERATE_SYSCALL(yield) \
@@ -106,6 +115,19 @@
     __ENUMERATE_SYSCALL(beep) \
     __ENUMERATE_SYSCALL(getsockname) \
     __ENUMERATE_SYSCALL(getpeername) \
+    __ENUMERATE_SYSCALL(sendmsg) \
+    __ENUMERATE_SYSCALL(recvmsg) \
+    __ENUMERATE_SYSCALL(share_buffer_with) \
+    __ENUMERATE_SYSCALL(set_thread_specific_data) \
+    __ENUMERATE_SYSCALL(futex) \
+    __ENUMERATE_SYSCALL(epoll_create) \
+    __ENUMERATE_SYSCALL(epoll_ctl) \
+    __ENUMERATE_SYSCALL(epoll_wait) \
+    __ENUMERATE_SYSCALL(readv) \
+    __ENUMERATE_SYSCALL(preadv) \
+    __ENUMERATE_SYSCALL(pwritev) \
+    __ENUMERATE_SYSCALL(get_dir_entries_with_stat) \
+    __ENUMERATE_SYSCALL(sendfile) \
 
 
 namespace Syscall {
@@ -181,11 +203,88 @@ struct SC_setsockopt_params {
     size_t value_size; // socklen_t
 };
 
+struct SC_create_thread_params {
+    void* stack_location; // nullptr means the kernel allocates a stack.
+    size_t stack_size;
+    void* thread_specific_data;
+    int* tid_address; // Receives the new TID, cleared (and futex-woken) when the thread exits.
+};
+
+struct SC_futex_params {
+    int* userspace_address;
+    int futex_op;
+    int val;
+    const struct timespec* timeout;
+    int* userspace_address2; // FUTEX_REQUEUE: where to move the waiters that weren't woken.
+    int val2; // FUTEX_REQUEUE: how many of them to move.
+};
+
+struct SC_epoll_ctl_params {
+    int epfd;
+    int op;
+    int fd;
+    struct epoll_event* event;
+};
+
+struct SC_epoll_wait_params {
+    int epfd;
+    struct epoll_event* events;
+    int max_events;
+    int timeout;
+};
+
+struct SC_preadv_params {
+    int fd;
+    const struct iovec* iov;
+    int iov_count;
+    int32_t offset;
+};
+
+struct SC_pwritev_params {
+    int fd;
+    const struct iovec* iov;
+    int iov_count;
+    int32_t offset;
+};
+
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    int32_t* offset;
+    size_t count;
+};
+
 void initialize();
 int sync();
+#ifdef KERNEL
+// Points sysenter at the kernel stack of the thread we're about to run.
+void set_sysenter_stack(dword kernel_stack_top);
+#endif
+
+#ifndef KERNEL
+// sysenter saves nothing, so we hand the kernel our return address in %edi and our
+// stack pointer in %esi. It comes back with %ecx and %edx clobbered.
+inline dword invoke_sysenter(Function function, dword arg1, dword arg2, dword arg3)
+{
+    dword result;
+    asm volatile(
+        "movl %%esp, %%esi\n"
+        "movl $1f, %%edi\n"
+        "sysenter\n"
+        "1:\n"
+        : "=a"(result), "+d"(arg1), "+c"(arg2)
+        : "a"(function), "b"(arg3)
+        : "esi", "edi", "memory", "cc");
+    return result;
+}
+#endif
 
 inline dword invoke(Function function)
 {
+#ifndef KERNEL
+    if (__syscall_use_sysenter)
+        return invoke_sysenter(function, 0, 0, 0);
+#endif
     dword result;
     asm volatile("int $0x82":"=a"(result):"a"(function):"memory");
     return result;
@@ -194,6 +293,10 @@ inline dword invoke(Function function)
 template<typename T1>
 inline dword invoke(Function function, T1 arg1)
 {
+#ifndef KERNEL
+    if (__syscall_use_sysenter)
+        return invoke_sysenter(function, (dword)arg1, 0, 0);
+#endif
     dword result;
     asm volatile("int $0x82":"=a"(result):"a"(function),"d"((dword)arg1):"memory");
     return result;
@@ -202,6 +305,10 @@ inline dword invoke(Function function, T1 arg1)
 template<typename T1, typename T2>
 inline dword invoke(Function function, T1 arg1, T2 arg2)
 {
+#ifndef KERNEL
+    if (__syscall_use_sysenter)
+        return invoke_sysenter(function, (dword)arg1, (dword)arg2, 0);
+#endif
     dword result;
     asm volatile("int $0x82":"=a"(result):"a"(function),"d"((dword)arg1),"c"((dword)arg2):"memory");
     return result;
@@ -210,6 +317,10 @@ inline dword invoke(Function function, T1 arg1, T2 arg2)
 template<typename T1, typename T2, typename T3>
 inline dword invoke(Function function, T1 arg1, T2 arg2, T3 arg3)
 {
+#ifndef KERNEL
+    if (__syscall_use_sysenter)
+        return invoke_sysenter(function, (dword)arg1, (dword)arg2, (dword)arg3);
+#endif
     dword result;
     asm volatile("int $0x82":"=a"(result):"a"(function),"d"((dword)arg1),"c"((dword)arg2),"b"((dword)arg3):"memory");
     return result;
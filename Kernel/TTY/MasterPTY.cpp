@@ -35,7 +35,11 @@ ssize_t MasterPTY::read(FileDescriptor&, byte* buffer, ssize_t size)
 {
     if (!m_slave && m_buffer.is_empty())
         return 0;
-    return m_buffer.read(buffer, size);
+    ssize_t nread = m_buffer.read(buffer, size);
+    // That may have made room for the slave to write into.
+    if (nread > 0 && m_slave)
+        m_slave->did_change_readiness();
+    return nread;
 }
 
 ssize_t MasterPTY::write(FileDescriptor&, const byte* buffer, ssize_t size)
@@ -67,6 +71,7 @@ void MasterPTY::notify_slave_closed(Badge<SlavePTY>)
     // +1 retain for FileDescriptor::m_device
     if (m_slave->retain_count() == 2)
         m_slave = nullptr;
+    did_change_readiness();
 }
 
 ssize_t MasterPTY::on_slave_write(const byte* data, ssize_t size)
@@ -74,6 +79,7 @@ ssize_t MasterPTY::on_slave_write(const byte* data, ssize_t size)
     if (m_closed)
         return -EIO;
     m_buffer.write(data, size);
+    did_change_readiness();
     return size;
 }
 
@@ -93,6 +99,7 @@ void MasterPTY::close()
         m_closed = true;
 
         m_slave->hang_up();
+        m_slave->did_change_readiness();
     }
 }
 
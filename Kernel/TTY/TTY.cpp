@@ -67,6 +67,7 @@ void TTY::emit(byte ch)
         }
     }
     m_buffer.write(&ch, 1);
+    did_change_readiness();
 }
 
 void TTY::generate_signal(int signal)
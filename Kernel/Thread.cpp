@@ -1,6 +1,7 @@
 #include <Kernel/Thread.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/Process.h>
+#include <Kernel/ReadinessQueue.h>
 #include <Kernel/FileSystem/FileDescriptor.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <LibC/signal_numbers.h>
@@ -48,7 +49,7 @@ Thread::Thread(Process& process)
     m_tss.ds = ds;
     m_tss.es = ds;
     m_tss.fs = ds;
-    m_tss.gs = ds;
+    m_tss.gs = m_process.is_ring0() ? ds : (GDT_SELECTOR_THREAD_SPECIFIC | 3);
     m_tss.ss = ss;
     m_tss.cs = cs;
 
@@ -163,6 +164,8 @@ const char* to_string(Thread::State state)
     case Thread::BlockedConnect: return "Connect";
     case Thread::BlockedReceive: return "Receive";
     case Thread::BlockedSnoozing: return "Snoozing";
+    case Thread::BlockedFutex: return "Futex";
+    case Thread::BlockedReadiness: return "Readiness";
     }
     kprintf("to_string(Thread::State): Invalid state: %u\n", state);
     ASSERT_NOT_REACHED();
@@ -175,6 +178,8 @@ void Thread::finalize()
     set_state(Thread::State::Dead);
 
     m_blocked_descriptor = nullptr;
+    Futex::remove_waiter(*this);
+    ReadinessQueue::remove_waiter(*this);
 
     if (this == &m_process.main_thread())
         m_process.finalize();
@@ -407,7 +412,7 @@ ShouldUnblockThread Thread::dispatch_signal(byte signal)
     m_tss.ds = 0x23;
     m_tss.es = 0x23;
     m_tss.fs = 0x23;
-    m_tss.gs = 0x23;
+    m_tss.gs = GDT_SELECTOR_THREAD_SPECIFIC | 3;
     m_tss.eip = handler_laddr.get();
 
     // FIXME: Should we worry about the stack being 16 byte aligned when entering a signal handler?
@@ -501,6 +506,15 @@ void Thread::make_userspace_stack_for_secondary_thread(void *argument)
     push_value_on_stack(0);
 }
 
+void Thread::make_userspace_stack_for_secondary_thread(void* argument, LinearAddress stack_location, size_t stack_size)
+{
+    m_tss.esp = stack_location.offset(stack_size).get() & 0xfffffff0u;
+
+    // NOTE: The stack needs to be 16-byte aligned.
+    push_value_on_stack((dword)argument);
+    push_value_on_stack(0);
+}
+
 Thread* Thread::clone(Process& process)
 {
     auto* clone = new Thread(process);
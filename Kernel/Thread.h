@@ -1,5 +1,6 @@
 #pragma once
 
+#include <Kernel/Futex.h>
 #include <Kernel/i386.h>
 #include <Kernel/KResult.h>
 #include <Kernel/LinearAddress.h>
@@ -14,6 +15,7 @@
 class Alarm;
 class FileDescriptor;
 class Process;
+class ReadinessQueue;
 class Region;
 class Thread;
 
@@ -29,7 +31,9 @@ extern InlineLinkedList<Thread>* g_runnable_threads;
 extern InlineLinkedList<Thread>* g_nonrunnable_threads;
 
 class Thread : public InlineLinkedListNode<Thread> {
+    friend class Futex;
     friend class Process;
+    friend class ReadinessQueue;
     friend class Scheduler;
 public:
     explicit Thread(Process&);
@@ -68,6 +72,8 @@ public:
         BlockedConnect,
         BlockedReceive,
         BlockedSnoozing,
+        BlockedFutex,
+        BlockedReadiness,
     };
 
     void did_schedule() { ++m_times_scheduled; }
@@ -76,7 +82,7 @@ public:
     bool is_stopped() const { return m_state == Stopped; }
     bool is_blocked() const
     {
-        return m_state == BlockedSleep || m_state == BlockedWait || m_state == BlockedRead || m_state == BlockedWrite || m_state == BlockedSignal || m_state == BlockedSelect;
+        return m_state == BlockedSleep || m_state == BlockedWait || m_state == BlockedRead || m_state == BlockedWrite || m_state == BlockedSignal || m_state == BlockedSelect || m_state == BlockedFutex || m_state == BlockedReadiness;
     }
     bool in_kernel() const { return (m_tss.cs & 0x03) == 0; }
 
@@ -99,6 +105,12 @@ public:
     void snooze_until(Alarm&);
     KResult wait_for_connect(FileDescriptor&);
 
+    LinearAddress thread_specific_data() const { return m_thread_specific_data; }
+    void set_thread_specific_data(LinearAddress laddr) { m_thread_specific_data = laddr; }
+    LinearAddress tid_address() const { return m_tid_address; }
+    void set_tid_address(LinearAddress laddr) { m_tid_address = laddr; }
+    bool was_interrupted_while_blocked() const { return m_was_interrupted_while_blocked; }
+
     const FarPtr& far_ptr() const { return m_far_ptr; }
 
     bool tick();
@@ -122,10 +134,15 @@ public:
     bool has_used_fpu() const { return m_has_used_fpu; }
     void set_has_used_fpu(bool b) { m_has_used_fpu = b; }
 
+    // How many loopback packets this thread is delivering in-line right now (see LoopbackAdapter::send_ipv4()).
+    int loopback_delivery_depth() const { return m_loopback_delivery_depth; }
+    void set_loopback_delivery_depth(int depth) { m_loopback_delivery_depth = depth; }
+
     void set_default_signal_dispositions();
     void push_value_on_stack(dword);
     void make_userspace_stack_for_main_thread(Vector<String> arguments, Vector<String> environment);
     void make_userspace_stack_for_secondary_thread(void* argument);
+    void make_userspace_stack_for_secondary_thread(void* argument, LinearAddress stack_location, size_t stack_size);
 
     Thread* clone(Process&);
 
@@ -175,13 +192,21 @@ private:
     SignalActionData m_signal_action_data[32];
     Region* m_signal_stack_user_region { nullptr };
     Alarm* m_snoozing_alarm { nullptr };
+    LinearAddress m_thread_specific_data;
+    LinearAddress m_tid_address;
+    FutexKey m_futex_key;
+    ReadinessQueue* m_waiting_readiness_queue { nullptr };
     Vector<int> m_select_read_fds;
     Vector<int> m_select_write_fds;
     Vector<int> m_select_exceptional_fds;
     FPUState* m_fpu_state { nullptr };
     InlineLinkedList<Thread>* m_thread_list { nullptr };
     State m_state { Invalid };
+    int m_loopback_delivery_depth { 0 };
     bool m_select_has_timeout { false };
+    bool m_futex_queued { false };
+    bool m_futex_has_timeout { false };
+    bool m_readiness_has_timeout { false };
     bool m_has_used_fpu { false };
     bool m_was_interrupted_while_blocked { false };
 };
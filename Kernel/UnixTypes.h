@@ -36,6 +36,10 @@
 
 #define FD_CLOEXEC 1
 
+#define FUTEX_WAIT 1
+#define FUTEX_WAKE 2
+#define FUTEX_REQUEUE 3
+
 /* c_cc characters */
 #define VINTR 0
 #define VQUIT 1
@@ -315,6 +319,27 @@ struct pollfd {
     short revents;
 };
 
+#define EPOLLIN  POLLIN
+#define EPOLLOUT POLLOUT
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLL_CLOEXEC 02000000
+
+typedef union epoll_data {
+    void* ptr;
+    int fd;
+    dword u32;
+    qword u64;
+} epoll_data_t;
+
+struct epoll_event {
+    dword events;
+    epoll_data_t data;
+};
+
 #define AF_MASK 0xff
 #define AF_UNSPEC 0
 #define AF_LOCAL 1
@@ -326,15 +351,27 @@ struct pollfd {
 #define SOCK_STREAM 1
 #define SOCK_RAW 3
 #define SOCK_DGRAM 2
+#define SOCK_SEQPACKET 5
 #define SOCK_NONBLOCK 04000
 #define SOCK_CLOEXEC 02000000
 
+#define MSG_CTRUNC 0x8
+#define MSG_TRUNC 0x20
 #define MSG_DONTWAIT 0x40
 
 #define SOL_SOCKET 1
 
 #define SO_RCVTIMEO 1
 #define SO_SNDTIMEO 2
+#define SO_PEERCRED 5
+
+#define SCM_RIGHTS 1
+
+struct ucred {
+    pid_t pid;
+    uid_t uid;
+    gid_t gid;
+};
 
 #define IPPROTO_ICMP 1
 #define IPPROTO_TCP 6
@@ -378,6 +415,11 @@ struct timeval {
     suseconds_t tv_usec;
 };
 
+struct timespec {
+    time_t tv_sec;
+    long tv_nsec;
+};
+
 #define UTSNAME_ENTRY_LEN 65
 
 struct utsname {
@@ -397,3 +439,24 @@ struct iovec {
     void* iov_base;
     size_t iov_len;
 };
+
+struct msghdr {
+    void* msg_name;
+    socklen_t msg_namelen;
+    struct iovec* msg_iov;
+    int msg_iovlen;
+    void* msg_control;
+    socklen_t msg_controllen;
+    int msg_flags;
+};
+
+struct cmsghdr {
+    socklen_t cmsg_len;
+    int cmsg_level;
+    int cmsg_type;
+};
+
+#define CMSG_ALIGN(x) (((x) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+#define CMSG_DATA(cmsg) ((byte*)(cmsg) + CMSG_ALIGN(sizeof(struct cmsghdr)))
+#define CMSG_LEN(x) (CMSG_ALIGN(sizeof(struct cmsghdr)) + (x))
+#define CMSG_SPACE(x) (CMSG_ALIGN(sizeof(struct cmsghdr)) + CMSG_ALIGN(x))
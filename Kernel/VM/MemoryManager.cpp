@@ -366,6 +366,11 @@ PageFaultResponse MemoryManager::handle_page_fault(const PageFault& fault)
     }
     auto page_index_in_region = region->page_index_from_address(fault.laddr());
     if (fault.is_not_present()) {
+        if (!region->is_readable() && !region->is_writable()) {
+            // PROT_NONE mappings (e.g. thread stack guard pages) are never paged in.
+            kprintf("NP(error) fault in inaccessible Region{%p}[%u] at L%x\n", region, page_index_in_region, fault.laddr().get());
+            return PageFaultResponse::ShouldCrash;
+        }
         if (region->vmo().inode()) {
 #ifdef PAGE_FAULT_DEBUG
             dbgprintf("NP(inode) fault in Region{%p}[%u]\n", region, page_index_in_region);
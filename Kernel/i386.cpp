@@ -39,6 +39,8 @@ void gdt_free_entry(word entry)
 }
 
 extern "C" void handle_irq();
+extern "C" void sysenter_trap_handler();
+extern "C" void sysenter_trap_handler_end();
 extern "C" void asm_irq_entry();
 
 asm(
@@ -236,6 +238,30 @@ void exception_0_handler(RegisterDump& regs)
 }
 
 
+// 1: Debug exception
+EH_ENTRY_NO_CODE(1);
+void exception_1_handler(RegisterDump& regs)
+{
+    // sysenter doesn't clear TF, so a user can single-step into the sysenter stub.
+    // Drop TF and carry on; the stub reloads EFLAGS itself right after.
+    if ((regs.cs & 3) == 0 && regs.eip >= (dword)sysenter_trap_handler && regs.eip < (dword)sysenter_trap_handler_end) {
+        regs.eflags &= ~0x100;
+        return;
+    }
+
+    if (!current || (regs.cs & 3) == 0) {
+        kprintf("Debug exception in ring 0\n");
+        dump(regs);
+        dump_backtrace();
+        hang();
+    }
+
+    // Single-stepping (or a debug register hit) in userspace; nobody is set up to
+    // handle that in the kernel, so clear TF and let the process deal with SIGTRAP.
+    regs.eflags &= ~0x100;
+    current->send_signal(SIGTRAP, nullptr);
+}
+
 // 13: General Protection Fault
 EH_ENTRY(13);
 void exception_13_handler(RegisterDumpWithExceptionCode& regs)
@@ -312,7 +338,6 @@ void exception_14_handler(RegisterDumpWithExceptionCode& regs)
         hang(); \
     }
 
-EH(1, "Debug exception")
 EH(2, "Unknown error")
 EH(3, "Breakpoint")
 EH(4, "Overflow")
@@ -355,7 +380,7 @@ void flush_gdt()
 
 void gdt_init()
 {
-    s_gdt_length = 5;
+    s_gdt_length = 6;
 
     s_gdt_freelist = new Vector<word>();
     s_gdt_freelist->ensure_capacity(256);
@@ -371,6 +396,7 @@ void gdt_init()
     write_raw_gdt_entry(0x0010, 0x0000ffff, 0x00cf9200);
     write_raw_gdt_entry(0x0018, 0x0000ffff, 0x00cffa00);
     write_raw_gdt_entry(0x0020, 0x0000ffff, 0x00cff200);
+    write_raw_gdt_entry(GDT_SELECTOR_THREAD_SPECIFIC, 0x0000ffff, 0x00cff200);
 
     flush_gdt();
 
@@ -450,7 +476,7 @@ void idt_init()
         register_interrupt_handler(i, unimp_trap);
 
     register_interrupt_handler(0x00, exception_0_entry);
-    register_interrupt_handler(0x01, _exception1);
+    register_interrupt_handler(0x01, exception_1_entry);
     register_interrupt_handler(0x02, _exception2);
     register_interrupt_handler(0x03, _exception3);
     register_interrupt_handler(0x04, _exception4);
@@ -79,6 +79,10 @@ union [[gnu::packed]] Descriptor {
 
 class IRQHandler;
 
+// Ring 3 data segment whose base is moved to the running thread's
+// thread-specific data on every context switch, reachable through %gs.
+#define GDT_SELECTOR_THREAD_SPECIFIC 0x28
+
 void gdt_init();
 void idt_init();
 void sse_init();
@@ -282,6 +286,15 @@ inline void read_tsc(dword& lsw, dword& msw)
     asm volatile("rdtsc":"=d"(msw),"=a"(lsw));
 }
 
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+
+inline void write_msr(dword msr, dword value)
+{
+    asm volatile("wrmsr" :: "c"(msr), "a"(value), "d"(0));
+}
+
 struct Stopwatch {
     union SplitQword {
         struct {
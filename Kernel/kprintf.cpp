@@ -6,49 +6,69 @@
 #include <AK/Types.h>
 #include <AK/printf.cpp>
 
-static void console_putch(char*&, char ch)
-{
-    if (!current) {
-        IO::out8(0xe9, ch);
-        return;
+// Goes to the Bochs/QEMU debug port.
+struct DebuggerSink {
+    void append(const char* characters, int length)
+    {
+        IO::repeated_out8(0xe9, (const byte*)characters, length);
     }
-    Console::the().put_char(ch);
-}
+
+    void fill(char ch, int count)
+    {
+        while (count--)
+            IO::out8(0xe9, ch);
+    }
+};
+
+struct ConsoleSink {
+    void append(const char* characters, int length)
+    {
+        if (!current) {
+            DebuggerSink().append(characters, length);
+            return;
+        }
+        for (int i = 0; i < length; ++i)
+            Console::the().put_char(characters[i]);
+    }
+
+    void fill(char ch, int count)
+    {
+        if (!current) {
+            DebuggerSink().fill(ch, count);
+            return;
+        }
+        while (count--)
+            Console::the().put_char(ch);
+    }
+};
 
 int kprintf(const char* fmt, ...)
 {
     va_list ap;
     va_start(ap, fmt);
-    int ret = printf_internal(console_putch, nullptr, fmt, ap);
+    ConsoleSink sink;
+    int ret = printf_internal(sink, fmt, ap);
     va_end(ap);
     return ret;
 }
 
-static void buffer_putch(char*& bufptr, char ch)
-{
-    *bufptr++ = ch;
-}
-
 int ksprintf(char* buffer, const char* fmt, ...)
 {
     va_list ap;
     va_start(ap, fmt);
-    int ret = printf_internal(buffer_putch, buffer, fmt, ap);
+    PrintfBufferSink sink { buffer };
+    int ret = printf_internal(sink, fmt, ap);
     buffer[ret] = '\0';
     va_end(ap);
     return ret;
 }
 
-static void debugger_putch(char*&, char ch)
-{
-    IO::out8(0xe9, ch);
-}
-
 extern "C" int dbgprintf(const char* fmt, ...)
 {
     va_list ap;
     va_start(ap, fmt);
-    int ret = printf_internal(debugger_putch, nullptr, fmt, ap);
+    DebuggerSink sink;
+    int ret = printf_internal(sink, fmt, ap);
     va_end(ap);
     return ret;
 }
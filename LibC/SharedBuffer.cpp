@@ -29,6 +29,16 @@ RetainPtr<SharedBuffer> SharedBuffer::create_from_shared_buffer_id(int shared_bu
     return adopt(*new SharedBuffer(shared_buffer_id, size, data));
 }
 
+RetainPtr<SharedBuffer> SharedBuffer::share_with(pid_t peer)
+{
+    int shared_buffer_id = share_buffer_with(m_shared_buffer_id, peer);
+    if (shared_buffer_id < 0) {
+        perror("share_buffer_with");
+        return nullptr;
+    }
+    return adopt(*new SharedBuffer(shared_buffer_id, m_size, m_data));
+}
+
 SharedBuffer::SharedBuffer(int shared_buffer_id, int size, void* data)
     : m_shared_buffer_id(shared_buffer_id)
     , m_size(size)
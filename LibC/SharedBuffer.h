@@ -9,6 +9,10 @@ public:
     static RetainPtr<SharedBuffer> create_from_shared_buffer_id(int);
     ~SharedBuffer();
 
+    // Returns a read-only handle on the same memory for another peer.
+    // Its data() is only valid for as long as this buffer is alive.
+    RetainPtr<SharedBuffer> share_with(pid_t peer);
+
     int shared_buffer_id() const { return m_shared_buffer_id; }
     void seal();
     int size() const { return m_size; }
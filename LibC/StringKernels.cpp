@@ -0,0 +1,411 @@
+#include <AK/Types.h>
+#include <LibC/StringKernels.h>
+#include <emmintrin.h>
+#include <limits.h>
+#include <string.h>
+
+#pragma GCC optimize("O3")
+
+// Strings get read a word at a time, so the loads must be allowed to alias them.
+// memcmp() also does unaligned loads; x86 handles them fine.
+typedef dword __attribute__((may_alias)) aliasing_dword;
+typedef dword __attribute__((may_alias, aligned(1))) unaligned_dword;
+
+static inline dword repeat_byte(int c)
+{
+    return (byte)c * 0x01010101u;
+}
+
+// Non-zero iff some byte of word is zero. The lowest set bit is always in the
+// first zero byte; bits above it may be false positives.
+static inline dword has_zero_byte(dword word)
+{
+    return (word - 0x01010101u) & ~word & 0x80808080u;
+}
+
+static inline int first_marked_byte(dword marks)
+{
+    return __builtin_ctz(marks) / 8;
+}
+
+// The straightforward byte-at-a-time versions, kept around as the baseline.
+
+static size_t scalar_strlen(const char* str)
+{
+    size_t len = 0;
+    while (*(str++))
+        ++len;
+    return len;
+}
+
+static char* scalar_strchr(const char* str, int c)
+{
+    char ch = c;
+    for (;; ++str) {
+        if (*str == ch)
+            return const_cast<char*>(str);
+        if (!*str)
+            return nullptr;
+    }
+}
+
+static void* scalar_memchr(const void* ptr, int c, size_t size)
+{
+    char ch = c;
+    auto* cptr = (const char*)ptr;
+    for (size_t i = 0; i < size; ++i) {
+        if (cptr[i] == ch)
+            return const_cast<char*>(cptr + i);
+    }
+    return nullptr;
+}
+
+static int scalar_strcmp(const char* s1, const char* s2)
+{
+    while (*s1 == *s2++)
+        if (*s1++ == 0)
+            return 0;
+    return *(const unsigned char*)s1 - *(const unsigned char*)--s2;
+}
+
+static int scalar_memcmp(const void* v1, const void* v2, size_t n)
+{
+    auto* s1 = (const byte*)v1;
+    auto* s2 = (const byte*)v2;
+    while (n-- > 0) {
+        if (*s1++ != *s2++)
+            return s1[-1] < s2[-1] ? -1 : 1;
+    }
+    return 0;
+}
+
+static char* scalar_strstr(const char* haystack, const char* needle)
+{
+    char nch;
+    char hch;
+
+    if ((nch = *needle++) != 0) {
+        size_t len = scalar_strlen(needle);
+        do {
+            do {
+                if ((hch = *haystack++) == 0)
+                    return nullptr;
+            } while (hch != nch);
+        } while (strncmp(haystack, needle, len) != 0);
+        --haystack;
+    }
+    return const_cast<char*>(haystack);
+}
+
+// Word-at-a-time (SWAR) versions, using the has_zero_byte() trick.
+
+static size_t swar_strlen(const char* str)
+{
+    const char* ptr = str;
+    for (; (dword)ptr & 3; ++ptr) {
+        if (!*ptr)
+            return ptr - str;
+    }
+    auto* words = (const aliasing_dword*)ptr;
+    dword marks;
+    while (!(marks = has_zero_byte(*words)))
+        ++words;
+    return (const char*)words + first_marked_byte(marks) - str;
+}
+
+static char* swar_strchr(const char* str, int c)
+{
+    char ch = c;
+    for (; (dword)str & 3; ++str) {
+        if (*str == ch)
+            return const_cast<char*>(str);
+        if (!*str)
+            return nullptr;
+    }
+    dword pattern = repeat_byte(c);
+    auto* words = (const aliasing_dword*)str;
+    dword marks;
+    while (!(marks = has_zero_byte(*words) | has_zero_byte(*words ^ pattern)))
+        ++words;
+    auto* found = (const char*)words + first_marked_byte(marks);
+    return *found == ch ? const_cast<char*>(found) : nullptr;
+}
+
+static void* swar_memchr(const void* ptr, int c, size_t size)
+{
+    char ch = c;
+    auto* cptr = (const char*)ptr;
+    for (; size && ((dword)cptr & 3); --size, ++cptr) {
+        if (*cptr == ch)
+            return const_cast<char*>(cptr);
+    }
+    dword pattern = repeat_byte(c);
+    for (; size >= sizeof(dword); size -= sizeof(dword), cptr += sizeof(dword)) {
+        dword marks = has_zero_byte(*(const aliasing_dword*)cptr ^ pattern);
+        if (marks)
+            return const_cast<char*>(cptr + first_marked_byte(marks));
+    }
+    for (; size; --size, ++cptr) {
+        if (*cptr == ch)
+            return const_cast<char*>(cptr);
+    }
+    return nullptr;
+}
+
+static int swar_strcmp(const char* s1, const char* s2)
+{
+    // Only worth it when both strings can be word-aligned at the same time.
+    if (!(((dword)s1 ^ (dword)s2) & 3)) {
+        for (; (dword)s1 & 3; ++s1, ++s2) {
+            if (*s1 != *s2 || !*s1)
+                return *(const unsigned char*)s1 - *(const unsigned char*)s2;
+        }
+        auto* w1 = (const aliasing_dword*)s1;
+        auto* w2 = (const aliasing_dword*)s2;
+        while (*w1 == *w2 && !has_zero_byte(*w1)) {
+            ++w1;
+            ++w2;
+        }
+        s1 = (const char*)w1;
+        s2 = (const char*)w2;
+    }
+    return scalar_strcmp(s1, s2);
+}
+
+static int swar_memcmp(const void* v1, const void* v2, size_t n)
+{
+    auto* s1 = (const byte*)v1;
+    auto* s2 = (const byte*)v2;
+    for (; n >= sizeof(dword); n -= sizeof(dword), s1 += sizeof(dword), s2 += sizeof(dword)) {
+        if (*(const unaligned_dword*)s1 != *(const unaligned_dword*)s2)
+            return scalar_memcmp(s1, s2, sizeof(dword));
+    }
+    return scalar_memcmp(s1, s2, n);
+}
+
+// Boyer-Moore-Horspool. Calls back into strlen()/strchr()/memcmp(), so it
+// picks up whichever kernels are active.
+static char* horspool_strstr(const char* haystack, const char* needle)
+{
+    if (!needle[0])
+        return const_cast<char*>(haystack);
+
+    // Jump straight to the first possible match; for short needles a fast
+    // strchr() scan is all there is to it.
+    haystack = strchr(haystack, needle[0]);
+    if (!haystack)
+        return nullptr;
+    size_t needle_length = strlen(needle);
+    if (needle_length < 4) {
+        for (; haystack; haystack = strchr(haystack + 1, needle[0])) {
+            if (!strncmp(haystack, needle, needle_length))
+                return const_cast<char*>(haystack);
+        }
+        return nullptr;
+    }
+
+    size_t haystack_length = strlen(haystack);
+    if (haystack_length < needle_length)
+        return nullptr;
+
+    size_t last = needle_length - 1;
+    size_t skip[256];
+    for (size_t i = 0; i < 256; ++i)
+        skip[i] = needle_length;
+    for (size_t i = 0; i < last; ++i)
+        skip[(byte)needle[i]] = last - i;
+
+    auto* hay = (const byte*)haystack;
+    byte last_byte = needle[last];
+    for (size_t pos = 0; pos <= haystack_length - needle_length; pos += skip[hay[pos + last]]) {
+        if (hay[pos + last] == last_byte && !memcmp(hay + pos, needle, last))
+            return const_cast<char*>(haystack + pos);
+    }
+    return nullptr;
+}
+
+// SSE2 versions. Loads are 16-byte aligned, except in memcmp() (bounded by n)
+// and strcmp() (which steps bytewise near page ends.)
+
+[[gnu::target("sse2")]] static inline dword sse2_zero_marks(__m128i chunk)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_setzero_si128()));
+}
+
+[[gnu::target("sse2")]] static size_t sse2_strlen(const char* str)
+{
+    dword offset = (dword)str & 15;
+    auto* chunk = (const __m128i*)(str - offset);
+    dword marks = sse2_zero_marks(_mm_load_si128(chunk)) >> offset;
+    if (marks)
+        return __builtin_ctz(marks);
+    for (;;) {
+        ++chunk;
+        marks = sse2_zero_marks(_mm_load_si128(chunk));
+        if (marks)
+            return (const char*)chunk + __builtin_ctz(marks) - str;
+    }
+}
+
+[[gnu::target("sse2")]] static char* sse2_strchr(const char* str, int c)
+{
+    __m128i pattern = _mm_set1_epi8((char)c);
+    dword offset = (dword)str & 15;
+    auto* chunk = (const __m128i*)(str - offset);
+    __m128i data = _mm_load_si128(chunk);
+    dword marks = (sse2_zero_marks(data) | _mm_movemask_epi8(_mm_cmpeq_epi8(data, pattern))) >> offset;
+    const char* found;
+    if (marks) {
+        found = str + __builtin_ctz(marks);
+    } else {
+        for (;;) {
+            ++chunk;
+            data = _mm_load_si128(chunk);
+            marks = sse2_zero_marks(data) | _mm_movemask_epi8(_mm_cmpeq_epi8(data, pattern));
+            if (marks)
+                break;
+        }
+        found = (const char*)chunk + __builtin_ctz(marks);
+    }
+    return *found == (char)c ? const_cast<char*>(found) : nullptr;
+}
+
+[[gnu::target("sse2")]] static void* sse2_memchr(const void* ptr, int c, size_t size)
+{
+    if (!size)
+        return nullptr;
+    __m128i pattern = _mm_set1_epi8((char)c);
+    auto* cptr = (const char*)ptr;
+    dword offset = (dword)cptr & 15;
+    auto* chunk = (const char*)(cptr - offset);
+    dword marks = (dword)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)chunk), pattern)) >> offset;
+    // Bytes from cptr that the first chunk covers.
+    size_t covered = 16 - offset;
+    if (marks) {
+        size_t index = __builtin_ctz(marks);
+        return index < size ? const_cast<char*>(cptr + index) : nullptr;
+    }
+    if (size <= covered)
+        return nullptr;
+    size -= covered;
+    for (;;) {
+        chunk += 16;
+        marks = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)chunk), pattern));
+        if (marks) {
+            size_t index = __builtin_ctz(marks);
+            return index < size ? const_cast<char*>(chunk + index) : nullptr;
+        }
+        if (size <= 16)
+            return nullptr;
+        size -= 16;
+    }
+}
+
+static inline bool near_page_end(const char* ptr)
+{
+    return ((dword)ptr & (PAGE_SIZE - 1)) > PAGE_SIZE - 16;
+}
+
+[[gnu::target("sse2")]] static int sse2_strcmp(const char* s1, const char* s2)
+{
+    for (;;) {
+        if (near_page_end(s1) || near_page_end(s2)) {
+            if (*s1 != *s2 || !*s1)
+                return *(const unsigned char*)s1 - *(const unsigned char*)s2;
+            ++s1;
+            ++s2;
+            continue;
+        }
+        __m128i a = _mm_loadu_si128((const __m128i*)s1);
+        __m128i b = _mm_loadu_si128((const __m128i*)s2);
+        // A bit for every byte where the strings match and haven't ended.
+        dword same = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) & ~sse2_zero_marks(a) & 0xffff;
+        if (same != 0xffff) {
+            int index = __builtin_ctz(~same);
+            return ((const unsigned char*)s1)[index] - ((const unsigned char*)s2)[index];
+        }
+        s1 += 16;
+        s2 += 16;
+    }
+}
+
+[[gnu::target("sse2")]] static int sse2_memcmp(const void* v1, const void* v2, size_t n)
+{
+    auto* s1 = (const byte*)v1;
+    auto* s2 = (const byte*)v2;
+    for (; n >= 16; n -= 16, s1 += 16, s2 += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)s1);
+        __m128i b = _mm_loadu_si128((const __m128i*)s2);
+        dword same = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+        if (same != 0xffff) {
+            int index = __builtin_ctz(~same);
+            return s1[index] < s2[index] ? -1 : 1;
+        }
+    }
+    return swar_memcmp(s1, s2, n);
+}
+
+// Checked once, via CPUID.
+static bool cpu_has_sse2()
+{
+    dword eax, ebx, ecx, edx;
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(1), "c"(0));
+    return (edx & (1 << 26)) != 0;
+}
+
+static const StringKernels s_scalar_kernels {
+    "scalar",
+    scalar_strlen,
+    scalar_strchr,
+    scalar_memchr,
+    scalar_strcmp,
+    scalar_memcmp,
+    scalar_strstr,
+};
+
+static const StringKernels s_swar_kernels {
+    "swar",
+    swar_strlen,
+    swar_strchr,
+    swar_memchr,
+    swar_strcmp,
+    swar_memcmp,
+    horspool_strstr,
+};
+
+static const StringKernels s_sse2_kernels {
+    "sse2",
+    sse2_strlen,
+    sse2_strchr,
+    sse2_memchr,
+    sse2_strcmp,
+    sse2_memcmp,
+    horspool_strstr,
+};
+
+const StringKernels* __string_kernels = &s_swar_kernels;
+static bool s_has_sse2;
+
+extern "C" void __string_init()
+{
+    s_has_sse2 = cpu_has_sse2();
+    if (s_has_sse2)
+        __string_kernels = &s_sse2_kernels;
+}
+
+const StringKernels& scalar_string_kernels()
+{
+    return s_scalar_kernels;
+}
+
+const StringKernels& swar_string_kernels()
+{
+    return s_swar_kernels;
+}
+
+const StringKernels* sse2_string_kernels()
+{
+    return s_has_sse2 ? &s_sse2_kernels : nullptr;
+}
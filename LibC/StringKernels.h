@@ -0,0 +1,33 @@
+#pragma once
+
+#include <AK/Types.h>
+#include <stddef.h>
+
+// Implementations of the hot <string.h> primitives. string.cpp forwards to
+// the best set this CPU supports, which __libc_init() picks once via CPUID.
+// Until then (and on CPUs without SSE2) the word-at-a-time set is used.
+//
+// All of them read whole aligned words/vectors, which may run past the end
+// of the string or buffer but never into the next page.
+struct StringKernels {
+    const char* name;
+
+    size_t (*strlen)(const char*);
+    char* (*strchr)(const char*, int);
+    void* (*memchr)(const void*, int, size_t);
+    int (*strcmp)(const char*, const char*);
+    int (*memcmp)(const void*, const void*, size_t);
+    char* (*strstr)(const char* haystack, const char* needle);
+};
+
+extern const StringKernels* __string_kernels;
+
+inline const StringKernels& string_kernels()
+{
+    return *__string_kernels;
+}
+
+// Kernel sets for benchmarking. sse2_string_kernels() returns null if the CPU lacks SSE2.
+const StringKernels& scalar_string_kernels();
+const StringKernels& swar_string_kernels();
+const StringKernels* sse2_string_kernels();
@@ -22,6 +22,7 @@ DIR* opendir(const char* name)
     dirp->buffer = nullptr;
     dirp->buffer_size = 0;
     dirp->nextptr = nullptr;
+    dirp->buffer_has_stat = false;
     return dirp;
 }
 
@@ -49,28 +50,54 @@ struct [[gnu::packed]] sys_dirent {
     }
 };
 
-dirent* readdir(DIR* dirp)
+static bool fill_buffer(DIR* dirp, bool with_stat)
 {
-    if (!dirp)
-        return nullptr;
-    if (dirp->fd == -1)
-        return nullptr;
+    struct stat st;
+    int rc = fstat(dirp->fd, &st);
+    if (rc < 0)
+        return false;
 
-    if (!dirp->buffer) {
-        struct stat st;
-        int rc = fstat(dirp->fd, &st);
-        if (rc < 0)
-            return nullptr;
+    if (!with_stat) {
         size_t size_to_allocate = max(st.st_size, 4096);
         dirp->buffer = (char*)malloc(size_to_allocate);
         ssize_t nread = syscall(SC_get_dir_entries, dirp->fd, dirp->buffer, size_to_allocate);
         dirp->buffer_size = nread;
         dirp->nextptr = dirp->buffer;
+        return true;
+    }
+
+    // Entries carry a struct stat each, so we can't tell how much room they need up front.
+    size_t size_to_allocate = max(st.st_size * 4, 4096);
+    for (;;) {
+        dirp->buffer = (char*)malloc(size_to_allocate);
+        ssize_t nread = syscall(SC_get_dir_entries_with_stat, dirp->fd, dirp->buffer, size_to_allocate);
+        if (nread >= 0) {
+            dirp->buffer_size = nread;
+            dirp->nextptr = dirp->buffer;
+            dirp->buffer_has_stat = true;
+            return true;
+        }
+        free(dirp->buffer);
+        dirp->buffer = nullptr;
+        if (nread != -ERANGE) {
+            errno = -nread;
+            return false;
+        }
+        size_to_allocate *= 2;
     }
+}
 
+static dirent* next_entry(DIR* dirp, struct stat* statbuf)
+{
     if (dirp->nextptr >= (dirp->buffer + dirp->buffer_size))
         return nullptr;
 
+    if (dirp->buffer_has_stat) {
+        if (statbuf)
+            memcpy(statbuf, dirp->nextptr, sizeof(struct stat));
+        dirp->nextptr += sizeof(struct stat);
+    }
+
     auto* sys_ent = (sys_dirent*)dirp->nextptr;
     dirp->cur_ent.d_ino = sys_ent->ino;
     dirp->cur_ent.d_type = sys_ent->file_type;
@@ -85,5 +112,32 @@ dirent* readdir(DIR* dirp)
     return &dirp->cur_ent;
 }
 
+dirent* readdir(DIR* dirp)
+{
+    if (!dirp)
+        return nullptr;
+    if (dirp->fd == -1)
+        return nullptr;
+    if (!dirp->buffer && !fill_buffer(dirp, false))
+        return nullptr;
+    return next_entry(dirp, nullptr);
+}
+
+dirent* readdir_with_stat(DIR* dirp, struct stat* statbuf)
+{
+    if (!dirp)
+        return nullptr;
+    if (dirp->fd == -1)
+        return nullptr;
+    if (!dirp->buffer && !fill_buffer(dirp, true))
+        return nullptr;
+    if (!dirp->buffer_has_stat) {
+        // Already being read with readdir().
+        errno = EINVAL;
+        return nullptr;
+    }
+    return next_entry(dirp, statbuf);
+}
+
 }
 
@@ -19,12 +19,19 @@ struct __DIR {
     char* buffer;
     size_t buffer_size;
     char* nextptr;
+    int buffer_has_stat;
 };
 typedef struct __DIR DIR;
 
+struct stat;
+
 DIR* opendir(const char* name);
 int closedir(DIR*);
 struct dirent* readdir(DIR*);
 
+// Like readdir(), but also fills in what lstat() would say about the entry,
+// fetched for the whole directory at once. Use it from the first read on.
+struct dirent* readdir_with_stat(DIR*, struct stat*);
+
 __END_DECLS
 
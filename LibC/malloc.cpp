@@ -5,9 +5,17 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
+#include <sched.h>
 #include <serenity.h>
 
-// FIXME: Thread safety.
+// Thread safety: the blocks and size class lists (the "core") are protected by one global lock.
+// In front of the core sits a set of caches, each holding a small magazine of free chunks per size class.
+// We don't have thread-local storage, so a thread picks its cache by hashing its stack address.
+// Stacks are separate 64 KB regions, so concurrently running threads usually land in different caches.
+// Each cache has its own lock, which is normally uncontended and never waited on:
+// if a cache is busy because another thread hashed to it, we just go to the core instead.
+// Like elsewhere, malloc() and free() are not async-signal-safe: a signal handler that
+// interrupts a thread holding the core lock would spin on it forever.
 
 //#define MALLOC_DEBUG
 #define RECYCLE_BIG_ALLOCATIONS
@@ -20,13 +28,44 @@
 
 static const size_t number_of_chunked_blocks_to_keep_around_per_size_class = 32;
 static const size_t number_of_big_blocks_to_keep_around_per_size_class = 8;
+static const int number_of_caches = 16;
+static const int magazine_capacity = 16;
 
 static bool s_log_malloc = false;
-static bool s_scrub_malloc = true;
-static bool s_scrub_free = true;
+static bool s_scrub_malloc = false;
+static bool s_scrub_free = false;
 static unsigned short size_classes[] = { 8, 16, 32, 64, 128, 252, 508, 1016, 2036, 0 };
 static constexpr size_t num_size_classes = sizeof(size_classes) / sizeof(unsigned short);
 
+class SpinLock {
+public:
+    bool try_lock() { return !__sync_lock_test_and_set(&m_lock, 1); }
+    void lock()
+    {
+        while (!try_lock())
+            sched_yield();
+    }
+    void unlock() { __sync_lock_release(&m_lock); }
+
+private:
+    volatile int m_lock { 0 };
+};
+
+class SpinLocker {
+public:
+    explicit SpinLocker(SpinLock& lock)
+        : m_lock(lock)
+    {
+        m_lock.lock();
+    }
+    ~SpinLocker() { m_lock.unlock(); }
+
+private:
+    SpinLock& m_lock;
+};
+
+static SpinLock s_core_lock;
+
 struct CommonHeader {
     size_t m_magic;
     size_t m_size;
@@ -90,8 +129,19 @@ struct BigAllocator {
     Vector<BigAllocationBlock*, number_of_big_blocks_to_keep_around_per_size_class> blocks;
 };
 
+struct Magazine {
+    int count { 0 };
+    void* chunks[magazine_capacity];
+};
+
+struct Cache {
+    SpinLock lock;
+    Magazine magazines[num_size_classes];
+};
+
 static Allocator g_allocators[num_size_classes];
 static BigAllocator g_big_allocators[1];
+static Cache g_caches[number_of_caches];
 
 static Allocator* allocator_for_size(size_t size, size_t& good_size)
 {
@@ -105,6 +155,17 @@ static Allocator* allocator_for_size(size_t size, size_t& good_size)
     return nullptr;
 }
 
+static inline int size_class_index(const Allocator* allocator)
+{
+    return allocator - g_allocators;
+}
+
+static inline Cache& cache_for_current_thread()
+{
+    auto stack_address = (uintptr_t)__builtin_frame_address(0);
+    return g_caches[(stack_address >> 16) % number_of_caches];
+}
+
 static BigAllocator* big_allocator_for_size(size_t size)
 {
     if (size == 4096)
@@ -134,37 +195,12 @@ static void os_free(void* ptr, size_t size)
     assert(rc == 0);
 }
 
-void* malloc(size_t size)
+// Takes a chunk from the core. Must be called with s_core_lock held.
+static void* core_allocate_chunk(Allocator& allocator, size_t good_size)
 {
-    if (s_log_malloc)
-        dbgprintf("LibC: malloc(%u)\n", size);
-
-    if (!size)
-        return nullptr;
-
-    size_t good_size;
-    auto* allocator = allocator_for_size(size, good_size);
-
-    if (!allocator) {
-        size_t real_size = PAGE_ROUND_UP(sizeof(BigAllocationBlock) + size);
-#ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(real_size)) {
-            if (!allocator->blocks.is_empty()) {
-                auto* block = allocator->blocks.take_last();
-                return &block->m_slot[0];
-            }
-        }
-#endif
-        char buffer[64];
-        snprintf(buffer, sizeof(buffer), "malloc: BigAllocationBlock(%u)", real_size);
-        auto* block = (BigAllocationBlock*)os_alloc(real_size, buffer);
-        new (block) BigAllocationBlock(real_size);
-        return &block->m_slot[0];
-    }
-
     ChunkedBlock* block = nullptr;
 
-    for (block = allocator->usable_blocks.head(); block; block = block->next()) {
+    for (block = allocator.usable_blocks.head(); block; block = block->next()) {
         if (block->free_chunks())
             break;
     }
@@ -174,8 +210,8 @@ void* malloc(size_t size)
         snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%u)", good_size);
         block = (ChunkedBlock*)os_alloc(PAGE_SIZE, buffer);
         new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(block);
-        ++allocator->block_count;
+        allocator.usable_blocks.append(block);
+        ++allocator.block_count;
     }
 
     --block->m_free_chunks;
@@ -185,49 +221,22 @@ void* malloc(size_t size)
 #ifdef MALLOC_DEBUG
         dbgprintf("Block %p is now full in size class %u\n", block, good_size);
 #endif
-        allocator->usable_blocks.remove(block);
-        allocator->full_blocks.append(block);
+        allocator.usable_blocks.remove(block);
+        allocator.full_blocks.append(block);
     }
 #ifdef MALLOC_DEBUG
-    dbgprintf("LibC: allocated %p (chunk %d in block %p, size %u)\n", ptr, index, block, block->bytes_per_chunk());
+    dbgprintf("LibC: allocated %p (block %p, size %u)\n", ptr, block, block->bytes_per_chunk());
 #endif
-    if (s_scrub_malloc)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
     return ptr;
 }
 
-void free(void* ptr)
+// Returns a chunk to its block. Must be called with s_core_lock held.
+static void core_free_chunk(ChunkedBlock* block, void* ptr)
 {
-    if (!ptr)
-        return;
-
-    void* page_base = (void*)((uintptr_t)ptr & (uintptr_t)~0xfff);
-    size_t magic = *(size_t*)page_base;
-
-    if (magic == MAGIC_BIGALLOC_HEADER) {
-        auto* block = (BigAllocationBlock*)page_base;
-#ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(block->m_size)) {
-            if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
-                allocator->blocks.append(block);
-                return;
-            }
-        }
-#endif
-        os_free(block, block->m_size);
-        return;
-    }
-
-    assert(magic == MAGIC_PAGE_HEADER);
-    auto* block = (ChunkedBlock*)page_base;
-
 #ifdef MALLOC_DEBUG
-    dbgprintf("LibC: freeing %p in allocator %p (size=%u, used=%u)\n", ptr, page, page->bytes_per_chunk(), page->used_chunks());
+    dbgprintf("LibC: freeing %p in block %p (size=%u, used=%u)\n", ptr, block, block->bytes_per_chunk(), block->used_chunks());
 #endif
 
-    if (s_scrub_free)
-        memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
-
     auto* entry = (FreelistEntry*)ptr;
     entry->next = block->m_freelist;
     block->m_freelist = entry;
@@ -269,6 +278,118 @@ void free(void* ptr)
     }
 }
 
+static void* allocate_chunk(Allocator& allocator, size_t good_size)
+{
+    auto& cache = cache_for_current_thread();
+    if (!cache.lock.try_lock()) {
+        SpinLocker locker(s_core_lock);
+        return core_allocate_chunk(allocator, good_size);
+    }
+    auto& magazine = cache.magazines[size_class_index(&allocator)];
+    if (!magazine.count) {
+        // Refill half the magazine, so a following free() has room without going to the core.
+        SpinLocker locker(s_core_lock);
+        while (magazine.count < magazine_capacity / 2)
+            magazine.chunks[magazine.count++] = core_allocate_chunk(allocator, good_size);
+    }
+    void* ptr = magazine.chunks[--magazine.count];
+    cache.lock.unlock();
+    return ptr;
+}
+
+static void free_chunk(ChunkedBlock* block, void* ptr)
+{
+    auto& cache = cache_for_current_thread();
+    if (!cache.lock.try_lock()) {
+        SpinLocker locker(s_core_lock);
+        core_free_chunk(block, ptr);
+        return;
+    }
+    size_t good_size;
+    auto* allocator = allocator_for_size(block->m_size, good_size);
+    auto& magazine = cache.magazines[size_class_index(allocator)];
+    if (magazine.count == magazine_capacity) {
+        // Give the older half back, so the chunks we just touched stay cached.
+        SpinLocker locker(s_core_lock);
+        int half = magazine_capacity / 2;
+        for (int i = 0; i < half; ++i) {
+            void* chunk = magazine.chunks[i];
+            core_free_chunk((ChunkedBlock*)((uintptr_t)chunk & (uintptr_t)~0xfff), chunk);
+        }
+        memmove(magazine.chunks, magazine.chunks + half, (magazine_capacity - half) * sizeof(void*));
+        magazine.count -= half;
+    }
+    magazine.chunks[magazine.count++] = ptr;
+    cache.lock.unlock();
+}
+
+void* malloc(size_t size)
+{
+    if (s_log_malloc)
+        dbgprintf("LibC: malloc(%u)\n", size);
+
+    if (!size)
+        return nullptr;
+
+    size_t good_size;
+    auto* allocator = allocator_for_size(size, good_size);
+
+    if (!allocator) {
+        size_t real_size = PAGE_ROUND_UP(sizeof(BigAllocationBlock) + size);
+#ifdef RECYCLE_BIG_ALLOCATIONS
+        if (auto* allocator = big_allocator_for_size(real_size)) {
+            SpinLocker locker(s_core_lock);
+            if (!allocator->blocks.is_empty()) {
+                auto* block = allocator->blocks.take_last();
+                return &block->m_slot[0];
+            }
+        }
+#endif
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "malloc: BigAllocationBlock(%u)", real_size);
+        auto* block = (BigAllocationBlock*)os_alloc(real_size, buffer);
+        new (block) BigAllocationBlock(real_size);
+        return &block->m_slot[0];
+    }
+
+    void* ptr = allocate_chunk(*allocator, good_size);
+    if (s_scrub_malloc)
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
+    return ptr;
+}
+
+void free(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    void* page_base = (void*)((uintptr_t)ptr & (uintptr_t)~0xfff);
+    size_t magic = *(size_t*)page_base;
+
+    if (magic == MAGIC_BIGALLOC_HEADER) {
+        auto* block = (BigAllocationBlock*)page_base;
+#ifdef RECYCLE_BIG_ALLOCATIONS
+        if (auto* allocator = big_allocator_for_size(block->m_size)) {
+            SpinLocker locker(s_core_lock);
+            if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
+                allocator->blocks.append(block);
+                return;
+            }
+        }
+#endif
+        os_free(block, block->m_size);
+        return;
+    }
+
+    assert(magic == MAGIC_PAGE_HEADER);
+    auto* block = (ChunkedBlock*)page_base;
+
+    if (s_scrub_free)
+        memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+
+    free_chunk(block, ptr);
+}
+
 void* calloc(size_t count, size_t size)
 {
     size_t new_size = count * size;
@@ -297,10 +418,10 @@ void* realloc(void* ptr, size_t size)
 
 void __malloc_init()
 {
-    if (getenv("LIBC_NOSCRUB_MALLOC"))
-        s_scrub_malloc = false;
-    if (getenv("LIBC_NOSCRUB_FREE"))
-        s_scrub_free = false;
+    if (getenv("LIBC_SCRUB_MALLOC"))
+        s_scrub_malloc = true;
+    if (getenv("LIBC_SCRUB_FREE"))
+        s_scrub_free = true;
     if (getenv("LIBC_LOG_MALLOC"))
         s_log_malloc = true;
 }
@@ -0,0 +1,653 @@
+#include <AK/Types.h>
+#include <Kernel/Syscall.h>
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <mman.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+//#define PTHREAD_DEBUG
+
+#define PAGE_ROUND_UP(x) ((((size_t)(x)) + PAGE_SIZE - 1) & (~(PAGE_SIZE - 1)))
+
+// Every thread's %gs segment is based at its __pthread, so self must be the first member.
+struct __pthread {
+    __pthread* self;
+    int tid; // Set by the kernel before the thread runs, cleared (and futex-woken) when it exits.
+    int detach_state;
+    void* (*start_routine)(void*);
+    int (*raw_entry)(void*); // For threads started through create_thread().
+    void* argument;
+    void* return_value;
+    void* guard_page;
+    void* stack_region;
+    size_t stack_region_size;
+    __pthread* next_exited;
+    bool queued_for_reaping;
+    const void* specific[PTHREAD_KEYS_MAX];
+};
+
+enum {
+    __PTHREAD_JOINABLE = 0,
+    __PTHREAD_DETACHED,
+    __PTHREAD_EXITED,
+};
+
+static const size_t default_stack_size = 1 * MB;
+static const int mutex_spin_count = 100;
+
+static __pthread s_main_thread;
+
+struct KeySlot {
+    bool in_use;
+    void (*destructor)(void*);
+};
+static KeySlot s_keys[PTHREAD_KEYS_MAX];
+static pthread_spinlock_t s_keys_lock;
+
+// Detached threads can't unmap the stack they're running on; whoever creates
+// the next thread cleans up after them once the kernel has cleared their tid.
+static __pthread* s_exited_threads;
+static pthread_spinlock_t s_exited_threads_lock;
+
+// These bypass errno on purpose, since it isn't per-thread.
+static int futex_wait(int* address, int value, const struct timespec* timeout)
+{
+    Syscall::SC_futex_params params { address, FUTEX_WAIT, value, timeout, nullptr, 0 };
+    return syscall(SC_futex, &params);
+}
+
+static int futex_wake(int* address, int count)
+{
+    Syscall::SC_futex_params params { address, FUTEX_WAKE, count, nullptr, nullptr, 0 };
+    return syscall(SC_futex, &params);
+}
+
+static int futex_requeue(int* address, int wake_count, int* target, int requeue_count)
+{
+    Syscall::SC_futex_params params { address, FUTEX_REQUEUE, wake_count, nullptr, target, requeue_count };
+    return syscall(SC_futex, &params);
+}
+
+static void free_thread(__pthread* thread)
+{
+    // Read everything we need before the struct itself goes away.
+    void* guard_page = thread->guard_page;
+    void* stack_region = thread->stack_region;
+    size_t stack_region_size = thread->stack_region_size;
+    munmap(guard_page, PAGE_SIZE);
+    munmap(stack_region, stack_region_size);
+}
+
+static void reap_exited_threads()
+{
+    pthread_spin_lock(&s_exited_threads_lock);
+    __pthread** link = &s_exited_threads;
+    while (*link) {
+        __pthread* thread = *link;
+        if (__atomic_load_n(&thread->tid, __ATOMIC_ACQUIRE)) {
+            link = &thread->next_exited;
+            continue;
+        }
+        *link = thread->next_exited;
+        free_thread(thread);
+    }
+    pthread_spin_unlock(&s_exited_threads_lock);
+}
+
+static void add_to_exited_threads(__pthread* thread)
+{
+    pthread_spin_lock(&s_exited_threads_lock);
+    if (!thread->queued_for_reaping) {
+        thread->queued_for_reaping = true;
+        thread->next_exited = s_exited_threads;
+        s_exited_threads = thread;
+    }
+    pthread_spin_unlock(&s_exited_threads_lock);
+}
+
+static bool allocate_stack(__pthread*& thread, size_t stack_size)
+{
+    size_t region_size = PAGE_ROUND_UP(stack_size + sizeof(__pthread));
+    // Reserve room for the guard page and the stack together, then map each
+    // half at its fixed spot. Another thread may grab the hole in between, so retry.
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        byte* reservation = (byte*)mmap(nullptr, PAGE_SIZE + region_size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+        if (reservation == MAP_FAILED)
+            return false;
+        munmap(reservation, PAGE_SIZE + region_size);
+        void* guard_page = mmap_with_name(reservation, PAGE_SIZE, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, "Stack guard (pthread)");
+        if (guard_page == MAP_FAILED)
+            continue;
+        void* stack_region = mmap_with_name(reservation + PAGE_SIZE, region_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, "Stack (pthread)");
+        if (stack_region == MAP_FAILED) {
+            munmap(guard_page, PAGE_SIZE);
+            continue;
+        }
+        thread = (__pthread*)(((dword)stack_region + region_size - sizeof(__pthread)) & ~15u);
+        thread->guard_page = guard_page;
+        thread->stack_region = stack_region;
+        thread->stack_region_size = region_size;
+        return true;
+    }
+    return false;
+}
+
+static int run_thread(void* argument)
+{
+    auto* thread = (__pthread*)argument;
+    pthread_exit(thread->start_routine(thread->argument));
+}
+
+static int run_raw_thread(void* argument)
+{
+    auto* thread = (__pthread*)argument;
+    exit_thread(thread->raw_entry(thread->argument));
+    return 0;
+}
+
+static __pthread* create_control_block(size_t stack_size, int detach_state)
+{
+    reap_exited_threads();
+
+    __pthread* thread = nullptr;
+    if (!allocate_stack(thread, stack_size))
+        return nullptr;
+    thread->self = thread;
+    thread->tid = 0;
+    thread->detach_state = detach_state;
+    thread->start_routine = nullptr;
+    thread->raw_entry = nullptr;
+    thread->argument = nullptr;
+    thread->return_value = nullptr;
+    thread->next_exited = nullptr;
+    thread->queued_for_reaping = false;
+    memset(thread->specific, 0, sizeof(thread->specific));
+    return thread;
+}
+
+// Returns the new TID, or a negated errno (and frees the control block) on failure.
+static int start_thread(__pthread* thread, int (*entry)(void*))
+{
+    Syscall::SC_create_thread_params params {
+        thread->stack_region,
+        (size_t)((dword)thread - (dword)thread->stack_region),
+        thread,
+        &thread->tid
+    };
+    int rc = syscall(SC_create_thread, entry, thread, &params);
+    if (rc < 0) {
+        free_thread(thread);
+        return rc;
+    }
+#ifdef PTHREAD_DEBUG
+    dbgprintf("start_thread: tid=%d, stack=%p (%u bytes)\n", rc, thread->stack_region, thread->stack_region_size);
+#endif
+    return rc;
+}
+
+static void lock_mutex_contended(pthread_mutex_t* mutex, int state)
+{
+    for (int i = 0; i < mutex_spin_count; ++i) {
+        asm volatile("pause");
+        if (__atomic_load_n(&mutex->lock, __ATOMIC_RELAXED) != 0)
+            continue;
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&mutex->lock, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return;
+    }
+    // Mark the lock contended so the holder knows to wake us, then sleep until it's ours.
+    if (state != 2)
+        state = __atomic_exchange_n(&mutex->lock, 2, __ATOMIC_ACQUIRE);
+    while (state != 0) {
+        futex_wait(&mutex->lock, 2, nullptr);
+        state = __atomic_exchange_n(&mutex->lock, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+extern "C" {
+
+void __pthread_init()
+{
+    s_main_thread.self = &s_main_thread;
+    s_main_thread.tid = syscall(SC_gettid);
+    syscall(SC_set_thread_specific_data, &s_main_thread);
+}
+
+void __pthread_fork_child()
+{
+    // Only the forking thread survives, and it has a new TID.
+    pthread_self()->tid = syscall(SC_gettid);
+}
+
+int gettid()
+{
+    return pthread_self()->tid;
+}
+
+// Threads started the old way get a control block too, so pthread_self(),
+// gettid() and everything built on them work in every thread.
+int create_thread(int (*entry)(void*), void* argument)
+{
+    auto* thread = create_control_block(default_stack_size, __PTHREAD_DETACHED);
+    if (!thread) {
+        errno = EAGAIN;
+        return -1;
+    }
+    thread->raw_entry = entry;
+    thread->argument = argument;
+    int rc = start_thread(thread, run_raw_thread);
+    // Nobody can join these, so their stacks get reaped as soon as they exit.
+    if (rc >= 0)
+        add_to_exited_threads(thread);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int pthread_create(pthread_t* out_thread, pthread_attr_t* attributes, void* (*start_routine)(void*), void* argument)
+{
+    size_t stack_size = attributes ? attributes->stack_size : default_stack_size;
+    int detach_state = attributes ? attributes->detach_state : __PTHREAD_JOINABLE;
+    auto* thread = create_control_block(stack_size, detach_state);
+    if (!thread)
+        return EAGAIN;
+    thread->start_routine = start_routine;
+    thread->argument = argument;
+    int rc = start_thread(thread, run_thread);
+    if (rc < 0)
+        return -rc;
+    if (out_thread)
+        *out_thread = thread;
+    return 0;
+}
+
+void pthread_exit(void* value)
+{
+    auto* self = pthread_self();
+    self->return_value = value;
+
+    for (int iteration = 0; iteration < PTHREAD_DESTRUCTOR_ITERATIONS; ++iteration) {
+        bool called_any = false;
+        for (int key = 0; key < PTHREAD_KEYS_MAX; ++key) {
+            void* specific = const_cast<void*>(self->specific[key]);
+            if (!specific || !s_keys[key].in_use || !s_keys[key].destructor)
+                continue;
+            self->specific[key] = nullptr;
+            s_keys[key].destructor(specific);
+            called_any = true;
+        }
+        if (!called_any)
+            break;
+    }
+
+    int expected = __PTHREAD_JOINABLE;
+    if (!__atomic_compare_exchange_n(&self->detach_state, &expected, __PTHREAD_EXITED, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // Detached: nobody will join us, so leave the stack for reap_exited_threads().
+        if (self != &s_main_thread)
+            add_to_exited_threads(self);
+    }
+    exit_thread(0);
+    ASSERT_NOT_REACHED();
+}
+
+int pthread_join(pthread_t thread, void** return_value)
+{
+    if (thread == pthread_self())
+        return EDEADLK;
+    if (thread == &s_main_thread || __atomic_load_n(&thread->detach_state, __ATOMIC_ACQUIRE) == __PTHREAD_DETACHED)
+        return EINVAL;
+    for (;;) {
+        int tid = __atomic_load_n(&thread->tid, __ATOMIC_ACQUIRE);
+        if (!tid)
+            break;
+        futex_wait(&thread->tid, tid, nullptr);
+    }
+    if (return_value)
+        *return_value = thread->return_value;
+    free_thread(thread);
+    return 0;
+}
+
+int pthread_detach(pthread_t thread)
+{
+    int expected = __PTHREAD_JOINABLE;
+    if (__atomic_compare_exchange_n(&thread->detach_state, &expected, __PTHREAD_DETACHED, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return 0;
+    if (expected == __PTHREAD_DETACHED)
+        return EINVAL;
+    // It already exited (or is about to); the tid check in reap_exited_threads() covers the latter.
+    if (thread != &s_main_thread)
+        add_to_exited_threads(thread);
+    return 0;
+}
+
+pthread_t pthread_self()
+{
+    pthread_t self;
+    asm("movl %%gs:0, %0" : "=r"(self));
+    return self;
+}
+
+int pthread_equal(pthread_t a, pthread_t b)
+{
+    return a == b;
+}
+
+int pthread_attr_init(pthread_attr_t* attributes)
+{
+    attributes->detach_state = PTHREAD_CREATE_JOINABLE;
+    attributes->stack_size = default_stack_size;
+    return 0;
+}
+
+int pthread_attr_destroy(pthread_attr_t*)
+{
+    return 0;
+}
+
+int pthread_attr_getdetachstate(const pthread_attr_t* attributes, int* detach_state)
+{
+    *detach_state = attributes->detach_state;
+    return 0;
+}
+
+int pthread_attr_setdetachstate(pthread_attr_t* attributes, int detach_state)
+{
+    if (detach_state != PTHREAD_CREATE_JOINABLE && detach_state != PTHREAD_CREATE_DETACHED)
+        return EINVAL;
+    attributes->detach_state = detach_state;
+    return 0;
+}
+
+int pthread_attr_getstacksize(const pthread_attr_t* attributes, size_t* stack_size)
+{
+    *stack_size = attributes->stack_size;
+    return 0;
+}
+
+int pthread_attr_setstacksize(pthread_attr_t* attributes, size_t stack_size)
+{
+    if (stack_size < PTHREAD_STACK_MIN)
+        return EINVAL;
+    attributes->stack_size = stack_size;
+    return 0;
+}
+
+int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attributes)
+{
+    mutex->lock = 0;
+    mutex->type = attributes ? attributes->type : PTHREAD_MUTEX_NORMAL;
+    mutex->owner = nullptr;
+    mutex->level = 0;
+    return 0;
+}
+
+int pthread_mutex_destroy(pthread_mutex_t*)
+{
+    return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    auto* self = pthread_self();
+    if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == self) {
+        ++mutex->level;
+        return 0;
+    }
+    int state = 0;
+    if (!__atomic_compare_exchange_n(&mutex->lock, &state, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        lock_mutex_contended(mutex, state);
+    mutex->owner = self;
+    mutex->level = 1;
+    return 0;
+}
+
+int pthread_mutex_trylock(pthread_mutex_t* mutex)
+{
+    auto* self = pthread_self();
+    if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == self) {
+        ++mutex->level;
+        return 0;
+    }
+    int expected = 0;
+    if (!__atomic_compare_exchange_n(&mutex->lock, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return EBUSY;
+    mutex->owner = self;
+    mutex->level = 1;
+    return 0;
+}
+
+int pthread_mutex_unlock(pthread_mutex_t* mutex)
+{
+    if (mutex->type == PTHREAD_MUTEX_RECURSIVE && --mutex->level)
+        return 0;
+    mutex->owner = nullptr;
+    mutex->level = 0;
+    if (__atomic_fetch_sub(&mutex->lock, 1, __ATOMIC_RELEASE) != 1) {
+        __atomic_store_n(&mutex->lock, 0, __ATOMIC_RELEASE);
+        futex_wake(&mutex->lock, 1);
+    }
+    return 0;
+}
+
+int pthread_mutexattr_init(pthread_mutexattr_t* attributes)
+{
+    attributes->type = PTHREAD_MUTEX_NORMAL;
+    return 0;
+}
+
+int pthread_mutexattr_settype(pthread_mutexattr_t* attributes, int type)
+{
+    if (type != PTHREAD_MUTEX_NORMAL && type != PTHREAD_MUTEX_RECURSIVE)
+        return EINVAL;
+    attributes->type = type;
+    return 0;
+}
+
+int pthread_mutexattr_destroy(pthread_mutexattr_t*)
+{
+    return 0;
+}
+
+int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t*)
+{
+    cond->sequence = 0;
+    cond->mutex = nullptr;
+    return 0;
+}
+
+int pthread_cond_destroy(pthread_cond_t*)
+{
+    return 0;
+}
+
+int pthread_condattr_init(pthread_condattr_t*)
+{
+    return 0;
+}
+
+int pthread_condattr_destroy(pthread_condattr_t*)
+{
+    return 0;
+}
+
+static int wait_on_cond(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* timeout)
+{
+    // Any signal after we sample the sequence changes it, so the futex wait can't miss it.
+    int sequence = __atomic_load_n(&cond->sequence, __ATOMIC_ACQUIRE);
+    cond->mutex = mutex;
+    int level = mutex->level;
+    mutex->level = 1;
+    pthread_mutex_unlock(mutex);
+
+    int rc = futex_wait(&cond->sequence, sequence, timeout);
+
+    // Others may be queued behind us (pthread_cond_broadcast() moves waiters
+    // straight onto the mutex), so always take it as contended.
+    auto* self = pthread_self();
+    int state = __atomic_exchange_n(&mutex->lock, 2, __ATOMIC_ACQUIRE);
+    while (state != 0) {
+        futex_wait(&mutex->lock, 2, nullptr);
+        state = __atomic_exchange_n(&mutex->lock, 2, __ATOMIC_ACQUIRE);
+    }
+    mutex->owner = self;
+    mutex->level = level;
+    return rc == -ETIMEDOUT ? ETIMEDOUT : 0;
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+    return wait_on_cond(cond, mutex, nullptr);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* abstime)
+{
+    // The kernel takes a relative timeout; abstime is against the realtime clock.
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    long now_nsec = now.tv_usec * 1000;
+    if (abstime->tv_sec < now.tv_sec || (abstime->tv_sec == now.tv_sec && abstime->tv_nsec <= now_nsec))
+        return ETIMEDOUT;
+    struct timespec relative;
+    relative.tv_sec = abstime->tv_sec - now.tv_sec;
+    relative.tv_nsec = abstime->tv_nsec - now_nsec;
+    if (relative.tv_nsec < 0) {
+        relative.tv_nsec += 1000000000;
+        --relative.tv_sec;
+    }
+    return wait_on_cond(cond, mutex, &relative);
+}
+
+int pthread_cond_signal(pthread_cond_t* cond)
+{
+    __atomic_add_fetch(&cond->sequence, 1, __ATOMIC_RELEASE);
+    futex_wake(&cond->sequence, 1);
+    return 0;
+}
+
+int pthread_cond_broadcast(pthread_cond_t* cond)
+{
+    __atomic_add_fetch(&cond->sequence, 1, __ATOMIC_RELEASE);
+    auto* mutex = cond->mutex;
+    // Waking everyone just has them pile up on the mutex. While we hold it,
+    // wake one and move the rest to the mutex's queue, to be woken one at a
+    // time as it's handed over. Marking it contended makes sure our unlock
+    // wakes the next in line.
+    if (mutex && mutex->owner == pthread_self()) {
+        __atomic_store_n(&mutex->lock, 2, __ATOMIC_RELAXED);
+        futex_requeue(&cond->sequence, 1, &mutex->lock, INT_MAX);
+        return 0;
+    }
+    futex_wake(&cond->sequence, INT_MAX);
+    return 0;
+}
+
+int pthread_once(pthread_once_t* once_control, void (*init_routine)(void))
+{
+    enum {
+        Initial = PTHREAD_ONCE_INIT,
+        Running,
+        RunningWithWaiters,
+        Done,
+    };
+    if (__atomic_load_n(once_control, __ATOMIC_ACQUIRE) == Done)
+        return 0;
+
+    int expected = Initial;
+    if (__atomic_compare_exchange_n(once_control, &expected, Running, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        init_routine();
+        if (__atomic_exchange_n(once_control, Done, __ATOMIC_RELEASE) == RunningWithWaiters)
+            futex_wake(once_control, INT_MAX);
+        return 0;
+    }
+
+    for (;;) {
+        int state = __atomic_load_n(once_control, __ATOMIC_ACQUIRE);
+        if (state == Done)
+            return 0;
+        if (state == Running) {
+            if (!__atomic_compare_exchange_n(once_control, &state, RunningWithWaiters, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                continue;
+        }
+        futex_wait(once_control, RunningWithWaiters, nullptr);
+    }
+}
+
+int pthread_key_create(pthread_key_t* key, void (*destructor)(void*))
+{
+    pthread_spin_lock(&s_keys_lock);
+    for (int i = 0; i < PTHREAD_KEYS_MAX; ++i) {
+        if (s_keys[i].in_use)
+            continue;
+        s_keys[i].in_use = true;
+        s_keys[i].destructor = destructor;
+        pthread_spin_unlock(&s_keys_lock);
+        *key = i;
+        return 0;
+    }
+    pthread_spin_unlock(&s_keys_lock);
+    return EAGAIN;
+}
+
+int pthread_key_delete(pthread_key_t key)
+{
+    if (key < 0 || key >= PTHREAD_KEYS_MAX)
+        return EINVAL;
+    pthread_spin_lock(&s_keys_lock);
+    s_keys[key].in_use = false;
+    s_keys[key].destructor = nullptr;
+    pthread_spin_unlock(&s_keys_lock);
+    return 0;
+}
+
+void* pthread_getspecific(pthread_key_t key)
+{
+    if (key < 0 || key >= PTHREAD_KEYS_MAX)
+        return nullptr;
+    return const_cast<void*>(pthread_self()->specific[key]);
+}
+
+int pthread_setspecific(pthread_key_t key, const void* value)
+{
+    if (key < 0 || key >= PTHREAD_KEYS_MAX)
+        return EINVAL;
+    pthread_self()->specific[key] = value;
+    return 0;
+}
+
+int pthread_spin_init(pthread_spinlock_t* lock, int)
+{
+    *lock = 0;
+    return 0;
+}
+
+int pthread_spin_destroy(pthread_spinlock_t*)
+{
+    return 0;
+}
+
+int pthread_spin_lock(pthread_spinlock_t* lock)
+{
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+        // There's only one CPU, so the holder can't make progress until we get off it.
+        sched_yield();
+    }
+    return 0;
+}
+
+int pthread_spin_trylock(pthread_spinlock_t* lock)
+{
+    if (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+        return EBUSY;
+    return 0;
+}
+
+int pthread_spin_unlock(pthread_spinlock_t* lock)
+{
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+}
@@ -1,22 +1,60 @@
 #pragma once
 
 #include <sys/cdefs.h>
+#include <sys/types.h>
 #include <sched.h>
+#include <time.h>
 
 __BEGIN_DECLS
 
-typedef void* pthread_t;
-typedef void* pthread_key_t;
-typedef void* pthread_once_t;
-typedef void* pthread_mutex_t;
-typedef void* pthread_attr_t;
-typedef void* pthread_mutexattr_t;
-typedef void* pthread_cond_t;
-typedef void* pthread_spinlock_t;
-typedef void* pthread_condattr_t;
-
-int pthread_create(pthread_t, pthread_attr_t*, void*(*)(void*), void*);
-void pthread_exit(void*);
+struct __pthread;
+
+typedef struct __pthread* pthread_t;
+typedef int pthread_key_t;
+typedef int pthread_once_t;
+typedef int pthread_spinlock_t;
+
+typedef struct __pthread_mutex_t {
+    int lock; // 0: unlocked, 1: locked, 2: locked and maybe contended.
+    int type;
+    pthread_t owner;
+    int level;
+} pthread_mutex_t;
+
+typedef struct __pthread_mutexattr_t {
+    int type;
+} pthread_mutexattr_t;
+
+typedef struct __pthread_cond_t {
+    int sequence;
+    pthread_mutex_t* mutex;
+} pthread_cond_t;
+
+typedef struct __pthread_condattr_t {
+    int unused;
+} pthread_condattr_t;
+
+typedef struct __pthread_attr_t {
+    int detach_state;
+    size_t stack_size;
+} pthread_attr_t;
+
+#define PTHREAD_MUTEX_NORMAL 0
+#define PTHREAD_MUTEX_RECURSIVE 1
+#define PTHREAD_MUTEX_DEFAULT PTHREAD_MUTEX_NORMAL
+#define PTHREAD_MUTEX_INITIALIZER { 0, PTHREAD_MUTEX_NORMAL, 0, 0 }
+#define PTHREAD_COND_INITIALIZER { 0, 0 }
+#define PTHREAD_ONCE_INIT 0
+
+#define PTHREAD_CREATE_JOINABLE 0
+#define PTHREAD_CREATE_DETACHED 1
+
+#define PTHREAD_KEYS_MAX 64
+#define PTHREAD_DESTRUCTOR_ITERATIONS 4
+#define PTHREAD_STACK_MIN 16384
+
+int pthread_create(pthread_t*, pthread_attr_t*, void*(*)(void*), void*);
+void pthread_exit(void*) __attribute__((noreturn));
 int pthread_kill(pthread_t, int);
 void pthread_cleanup_push(void(*)(void*), void*);
 void pthread_cleanup_pop(int);
@@ -28,33 +66,26 @@ int pthread_mutex_init(pthread_mutex_t*, const pthread_mutexattr_t*);
 int pthread_mutex_destroy(pthread_mutex_t*);
 int pthread_attr_init(pthread_attr_t*);
 int pthread_attr_destroy(pthread_attr_t*);
+int pthread_attr_getdetachstate(const pthread_attr_t*, int*);
+int pthread_attr_setdetachstate(pthread_attr_t*, int);
+int pthread_attr_getstacksize(const pthread_attr_t*, size_t*);
+int pthread_attr_setstacksize(pthread_attr_t*, size_t);
 
 int pthread_once(pthread_once_t*, void(*)(void));
-#define PTHREAD_ONCE_INIT 0
-pthread_once_t once_control = PTHREAD_ONCE_INIT;
 void *pthread_getspecific(pthread_key_t key);
 int pthread_setspecific(pthread_key_t key, const void *value);
 
-#define PTHREAD_MUTEX_NORMAL 0
-#define PTHREAD_MUTEX_RECURSIVE 1
-#define PTHREAD_MUTEX_INITIALIZER 0
-#define PTHREAD_COND_INITIALIZER 0
-
 int pthread_key_create(pthread_key_t *key, void (*destructor)(void*));
 int pthread_key_delete(pthread_key_t key);
 int pthread_cond_broadcast(pthread_cond_t *);
 int pthread_cond_init(pthread_cond_t *, const pthread_condattr_t *);
 int pthread_cond_signal(pthread_cond_t *);
 int pthread_cond_wait(pthread_cond_t *, pthread_mutex_t *);
+int pthread_condattr_init(pthread_condattr_t *);
 int pthread_condattr_destroy(pthread_condattr_t *);
 int pthread_cancel(pthread_t);
-void pthread_cleanup_push(void (*)(void *), void *);
-void pthread_cleanup_pop(int);
-int pthread_cond_broadcast(pthread_cond_t *);
 int pthread_cond_destroy(pthread_cond_t *);
 int pthread_cond_timedwait(pthread_cond_t *, pthread_mutex_t *, const struct timespec *);
-int pthread_cond_wait(pthread_cond_t *, pthread_mutex_t *);
-int pthread_condattr_destroy(pthread_condattr_t *);
 
 void pthread_testcancel(void);
 
@@ -63,11 +94,9 @@ int pthread_spin_init(pthread_spinlock_t *, int);
 int pthread_spin_lock(pthread_spinlock_t *);
 int pthread_spin_trylock(pthread_spinlock_t *);
 int pthread_spin_unlock(pthread_spinlock_t *);
-int pthread_cond_destroy(pthread_cond_t *);
 pthread_t pthread_self(void);
 int pthread_detach(pthread_t);
 int pthread_equal(pthread_t, pthread_t);
-void pthread_exit(void *);
 int pthread_mutexattr_init(pthread_mutexattr_t *);
 int pthread_mutexattr_settype(pthread_mutexattr_t *, int);
 int pthread_mutexattr_destroy(pthread_mutexattr_t *);
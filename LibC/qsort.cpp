@@ -1,98 +1,53 @@
-/*-
- * Copyright (c) 1980, 1983, 1990 The Regents of the University of California.
- * All rights reserved.
- *
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- * 3. All advertising materials mentioning features or use of this software
- *    must display the following acknowledgement:
- *	This product includes software developed by the University of
- *	California, Berkeley and its contributors.
- * 4. Neither the name of the University nor the names of its contributors
- *    may be used to endorse or promote products derived from this software
- *    without specific prior written permission.
- *
- * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
- * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
- * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
- * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
- * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
- * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
- * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
- * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
- * SUCH DAMAGE.
- */
-
-#if defined(LIBC_SCCS) && !defined(lint)
-static char sccsid[] = "@(#)qsort.c	5.9 (Berkeley) 2/23/91";
-#endif /* LIBC_SCCS and not lint */
-
-#include <sys/types.h>
+#include <AK/QuickSort.h>
+#include <AK/Types.h>
 #include <stdlib.h>
+#include <sys/types.h>
 
-static void insertion_sort(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*));
-static void insertion_sort_r(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg);
-
-void qsort(void* bot, size_t nmemb, size_t size, int (*compar)(const void *, const void *))
-{
-	if (nmemb <= 1)
-		return;
-
-    insertion_sort(bot, nmemb, size, compar);
-}
+// qsort() shares AK's introsort, which only needs to compare and swap
+// elements by index. Here the elements are opaque runs of `size` bytes.
+template<typename Compare>
+struct BlobSortOps {
+    byte* base;
+    size_t size;
+    Compare compare;
+
+    byte* element(int index) { return base + index * size; }
+
+    bool less(int a, int b) { return compare(element(a), element(b)) < 0; }
+
+    void swap(int a, int b)
+    {
+        byte* pa = element(a);
+        byte* pb = element(b);
+        if (!(((dword)base | size) & 3)) {
+            auto* da = (dword*)pa;
+            auto* db = (dword*)pb;
+            for (size_t i = 0; i < size / sizeof(dword); ++i)
+                AK::swap(da[i], db[i]);
+            return;
+        }
+        for (size_t i = 0; i < size; ++i)
+            AK::swap(pa[i], pb[i]);
+    }
+};
 
-void qsort_r(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg)
+template<typename Compare>
+static void sort_blobs(void* base, size_t nmemb, size_t size, Compare compare)
 {
-    if (nmemb <= 1)
+    if (nmemb <= 1 || !size)
         return;
-
-    insertion_sort_r(bot, nmemb, size, compar, arg);
+    BlobSortOps<Compare> ops { (byte*)base, size, compare };
+    AK::SortDetail::intro_sort(ops, nmemb);
 }
 
-void insertion_sort(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*))
+void qsort(void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*))
 {
-    int cnt;
-    unsigned char ch;
-    char *s1, *s2, *t1, *t2, *top;
-    top = (char*)bot + nmemb * size;
-    for (t1 = (char*)bot + size; t1 < top;) {
-		for (t2 = t1; (t2 -= size) >= bot && compar(t1, t2) < 0;);
-		if (t1 != (t2 += size)) {
-			for (cnt = size; cnt--; ++t1) {
-				ch = *t1;
-				for (s1 = s2 = t1; (s2 -= size) >= t2; s1 = s2)
-					*s1 = *s2;
-				*s1 = ch;
-			}
-		} else
-			t1 += size;
-	}
+    sort_blobs(base, nmemb, size, compar);
 }
 
-void insertion_sort_r(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg)
+void qsort_r(void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg)
 {
-    int cnt;
-    unsigned char ch;
-    char *s1, *s2, *t1, *t2, *top;
-    top = (char*)bot + nmemb * size;
-    for (t1 = (char*)bot + size; t1 < top;) {
-        for (t2 = t1; (t2 -= size) >= bot && compar(t1, t2, arg) < 0;);
-        if (t1 != (t2 += size)) {
-            for (cnt = size; cnt--; ++t1) {
-                ch = *t1;
-                for (s1 = s2 = t1; (s2 -= size) >= t2; s1 = s2)
-                    *s1 = *s2;
-                *s1 = ch;
-            }
-        } else
-            t1 += size;
-    }
+    sort_blobs(base, nmemb, size, [compar, arg](const void* a, const void* b) {
+        return compar(a, b, arg);
+    });
 }
@@ -14,6 +14,12 @@
 
 extern "C" {
 
+enum {
+    __STDIO_IDLE,
+    __STDIO_READING,
+    __STDIO_WRITING,
+};
+
 static FILE __default_streams[4];
 FILE* stdin;
 FILE* stdout;
@@ -68,6 +74,8 @@ int setvbuf(FILE* stream, char* buf, int mode, size_t size)
         stream->buffer_size = BUFSIZ;
     }
     stream->buffer_index = 0;
+    stream->buffer_length = 0;
+    stream->direction = __STDIO_IDLE;
     return 0;
 }
 
@@ -93,56 +101,133 @@ int feof(FILE* stream)
     return stream->eof;
 }
 
+static int write_all(FILE* stream, const char* data, size_t size)
+{
+    while (size) {
+        ssize_t rc = write(stream->fd, data, size);
+        if (rc < 0) {
+            if (errno == EINTR)
+                continue;
+            stream->error = errno;
+            return EOF;
+        }
+        data += rc;
+        size -= rc;
+    }
+    return 0;
+}
+
 int fflush(FILE* stream)
 {
     // FIXME: fflush(NULL) should flush all open output streams.
     ASSERT(stream);
+    if (stream->direction == __STDIO_READING) {
+        // Give back what we read ahead, so the file offset matches what the caller has consumed.
+        // This fails harmlessly on pipes and terminals.
+        off_t unread = (stream->buffer_length - stream->buffer_index) + (stream->have_ungotten ? 1 : 0);
+        if (unread)
+            lseek(stream->fd, -unread, SEEK_CUR);
+        stream->buffer_index = 0;
+        stream->buffer_length = 0;
+        stream->have_ungotten = false;
+        stream->direction = __STDIO_IDLE;
+        return 0;
+    }
     if (!stream->buffer_index)
         return 0;
-    int rc = write(stream->fd, stream->buffer, stream->buffer_index);
+    int rc = write_all(stream, stream->buffer, stream->buffer_index);
     stream->buffer_index = 0;
+    stream->direction = __STDIO_IDLE;
+    if (rc < 0)
+        return EOF;
     stream->error = 0;
     stream->eof = 0;
-    if (rc < 0) {
+    return 0;
+}
+
+static inline void prepare_for_writing(FILE* stream)
+{
+    if (stream->direction == __STDIO_READING)
+        fflush(stream);
+    stream->direction = __STDIO_WRITING;
+}
+
+// Reads more data into an empty read buffer. Returns false at end-of-file or on error.
+static bool refill(FILE* stream)
+{
+    if (stream->direction == __STDIO_WRITING)
+        fflush(stream);
+    stream->direction = __STDIO_READING;
+    stream->buffer_index = 0;
+    stream->buffer_length = 0;
+    // Someone waiting on interactive input should get to see the prompt first.
+    if (stream->mode != _IOFBF && stream != stdout && stdout->direction == __STDIO_WRITING)
+        fflush(stdout);
+    // An unbuffered stream mustn't read ahead.
+    size_t size = stream->mode == _IONBF ? 1 : stream->buffer_size;
+    ssize_t nread;
+    do {
+        nread = read(stream->fd, stream->buffer, size);
+    } while (nread < 0 && errno == EINTR);
+    if (nread < 0) {
         stream->error = errno;
-        return EOF;
+        return false;
     }
-    return 0;
+    if (nread == 0) {
+        stream->eof = true;
+        return false;
+    }
+    stream->buffer_length = nread;
+    return true;
 }
 
 char* fgets(char* buffer, int size, FILE* stream)
 {
     assert(stream);
-    ssize_t nread = 0;
-    for (;;) {
-        if (nread >= size)
-            break;
-        int ch = fgetc(stream);
-        if (ch == EOF) {
-            if (nread == 0)
-                return nullptr;
-            break;
+    if (size <= 0)
+        return nullptr;
+    int nread = 0;
+    if (stream->have_ungotten && size > 1) {
+        stream->have_ungotten = false;
+        buffer[nread++] = stream->ungotten;
+        if (stream->ungotten == '\n') {
+            buffer[nread] = '\0';
+            return buffer;
+        }
+    }
+    while (nread < size - 1) {
+        if (stream->direction != __STDIO_READING || stream->buffer_index == stream->buffer_length) {
+            if (!refill(stream))
+                break;
         }
-        buffer[nread++] = ch;
-        if (!ch || ch == '\n')
+        const char* start = stream->buffer + stream->buffer_index;
+        size_t available = min(stream->buffer_length - stream->buffer_index, (size_t)(size - 1 - nread));
+        auto* newline = (const char*)memchr(start, '\n', available);
+        size_t count = newline ? (newline - start) + 1 : available;
+        memcpy(buffer + nread, start, count);
+        stream->buffer_index += count;
+        nread += count;
+        if (newline)
             break;
     }
-    if (nread < size)
-        buffer[nread] = '\0';
+    if (!nread)
+        return nullptr;
+    buffer[nread] = '\0';
     return buffer;
 }
 
 int fgetc(FILE* stream)
 {
     assert(stream);
-    char ch;
-    size_t nread = fread(&ch, sizeof(char), 1, stream);
-    if (nread <= 0) {
-        stream->eof = nread == 0;
-        stream->error = errno;
-        return EOF;
+    if (stream->have_ungotten) {
+        stream->have_ungotten = false;
+        return (byte)stream->ungotten;
+    }
+    if (stream->direction != __STDIO_READING || stream->buffer_index == stream->buffer_length) {
+        if (!refill(stream))
+            return EOF;
     }
-    return ch;
+    return (byte)stream->buffer[stream->buffer_index++];
 }
 
 int getc(FILE* stream)
@@ -169,6 +254,8 @@ int ungetc(int c, FILE* stream)
 int fputc(int ch, FILE* stream)
 {
     assert(stream);
+    if (stream->direction != __STDIO_WRITING)
+        prepare_for_writing(stream);
     assert(stream->buffer_index < stream->buffer_size);
     stream->buffer[stream->buffer_index++] = ch;
     if (stream->buffer_index >= stream->buffer_size)
@@ -192,11 +279,9 @@ int putchar(int ch)
 
 int fputs(const char* s, FILE* stream)
 {
-    for (; *s; ++s) {
-        int rc = putc(*s, stream);
-        if (rc == EOF)
-            return EOF;
-    }
+    size_t length = strlen(s);
+    if (fwrite(s, 1, length, stream) < length)
+        return EOF;
     return 1;
 }
 
@@ -223,46 +308,92 @@ int ferror(FILE* stream)
 size_t fread(void* ptr, size_t size, size_t nmemb, FILE* stream)
 {
     assert(stream);
-    if (!size)
+    size_t total = size * nmemb;
+    if (!total)
         return 0;
 
-    ssize_t nread = 0;
+    auto* bytes = (char*)ptr;
+    size_t nread = 0;
 
     if (stream->have_ungotten) {
-        // FIXME: Support ungotten character even if size != 1.
-        ASSERT(size == 1);
-        ((char*)ptr)[0] = stream->ungotten;
+        bytes[nread++] = stream->ungotten;
         stream->have_ungotten = false;
-        --nmemb;
-        if (!nmemb)
-            return 1;
-        ptr = &((char*)ptr)[1];
-        ++nread;
     }
 
-    ssize_t rc = read(stream->fd, ptr, nmemb * size);
-    if (rc < 0) {
-        stream->error = errno;
-        return 0;
+    while (nread < total) {
+        if (stream->direction == __STDIO_READING && stream->buffer_index < stream->buffer_length) {
+            size_t count = min(stream->buffer_length - stream->buffer_index, total - nread);
+            memcpy(bytes + nread, stream->buffer + stream->buffer_index, count);
+            stream->buffer_index += count;
+            nread += count;
+            continue;
+        }
+        // Requests at least as large as the buffer go straight into the caller's memory.
+        if (stream->mode != _IONBF && total - nread >= stream->buffer_size) {
+            if (stream->direction == __STDIO_WRITING)
+                fflush(stream);
+            stream->direction = __STDIO_READING;
+            stream->buffer_index = 0;
+            stream->buffer_length = 0;
+            ssize_t rc = read(stream->fd, bytes + nread, total - nread);
+            if (rc < 0 && errno == EINTR)
+                continue;
+            if (rc < 0) {
+                stream->error = errno;
+                break;
+            }
+            if (rc == 0) {
+                stream->eof = true;
+                break;
+            }
+            nread += rc;
+            continue;
+        }
+        if (!refill(stream))
+            break;
     }
-    if (rc == 0)
-        stream->eof = true;
-    nread += rc;
     return nread / size;
 }
 
 size_t fwrite(const void* ptr, size_t size, size_t nmemb, FILE* stream)
 {
     assert(stream);
-    auto* bytes = (const byte*)ptr;
-    ssize_t nwritten = 0;
-    for (size_t i = 0; i < (size * nmemb); ++i) {
-        int rc = fputc(bytes[i], stream);
-        if (rc == EOF)
-            break;
-        ++nwritten;
+    size_t total = size * nmemb;
+    if (!total)
+        return 0;
+    auto* bytes = (const char*)ptr;
+
+    if (stream->direction != __STDIO_WRITING)
+        prepare_for_writing(stream);
+
+    if (stream->mode != _IONBF && total < stream->buffer_size) {
+        size_t space = stream->buffer_size - stream->buffer_index;
+        if (total >= space) {
+            // Top up the buffer and flush it, then keep the rest.
+            memcpy(stream->buffer + stream->buffer_index, bytes, space);
+            stream->buffer_index = stream->buffer_size;
+            if (fflush(stream) < 0)
+                return 0;
+            stream->direction = __STDIO_WRITING;
+            bytes += space;
+            total -= space;
+        }
+        memcpy(stream->buffer + stream->buffer_index, bytes, total);
+        stream->buffer_index += total;
+        if (stream->mode == _IOLBF && memchr(bytes, '\n', total)) {
+            if (fflush(stream) < 0)
+                return 0;
+        }
+        return nmemb;
     }
-    return nwritten / size;
+
+    // Large writes (and everything when unbuffered) go straight to write() once the buffer is flushed.
+    if (fflush(stream) < 0)
+        return 0;
+    stream->direction = __STDIO_WRITING;
+    if (write_all(stream, bytes, total) < 0)
+        return 0;
+    return nmemb;
 }
 
 int fseek(FILE* stream, long offset, int whence)
@@ -282,8 +413,16 @@ int fseek(FILE* stream, long offset, int whence)
 long ftell(FILE* stream)
 {
     assert(stream);
-    fflush(stream);
-    return lseek(stream->fd, 0, SEEK_CUR);
+    off_t offset = lseek(stream->fd, 0, SEEK_CUR);
+    if (offset < 0)
+        return offset;
+    if (stream->direction == __STDIO_WRITING)
+        return offset + stream->buffer_index;
+    if (stream->direction == __STDIO_READING)
+        offset -= stream->buffer_length - stream->buffer_index;
+    if (stream->have_ungotten)
+        --offset;
+    return offset;
 }
 
 void rewind(FILE* stream)
@@ -304,21 +443,57 @@ int dbgprintf(const char* fmt, ...)
     return ret;
 }
 
-static void stdout_putch(char*&, char ch)
-{
-    putchar(ch);
-}
+// Stages formatted output and hands it to fwrite() in chunks, so a stream sees a few
+// writes per printf() instead of an fputc() (or, unbuffered, a write()) per character.
+struct StreamSink {
+    explicit StreamSink(FILE* stream)
+        : stream(stream)
+    {
+    }
 
-static FILE* __current_stream = nullptr;
-static void stream_putch(char*&, char ch)
-{
-    fputc(ch, __current_stream);
-}
+    FILE* stream;
+    char buffer[128];
+    int length { 0 };
+
+    void flush()
+    {
+        if (length)
+            fwrite(buffer, 1, length, stream);
+        length = 0;
+    }
+
+    void append(const char* characters, int count)
+    {
+        if (length + count > (int)sizeof(buffer)) {
+            flush();
+            if (count >= (int)sizeof(buffer)) {
+                fwrite(characters, 1, count, stream);
+                return;
+            }
+        }
+        memcpy(buffer + length, characters, count);
+        length += count;
+    }
+
+    void fill(char ch, int count)
+    {
+        while (count) {
+            if (length == (int)sizeof(buffer))
+                flush();
+            int chunk = min(count, (int)sizeof(buffer) - length);
+            memset(buffer + length, ch, chunk);
+            length += chunk;
+            count -= chunk;
+        }
+    }
+};
 
 int vfprintf(FILE* stream, const char* fmt, va_list ap)
 {
-    __current_stream = stream;
-    return printf_internal(stream_putch, nullptr, fmt, ap);
+    StreamSink sink(stream);
+    int ret = printf_internal(sink, fmt, ap);
+    sink.flush();
+    return ret;
 }
 
 int fprintf(FILE* stream, const char* fmt, ...)
@@ -332,7 +507,7 @@ int fprintf(FILE* stream, const char* fmt, ...)
 
 int vprintf(const char* fmt, va_list ap)
 {
-    return printf_internal(stdout_putch, nullptr, fmt, ap);
+    return vfprintf(stdout, fmt, ap);
 }
 
 int printf(const char* fmt, ...)
@@ -344,14 +519,10 @@ int printf(const char* fmt, ...)
     return ret;
 }
 
-static void buffer_putch(char*& bufptr, char ch)
-{
-    *bufptr++ = ch;
-}
-
 int vsprintf(char* buffer, const char* fmt, va_list ap)
 {
-    int ret = printf_internal(buffer_putch, buffer, fmt, ap);
+    PrintfBufferSink sink { buffer };
+    int ret = printf_internal(sink, fmt, ap);
     buffer[ret] = '\0';
     return ret;
 }
@@ -361,25 +532,17 @@ int sprintf(char* buffer, const char* fmt, ...)
     va_list ap;
     va_start(ap, fmt);
     int ret = vsprintf(buffer, fmt, ap);
-    buffer[ret] = '\0';
     va_end(ap);
     return ret;
 }
 
-static size_t __vsnprintf_space_remaining;
-static void sized_buffer_putch(char*& bufptr, char ch)
-{
-    if (__vsnprintf_space_remaining) {
-        *bufptr++ = ch;
-        --__vsnprintf_space_remaining;
-    }
-}
-
 int vsnprintf(char* buffer, size_t size, const char* fmt, va_list ap)
 {
-    __vsnprintf_space_remaining = size;
-    int ret = printf_internal(sized_buffer_putch, buffer, fmt, ap);
-    buffer[ret] = '\0';
+    // Keep room for the terminator, and return the length the whole thing would have had.
+    PrintfSizedBufferSink sink { buffer, size ? size - 1 : 0 };
+    int ret = printf_internal(sink, fmt, ap);
+    if (size)
+        *sink.bufptr = '\0';
     return ret;
 }
 
@@ -388,7 +551,6 @@ int snprintf(char* buffer, size_t size, const char* fmt, ...)
     va_list ap;
     va_start(ap, fmt);
     int ret = vsnprintf(buffer, size, fmt, ap);
-    buffer[ret] = '\0';
     va_end(ap);
     return ret;
 }
@@ -29,7 +29,11 @@ struct __STDIO_FILE {
     int mode;
     char* buffer;
     size_t buffer_size;
+    // When writing, buffer[0, buffer_index) is waiting to be written.
+    // When reading, buffer[buffer_index, buffer_length) has been read ahead but not consumed.
     size_t buffer_index;
+    size_t buffer_length;
+    int direction;
     int have_ungotten;
     char ungotten;
     char default_buffer[BUFSIZ];
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <AK/Types.h>
 #include <AK/StdLibExtras.h>
+#include <LibC/StringKernels.h>
 #include "ctype.h"
 
 extern "C" {
@@ -48,10 +49,7 @@ size_t strcspn(const char* s, const char* reject)
 
 size_t strlen(const char* str)
 {
-    size_t len = 0;
-    while (*(str++))
-        ++len;
-    return len;
+    return string_kernels().strlen(str);
 }
 
 char* strdup(const char* str)
@@ -73,10 +71,7 @@ char* strndup(const char* str, size_t maxlen)
 
 int strcmp(const char* s1, const char* s2)
 {
-    while (*s1 == *s2++)
-        if (*s1++ == 0)
-            return 0;
-    return *(const unsigned char*)s1 - *(const unsigned char*)--s2;
+    return string_kernels().strcmp(s1, s2);
 }
 
 int strncmp(const char* s1, const char* s2, size_t n)
@@ -123,13 +118,7 @@ int strncasecmp(const char* s1, const char* s2, size_t n)
 
 int memcmp(const void* v1, const void* v2, size_t n)
 {
-    auto* s1 = (const uint8_t*)v1;
-    auto* s2 = (const uint8_t*)v2;
-    while (n-- > 0) {
-        if (*s1++ != *s2++)
-            return s1[-1] < s2[-1] ? -1 : 1;
-    }
-    return 0;
+    return string_kernels().memcmp(v1, v2, n);
 }
 
 void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
@@ -220,24 +209,12 @@ char* strncpy(char* dest, const char* src, size_t n)
 
 char* strchr(const char* str, int c)
 {
-    char ch = c;
-    for (;; ++str) {
-        if (*str == ch)
-            return const_cast<char*>(str);
-        if (!*str)
-            return nullptr;
-    }
+    return string_kernels().strchr(str, c);
 }
 
 void* memchr(const void* ptr, int c, size_t size)
 {
-    char ch = c;
-    auto* cptr = (const char*)ptr;
-    for (size_t i = 0; i < size; ++i) {
-        if (cptr[i] == ch)
-            return const_cast<char*>(cptr + i);
-    }
-    return nullptr;
+    return string_kernels().memchr(ptr, c, size);
 }
 
 char* strrchr(const char* str, int ch)
@@ -368,20 +345,7 @@ char* strsignal(int signum)
 
 char* strstr(const char* haystack, const char* needle)
 {
-    char nch;
-    char hch;
-
-    if ((nch = *needle++) != 0) {
-        size_t len = strlen(needle);
-        do {
-            do {
-                if ((hch = *haystack++) == 0)
-                    return nullptr;
-            } while (hch != nch);
-        } while (strncmp(haystack, needle, len) != 0);
-        --haystack;
-    }
-    return const_cast<char*>(haystack);
+    return string_kernels().strstr(haystack, needle);
 }
 
 char* strpbrk(const char* s, const char* accept)
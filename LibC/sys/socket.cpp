@@ -60,6 +60,18 @@ ssize_t recv(int sockfd, void* buffer, size_t buffer_length, int flags)
     return recvfrom(sockfd, buffer, buffer_length, flags, nullptr, nullptr);
 }
 
+ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags)
+{
+    int rc = syscall(SC_sendmsg, sockfd, msg, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags)
+{
+    int rc = syscall(SC_recvmsg, sockfd, msg, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 int getsockopt(int sockfd, int level, int option, void* value, socklen_t* value_size)
 {
     Syscall::SC_getsockopt_params params { sockfd, level, option, value, value_size };
@@ -4,6 +4,7 @@
 #include <sys/types.h>
 #include <stdint.h>
 #include <sys/un.h>
+#include <sys/uio.h>
 
 __BEGIN_DECLS
 
@@ -20,6 +21,7 @@ __BEGIN_DECLS
 #define SOCK_STREAM 1
 #define SOCK_DGRAM 2
 #define SOCK_RAW 3
+#define SOCK_SEQPACKET 5
 #define SOCK_NONBLOCK 04000
 #define SOCK_CLOEXEC 02000000
 
@@ -27,6 +29,8 @@ __BEGIN_DECLS
 #define IPPROTO_TCP 6
 #define IPPROTO_UDP 17
 
+#define MSG_CTRUNC 0x8
+#define MSG_TRUNC 0x20
 #define MSG_DONTWAIT 0x40
 
 struct sockaddr {
@@ -52,6 +56,41 @@ struct sockaddr_in {
 #define SO_SNDTIMEO 2
 #define SO_KEEPALIVE 3
 #define SO_ERROR 4
+#define SO_PEERCRED 5
+
+#define SCM_RIGHTS 1
+
+struct ucred {
+    pid_t pid;
+    uid_t uid;
+    gid_t gid;
+};
+
+struct msghdr {
+    void* msg_name;
+    socklen_t msg_namelen;
+    struct iovec* msg_iov;
+    int msg_iovlen;
+    void* msg_control;
+    socklen_t msg_controllen;
+    int msg_flags;
+};
+
+struct cmsghdr {
+    socklen_t cmsg_len;
+    int cmsg_level;
+    int cmsg_type;
+};
+
+#define CMSG_ALIGN(x) (((x) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+#define CMSG_DATA(cmsg) ((unsigned char*)(cmsg) + CMSG_ALIGN(sizeof(struct cmsghdr)))
+#define CMSG_LEN(x) (CMSG_ALIGN(sizeof(struct cmsghdr)) + (x))
+#define CMSG_SPACE(x) (CMSG_ALIGN(sizeof(struct cmsghdr)) + CMSG_ALIGN(x))
+#define CMSG_FIRSTHDR(msg) ((msg)->msg_controllen >= sizeof(struct cmsghdr) ? (struct cmsghdr*)(msg)->msg_control : (struct cmsghdr*)0)
+#define CMSG_NXTHDR(msg, cmsg) \
+    (((unsigned char*)(cmsg) + CMSG_ALIGN((cmsg)->cmsg_len) + sizeof(struct cmsghdr) > (unsigned char*)(msg)->msg_control + (msg)->msg_controllen) \
+            ? (struct cmsghdr*)0 \
+            : (struct cmsghdr*)((unsigned char*)(cmsg) + CMSG_ALIGN((cmsg)->cmsg_len)))
 
 int socket(int domain, int type, int protocol);
 int bind(int sockfd, const struct sockaddr* addr, socklen_t);
@@ -62,6 +101,8 @@ ssize_t send(int sockfd, const void*, size_t, int flags);
 ssize_t sendto(int sockfd, const void*, size_t, int flags, const struct sockaddr*, socklen_t);
 ssize_t recv(int sockfd, void*, size_t, int flags);
 ssize_t recvfrom(int sockfd, void*, size_t, int flags, struct sockaddr*, socklen_t*);
+ssize_t sendmsg(int sockfd, const struct msghdr*, int flags);
+ssize_t recvmsg(int sockfd, struct msghdr*, int flags);
 int getsockopt(int sockfd, int level, int option, void*, socklen_t*);
 int setsockopt(int sockfd, int level, int option, const void*, socklen_t);
 int getsockname(int sockfd, struct sockaddr*, socklen_t*);
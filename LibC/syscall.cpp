@@ -0,0 +1,29 @@
+#include <AK/Types.h>
+#include <Kernel/Syscall.h>
+
+extern "C" {
+
+bool __syscall_use_sysenter;
+
+// Mirrors the kernel's check; it installs a sysenter handler on exactly these CPUs.
+static bool cpu_has_sysenter()
+{
+    dword eax, ebx, ecx, edx;
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(1), "c"(0));
+    if (!(edx & (1 << 11)))
+        return false;
+    // The original Pentium Pro claims SEP without actually having it.
+    dword family = (eax >> 8) & 0xf;
+    dword model = (eax >> 4) & 0xf;
+    dword stepping = eax & 0xf;
+    return !(family == 6 && model < 3 && stepping < 3);
+}
+
+void __syscall_init()
+{
+    __syscall_use_sysenter = cpu_has_sysenter();
+}
+
+}
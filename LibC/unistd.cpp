@@ -31,6 +31,10 @@ int chown(const char* pathname, uid_t uid, gid_t gid)
 pid_t fork()
 {
     int rc = syscall(SC_fork);
+    if (rc == 0) {
+        void __pthread_fork_child();
+        __pthread_fork_child();
+    }
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
@@ -435,6 +439,12 @@ int seal_shared_buffer(int shared_buffer_id)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int share_buffer_with(int shared_buffer_id, pid_t peer_pid)
+{
+    int rc = syscall(SC_share_buffer_with, shared_buffer_id, peer_pid);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 char* getlogin()
 {
     static char __getlogin_buffer[256];
@@ -445,27 +455,22 @@ char* getlogin()
     return nullptr;
 }
 
-int create_thread(int(*entry)(void*), void* argument)
-{
-    int rc = syscall(SC_create_thread, entry, argument);
-    __RETURN_WITH_ERRNO(rc, rc, -1);
-}
-
 void exit_thread(int code)
 {
     syscall(SC_exit_thread, code);
     ASSERT_NOT_REACHED();
 }
 
-int ftruncate(int fd, off_t length)
+int futex(int* userspace_address, int futex_op, int value, const struct timespec* timeout, int* userspace_address2, int value2)
 {
-    int rc = syscall(SC_ftruncate, fd, length);
+    Syscall::SC_futex_params params { userspace_address, futex_op, value, timeout, userspace_address2, value2 };
+    int rc = syscall(SC_futex, &params);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
-int gettid()
+int ftruncate(int fd, off_t length)
 {
-    int rc = syscall(SC_gettid);
+    int rc = syscall(SC_ftruncate, fd, length);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
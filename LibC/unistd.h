@@ -12,6 +12,10 @@ __BEGIN_DECLS
 #define STDOUT_FILENO 1
 #define STDERR_FILENO 2
 
+#define FUTEX_WAIT 1
+#define FUTEX_WAKE 2
+#define FUTEX_REQUEUE 3
+
 extern char** environ;
 
 int fsync(int fd);
@@ -21,11 +25,14 @@ int gettid();
 int donate(int tid);
 int create_thread(int(*)(void*), void*);
 void exit_thread(int);
+struct timespec;
+int futex(int* userspace_address, int futex_op, int value, const struct timespec* timeout, int* userspace_address2, int value2);
 int create_shared_buffer(pid_t peer_pid, int, void** buffer);
 void* get_shared_buffer(int shared_buffer_id);
 int release_shared_buffer(int shared_buffer_id);
 int seal_shared_buffer(int shared_buffer_id);
 int get_shared_buffer_size(int shared_buffer_id);
+int share_buffer_with(int shared_buffer_id, pid_t peer_pid);
 int read_tsc(unsigned* lsw, unsigned* msw);
 inline int getpagesize() { return 4096; }
 pid_t fork();
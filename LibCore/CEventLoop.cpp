@@ -8,7 +8,7 @@
 #include <LibC/fcntl.h>
 #include <LibC/string.h>
 #include <LibC/time.h>
-#include <LibC/sys/select.h>
+#include <LibC/sys/epoll.h>
 #include <LibC/sys/socket.h>
 #include <LibC/sys/time.h>
 #include <LibC/errno.h>
@@ -22,7 +22,8 @@
 static CEventLoop* s_main_event_loop;
 static Vector<CEventLoop*>* s_event_loop_stack;
 HashMap<int, OwnPtr<CEventLoop::EventLoopTimer>>* CEventLoop::s_timers;
-HashTable<CNotifier*>* CEventLoop::s_notifiers;
+HashMap<int, Vector<CNotifier*>>* CEventLoop::s_notifiers;
+int CEventLoop::s_epoll_fd = -1;
 int CEventLoop::s_next_timer_id = 1;
 
 CEventLoop::CEventLoop()
@@ -30,7 +31,9 @@ CEventLoop::CEventLoop()
     if (!s_event_loop_stack) {
         s_event_loop_stack = new Vector<CEventLoop*>;
         s_timers = new HashMap<int, OwnPtr<CEventLoop::EventLoopTimer>>;
-        s_notifiers = new HashTable<CNotifier*>;
+        s_notifiers = new HashMap<int, Vector<CNotifier*>>;
+        s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        ASSERT(s_epoll_fd >= 0);
     }
 
     if (!s_main_event_loop) {
@@ -153,30 +156,6 @@ void CEventLoop::post_event(CObject& receiver, OwnPtr<CEvent>&& event)
 
 void CEventLoop::wait_for_event(WaitMode mode)
 {
-    fd_set rfds;
-    fd_set wfds;
-    FD_ZERO(&rfds);
-    FD_ZERO(&wfds);
-
-    int max_fd = 0;
-    auto add_fd_to_set = [&max_fd] (int fd, fd_set& set){
-        FD_SET(fd, &set);
-        if (fd > max_fd)
-            max_fd = fd;
-    };
-
-    int max_fd_added = -1;
-    add_file_descriptors_for_select(rfds, max_fd_added);
-    max_fd = max(max_fd, max_fd_added);
-    for (auto& notifier : *s_notifiers) {
-        if (notifier->event_mask() & CNotifier::Read)
-            add_fd_to_set(notifier->fd(), rfds);
-        if (notifier->event_mask() & CNotifier::Write)
-            add_fd_to_set(notifier->fd(), wfds);
-        if (notifier->event_mask() & CNotifier::Exceptional)
-            ASSERT_NOT_REACHED();
-    }
-
     bool queued_events_is_empty;
     {
         LOCKER(m_lock);
@@ -184,23 +163,29 @@ void CEventLoop::wait_for_event(WaitMode mode)
     }
 
     timeval now;
-    struct timeval timeout = { 0, 0 };
-    bool should_wait_forever = false;
+    int timeout_ms = 0;
     if (mode == WaitMode::WaitForEvents) {
         if (!s_timers->is_empty() && queued_events_is_empty) {
+            timeval timeout;
             gettimeofday(&now, nullptr);
             get_next_timer_expiration(timeout);
-            AK::timeval_sub(&timeout, &now, &timeout);
+            // time_t is unsigned, so don't subtract past zero if a timer is already due.
+            if (timeout.tv_sec > now.tv_sec || (timeout.tv_sec == now.tv_sec && timeout.tv_usec > now.tv_usec)) {
+                AK::timeval_sub(&timeout, &now, &timeout);
+                timeout_ms = timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000;
+            }
         } else {
-            should_wait_forever = true;
+            timeout_ms = -1;
         }
-    } else {
-        should_wait_forever = false;
     }
 
-    int rc = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
+    // Whatever doesn't fit is still ready next time around.
+    epoll_event events[32];
+    int rc = epoll_wait(s_epoll_fd, events, sizeof(events) / sizeof(events[0]), timeout_ms);
     if (rc < 0) {
-        ASSERT_NOT_REACHED();
+        if (errno != EINTR)
+            ASSERT_NOT_REACHED();
+        rc = 0;
     }
 
     if (!s_timers->is_empty()) {
@@ -223,18 +208,27 @@ void CEventLoop::wait_for_event(WaitMode mode)
         }
     }
 
-    for (auto& notifier : *s_notifiers) {
-        if (FD_ISSET(notifier->fd(), &rfds)) {
+    for (int i = 0; i < rc; ++i)
+        dispatch_notifiers(events[i].data.fd, events[i].events);
+}
+
+void CEventLoop::dispatch_notifiers(int fd, unsigned ready_events)
+{
+    auto it = s_notifiers->find(fd);
+    if (it == s_notifiers->end())
+        return;
+    // Callbacks may add and remove notifiers, so walk a copy and skip the ones that have gone away.
+    auto notifiers = (*it).value;
+    for (auto* notifier : notifiers) {
+        if (is_registered(fd, *notifier) && (ready_events & EPOLLIN) && (notifier->event_mask() & CNotifier::Read)) {
             if (notifier->on_ready_to_read)
                 notifier->on_ready_to_read();
         }
-        if (FD_ISSET(notifier->fd(), &wfds)) {
+        if (is_registered(fd, *notifier) && (ready_events & EPOLLOUT) && (notifier->event_mask() & CNotifier::Write)) {
             if (notifier->on_ready_to_write)
                 notifier->on_ready_to_write();
         }
     }
-
-    process_file_descriptors_after_select(rfds);
 }
 
 bool CEventLoop::EventLoopTimer::has_expired(const timeval& now) const
@@ -287,12 +281,72 @@ bool CEventLoop::unregister_timer(int timer_id)
     return true;
 }
 
+bool CEventLoop::is_registered(int fd, CNotifier& notifier)
+{
+    auto it = s_notifiers->find(fd);
+    if (it == s_notifiers->end())
+        return false;
+    for (auto* registered : (*it).value) {
+        if (registered == &notifier)
+            return true;
+    }
+    return false;
+}
+
+void CEventLoop::update_watched_events(int fd)
+{
+    unsigned events = 0;
+    auto it = s_notifiers->find(fd);
+    if (it != s_notifiers->end()) {
+        for (auto* notifier : (*it).value) {
+            if (notifier->event_mask() & CNotifier::Read)
+                events |= EPOLLIN;
+            if (notifier->event_mask() & CNotifier::Write)
+                events |= EPOLLOUT;
+            if (notifier->event_mask() & CNotifier::Exceptional)
+                ASSERT_NOT_REACHED();
+        }
+    }
+
+    // Errors are ignored: the fd may already have been closed, which unwatches it anyway.
+    if (!events) {
+        epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
+    epoll_event event;
+    event.events = events;
+    event.data.u64 = 0;
+    event.data.fd = fd;
+    if (epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, fd, &event) < 0 && errno == ENOENT)
+        epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
 void CEventLoop::register_notifier(Badge<CNotifier>, CNotifier& notifier)
 {
-    s_notifiers->set(&notifier);
+    auto it = s_notifiers->find(notifier.fd());
+    if (it == s_notifiers->end()) {
+        Vector<CNotifier*> notifiers;
+        notifiers.append(&notifier);
+        s_notifiers->set(notifier.fd(), move(notifiers));
+    } else {
+        (*it).value.append(&notifier);
+    }
+    update_watched_events(notifier.fd());
 }
 
 void CEventLoop::unregister_notifier(Badge<CNotifier>, CNotifier& notifier)
 {
-    s_notifiers->remove(&notifier);
+    auto it = s_notifiers->find(notifier.fd());
+    if (it == s_notifiers->end())
+        return;
+    auto& notifiers = (*it).value;
+    notifiers.remove_first_matching([&](auto* registered) { return registered == &notifier; });
+    if (notifiers.is_empty())
+        s_notifiers->remove(it);
+    update_watched_events(notifier.fd());
+}
+
+void CEventLoop::update_notifier(Badge<CNotifier>, CNotifier& notifier)
+{
+    update_watched_events(notifier.fd());
 }
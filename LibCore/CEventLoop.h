@@ -6,7 +6,7 @@
 #include <AK/OwnPtr.h>
 #include <AK/Vector.h>
 #include <AK/WeakPtr.h>
-#include <sys/select.h>
+#include <sys/time.h>
 #include <time.h>
 
 class CEvent;
@@ -41,6 +41,7 @@ public:
 
     static void register_notifier(Badge<CNotifier>, CNotifier&);
     static void unregister_notifier(Badge<CNotifier>, CNotifier&);
+    static void update_notifier(Badge<CNotifier>, CNotifier&);
 
     void quit(int);
 
@@ -50,13 +51,14 @@ public:
     }
 
 protected:
-    virtual void add_file_descriptors_for_select(fd_set&, int& max_fd) { UNUSED_PARAM(max_fd); }
-    virtual void process_file_descriptors_after_select(const fd_set&) { }
     virtual void do_processing() { }
 
 private:
     void wait_for_event(WaitMode);
     void get_next_timer_expiration(timeval&);
+    void dispatch_notifiers(int fd, unsigned ready_events);
+    static void update_watched_events(int fd);
+    static bool is_registered(int fd, CNotifier&);
 
     struct QueuedEvent {
         WeakPtr<CObject> receiver;
@@ -84,5 +86,8 @@ private:
     static HashMap<int, OwnPtr<EventLoopTimer>>* s_timers;
     static int s_next_timer_id;
 
-    static HashTable<CNotifier*>* s_notifiers;
+    // All notifiers, by the fd they watch. The kernel watches each fd (in s_epoll_fd)
+    // for the union of its notifiers' events, so waiting costs nothing per idle fd.
+    static HashMap<int, Vector<CNotifier*>>* s_notifiers;
+    static int s_epoll_fd;
 };
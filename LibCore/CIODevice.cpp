@@ -2,7 +2,7 @@
 #include <unistd.h>
 #include <sys/select.h>
 #include <stdio.h>
-#include <AK/printf.cpp>
+#include <AK/StringBuilder.h>
 
 CIODevice::CIODevice(CObject* parent)
     : CObject(parent)
@@ -216,12 +216,12 @@ int CIODevice::printf(const char* format, ...)
 {
     va_list ap;
     va_start(ap, format);
-    // FIXME: We're not propagating write() failures to client here!
-    int ret = printf_internal([this] (char*&, char ch) {
-        int rc = write((const byte*)&ch, 1);
-        if (rc < 0)
-            dbgprintf("CIODevice::printf: write: %s\n", strerror(errno));
-    }, nullptr, format, ap);
+    // Format the whole thing first, so it goes out in one write() rather than one per character.
+    StringBuilder builder;
+    builder.appendvf(format, ap);
     va_end(ap);
-    return ret;
+    // FIXME: We're not propagating write() failures to client here!
+    auto buffer = builder.to_byte_buffer();
+    write(buffer.pointer(), buffer.size());
+    return buffer.size();
 }
@@ -4,19 +4,6 @@
 #include <AK/Types.h>
 #include <unistd.h>
 
-#define memory_barrier() asm volatile ("" ::: "memory")
-
-static inline dword CAS(volatile dword* mem, dword newval, dword oldval)
-{
-    dword ret;
-    asm volatile(
-        "cmpxchgl %2, %1"
-        :"=a"(ret), "+m"(*mem)
-        :"r"(newval), "0"(oldval)
-        :"cc", "memory");
-    return ret;
-}
-
 class CLock {
 public:
     CLock() { }
@@ -26,7 +13,9 @@ public:
     void unlock();
 
 private:
-    volatile dword m_lock { 0 };
+    void lock_contended(int state);
+
+    int m_lock { 0 }; // 0: unlocked, 1: locked, 2: locked and maybe contended.
     dword m_level { 0 };
     int m_holder { -1 };
 };
@@ -42,42 +31,43 @@ private:
     CLock& m_lock;
 };
 
+// Uncontended lock() and unlock() make no syscalls: gettid() reads the
+// thread's control block, and the kernel is only asked to sleep or wake
+// threads when the lock is actually contended.
 [[gnu::always_inline]] inline void CLock::lock()
 {
     int tid = gettid();
-    for (;;) {
-        if (CAS(&m_lock, 1, 0) == 0) {
-            if (m_holder == -1 || m_holder == tid) {
-                m_holder = tid;
-                ++m_level;
-                memory_barrier();
-                m_lock = 0;
-                return;
-            }
-            m_lock = 0;
-        }
-        donate(m_holder);
+    if (m_holder == tid) {
+        ++m_level;
+        return;
+    }
+    int state = 0;
+    if (!__atomic_compare_exchange_n(&m_lock, &state, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        lock_contended(state);
+    m_holder = tid;
+    m_level = 1;
+}
+
+inline void CLock::lock_contended(int state)
+{
+    if (state != 2)
+        state = __atomic_exchange_n(&m_lock, 2, __ATOMIC_ACQUIRE);
+    while (state != 0) {
+        futex(&m_lock, FUTEX_WAIT, 2, nullptr, nullptr, 0);
+        state = __atomic_exchange_n(&m_lock, 2, __ATOMIC_ACQUIRE);
     }
 }
 
 inline void CLock::unlock()
 {
-    for (;;) {
-        if (CAS(&m_lock, 1, 0) == 0) {
-            ASSERT(m_holder == gettid());
-            ASSERT(m_level);
-            --m_level;
-            if (m_level) {
-                memory_barrier();
-                m_lock = 0;
-                return;
-            }
-            m_holder = -1;
-            memory_barrier();
-            m_lock = 0;
-            return;
-        }
-        donate(m_holder);
+    ASSERT(m_holder == gettid());
+    ASSERT(m_level);
+    if (--m_level)
+        return;
+    m_holder = -1;
+    if (__atomic_fetch_sub(&m_lock, 1, __ATOMIC_RELEASE) != 1) {
+        __atomic_store_n(&m_lock, 0, __ATOMIC_RELEASE);
+        futex(&m_lock, FUTEX_WAKE, 1, nullptr, nullptr, 0);
     }
 }
 
@@ -14,3 +14,11 @@ CNotifier::~CNotifier()
     CEventLoop::unregister_notifier(Badge<CNotifier>(), *this);
 }
 
+void CNotifier::set_event_mask(unsigned event_mask)
+{
+    if (m_event_mask == event_mask)
+        return;
+    m_event_mask = event_mask;
+    CEventLoop::update_notifier(Badge<CNotifier>(), *this);
+}
+
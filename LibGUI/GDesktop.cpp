@@ -42,3 +42,19 @@ String GDesktop::wallpaper() const
     auto response = GEventLoop::current().sync_request(message, WSAPI_ServerMessage::Type::DidGetWallpaper);
     return String(response.text, response.text_length);
 }
+
+WSAPI_FrameStats GDesktop::frame_stats() const
+{
+    WSAPI_ClientMessage message;
+    message.type = WSAPI_ClientMessage::Type::GetFrameStats;
+    auto response = GEventLoop::current().sync_request(message, WSAPI_ServerMessage::Type::DidGetFrameStats);
+    return response.frame_stats;
+}
+
+void GDesktop::set_frame_time_overlay_enabled(bool enabled)
+{
+    WSAPI_ClientMessage message;
+    message.type = WSAPI_ClientMessage::Type::SetFrameTimeOverlay;
+    message.value = enabled;
+    GEventLoop::current().post_message_to_server(message);
+}
@@ -4,6 +4,7 @@
 #include <AK/Badge.h>
 #include <AK/Function.h>
 #include <SharedGraphics/Rect.h>
+#include <WindowServer/WSAPITypes.h>
 
 class GEventLoop;
 
@@ -15,6 +16,9 @@ public:
     String wallpaper() const;
     bool set_wallpaper(const String& path);
 
+    WSAPI_FrameStats frame_stats() const;
+    void set_frame_time_overlay_enabled(bool);
+
     Rect rect() const { return m_rect; }
     void did_receive_screen_rect(Badge<GEventLoop>, const Rect&);
 
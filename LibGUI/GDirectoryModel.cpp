@@ -42,7 +42,7 @@ int thumbnail_thread(void* model_ptr)
                 continue;
             auto thumbnail = GraphicsBitmap::create(png_bitmap->format(), { 32, 32 });
             Painter painter(*thumbnail);
-            painter.draw_scaled_bitmap(thumbnail->rect(), *png_bitmap, png_bitmap->rect());
+            painter.draw_scaled_bitmap(thumbnail->rect(), *png_bitmap, png_bitmap->rect(), Painter::ScalingMode::BoxFilter);
             {
                 LOCKER(thumbnail_cache().lock());
                 thumbnail_cache().resource().set(path, move(thumbnail));
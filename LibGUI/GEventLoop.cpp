@@ -25,6 +25,7 @@
 //#define COALESCING_DEBUG
 
 int GEventLoop::s_windowserver_fd = -1;
+CNotifier* GEventLoop::s_windowserver_notifier;
 int GEventLoop::s_my_client_id = -1;
 pid_t GEventLoop::s_server_pid = -1;
 
@@ -62,6 +63,31 @@ void GEventLoop::connect_to_server()
     request.greeting.client_pid = getpid();
     auto response = sync_request(request, WSAPI_ServerMessage::Type::Greeting);
     handle_greeting(response);
+
+    // Messages go to whichever event loop is running when they arrive.
+    s_windowserver_notifier = new CNotifier(s_windowserver_fd, CNotifier::Read);
+    s_windowserver_notifier->on_ready_to_read = [] { GEventLoop::current().drain_messages_from_server(); };
+
+    GraphicsBitmap::set_load_from_file_hook(load_from_image_cache);
+}
+
+RetainPtr<GraphicsBitmap> GEventLoop::load_from_image_cache(const String& path)
+{
+    // Only the shared resources are cached, so don't bother asking for anything else.
+    if (strncmp(path.characters(), "/res/", 5) || path.length() >= (int)sizeof(WSAPI_ClientMessage::text))
+        return nullptr;
+    WSAPI_ClientMessage request;
+    request.type = WSAPI_ClientMessage::Type::GetCachedImage;
+    strcpy(request.text, path.characters());
+    request.text_length = path.length();
+    auto response = current().sync_request(request, WSAPI_ServerMessage::Type::DidGetCachedImage);
+    if (response.backing.shared_buffer_id < 0)
+        return nullptr;
+    auto shared_buffer = SharedBuffer::create_from_shared_buffer_id(response.backing.shared_buffer_id);
+    if (!shared_buffer)
+        return nullptr;
+    auto format = response.backing.has_alpha_channel ? GraphicsBitmap::Format::RGBA32 : GraphicsBitmap::Format::RGB32;
+    return GraphicsBitmap::create_with_shared_buffer(format, *shared_buffer, response.backing.size);
 }
 
 GEventLoop::GEventLoop()
@@ -3,6 +3,7 @@
 #include <LibCore/CEventLoop.h>
 #include <WindowServer/WSAPITypes.h>
 #include <LibGUI/GEvent.h>
+#include <SharedGraphics/GraphicsBitmap.h>
 
 class GAction;
 class CObject;
@@ -30,18 +31,6 @@ public:
     }
 
 private:
-    virtual void add_file_descriptors_for_select(fd_set& fds, int& max_fd_added) override
-    {
-        FD_SET(s_windowserver_fd, &fds);
-        max_fd_added = s_windowserver_fd;
-    }
-
-    virtual void process_file_descriptors_after_select(const fd_set& fds) override
-    {
-        if (FD_ISSET(s_windowserver_fd, &fds))
-            drain_messages_from_server();
-    }
-
     virtual void do_processing() override
     {
         while (!m_unprocessed_bundles.is_empty())
@@ -62,6 +51,7 @@ private:
     void handle_wm_event(const WSAPI_ServerMessage&, GWindow&);
     void handle_greeting(WSAPI_ServerMessage&);
     void connect_to_server();
+    static RetainPtr<GraphicsBitmap> load_from_image_cache(const String& path);
 
     struct IncomingWSMessageBundle {
         WSAPI_ServerMessage message;
@@ -72,4 +62,5 @@ private:
     static pid_t s_server_pid;
     static int s_my_client_id;
     static int s_windowserver_fd;
+    static CNotifier* s_windowserver_notifier;
 };
@@ -33,6 +33,7 @@ GWindow::GWindow(CObject* parent)
 {
     m_rect_when_windowless = { 100, 400, 140, 140 };
     m_title_when_windowless = "GWindow";
+    m_pending_paint_event_rects.set_max_rect_count(32);
 }
 
 GWindow::~GWindow()
@@ -73,6 +74,7 @@ void GWindow::show()
     request.text_length = m_title_when_windowless.length();
     auto response = GEventLoop::current().sync_request(request, WSAPI_ServerMessage::Type::DidCreateWindow);
     m_window_id = response.window_id;
+    create_damage_ring();
 
     windows().set(m_window_id, this);
     update();
@@ -88,6 +90,7 @@ void GWindow::hide()
     request.window_id = m_window_id;
     GEventLoop::current().sync_request(request, WSAPI_ServerMessage::Type::DidDestroyWindow);
     m_window_id = 0;
+    m_damage_ring_buffer = nullptr;
     m_pending_paint_event_rects.clear();
     m_back_bitmap = nullptr;
     m_front_bitmap = nullptr;
@@ -235,7 +238,7 @@ void GWindow::event(CEvent& event)
         else if (created_new_backing_store)
             set_current_backing_bitmap(*m_back_bitmap, true);
 
-        if (m_window_id) {
+        if (m_window_id && !post_to_damage_ring(WSAPI_DamageRing::DidFinishPainting, rects)) {
             WSAPI_ClientMessage message;
             message.type = WSAPI_ClientMessage::Type::DidFinishPainting;
             message.window_id = m_window_id;
@@ -283,7 +286,7 @@ void GWindow::event(CEvent& event)
             m_back_bitmap = nullptr;
         if (!m_pending_paint_event_rects.is_empty()) {
             m_pending_paint_event_rects.clear_with_capacity();
-            m_pending_paint_event_rects.append({ { }, new_size });
+            m_pending_paint_event_rects.add({ { }, new_size });
         }
         m_rect_when_windowless = { { }, new_size };
         m_main_widget->set_relative_rect({ { }, new_size });
@@ -305,19 +308,20 @@ void GWindow::update(const Rect& a_rect)
 {
     if (!m_window_id)
         return;
-    for (auto& pending_rect : m_pending_paint_event_rects) {
-        if (pending_rect.contains(a_rect)) {
+    if (m_pending_paint_event_rects.contains(a_rect)) {
 #ifdef UPDATE_COALESCING_DEBUG
-            dbgprintf("Ignoring %s since it's contained by pending rect %s\n", a_rect.to_string().characters(), pending_rect.to_string().characters());
+        dbgprintf("Ignoring %s since it's already pending\n", a_rect.to_string().characters());
 #endif
-            return;
-        }
+        return;
     }
 
     if (m_pending_paint_event_rects.is_empty()) {
         deferred_invoke([this] (auto&) {
-            auto rects = move(m_pending_paint_event_rects);
-            if (rects.is_empty())
+            auto rect_set = move(m_pending_paint_event_rects);
+            if (rect_set.is_empty())
+                return;
+            auto& rects = rect_set.rects();
+            if (post_to_damage_ring(WSAPI_DamageRing::Invalidate, rects))
                 return;
             WSAPI_ClientMessage request;
             request.type = WSAPI_ClientMessage::Type::InvalidateRect;
@@ -331,7 +335,7 @@ void GWindow::update(const Rect& a_rect)
             GEventLoop::current().post_message_to_server(request, extra_data);
         });
     }
-    m_pending_paint_event_rects.append(a_rect);
+    m_pending_paint_event_rects.add(a_rect);
 }
 
 void GWindow::set_main_widget(GWidget* widget)
@@ -469,6 +473,51 @@ void GWindow::flip(const Vector<Rect, 32>& dirty_rects)
         painter.blit(dirty_rect.location(), *m_front_bitmap, dirty_rect);
 }
 
+void GWindow::create_damage_ring()
+{
+    auto shared_buffer = SharedBuffer::create(GEventLoop::server_pid(), sizeof(WSAPI_DamageRing));
+    if (!shared_buffer) {
+        dbgprintf("GWindow: Couldn't create a damage ring, falling back to messages\n");
+        return;
+    }
+    auto& ring = *(WSAPI_DamageRing*)shared_buffer->data();
+    ring.head = 0;
+    ring.tail = 0;
+    // The server hasn't seen the ring yet, so the first post has to wake it up.
+    ring.server_armed = 1;
+
+    WSAPI_ClientMessage message;
+    message.type = WSAPI_ClientMessage::Type::SetWindowDamageRing;
+    message.window_id = m_window_id;
+    message.value = shared_buffer->shared_buffer_id();
+    GEventLoop::current().post_message_to_server(message);
+    m_damage_ring_buffer = move(shared_buffer);
+}
+
+// Returns false if the rects didn't fit, in which case the caller should send them in a message instead.
+bool GWindow::post_to_damage_ring(WSAPI_DamageRing::EntryType type, const Vector<Rect, 32>& rects)
+{
+    if (!m_damage_ring_buffer)
+        return false;
+    auto& ring = *(WSAPI_DamageRing*)m_damage_ring_buffer->data();
+    unsigned head = ring.head;
+    if (head - ring.tail + rects.size() > WSAPI_DamageRing::capacity)
+        return false;
+    for (auto& rect : rects)
+        ring.entries[head++ % WSAPI_DamageRing::capacity] = { type, rect };
+    __sync_synchronize();
+    ring.head = head;
+    __sync_synchronize();
+
+    if (__sync_lock_test_and_set(&ring.server_armed, 0)) {
+        WSAPI_ClientMessage message;
+        message.type = WSAPI_ClientMessage::Type::DamageRingNotify;
+        message.window_id = m_window_id;
+        GEventLoop::current().post_message_to_server(message);
+    }
+    return true;
+}
+
 Retained<GraphicsBitmap> GWindow::create_backing_bitmap(const Size& size)
 {
     ASSERT(GEventLoop::server_pid());
@@ -2,8 +2,10 @@
 
 #include <LibCore/CObject.h>
 #include <LibGUI/GWindowType.h>
+#include <SharedGraphics/DisjointRectSet.h>
 #include <SharedGraphics/Rect.h>
 #include <SharedGraphics/GraphicsBitmap.h>
+#include <WindowServer/WSAPITypes.h>
 #include <AK/AKString.h>
 #include <AK/WeakPtr.h>
 
@@ -132,6 +134,8 @@ private:
     Retained<GraphicsBitmap> create_backing_bitmap(const Size&);
     void set_current_backing_bitmap(GraphicsBitmap&, bool flush_immediately = false);
     void flip(const Vector<Rect, 32>& dirty_rects);
+    void create_damage_ring();
+    bool post_to_damage_ring(WSAPI_DamageRing::EntryType, const Vector<Rect, 32>&);
 
     RetainPtr<GraphicsBitmap> m_front_bitmap;
     RetainPtr<GraphicsBitmap> m_back_bitmap;
@@ -145,7 +149,8 @@ private:
     Rect m_rect_when_windowless;
     String m_title_when_windowless;
     String m_icon_path;
-    Vector<Rect, 32> m_pending_paint_event_rects;
+    DisjointRectSet m_pending_paint_event_rects;
+    RetainPtr<SharedBuffer> m_damage_ring_buffer;
     Size m_size_increment;
     Size m_base_size;
     Color m_background_color { Color::LightGray };
@@ -66,6 +66,17 @@ enum WSAPI_WMEventMask : unsigned {
     WindowRemovals = 1 << 3,
 };
 
+struct WSAPI_FrameStats {
+    unsigned frame_count;
+    unsigned missed_deadline_count;
+    unsigned last_compose_us;
+    unsigned last_flush_us;
+    unsigned average_compose_us;
+    unsigned average_flush_us;
+    unsigned max_compose_us;
+    unsigned max_flush_us;
+};
+
 struct WSAPI_ServerMessage {
     enum Type : unsigned {
         Invalid,
@@ -111,6 +122,8 @@ struct WSAPI_ServerMessage {
         WM_WindowStateChanged,
         WM_WindowRectChanged,
         WM_WindowIconChanged,
+        DidGetFrameStats,
+        DidGetCachedImage,
     };
     Type type { Invalid };
     int window_id { -1 };
@@ -152,6 +165,7 @@ struct WSAPI_ServerMessage {
         struct {
             WSAPI_Size window_size;
         } paint;
+        WSAPI_FrameStats frame_stats;
         struct {
             WSAPI_Point position;
             WSAPI_MouseButton button;
@@ -223,6 +237,11 @@ struct WSAPI_ClientMessage {
         DismissMenu,
         SetWindowIcon,
         SetWindowHasAlphaChannel,
+        SetWindowDamageRing,
+        DamageRingNotify,
+        GetFrameStats,
+        SetFrameTimeOverlay,
+        GetCachedImage,
     };
     Type type { Invalid };
     int window_id { -1 };
@@ -290,6 +309,27 @@ struct WSAPI_ClientMessage {
     };
 };
 
+// A single-producer, single-consumer ring in a SharedBuffer through which a client posts damage
+// for one window without sending a message per update. The server drains it at every compose.
+// When the server has drained the ring and gone idle, it sets server_armed. The client that
+// clears server_armed owes the server one DamageRingNotify message to wake it up.
+struct WSAPI_DamageRing {
+    enum EntryType : unsigned {
+        Invalidate,
+        DidFinishPainting,
+    };
+    struct Entry {
+        EntryType type;
+        WSAPI_Rect rect;
+    };
+    static const unsigned capacity = 128;
+
+    volatile unsigned head;
+    volatile unsigned tail;
+    volatile unsigned server_armed;
+    Entry entries[capacity];
+};
+
 inline Rect::Rect(const WSAPI_Rect& r) : Rect(r.location, r.size) { }
 inline Point::Point(const WSAPI_Point& p) : Point(p.x, p.y) { }
 inline Size::Size(const WSAPI_Size& s) : Size(s.width, s.height) { }
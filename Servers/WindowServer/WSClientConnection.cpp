@@ -1,9 +1,11 @@
+#include <LibCore/CNotifier.h>
 #include <SharedBuffer.h>
 #include <WindowServer/WSAPITypes.h>
 #include <WindowServer/WSClientConnection.h>
 #include <WindowServer/WSClipboard.h>
 #include <WindowServer/WSCompositor.h>
 #include <WindowServer/WSEventLoop.h>
+#include <WindowServer/WSImageCache.h>
 #include <WindowServer/WSMenu.h>
 #include <WindowServer/WSMenuBar.h>
 #include <WindowServer/WSMenuItem.h>
@@ -48,6 +50,9 @@ WSClientConnection::WSClientConnection(int fd)
         s_connections = new HashMap<int, WSClientConnection*>;
     s_connections->set(m_client_id, this);
 
+    m_notifier = make<CNotifier>(m_fd, CNotifier::Read);
+    m_notifier->on_ready_to_read = [this] { WSEventLoop::the().drain_client(*this); };
+
     WSAPI_ServerMessage message;
     message.type = WSAPI_ServerMessage::Type::Greeting;
     message.greeting.server_pid = getpid();
@@ -59,6 +64,8 @@ WSClientConnection::WSClientConnection(int fd)
 WSClientConnection::~WSClientConnection()
 {
     s_connections->remove(m_client_id);
+    // Stop watching the fd before it's closed (and possibly reused.)
+    m_notifier = nullptr;
     int rc = close(m_fd);
     ASSERT(rc == 0);
 }
@@ -362,6 +369,42 @@ void WSClientConnection::handle_request(const WSAPIGetWallpaperRequest&)
     post_message(response);
 }
 
+void WSClientConnection::handle_request(const WSAPIGetFrameStatsRequest&)
+{
+    WSAPI_ServerMessage response;
+    response.type = WSAPI_ServerMessage::Type::DidGetFrameStats;
+    response.frame_stats = WSCompositor::the().frame_stats();
+    post_message(response);
+}
+
+void WSClientConnection::handle_request(const WSAPISetFrameTimeOverlayRequest& request)
+{
+    WSCompositor::the().set_frame_time_overlay_enabled(request.enabled());
+}
+
+void WSClientConnection::handle_request(const WSAPIGetCachedImageRequest& request)
+{
+    WSAPI_ServerMessage response;
+    response.type = WSAPI_ServerMessage::Type::DidGetCachedImage;
+    response.backing.shared_buffer_id = -1;
+    auto* image = WSImageCache::the().image(request.path(), m_pid);
+    if (image) {
+        RetainPtr<SharedBuffer> buffer;
+        if (image->peer_pid == m_pid)
+            buffer = image->buffer.copy_ref();
+        else
+            buffer = image->buffer->share_with(m_pid);
+        if (buffer) {
+            response.backing.shared_buffer_id = buffer->shared_buffer_id();
+            response.backing.size = image->size;
+            response.backing.bpp = 32;
+            response.backing.has_alpha_channel = image->has_alpha_channel;
+            m_cached_image_buffers.set(request.path(), move(buffer));
+        }
+    }
+    post_message(response);
+}
+
 void WSClientConnection::handle_request(const WSAPISetWindowTitleRequest& request)
 {
     int window_id = request.window_id();
@@ -666,6 +709,32 @@ void WSClientConnection::handle_request(const WSAPISetWindowHasAlphaChannelReque
     post_message(response);
 }
 
+void WSClientConnection::handle_request(const WSAPISetWindowDamageRingRequest& request)
+{
+    int window_id = request.window_id();
+    auto it = m_windows.find(window_id);
+    if (it == m_windows.end()) {
+        post_error("WSAPISetWindowDamageRingRequest: Bad window ID");
+        return;
+    }
+    auto& window = *(*it).value;
+    auto shared_buffer = SharedBuffer::create_from_shared_buffer_id(request.shared_buffer_id());
+    if (!shared_buffer || !window.set_damage_ring(*shared_buffer))
+        post_error("WSAPISetWindowDamageRingRequest: Bad shared buffer");
+}
+
+void WSClientConnection::handle_request(const WSAPIDamageRingNotification& request)
+{
+    int window_id = request.window_id();
+    auto it = m_windows.find(window_id);
+    if (it == m_windows.end()) {
+        post_error("WSAPIDamageRingNotification: Bad window ID");
+        return;
+    }
+    auto& window = *(*it).value;
+    window.drain_damage_ring();
+}
+
 void WSClientConnection::handle_request(const WSWMAPISetActiveWindowRequest& request)
 {
     auto* client = WSClientConnection::from_client_id(request.target_client_id());
@@ -786,6 +855,16 @@ void WSClientConnection::on_request(const WSAPIClientRequest& request)
         return handle_request(static_cast<const WSAPIDismissMenuRequest&>(request));
     case WSEvent::APISetWindowHasAlphaChannelRequest:
         return handle_request(static_cast<const WSAPISetWindowHasAlphaChannelRequest&>(request));
+    case WSEvent::APISetWindowDamageRingRequest:
+        return handle_request(static_cast<const WSAPISetWindowDamageRingRequest&>(request));
+    case WSEvent::APIDamageRingNotification:
+        return handle_request(static_cast<const WSAPIDamageRingNotification&>(request));
+    case WSEvent::APIGetFrameStatsRequest:
+        return handle_request(static_cast<const WSAPIGetFrameStatsRequest&>(request));
+    case WSEvent::APIGetCachedImageRequest:
+        return handle_request(static_cast<const WSAPIGetCachedImageRequest&>(request));
+    case WSEvent::APISetFrameTimeOverlayRequest:
+        return handle_request(static_cast<const WSAPISetFrameTimeOverlayRequest&>(request));
     default:
         break;
     }
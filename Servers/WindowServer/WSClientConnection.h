@@ -8,6 +8,7 @@
 #include <LibCore/CObject.h>
 #include <WindowServer/WSEvent.h>
 
+class CNotifier;
 class WSWindow;
 class WSMenu;
 class WSMenuBar;
@@ -78,12 +79,18 @@ private:
     void handle_request(const WSAPIPopupMenuRequest&);
     void handle_request(const WSAPIDismissMenuRequest&);
     void handle_request(const WSAPISetWindowHasAlphaChannelRequest&);
+    void handle_request(const WSAPISetWindowDamageRingRequest&);
+    void handle_request(const WSAPIDamageRingNotification&);
+    void handle_request(const WSAPIGetFrameStatsRequest&);
+    void handle_request(const WSAPISetFrameTimeOverlayRequest&);
+    void handle_request(const WSAPIGetCachedImageRequest&);
 
     void post_error(const String&);
 
     int m_client_id { 0 };
     int m_fd { -1 };
     pid_t m_pid { -1 };
+    OwnPtr<CNotifier> m_notifier;
 
     HashMap<int, OwnPtr<WSWindow>> m_windows;
     HashMap<int, OwnPtr<WSMenuBar>> m_menubars;
@@ -95,6 +102,10 @@ private:
     int m_next_window_id { 1982 };
 
     RetainPtr<SharedBuffer> m_last_sent_clipboard_content;
+
+    // Our side of the image cache buffers handed to this client, by path.
+    // FIXME: Like the clipboard, these are kept around since a SharedBuffer goes away if neither side is retaining it.
+    HashMap<String, RetainPtr<SharedBuffer>> m_cached_image_buffers;
 };
 
 template<typename Matching, typename Callback>
@@ -22,34 +22,40 @@ WSCompositor::WSCompositor()
     m_front_bitmap = GraphicsBitmap::create_wrapper(GraphicsBitmap::Format::RGB32, size, WSScreen::the().scanline(0));
     m_back_bitmap = GraphicsBitmap::create_wrapper(GraphicsBitmap::Format::RGB32, size, WSScreen::the().scanline(size.height()));
 
+    // Past this many dirty rects, a frame just repaints their bounding rect.
+    m_dirty_rects.set_max_rect_count(64);
+
     m_front_painter = make<Painter>(*m_front_bitmap);
     m_back_painter = make<Painter>(*m_back_bitmap);
 
     m_wallpaper_path = "/res/wallpapers/retro.rgb";
     m_wallpaper = GraphicsBitmap::load_from_file(GraphicsBitmap::Format::RGBA32, m_wallpaper_path, { 1024, 768 });
 
-    m_compose_timer.on_timeout = [=]() {
-#if defined(COMPOSITOR_DEBUG)
-        dbgprintf("WSCompositor: delayed frame callback: %d rects\n", m_dirty_rects.size());
-#endif
-        compose();
-    };
-    m_compose_timer.set_single_shot(true);
-    m_compose_timer.set_interval(1000 / 60);
-    m_immediate_compose_timer.on_timeout = [=]() {
+    m_frame_timer.on_timeout = [=]() {
 #if defined(COMPOSITOR_DEBUG)
-        dbgprintf("WSCompositor: immediate frame callback: %d rects\n", m_dirty_rects.size());
+        dbgprintf("WSCompositor: frame callback: %d rects\n", m_dirty_rects.size());
 #endif
         compose();
     };
-    m_immediate_compose_timer.set_single_shot(true);
-    m_immediate_compose_timer.set_interval(0);
+    m_frame_timer.set_single_shot(true);
+    gettimeofday(&m_last_frame_start, nullptr);
+}
+
+static int microseconds_between(const timeval& start, const timeval& end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_usec - start.tv_usec);
 }
 
 void WSCompositor::compose()
 {
     auto& wm = WSWindowManager::the();
 
+    // Pick up whatever damage clients have posted to their rings since the last frame.
+    wm.for_each_window([] (WSWindow& window) {
+        window.drain_damage_ring();
+        return IterationDecision::Continue;
+    });
+
     auto dirty_rects = move(m_dirty_rects);
 
     if (dirty_rects.size() == 0) {
@@ -57,56 +63,72 @@ void WSCompositor::compose()
         return;
     }
 
+    timeval frame_start;
+    gettimeofday(&frame_start, nullptr);
+    m_last_frame_start = frame_start;
+
     dirty_rects.add(Rect::intersection(m_last_geometry_label_rect, WSScreen::the().rect()));
     dirty_rects.add(Rect::intersection(m_last_cursor_rect, WSScreen::the().rect()));
     dirty_rects.add(Rect::intersection(current_cursor_rect(), WSScreen::the().rect()));
+    if (m_frame_time_overlay_enabled)
+        dirty_rects.add(frame_time_overlay_rect());
 #ifdef DEBUG_COUNTERS
     dbgprintf("[WM] compose #%u (%u rects)\n", ++m_compose_count, dirty_rects.rects().size());
 #endif
 
+    catch_up_back_buffer(dirty_rects);
+
+    timeval compose_start;
+    gettimeofday(&compose_start, nullptr);
+
     auto any_dirty_rect_intersects_window = [&dirty_rects] (const WSWindow& window) {
-        auto window_frame_rect = window.frame().rect();
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (dirty_rect.intersects(window_frame_rect))
-                return true;
+        return dirty_rects.intersects(window.frame().rect());
+    };
+
+    wm.recompute_occlusions();
+
+    // Every dirty rect is intersected with the (disjoint) visible fragments of the desktop
+    // and each window, so a pixel that's covered by an opaque window is only painted once.
+    auto for_each_dirty_fragment = [&dirty_rects] (const DisjointRectSet& region, auto callback) {
+        for (auto& visible_rect : region.rects()) {
+            for (auto& dirty_rect : dirty_rects.rects()) {
+                auto fragment = Rect::intersection(visible_rect, dirty_rect);
+                if (!fragment.is_empty())
+                    callback(fragment);
+            }
         }
-        return false;
     };
 
-    for (auto& dirty_rect : dirty_rects.rects()) {
-        if (wm.any_opaque_window_contains_rect(dirty_rect))
-            continue;
+    auto paint_desktop_fragment = [&] (const Rect& fragment) {
         if (!m_wallpaper)
-            m_back_painter->fill_rect(dirty_rect, wm.m_background_color);
+            m_back_painter->fill_rect(fragment, wm.m_background_color);
         else
-            m_back_painter->blit(dirty_rect.location(), *m_wallpaper, dirty_rect);
-    }
+            m_back_painter->blit(fragment.location(), *m_wallpaper, fragment);
+    };
 
-    auto compose_window = [&] (WSWindow& window) -> IterationDecision {
+    auto compose_window = [&] (WSWindow& window, bool clip_to_visible_region) -> IterationDecision {
         if (!any_dirty_rect_intersects_window(window))
             return IterationDecision::Continue;
         PainterStateSaver saver(*m_back_painter);
         m_back_painter->add_clip_rect(window.frame().rect());
         RetainPtr<GraphicsBitmap> backing_store = window.backing_store();
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (wm.any_opaque_window_above_this_one_contains_rect(window, dirty_rect))
-                continue;
+        auto paint_fragment = [&] (const Rect& fragment) {
             PainterStateSaver saver(*m_back_painter);
-            m_back_painter->add_clip_rect(dirty_rect);
+            m_back_painter->add_clip_rect(fragment);
             if (!backing_store)
-                m_back_painter->fill_rect(dirty_rect, window.background_color());
+                m_back_painter->fill_rect(fragment, window.background_color());
             if (!window.is_fullscreen())
                 window.frame().paint(*m_back_painter);
             if (!backing_store)
-                continue;
-            Rect dirty_rect_in_window_coordinates = Rect::intersection(dirty_rect, window.rect());
-            if (dirty_rect_in_window_coordinates.is_empty())
-                continue;
-            dirty_rect_in_window_coordinates.move_by(-window.position());
+                return;
+            Rect fragment_in_window_coordinates = Rect::intersection(fragment, window.rect());
+            if (fragment_in_window_coordinates.is_empty())
+                return;
+            fragment_in_window_coordinates.move_by(-window.position());
             auto dst = window.position();
-            dst.move_by(dirty_rect_in_window_coordinates.location());
+            dst.move_by(fragment_in_window_coordinates.location());
 
-            m_back_painter->blit(dst, *backing_store, dirty_rect_in_window_coordinates, window.opacity());
+            m_back_painter->blit(dst, *backing_store, fragment_in_window_coordinates, window.opacity());
 
             if (backing_store->width() < window.width()) {
                 Rect right_fill_rect { window.x() + backing_store->width(), window.y(), window.width() - backing_store->width(), window.height() };
@@ -117,21 +139,32 @@ void WSCompositor::compose()
                 Rect bottom_fill_rect { window.x(), window.y() + backing_store->height(), window.width(), window.height() - backing_store->height() };
                 m_back_painter->fill_rect(bottom_fill_rect, window.background_color());
             }
+        };
+        if (clip_to_visible_region) {
+            for_each_dirty_fragment(window.visible_region(), paint_fragment);
+        } else {
+            for (auto& dirty_rect : dirty_rects.rects())
+                paint_fragment(dirty_rect);
         }
         return IterationDecision::Continue;
     };
 
     if (auto* fullscreen_window = wm.active_fullscreen_window()) {
-        compose_window(*fullscreen_window);
+        compose_window(*fullscreen_window, false);
     } else {
+        for_each_dirty_fragment(wm.uncovered_desktop_region(), paint_desktop_fragment);
+
         wm.for_each_visible_window_from_back_to_front([&] (WSWindow& window) {
-            return compose_window(window);
+            return compose_window(window, true);
         });
 
         draw_geometry_label();
         draw_menubar();
     }
 
+    if (m_frame_time_overlay_enabled)
+        draw_frame_time_overlay();
+
     draw_cursor();
 
     if (m_flash_flush) {
@@ -139,17 +172,40 @@ void WSCompositor::compose()
             m_front_painter->fill_rect(rect, Color::Yellow);
     }
 
+    timeval flip_start;
+    gettimeofday(&flip_start, nullptr);
+
     flip_buffers();
-    for (auto& r : dirty_rects.rects())
-        flush(r);
+
+    timeval frame_end;
+    gettimeofday(&frame_end, nullptr);
+    record_frame_timing(microseconds_between(compose_start, flip_start),
+        microseconds_between(frame_start, compose_start) + microseconds_between(flip_start, frame_end));
+
+    // The buffer we just stopped scanning out is now one frame behind.
+    // Remember what changed so the next frame can catch it up.
+    m_damage_since_last_flip = move(dirty_rects);
 }
 
-void WSCompositor::flush(const Rect& a_rect)
+void WSCompositor::catch_up_back_buffer(const DisjointRectSet& dirty_rects)
+{
+    // The back buffer was last on screen two frames ago. Anything that changed in the
+    // previous frame and isn't about to be repainted anyway is copied over from the
+    // front buffer, which holds the previous frame.
+    auto damage = move(m_damage_since_last_flip);
+    damage.subtract(dirty_rects);
+    for (auto& rect : damage.rects())
+        copy_front_to_back(rect);
+}
+
+void WSCompositor::copy_front_to_back(const Rect& a_rect)
 {
     auto rect = Rect::intersection(a_rect, WSScreen::the().rect());
+    if (rect.is_empty())
+        return;
 
 #ifdef DEBUG_COUNTERS
-    dbgprintf("[WM] flush #%u (%d,%d %dx%d)\n", ++m_flush_count, rect.x(), rect.y(), rect.width(), rect.height());
+    dbgprintf("[WM] catch-up copy #%u (%d,%d %dx%d)\n", ++m_flush_count, rect.x(), rect.y(), rect.width(), rect.height());
 #endif
 
     const RGBA32* front_ptr = m_front_bitmap->scanline(rect.y()) + rect.x();
@@ -177,19 +233,112 @@ void WSCompositor::invalidate(const Rect& a_rect)
 
     m_dirty_rects.add(rect);
 
-    // We delay composition by a timer interval, but to not affect latency too
-    // much, if a pending compose is not already scheduled, we also schedule an
-    // immediate compose the next spin of the event loop.
-    if (!m_compose_timer.is_active()) {
-#if defined(COMPOSITOR_DEBUG)
-        dbgprintf("Invalidated (starting immediate frame): %dx%d %dx%d\n", a_rect.x(), a_rect.y(), a_rect.width(), a_rect.height());
-#endif
-        m_compose_timer.start();
-        m_immediate_compose_timer.start();
-    } else {
+    if (!m_frame_timer.is_active())
+        schedule_frame();
+}
+
+void WSCompositor::schedule_frame()
+{
+    // Compose at most once per frame interval: right away if the last frame is at
+    // least an interval old, otherwise at the next frame boundary. Everything that
+    // gets invalidated in the meantime is coalesced into that one frame.
+    // FIXME: Pace to the display's vertical retrace once the video driver can tell us about it.
+    timeval now;
+    gettimeofday(&now, nullptr);
+    // Do this in 64 bits: after a long idle stretch the gap doesn't fit in an int of
+    // microseconds. A gap that's negative (the clock was set back) also means "compose now".
+    long long us_since_last_frame = (long long)(now.tv_sec - m_last_frame_start.tv_sec) * 1000000 + (now.tv_usec - m_last_frame_start.tv_usec);
+    int delay = 0;
+    if (us_since_last_frame >= 0 && us_since_last_frame < frame_interval_ms * 1000)
+        delay = frame_interval_ms - (int)(us_since_last_frame / 1000);
 #if defined(COMPOSITOR_DEBUG)
-        dbgprintf("Invalidated (frame callback pending): %dx%d %dx%d\n", a_rect.x(), a_rect.y(), a_rect.width(), a_rect.height());
+    dbgprintf("WSCompositor: scheduling frame in %d ms\n", delay);
 #endif
+    m_frame_timer.start(delay);
+}
+
+void WSCompositor::record_frame_timing(int compose_us, int flush_us)
+{
+    auto& timing = m_frame_history[m_frame_count % frame_history_size];
+    timing.compose_us = compose_us;
+    timing.flush_us = flush_us;
+    ++m_frame_count;
+    if (compose_us + flush_us > frame_interval_ms * 1000)
+        ++m_missed_deadline_count;
+}
+
+WSAPI_FrameStats WSCompositor::frame_stats() const
+{
+    WSAPI_FrameStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.frame_count = m_frame_count;
+    stats.missed_deadline_count = m_missed_deadline_count;
+    int count = min(m_frame_count, (unsigned)frame_history_size);
+    if (!count)
+        return stats;
+    auto& last = m_frame_history[(m_frame_count - 1) % frame_history_size];
+    stats.last_compose_us = last.compose_us;
+    stats.last_flush_us = last.flush_us;
+    unsigned total_compose_us = 0;
+    unsigned total_flush_us = 0;
+    for (int i = 0; i < count; ++i) {
+        auto& timing = m_frame_history[i];
+        total_compose_us += timing.compose_us;
+        total_flush_us += timing.flush_us;
+        stats.max_compose_us = max(stats.max_compose_us, (unsigned)timing.compose_us);
+        stats.max_flush_us = max(stats.max_flush_us, (unsigned)timing.flush_us);
+    }
+    stats.average_compose_us = total_compose_us / count;
+    stats.average_flush_us = total_flush_us / count;
+    return stats;
+}
+
+void WSCompositor::set_frame_time_overlay_enabled(bool enabled)
+{
+    if (m_frame_time_overlay_enabled == enabled)
+        return;
+    m_frame_time_overlay_enabled = enabled;
+    invalidate(frame_time_overlay_rect());
+}
+
+Rect WSCompositor::frame_time_overlay_rect() const
+{
+    // One bar per frame in the history, below the menubar in the top right corner.
+    auto screen_rect = WSScreen::the().rect();
+    Rect rect { 0, 0, frame_history_size * 3 + 8, 64 };
+    rect.set_x(screen_rect.right() - rect.width() - 4);
+    rect.set_y(22);
+    return rect;
+}
+
+void WSCompositor::draw_frame_time_overlay()
+{
+    auto& wm = WSWindowManager::the();
+    auto rect = frame_time_overlay_rect();
+    auto stats = frame_stats();
+    m_back_painter->fill_rect(rect, Color::Black);
+    m_back_painter->draw_rect(rect, Color::MidGray);
+
+    auto text_rect = Rect { rect.x() + 4, rect.y() + 2, rect.width() - 8, wm.font().glyph_height() };
+    auto text = String::format("compose %u.%u ms, flush %u.%u ms",
+        stats.average_compose_us / 1000, (stats.average_compose_us % 1000) / 100,
+        stats.average_flush_us / 1000, (stats.average_flush_us % 1000) / 100);
+    m_back_painter->draw_text(text_rect, text, wm.font(), TextAlignment::TopLeft, Color::White);
+    text_rect.move_by(0, wm.font().glyph_height() + 2);
+    text = String::format("frames %u, missed %u", stats.frame_count, stats.missed_deadline_count);
+    m_back_painter->draw_text(text_rect, text, wm.font(), TextAlignment::TopLeft, Color::White);
+
+    // Oldest frame on the left. A bar reaching the top of the graph took a full frame interval.
+    int graph_bottom = rect.bottom() - 3;
+    int graph_height = rect.bottom() - text_rect.bottom() - 6;
+    int count = min(m_frame_count, (unsigned)frame_history_size);
+    for (int i = 0; i < count; ++i) {
+        auto& timing = m_frame_history[(m_frame_count - count + i) % frame_history_size];
+        int total_us = timing.compose_us + timing.flush_us;
+        bool missed_deadline = total_us > frame_interval_ms * 1000;
+        int bar_height = min(graph_height, max(1, total_us * graph_height / (frame_interval_ms * 1000)));
+        Rect bar { rect.x() + 4 + i * 3, graph_bottom - bar_height + 1, 2, bar_height };
+        m_back_painter->fill_rect(bar, missed_deadline ? Color::Red : Color::Green);
     }
 }
 
@@ -197,11 +346,13 @@ bool WSCompositor::set_wallpaper(const String& path, Function<void(bool)>&& call
 {
     struct Context {
         String path;
+        Size screen_size;
         RetainPtr<GraphicsBitmap> bitmap;
         Function<void(bool)> callback;
     };
     auto context = make<Context>();
     context->path = path;
+    context->screen_size = WSScreen::the().size();
     context->callback = move(callback);
 
     int rc = create_thread([] (void* ctx) -> int {
@@ -212,6 +363,13 @@ bool WSCompositor::set_wallpaper(const String& path, Function<void(bool)>&& call
             exit_thread(0);
             return 0;
         }
+        // Scale it to fit the screen here, so composing never has to.
+        if (context->bitmap->size() != context->screen_size) {
+            auto scaled_bitmap = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, context->screen_size);
+            Painter painter(*scaled_bitmap);
+            painter.draw_scaled_bitmap(scaled_bitmap->rect(), *context->bitmap, context->bitmap->rect(), Painter::ScalingMode::Bilinear);
+            context->bitmap = move(scaled_bitmap);
+        }
         the().deferred_invoke([context = move(context)] (auto&) {
             the().finish_setting_wallpaper(context->path, *context->bitmap);
             context->callback(true);
@@ -219,7 +377,7 @@ bool WSCompositor::set_wallpaper(const String& path, Function<void(bool)>&& call
         exit_thread(0);
         return 0;
     }, context.leak_ptr());
-    ASSERT(rc == 0);
+    ASSERT(rc > 0);
 
     return true;
 }
@@ -250,9 +408,11 @@ void WSCompositor::set_resolution(int width, int height)
     WSScreen::the().set_resolution(width, height);
     m_front_bitmap = GraphicsBitmap::create_wrapper(GraphicsBitmap::Format::RGB32, { width, height }, WSScreen::the().scanline(0));
     m_back_bitmap = GraphicsBitmap::create_wrapper(GraphicsBitmap::Format::RGB32, { width, height }, WSScreen::the().scanline(height));
+
     m_front_painter = make<Painter>(*m_front_bitmap);
     m_back_painter = make<Painter>(*m_back_bitmap);
     m_buffers_are_flipped = false;
+    m_damage_since_last_flip.clear();
     invalidate();
     compose();
 }
@@ -6,6 +6,8 @@
 #include <LibCore/CTimer.h>
 #include <SharedGraphics/DisjointRectSet.h>
 #include <SharedGraphics/GraphicsBitmap.h>
+#include <WindowServer/WSAPITypes.h>
+#include <sys/time.h>
 
 class Painter;
 class WSCursor;
@@ -26,21 +28,42 @@ public:
     void invalidate_cursor();
     Rect current_cursor_rect() const;
 
+    WSAPI_FrameStats frame_stats() const;
+    bool frame_time_overlay_enabled() const { return m_frame_time_overlay_enabled; }
+    void set_frame_time_overlay_enabled(bool);
+
 private:
     virtual const char* class_name() const override { return "WSCompositor"; }
 
     WSCompositor();
     void flip_buffers();
-    void flush(const Rect&);
+    void catch_up_back_buffer(const DisjointRectSet& dirty_rects);
+    void copy_front_to_back(const Rect&);
     void draw_cursor();
     void draw_geometry_label();
     void draw_menubar();
     void finish_setting_wallpaper(const String& path, Retained<GraphicsBitmap>&&);
+    void schedule_frame();
+    void record_frame_timing(int compose_us, int flush_us);
+    Rect frame_time_overlay_rect() const;
+    void draw_frame_time_overlay();
+
+    static const int frame_interval_ms = 1000 / 60;
+    static const int frame_history_size = 64;
+
+    struct FrameTiming {
+        int compose_us { 0 };
+        int flush_us { 0 };
+    };
 
     unsigned m_compose_count { 0 };
     unsigned m_flush_count { 0 };
-    CTimer m_compose_timer;
-    CTimer m_immediate_compose_timer;
+    CTimer m_frame_timer;
+    struct timeval m_last_frame_start { 0, 0 };
+    FrameTiming m_frame_history[frame_history_size];
+    unsigned m_frame_count { 0 };
+    unsigned m_missed_deadline_count { 0 };
+    bool m_frame_time_overlay_enabled { false };
     bool m_flash_flush { false };
     bool m_buffers_are_flipped { false };
 
@@ -50,6 +73,7 @@ private:
     OwnPtr<Painter> m_front_painter;
 
     DisjointRectSet m_dirty_rects;
+    DisjointRectSet m_damage_since_last_flip;
 
     Rect m_last_cursor_rect;
     Rect m_last_geometry_label_rect;
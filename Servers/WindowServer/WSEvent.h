@@ -63,6 +63,11 @@ public:
         APIGetWallpaperRequest,
         APISetWindowOverrideCursorRequest,
         APISetWindowHasAlphaChannelRequest,
+        APISetWindowDamageRingRequest,
+        APIDamageRingNotification,
+        APIGetFrameStatsRequest,
+        APISetFrameTimeOverlayRequest,
+        APIGetCachedImageRequest,
         WMAPISetActiveWindowRequest,
         WMAPISetWindowMinimizedRequest,
         WMAPIStartWindowResizeRequest,
@@ -404,6 +409,37 @@ private:
     bool m_value { 0 };
 };
 
+class WSAPISetWindowDamageRingRequest final : public WSAPIClientRequest {
+public:
+    explicit WSAPISetWindowDamageRingRequest(int client_id, int window_id, int shared_buffer_id)
+        : WSAPIClientRequest(WSEvent::APISetWindowDamageRingRequest, client_id)
+        , m_window_id(window_id)
+        , m_shared_buffer_id(shared_buffer_id)
+    {
+    }
+
+    int window_id() const { return m_window_id; }
+    int shared_buffer_id() const { return m_shared_buffer_id; }
+
+private:
+    int m_window_id { 0 };
+    int m_shared_buffer_id { -1 };
+};
+
+class WSAPIDamageRingNotification final : public WSAPIClientRequest {
+public:
+    explicit WSAPIDamageRingNotification(int client_id, int window_id)
+        : WSAPIClientRequest(WSEvent::APIDamageRingNotification, client_id)
+        , m_window_id(window_id)
+    {
+    }
+
+    int window_id() const { return m_window_id; }
+
+private:
+    int m_window_id { 0 };
+};
+
 class WSAPISetWallpaperRequest final : public WSAPIClientRequest {
 public:
     explicit WSAPISetWallpaperRequest(int client_id, const String& wallpaper)
@@ -426,6 +462,42 @@ public:
     }
 };
 
+class WSAPIGetFrameStatsRequest final : public WSAPIClientRequest {
+public:
+    explicit WSAPIGetFrameStatsRequest(int client_id)
+        : WSAPIClientRequest(WSEvent::APIGetFrameStatsRequest, client_id)
+    {
+    }
+};
+
+class WSAPISetFrameTimeOverlayRequest final : public WSAPIClientRequest {
+public:
+    explicit WSAPISetFrameTimeOverlayRequest(int client_id, bool enabled)
+        : WSAPIClientRequest(WSEvent::APISetFrameTimeOverlayRequest, client_id)
+        , m_enabled(enabled)
+    {
+    }
+
+    bool enabled() const { return m_enabled; }
+
+private:
+    bool m_enabled { false };
+};
+
+class WSAPIGetCachedImageRequest final : public WSAPIClientRequest {
+public:
+    explicit WSAPIGetCachedImageRequest(int client_id, const String& path)
+        : WSAPIClientRequest(WSEvent::APIGetCachedImageRequest, client_id)
+        , m_path(path)
+    {
+    }
+
+    String path() const { return m_path; }
+
+private:
+    String m_path;
+};
+
 class WSAPISetWindowTitleRequest final : public WSAPIClientRequest {
 public:
     explicit WSAPISetWindowTitleRequest(int client_id, int window_id, const String& title)
@@ -1,5 +1,6 @@
 #include <WindowServer/WSEventLoop.h>
 #include <WindowServer/WSEvent.h>
+#include <LibCore/CNotifier.h>
 #include <LibCore/CObject.h>
 #include <WindowServer/WSWindowManager.h>
 #include <WindowServer/WSScreen.h>
@@ -9,7 +10,6 @@
 #include <Kernel/KeyCode.h>
 #include <Kernel/MousePacket.h>
 #include <sys/socket.h>
-#include <sys/select.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
@@ -38,6 +38,15 @@ WSEventLoop::WSEventLoop()
 
     ASSERT(m_keyboard_fd >= 0);
     ASSERT(m_mouse_fd >= 0);
+
+    m_keyboard_notifier = make<CNotifier>(m_keyboard_fd, CNotifier::Read);
+    m_keyboard_notifier->on_ready_to_read = [this] { drain_keyboard(); };
+
+    m_mouse_notifier = make<CNotifier>(m_mouse_fd, CNotifier::Read);
+    m_mouse_notifier->on_ready_to_read = [this] { drain_mouse(); };
+
+    m_server_notifier = make<CNotifier>(m_server_fd, CNotifier::Read);
+    m_server_notifier->on_ready_to_read = [this] { drain_server(); };
 }
 
 WSEventLoop::~WSEventLoop()
@@ -300,6 +309,25 @@ bool WSEventLoop::on_receive_from_client(int client_id, const WSAPI_ClientMessag
     case WSAPI_ClientMessage::SetWindowHasAlphaChannel:
         post_event(client, make<WSAPISetWindowHasAlphaChannelRequest>(client_id, message.window_id, message.value));
         break;
+    case WSAPI_ClientMessage::Type::SetWindowDamageRing:
+        post_event(client, make<WSAPISetWindowDamageRingRequest>(client_id, message.window_id, message.value));
+        break;
+    case WSAPI_ClientMessage::Type::DamageRingNotify:
+        post_event(client, make<WSAPIDamageRingNotification>(client_id, message.window_id));
+        break;
+    case WSAPI_ClientMessage::Type::GetFrameStats:
+        post_event(client, make<WSAPIGetFrameStatsRequest>(client_id));
+        break;
+    case WSAPI_ClientMessage::Type::SetFrameTimeOverlay:
+        post_event(client, make<WSAPISetFrameTimeOverlayRequest>(client_id, message.value));
+        break;
+    case WSAPI_ClientMessage::Type::GetCachedImage:
+        if (message.text_length > (int)sizeof(message.text)) {
+            client.did_misbehave();
+            return false;
+        }
+        post_event(client, make<WSAPIGetCachedImageRequest>(client_id, String(message.text, message.text_length)));
+        break;
     case WSAPI_ClientMessage::Type::WM_SetActiveWindow:
         post_event(client, make<WSWMAPISetActiveWindowRequest>(client_id, message.wm.client_id, message.wm.window_id));
         break;
@@ -315,35 +343,6 @@ bool WSEventLoop::on_receive_from_client(int client_id, const WSAPI_ClientMessag
     return true;
 }
 
-void WSEventLoop::add_file_descriptors_for_select(fd_set& fds, int& max_fd_added)
-{
-    auto add_fd_to_set = [&max_fd_added] (int fd, auto& set) {
-        FD_SET(fd, &set);
-        if (fd > max_fd_added)
-            max_fd_added = fd;
-    };
-    add_fd_to_set(m_keyboard_fd, fds);
-    add_fd_to_set(m_mouse_fd, fds);
-    add_fd_to_set(m_server_fd, fds);
-    WSClientConnection::for_each_client([&] (WSClientConnection& client) {
-        add_fd_to_set(client.fd(), fds);
-    });
-}
-
-void WSEventLoop::process_file_descriptors_after_select(const fd_set& fds)
-{
-    if (FD_ISSET(m_server_fd, &fds))
-        drain_server();
-    if (FD_ISSET(m_keyboard_fd, &fds))
-        drain_keyboard();
-    if (FD_ISSET(m_mouse_fd, &fds))
-        drain_mouse();
-    WSClientConnection::for_each_client([&] (WSClientConnection& client) {
-        if (FD_ISSET(client.fd(), &fds))
-            drain_client(client);
-    });
-}
-
 void WSEventLoop::drain_client(WSClientConnection& client)
 {
     unsigned messages_received = 0;
@@ -0,0 +1,70 @@
+#include <WindowServer/WSImageCache.h>
+#include <SharedGraphics/PNGLoader.h>
+#include <AK/FileSystemPath.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//#define IMAGE_CACHE_DEBUG
+
+WSImageCache& WSImageCache::the()
+{
+    static WSImageCache* s_the;
+    if (!s_the)
+        s_the = new WSImageCache;
+    return *s_the;
+}
+
+WSImageCache::WSImageCache()
+{
+}
+
+WSImageCache::~WSImageCache()
+{
+}
+
+bool WSImageCache::is_cacheable_path(const String& path)
+{
+    // We can read files the client may not be allowed to, so only hand out shared resources.
+    return path.length() > 5 && !strncmp(path.characters(), "/res/", 5) && path.ends_with(".png");
+}
+
+WSImageCache::Image* WSImageCache::image(const String& requested_path, pid_t client_pid)
+{
+    FileSystemPath canonical_path(requested_path);
+    if (!canonical_path.is_valid())
+        return nullptr;
+    String path = canonical_path.string();
+    if (!is_cacheable_path(path))
+        return nullptr;
+
+    struct stat st;
+    if (stat(path.characters(), &st) < 0)
+        return nullptr;
+
+    auto it = m_images.find(path);
+    if (it != m_images.end() && (*it).value.mtime == st.st_mtime)
+        return &(*it).value;
+
+    auto bitmap = load_png(path);
+    if (!bitmap)
+        return nullptr;
+    auto buffer = SharedBuffer::create(client_pid, bitmap->size_in_bytes());
+    if (!buffer)
+        return nullptr;
+    memcpy(buffer->data(), bitmap->scanline(0), bitmap->size_in_bytes());
+    buffer->seal();
+
+#ifdef IMAGE_CACHE_DEBUG
+    dbgprintf("WSImageCache: Decoded %s (%dx%d) into buffer %d\n", path.characters(), bitmap->width(), bitmap->height(), buffer->shared_buffer_id());
+#endif
+
+    Image image;
+    image.buffer = move(buffer);
+    image.peer_pid = client_pid;
+    image.mtime = st.st_mtime;
+    image.size = bitmap->size();
+    image.has_alpha_channel = bitmap->has_alpha_channel();
+    m_images.set(path, move(image));
+    return &(*m_images.find(path)).value;
+}
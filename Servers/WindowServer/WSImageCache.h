@@ -0,0 +1,34 @@
+#pragma once
+
+#include <AK/AKString.h>
+#include <AK/HashMap.h>
+#include <SharedGraphics/GraphicsBitmap.h>
+#include <SharedBuffer.h>
+#include <sys/types.h>
+
+// Decodes the images under /res once, into sealed SharedBuffers that every client
+// maps read-only. Entries are keyed by path and replaced when the file's mtime changes.
+class WSImageCache {
+public:
+    static WSImageCache& the();
+    ~WSImageCache();
+
+    struct Image {
+        RetainPtr<SharedBuffer> buffer;
+        pid_t peer_pid { -1 };
+        time_t mtime { 0 };
+        Size size;
+        bool has_alpha_channel { false };
+    };
+
+    // The buffer is shared with the client that caused it to be decoded.
+    // Everyone else needs a handle from buffer->share_with().
+    Image* image(const String& path, pid_t client_pid);
+
+    static bool is_cacheable_path(const String&);
+
+private:
+    WSImageCache();
+
+    HashMap<String, Image> m_images;
+};
@@ -4,6 +4,7 @@
 #include "WSEventLoop.h"
 #include <WindowServer/WSAPITypes.h>
 #include <WindowServer/WSClientConnection.h>
+#include <WindowServer/WSWindowSwitcher.h>
 
 static String default_window_icon_path()
 {
@@ -60,6 +61,22 @@ void WSWindow::set_title(const String& title)
     WSWindowManager::the().notify_title_changed(*this);
 }
 
+void WSWindow::set_opacity(float opacity)
+{
+    if (m_opacity == opacity)
+        return;
+    m_opacity = opacity;
+    WSWindowManager::the().invalidate_occlusions();
+}
+
+void WSWindow::set_has_alpha_channel(bool value)
+{
+    if (m_has_alpha_channel == value)
+        return;
+    m_has_alpha_channel = value;
+    WSWindowManager::the().invalidate_occlusions();
+}
+
 void WSWindow::set_rect(const Rect& rect)
 {
     Rect old_rect;
@@ -263,6 +280,7 @@ void WSWindow::set_visible(bool b)
     if (m_visible == b)
         return;
     m_visible = b;
+    WSWindowManager::the().invalidate_occlusions();
     invalidate();
 }
 
@@ -296,3 +314,56 @@ void WSWindow::request_update(const Rect& rect)
     }
     m_pending_paint_rects.add(rect);
 }
+
+bool WSWindow::set_damage_ring(Retained<SharedBuffer>&& buffer)
+{
+    if (buffer->size() < (int)sizeof(WSAPI_DamageRing))
+        return false;
+    m_damage_ring_buffer = move(buffer);
+    drain_damage_ring();
+    return true;
+}
+
+void WSWindow::drain_damage_ring()
+{
+    if (!m_damage_ring_buffer)
+        return;
+    auto& ring = *(WSAPI_DamageRing*)m_damage_ring_buffer->data();
+    bool did_finish_painting = false;
+    for (;;) {
+        ring.server_armed = 0;
+        unsigned head = ring.head;
+        __sync_synchronize();
+        unsigned tail = ring.tail;
+        if (head - tail > WSAPI_DamageRing::capacity) {
+            // The client scribbled over the ring indices. Drop what's there and repaint everything.
+            dbgprintf("WSWindow{%p}: Damage ring is corrupt (head=%u, tail=%u)\n", this, head, tail);
+            tail = head;
+            request_update({ { }, size() });
+        }
+        for (; tail != head; ++tail) {
+            auto entry = ring.entries[tail % WSAPI_DamageRing::capacity];
+            Rect rect = entry.rect;
+            switch (entry.type) {
+            case WSAPI_DamageRing::Invalidate:
+                request_update(rect.intersected({ { }, size() }));
+                break;
+            case WSAPI_DamageRing::DidFinishPainting:
+                WSWindowManager::the().invalidate(*this, rect);
+                did_finish_painting = true;
+                break;
+            }
+        }
+        __sync_synchronize();
+        ring.tail = tail;
+
+        // Arm the ring before going idle, then look once more so that a post
+        // racing with the arming isn't left behind without a wakeup.
+        ring.server_armed = 1;
+        __sync_synchronize();
+        if (ring.head == tail)
+            break;
+    }
+    if (did_finish_painting)
+        WSWindowSwitcher::the().refresh_if_needed();
+}
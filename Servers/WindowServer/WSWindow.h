@@ -54,7 +54,7 @@ public:
     void set_title(const String&);
 
     float opacity() const { return m_opacity; }
-    void set_opacity(float opacity) { m_opacity = opacity; }
+    void set_opacity(float);
 
     int x() const { return m_rect.x(); }
     int y() const { return m_rect.y(); }
@@ -115,7 +115,15 @@ public:
     bool global_cursor_tracking() const { return m_global_cursor_tracking_enabled || m_automatic_cursor_tracking_enabled; }
 
     bool has_alpha_channel() const { return m_has_alpha_channel; }
-    void set_has_alpha_channel(bool value) { m_has_alpha_channel = value; }
+    void set_has_alpha_channel(bool);
+
+    // An opaque window hides everything below its frame rect.
+    bool is_opaque() const { return m_opacity >= 1.0f && !m_has_alpha_channel; }
+
+    // The part of the frame rect that isn't hidden by opaque windows above this one.
+    // Kept up to date by WSWindowManager::recompute_occlusions().
+    const DisjointRectSet& visible_region() const { return m_visible_region; }
+    void set_visible_region(DisjointRectSet&& region) { m_visible_region = move(region); }
 
     Size size_increment() const { return m_size_increment; }
     void set_size_increment(const Size& increment) { m_size_increment = increment; }
@@ -138,6 +146,10 @@ public:
     void request_update(const Rect&);
     DisjointRectSet take_pending_paint_rects() { return move(m_pending_paint_rects); }
 
+    // See WSAPI_DamageRing. Returns false if the buffer is too small to hold a ring.
+    bool set_damage_ring(Retained<SharedBuffer>&&);
+    void drain_damage_ring();
+
     // For InlineLinkedList.
     // FIXME: Maybe make a ListHashSet and then WSWindowManager can just use that.
     WSWindow* m_next { nullptr };
@@ -175,5 +187,7 @@ private:
     Color m_background_color { Color::LightGray };
     unsigned m_wm_event_mask { 0 };
     DisjointRectSet m_pending_paint_rects;
+    DisjointRectSet m_visible_region;
     Rect m_unmaximized_rect;
+    RetainPtr<SharedBuffer> m_damage_ring_buffer;
 };
@@ -172,6 +172,7 @@ void WSWindowManager::tick_clock()
 
 void WSWindowManager::set_resolution(int width, int height)
 {
+    invalidate_occlusions();
     WSCompositor::the().set_resolution(width, height);
     WSClientConnection::for_each_client([&] (WSClientConnection& client) {
         client.notify_about_new_screen_rect(WSScreen::the().rect());
@@ -219,6 +220,7 @@ void WSWindowManager::set_current_menubar(WSMenuBar* menubar)
 void WSWindowManager::add_window(WSWindow& window)
 {
     m_windows_in_order.append(&window);
+    invalidate_occlusions();
 
     if (window.is_fullscreen()) {
         WSEventLoop::the().post_event(window, make<WSResizeEvent>(window.rect(), WSScreen::the().rect()));
@@ -251,6 +253,7 @@ void WSWindowManager::move_to_front_and_make_active(WSWindow& window)
         invalidate(window);
     m_windows_in_order.remove(&window);
     m_windows_in_order.append(&window);
+    invalidate_occlusions();
 
     set_active_window(&window);
 }
@@ -259,6 +262,7 @@ void WSWindowManager::remove_window(WSWindow& window)
 {
     invalidate(window);
     m_windows_in_order.remove(&window);
+    invalidate_occlusions();
     if (window.is_active())
         pick_new_active_window();
     if (m_switcher.is_visible() && window.type() != WSWindowType::WindowSwitcher)
@@ -337,6 +341,7 @@ void WSWindowManager::notify_rect_changed(WSWindow& window, const Rect& old_rect
 {
     UNUSED_PARAM(old_rect);
     UNUSED_PARAM(new_rect);
+    invalidate_occlusions();
 #ifdef RESIZE_DEBUG
     dbgprintf("[WM] WSWindow %p rect changed (%d,%d %dx%d) -> (%d,%d %dx%d)\n", &window, old_rect.x(), old_rect.y(), old_rect.width(), old_rect.height(), new_rect.x(), new_rect.y(), new_rect.width(), new_rect.height());
 #endif
@@ -347,6 +352,7 @@ void WSWindowManager::notify_rect_changed(WSWindow& window, const Rect& old_rect
 
 void WSWindowManager::notify_minimization_state_changed(WSWindow& window)
 {
+    invalidate_occlusions();
     tell_wm_listeners_window_state_changed(window);
 
     if (window.is_active() && window.is_minimized())
@@ -765,57 +771,29 @@ void WSWindowManager::clear_resize_candidate()
     m_resize_candidate = nullptr;
 }
 
-bool WSWindowManager::any_opaque_window_contains_rect(const Rect& rect)
+void WSWindowManager::recompute_occlusions()
 {
-    bool found_containing_window = false;
-    for_each_window([&] (WSWindow& window) {
-        if (!window.is_visible())
-            return IterationDecision::Continue;
-        if (window.is_minimized())
-            return IterationDecision::Continue;
-        if (window.opacity() < 1.0f)
-            return IterationDecision::Continue;
-        if (window.has_alpha_channel()) {
-            // FIXME: Just because the window has an alpha channel doesn't mean it's not opaque.
-            //        Maybe there's some way we could know this?
-            return IterationDecision::Continue;
-        }
-        if (window.frame().rect().contains(rect)) {
-            found_containing_window = true;
-            return IterationDecision::Abort;
-        }
-        return IterationDecision::Continue;
-    });
-    return found_containing_window;
-};
+    if (!m_occlusions_dirty)
+        return;
+    m_occlusions_dirty = false;
 
-bool WSWindowManager::any_opaque_window_above_this_one_contains_rect(const WSWindow& a_window, const Rect& rect)
-{
-    bool found_containing_window = false;
-    bool checking = false;
-    for_each_visible_window_from_back_to_front([&] (WSWindow& window) {
-        if (&window == &a_window) {
-            checking = true;
-            return IterationDecision::Continue;
-        }
-        if (!checking)
-            return IterationDecision::Continue;
-        if (!window.is_visible())
-            return IterationDecision::Continue;
-        if (window.is_minimized())
-            return IterationDecision::Continue;
-        if (window.opacity() < 1.0f)
-            return IterationDecision::Continue;
-        if (window.has_alpha_channel())
-            return IterationDecision::Continue;
-        if (window.frame().rect().contains(rect)) {
-            found_containing_window = true;
-            return IterationDecision::Abort;
-        }
+    auto screen_rect = WSScreen::the().rect();
+    DisjointRectSet opaque_region_above;
+    for_each_visible_window_from_front_to_back([&] (WSWindow& window) {
+        auto frame_rect = window.frame().rect();
+        DisjointRectSet visible_region;
+        visible_region.add(Rect::intersection(frame_rect, screen_rect));
+        visible_region.subtract(opaque_region_above);
+        window.set_visible_region(move(visible_region));
+        if (window.is_opaque())
+            opaque_region_above.add(frame_rect);
         return IterationDecision::Continue;
     });
-    return found_containing_window;
-};
+
+    m_uncovered_desktop_region.clear();
+    m_uncovered_desktop_region.add(screen_rect);
+    m_uncovered_desktop_region.subtract(opaque_region_above);
+}
 
 Rect WSWindowManager::menubar_rect() const
 {
@@ -864,6 +842,7 @@ void WSWindowManager::set_highlight_window(WSWindow* window)
     if (auto* previous_highlight_window = m_highlight_window.ptr())
         invalidate(*previous_highlight_window);
     m_highlight_window = window ? window->make_weak_ptr() : nullptr;
+    invalidate_occlusions();
     if (m_highlight_window)
         invalidate(*m_highlight_window);
 }
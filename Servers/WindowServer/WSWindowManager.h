@@ -103,8 +103,13 @@ public:
     void set_resize_candidate(WSWindow&, ResizeDirection);
     void clear_resize_candidate();
 
-    bool any_opaque_window_contains_rect(const Rect&);
-    bool any_opaque_window_above_this_one_contains_rect(const WSWindow&, const Rect&);
+    // Call whenever windows move, resize, restack, appear or disappear, or change opacity.
+    // The visible regions are then recomputed once, right before the next compose.
+    void invalidate_occlusions() { m_occlusions_dirty = true; }
+    void recompute_occlusions();
+
+    // The parts of the screen not covered by any opaque window.
+    const DisjointRectSet& uncovered_desktop_region() const { return m_uncovered_desktop_region; }
 
     void tell_wm_listeners_window_state_changed(WSWindow&);
     void tell_wm_listeners_window_icon_changed(WSWindow&);
@@ -223,6 +228,9 @@ private:
     WeakPtr<WSButton> m_hovered_button;
 
     WSCPUMonitor m_cpu_monitor;
+
+    bool m_occlusions_dirty { true };
+    DisjointRectSet m_uncovered_desktop_region;
 };
 
 template<typename Callback>
@@ -290,14 +298,16 @@ IterationDecision WSWindowManager::for_each_visible_window_of_type_from_front_to
 template<typename Callback>
 IterationDecision WSWindowManager::for_each_visible_window_from_front_to_back(Callback callback)
 {
+    // This must be the exact reverse of for_each_visible_window_from_back_to_front(),
+    // since occlusion and hit testing both rely on it matching the paint order.
     if (for_each_visible_window_of_type_from_front_to_back(WSWindowType::WindowSwitcher, callback) == IterationDecision::Abort)
         return IterationDecision::Abort;
     if (for_each_visible_window_of_type_from_front_to_back(WSWindowType::Menu, callback) == IterationDecision::Abort)
         return IterationDecision::Abort;
-    if (for_each_visible_window_of_type_from_front_to_back(WSWindowType::Taskbar, callback) == IterationDecision::Abort)
-        return IterationDecision::Abort;
     if (for_each_visible_window_of_type_from_front_to_back(WSWindowType::Tooltip, callback) == IterationDecision::Abort)
         return IterationDecision::Abort;
+    if (for_each_visible_window_of_type_from_front_to_back(WSWindowType::Taskbar, callback) == IterationDecision::Abort)
+        return IterationDecision::Abort;
     return for_each_visible_window_of_type_from_front_to_back(WSWindowType::Normal, callback);
 }
 
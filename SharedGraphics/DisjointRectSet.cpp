@@ -1,45 +1,263 @@
 #include <SharedGraphics/DisjointRectSet.h>
 
-void DisjointRectSet::add(const Rect& new_rect)
+namespace {
+
+// A horizontal run [left, right) within a band.
+struct Span {
+    int left;
+    int right;
+};
+
+typedef Vector<Span, 32> SpanList;
+
+}
+
+// Appends the spans of the band that covers scanline y, starting the search at `index`
+// (which is advanced past bands that end above y.)
+static void spans_at(const Vector<Rect, 32>& rects, int& index, int y, SpanList& spans)
+{
+    spans.clear_with_capacity();
+    while (index < rects.size() && rects[index].bottom() < y)
+        ++index;
+    if (index >= rects.size() || rects[index].top() > y)
+        return;
+    int band_top = rects[index].top();
+    for (int i = index; i < rects.size() && rects[i].top() == band_top; ++i)
+        spans.append({ rects[i].left(), rects[i].right() + 1 });
+}
+
+static void append_span(SpanList& spans, int left, int right)
+{
+    if (left >= right)
+        return;
+    if (!spans.is_empty() && spans.last().right >= left) {
+        if (right > spans.last().right)
+            spans.last().right = right;
+        return;
+    }
+    spans.append({ left, right });
+}
+
+static void unite_spans(const SpanList& a, const SpanList& b, SpanList& out)
+{
+    int i = 0;
+    int j = 0;
+    while (i < a.size() || j < b.size()) {
+        if (j >= b.size() || (i < a.size() && a[i].left <= b[j].left)) {
+            append_span(out, a[i].left, a[i].right);
+            ++i;
+        } else {
+            append_span(out, b[j].left, b[j].right);
+            ++j;
+        }
+    }
+}
+
+static void intersect_spans(const SpanList& a, const SpanList& b, SpanList& out)
 {
-    for (auto& rect : m_rects) {
-        if (rect.contains(new_rect))
-            return;
+    int i = 0;
+    int j = 0;
+    while (i < a.size() && j < b.size()) {
+        append_span(out, max(a[i].left, b[j].left), min(a[i].right, b[j].right));
+        if (a[i].right < b[j].right)
+            ++i;
+        else
+            ++j;
     }
+}
 
-    m_rects.append(new_rect);
-    if (m_rects.size() > 1)
-        shatter();
+static void subtract_spans(const SpanList& a, const SpanList& b, SpanList& out)
+{
+    int j = 0;
+    for (int i = 0; i < a.size(); ++i) {
+        int left = a[i].left;
+        int right = a[i].right;
+        while (j < b.size() && b[j].right <= left)
+            ++j;
+        for (int k = j; k < b.size() && b[k].left < right; ++k) {
+            append_span(out, left, b[k].left);
+            left = max(left, b[k].right);
+        }
+        append_span(out, left, right);
+    }
 }
 
-void DisjointRectSet::shatter()
+// Appends every band edge (top, and bottom + 1) of a banded rect list, in order.
+static void append_band_edges(const Vector<Rect, 32>& rects, Vector<int, 64>& edges)
 {
+    for (int i = 0; i < rects.size(); ++i) {
+        if (i && rects[i].top() == rects[i - 1].top())
+            continue;
+        edges.append(rects[i].top());
+        edges.append(rects[i].bottom() + 1);
+    }
+}
+
+void DisjointRectSet::apply(Operation operation, const Vector<Rect, 32>& other)
+{
+    // Every band edge of either operand, sorted and deduplicated. Each pair of consecutive
+    // edges is a slab in which both operands have a fixed set of spans.
+    Vector<int, 64> edges_a;
+    Vector<int, 64> edges_b;
+    append_band_edges(m_rects, edges_a);
+    append_band_edges(other, edges_b);
+    Vector<int, 64> edges;
+    edges.ensure_capacity(edges_a.size() + edges_b.size());
+    for (int i = 0, j = 0; i < edges_a.size() || j < edges_b.size();) {
+        int edge;
+        if (j >= edges_b.size() || (i < edges_a.size() && edges_a[i] <= edges_b[j]))
+            edge = edges_a[i++];
+        else
+            edge = edges_b[j++];
+        if (edges.is_empty() || edges.last() != edge)
+            edges.append(edge);
+    }
+
     Vector<Rect, 32> output;
-    output.ensure_capacity(m_rects.size());
-    bool pass_had_intersections = false;
-    do {
-        pass_had_intersections = false;
-        output.clear_with_capacity();
-        for (int i = 0; i < m_rects.size(); ++i) {
-            auto& r1 = m_rects[i];
-            for (int j = 0; j < m_rects.size(); ++j) {
-                if (i == j)
-                    continue;
-                auto& r2 = m_rects[j];
-                if (!r1.intersects(r2))
-                    continue;
-                pass_had_intersections = true;
-                auto pieces = r1.shatter(r2);
-                for (auto& piece : pieces)
-                    output.append(piece);
-                m_rects.remove(i);
-                for (; i < m_rects.size(); ++i)
-                    output.append(m_rects[i]);
-                goto next_pass;
+    SpanList spans_a;
+    SpanList spans_b;
+    SpanList spans;
+    int index_a = 0;
+    int index_b = 0;
+    int previous_band_start = -1;
+    int previous_band_bottom = 0;
+
+    for (int e = 0; e + 1 < edges.size(); ++e) {
+        int top = edges[e];
+        int bottom = edges[e + 1];
+        spans_at(m_rects, index_a, top, spans_a);
+        spans_at(other, index_b, top, spans_b);
+
+        spans.clear_with_capacity();
+        switch (operation) {
+        case Operation::Union:
+            unite_spans(spans_a, spans_b, spans);
+            break;
+        case Operation::Intersect:
+            intersect_spans(spans_a, spans_b, spans);
+            break;
+        case Operation::Subtract:
+            subtract_spans(spans_a, spans_b, spans);
+            break;
+        }
+        if (spans.is_empty())
+            continue;
+
+        // If this band continues the previous one with the very same spans, just grow it.
+        if (previous_band_start != -1 && previous_band_bottom == top && output.size() - previous_band_start == spans.size()) {
+            bool same_spans = true;
+            for (int i = 0; i < spans.size(); ++i) {
+                auto& rect = output[previous_band_start + i];
+                if (rect.left() != spans[i].left || rect.right() + 1 != spans[i].right) {
+                    same_spans = false;
+                    break;
+                }
+            }
+            if (same_spans) {
+                for (int i = previous_band_start; i < output.size(); ++i)
+                    output[i].set_height(bottom - output[i].top());
+                previous_band_bottom = bottom;
+                continue;
             }
-            output.append(r1);
         }
-next_pass:
-        swap(output, m_rects);
-    } while(pass_had_intersections);
+
+        previous_band_start = output.size();
+        previous_band_bottom = bottom;
+        for (auto& span : spans)
+            output.append({ span.left, top, span.right - span.left, bottom - top });
+    }
+
+    m_rects = move(output);
+}
+
+void DisjointRectSet::add(const Rect& rect)
+{
+    if (rect.is_empty())
+        return;
+    if (m_rects.is_empty()) {
+        m_rects.append(rect);
+        return;
+    }
+    if (contains(rect))
+        return;
+    Vector<Rect, 32> other;
+    other.append(rect);
+    apply(Operation::Union, other);
+
+    if (m_max_rect_count && m_rects.size() > m_max_rect_count) {
+        auto bounds = bounding_rect();
+        m_rects.clear_with_capacity();
+        m_rects.append(bounds);
+    }
+}
+
+void DisjointRectSet::add(const DisjointRectSet& other)
+{
+    for (auto& rect : other.m_rects)
+        add(rect);
+}
+
+void DisjointRectSet::subtract(const Rect& rect)
+{
+    if (!intersects(rect))
+        return;
+    Vector<Rect, 32> other;
+    other.append(rect);
+    apply(Operation::Subtract, other);
+}
+
+void DisjointRectSet::subtract(const DisjointRectSet& other)
+{
+    if (m_rects.is_empty() || other.is_empty())
+        return;
+    apply(Operation::Subtract, other.m_rects);
+}
+
+void DisjointRectSet::intersect(const Rect& rect)
+{
+    if (rect.is_empty()) {
+        m_rects.clear_with_capacity();
+        return;
+    }
+    Vector<Rect, 32> other;
+    other.append(rect);
+    apply(Operation::Intersect, other);
+}
+
+void DisjointRectSet::intersect(const DisjointRectSet& other)
+{
+    apply(Operation::Intersect, other.m_rects);
+}
+
+bool DisjointRectSet::intersects(const Rect& rect) const
+{
+    for (auto& r : m_rects) {
+        if (r.top() > rect.bottom())
+            break;
+        if (r.intersects(rect))
+            return true;
+    }
+    return false;
+}
+
+bool DisjointRectSet::contains(const Rect& rect) const
+{
+    // Since adjacent rects are merged, this only misses containment across band edges.
+    for (auto& r : m_rects) {
+        if (r.top() > rect.top())
+            break;
+        if (r.contains(rect))
+            return true;
+    }
+    return false;
+}
+
+Rect DisjointRectSet::bounding_rect() const
+{
+    if (m_rects.is_empty())
+        return { };
+    Rect bounds = m_rects.first();
+    for (auto& rect : m_rects)
+        bounds = bounds.united(rect);
+    return bounds;
 }
@@ -3,24 +3,62 @@
 #include <AK/Vector.h>
 #include <SharedGraphics/Rect.h>
 
+// A region of the plane stored as y-x banded rects, the same representation X11 and pixman use:
+// The rects are sorted by top edge, then left edge. Rects that share a band have the same
+// top and bottom edges and never touch, and vertically adjacent bands with identical spans
+// are merged. This keeps union, intersection and subtraction linear in the number of rects.
 class DisjointRectSet {
 public:
     DisjointRectSet() { }
     ~DisjointRectSet() { }
-    DisjointRectSet(DisjointRectSet&& other) : m_rects(move(other.m_rects)) { }
+    DisjointRectSet(DisjointRectSet&& other)
+        : m_rects(move(other.m_rects))
+        , m_max_rect_count(other.m_max_rect_count)
+    {
+    }
+    DisjointRectSet& operator=(DisjointRectSet&& other)
+    {
+        if (this != &other) {
+            m_rects = move(other.m_rects);
+            m_max_rect_count = other.m_max_rect_count;
+        }
+        return *this;
+    }
 
+    // Union.
     void add(const Rect&);
+    void add(const DisjointRectSet&);
+
+    void subtract(const Rect&);
+    void subtract(const DisjointRectSet&);
+
+    void intersect(const Rect&);
+    void intersect(const DisjointRectSet&);
+
+    bool intersects(const Rect&) const;
+    bool contains(const Rect&) const;
+
+    // For damage tracking: once add() leaves more than this many rects, the whole
+    // set collapses into its bounding rect. Repainting a few extra pixels is cheaper
+    // than chasing hundreds of tiny fragments. Zero (the default) means never.
+    void set_max_rect_count(int count) { m_max_rect_count = count; }
 
     bool is_empty() const { return m_rects.is_empty(); }
     int size() const { return m_rects.size(); }
+    Rect bounding_rect() const;
 
     void clear() { m_rects.clear(); }
     void clear_with_capacity() { m_rects.clear_with_capacity(); }
     const Vector<Rect, 32>& rects() const { return m_rects; }
 
 private:
-    void shatter();
+    enum class Operation {
+        Union,
+        Intersect,
+        Subtract,
+    };
+    void apply(Operation, const Vector<Rect, 32>&);
 
     Vector<Rect, 32> m_rects;
+    int m_max_rect_count { 0 };
 };
-
@@ -92,6 +92,31 @@ Font::~Font()
 {
 }
 
+void Font::build_glyph_spans() const
+{
+    m_glyph_spans.clear_with_capacity();
+    for (int ch = 0; ch < 256; ++ch) {
+        m_glyph_span_offsets[ch] = m_glyph_spans.size();
+        auto bitmap = glyph_bitmap((char)ch);
+        for (int y = 0; y < bitmap.height(); ++y) {
+            unsigned row = bitmap.row(y);
+            int x = 0;
+            while (x < bitmap.width()) {
+                if (!(row & (1u << x))) {
+                    ++x;
+                    continue;
+                }
+                int start = x;
+                while (x < bitmap.width() && (row & (1u << x)))
+                    ++x;
+                m_glyph_spans.append({ (byte)y, (byte)start, (byte)(x - start) });
+            }
+        }
+    }
+    m_glyph_span_offsets[256] = m_glyph_spans.size();
+    m_glyph_spans_valid = true;
+}
+
 RetainPtr<Font> Font::load_from_memory(const byte* data)
 {
     auto& header = *reinterpret_cast<const FontFileHeader*>(data);
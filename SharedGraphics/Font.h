@@ -6,6 +6,7 @@
 #include <AK/AKString.h>
 #include <AK/MappedFile.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 
 // FIXME: Make a MutableGlyphBitmap buddy class for FontEditor instead?
 class GlyphBitmap {
@@ -39,6 +40,13 @@ private:
     Size m_size;
 };
 
+// A horizontal run of set bits in one row of a glyph.
+struct GlyphSpan {
+    byte row;
+    byte x;
+    byte length;
+};
+
 class Font : public Retainable<Font> {
 public:
     static Font& default_font();
@@ -73,13 +81,30 @@ public:
     {
         ASSERT(m_glyph_widths);
         m_glyph_widths[(byte)ch] = width;
+        invalidate_glyph_spans();
+    }
+
+    // The glyph's set bits as runs sorted by row, built for the whole font on first use.
+    // Painter fills these instead of testing the glyph bitmap pixel by pixel.
+    const GlyphSpan* glyph_spans(char ch, int& span_count) const
+    {
+        if (!m_glyph_spans_valid)
+            build_glyph_spans();
+        int first = m_glyph_span_offsets[(byte)ch];
+        span_count = m_glyph_span_offsets[(byte)ch + 1] - first;
+        return m_glyph_spans.data() + first;
     }
 
+    // Must be called after editing glyph bitmaps in place (see FontEditor.)
+    void invalidate_glyph_spans() const { m_glyph_spans_valid = false; }
+
 private:
     Font(const String& name, unsigned* rows, byte* widths, bool is_fixed_width, byte glyph_width, byte glyph_height);
 
     static RetainPtr<Font> load_from_memory(const byte*);
 
+    void build_glyph_spans() const;
+
     String m_name;
 
     unsigned* m_rows { nullptr };
@@ -92,4 +117,8 @@ private:
     byte m_max_glyph_width { 0 };
 
     bool m_fixed_width { false };
+
+    mutable Vector<GlyphSpan> m_glyph_spans;
+    mutable int m_glyph_span_offsets[257];
+    mutable bool m_glyph_spans_valid { false };
 };
@@ -29,8 +29,19 @@ Retained<GraphicsBitmap> GraphicsBitmap::create_wrapper(Format format, const Siz
     return adopt(*new GraphicsBitmap(format, size, data));
 }
 
+static GraphicsBitmap::LoadFromFileHook s_load_from_file_hook;
+
+void GraphicsBitmap::set_load_from_file_hook(LoadFromFileHook hook)
+{
+    s_load_from_file_hook = hook;
+}
+
 RetainPtr<GraphicsBitmap> GraphicsBitmap::load_from_file(const String& path)
 {
+    if (s_load_from_file_hook) {
+        if (auto bitmap = s_load_from_file_hook(path))
+            return bitmap;
+    }
     return load_png(path);
 }
 
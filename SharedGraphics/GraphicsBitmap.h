@@ -20,6 +20,11 @@ public:
     static Retained<GraphicsBitmap> create_with_shared_buffer(Format, Retained<SharedBuffer>&&, const Size&);
     ~GraphicsBitmap();
 
+    // Lets a process get images some other way than decoding them itself, e.g. from the WindowServer's image cache.
+    // When the hook returns null, load_from_file() falls back to decoding the file.
+    typedef RetainPtr<GraphicsBitmap> (*LoadFromFileHook)(const String& path);
+    static void set_load_from_file_hook(LoadFromFileHook);
+
     RGBA32* scanline(int y);
     const RGBA32* scanline(int y) const;
 
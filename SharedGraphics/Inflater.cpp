@@ -0,0 +1,456 @@
+#include <SharedGraphics/Inflater.h>
+#include <AK/kmalloc.h>
+#include <AK/StdLibExtras.h>
+
+#pragma GCC optimize("O3")
+
+//#define INFLATER_DEBUG
+
+static const word s_length_base[31] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258, 0, 0 };
+static const byte s_length_extra[31] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0, 0, 0 };
+static const word s_distance_base[32] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577, 0, 0 };
+static const byte s_distance_extra[32] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 0, 0 };
+
+// The order in which code length code lengths are stored in a dynamic block header.
+static const byte s_code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+static inline int reverse_bits(int value, int bit_count)
+{
+    value = ((value & 0xaaaa) >> 1) | ((value & 0x5555) << 1);
+    value = ((value & 0xcccc) >> 2) | ((value & 0x3333) << 2);
+    value = ((value & 0xf0f0) >> 4) | ((value & 0x0f0f) << 4);
+    value = ((value & 0xff00) >> 8) | ((value & 0x00ff) << 8);
+    return value >> (16 - bit_count);
+}
+
+bool Inflater::Huffman::build(const byte* code_lengths, int count)
+{
+    int sizes[17];
+    int next_code[16];
+    memset(sizes, 0, sizeof(sizes));
+    memset(fast, 0, sizeof(fast));
+    for (int i = 0; i < count; ++i)
+        ++sizes[code_lengths[i]];
+    sizes[0] = 0;
+    for (int i = 1; i < 16; ++i) {
+        if (sizes[i] > (1 << i))
+            return false;
+    }
+
+    int code = 0;
+    int symbol_index = 0;
+    for (int i = 1; i < 16; ++i) {
+        next_code[i] = code;
+        first_code[i] = code;
+        first_symbol[i] = symbol_index;
+        code += sizes[i];
+        if (sizes[i] && code - 1 >= (1 << i))
+            return false;
+        // Pre-shifted so the slow path can compare against a 16-bit window of the bit buffer.
+        max_code[i] = code << (16 - i);
+        code <<= 1;
+        symbol_index += sizes[i];
+    }
+    max_code[16] = 0x10000;
+
+    for (int i = 0; i < count; ++i) {
+        int length = code_lengths[i];
+        if (!length)
+            continue;
+        int canonical_index = next_code[length] - first_code[length] + first_symbol[length];
+        size[canonical_index] = length;
+        value[canonical_index] = i;
+        if (length <= fast_bits) {
+            // DEFLATE stores codes starting from the most significant bit, so the table is indexed bit-reversed.
+            word entry = (length << 9) | i;
+            for (int j = reverse_bits(next_code[length], length); j < (1 << fast_bits); j += (1 << length))
+                fast[j] = entry;
+        }
+        ++next_code[length];
+    }
+    return true;
+}
+
+Inflater::Inflater(Format format)
+    : m_format(format)
+{
+    if (m_format == Format::Raw)
+        m_state = State::BlockHeader;
+}
+
+void Inflater::append_input(const byte* data, int size)
+{
+    if (size <= 0)
+        return;
+    m_segments.append({ data, size });
+}
+
+byte Inflater::next_segment_byte()
+{
+    while (m_next_segment < m_segments.size()) {
+        auto& segment = m_segments[m_next_segment++];
+        m_input_ptr = segment.data;
+        m_input_end = segment.data + segment.size;
+        if (m_input_ptr < m_input_end)
+            return *m_input_ptr++;
+    }
+    // Keep the bit buffer topped up with zeroes past the end. read() checks afterwards
+    // whether any of them were actually consumed.
+    ++m_overrun_bytes;
+    return 0;
+}
+
+int Inflater::decode_symbol_slowly(const Huffman& huffman)
+{
+    int k = reverse_bits(m_bit_buffer & 0xffff, 16);
+    int length;
+    for (length = Huffman::fast_bits + 1; k >= huffman.max_code[length]; ++length)
+        ;
+    if (length >= 16)
+        return -1;
+    int index = (k >> (16 - length)) - huffman.first_code[length] + huffman.first_symbol[length];
+    if (index >= 288 || huffman.size[index] != length)
+        return -1;
+    m_bit_buffer >>= length;
+    m_bit_count -= length;
+    return huffman.value[index];
+}
+
+[[gnu::always_inline]] inline int Inflater::decode_symbol(const Huffman& huffman)
+{
+    if (m_bit_count < 16)
+        refill();
+    int entry = huffman.fast[m_bit_buffer & ((1 << Huffman::fast_bits) - 1)];
+    if (entry) {
+        int length = entry >> 9;
+        m_bit_buffer >>= length;
+        m_bit_count -= length;
+        return entry & 511;
+    }
+    return decode_symbol_slowly(huffman);
+}
+
+bool Inflater::fail()
+{
+#ifdef INFLATER_DEBUG
+    dbgprintf("Inflater: Malformed stream after %u bytes of output\n", m_window_position);
+#endif
+    m_state = State::Error;
+    return false;
+}
+
+bool Inflater::read_header()
+{
+    dword cmf = take_bits(8);
+    dword flg = take_bits(8);
+    if ((cmf & 15) != 8 || (cmf * 256 + flg) % 31)
+        return fail();
+    // A preset dictionary is never used in PNG, and we don't support it.
+    if (flg & 0x20)
+        return fail();
+    m_state = State::BlockHeader;
+    return true;
+}
+
+bool Inflater::read_dynamic_tables()
+{
+    int literal_count = take_bits(5) + 257;
+    int distance_count = take_bits(5) + 1;
+    int code_length_count = take_bits(4) + 4;
+    // HLIT and HDIST can encode up to 288 and 32 codes, but only 286 and 30 are valid.
+    if (literal_count > 286 || distance_count > 30)
+        return fail();
+
+    byte code_length_lengths[19];
+    memset(code_length_lengths, 0, sizeof(code_length_lengths));
+    for (int i = 0; i < code_length_count; ++i)
+        code_length_lengths[s_code_length_order[i]] = take_bits(3);
+    Huffman code_length_codes;
+    if (!code_length_codes.build(code_length_lengths, 19))
+        return fail();
+
+    byte lengths[286 + 30];
+    int total = literal_count + distance_count;
+    int n = 0;
+    while (n < total) {
+        int symbol = decode_symbol(code_length_codes);
+        if (symbol < 0 || symbol >= 19)
+            return fail();
+        if (symbol < 16) {
+            lengths[n++] = symbol;
+            continue;
+        }
+        byte fill = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (n == 0)
+                return fail();
+            repeat = take_bits(2) + 3;
+            fill = lengths[n - 1];
+        } else if (symbol == 17) {
+            repeat = take_bits(3) + 3;
+        } else {
+            repeat = take_bits(7) + 11;
+        }
+        if (total - n < repeat)
+            return fail();
+        memset(lengths + n, fill, repeat);
+        n += repeat;
+    }
+
+    if (!m_literal_codes.build(lengths, literal_count))
+        return fail();
+    if (!m_distance_codes.build(lengths + literal_count, distance_count))
+        return fail();
+    return true;
+}
+
+bool Inflater::read_block_header()
+{
+    if (m_final_block) {
+        m_state = State::Done;
+        return true;
+    }
+    m_final_block = take_bits(1);
+    int type = take_bits(2);
+    switch (type) {
+    case 0: {
+        // Stored blocks start on a byte boundary.
+        take_bits(m_bit_count & 7);
+        int length = take_bits(16);
+        int inverted_length = take_bits(16);
+        if (length != (~inverted_length & 0xffff))
+            return fail();
+        m_stored_remaining = length;
+        m_state = State::Stored;
+        return true;
+    }
+    case 1: {
+        // Several threads may decode at once (WindowServer loads wallpapers on a thread of
+        // its own), so the fixed tables are fully built before they're published, and
+        // whoever loses the race to publish throws theirs away.
+        struct FixedCodes {
+            Huffman literal_codes;
+            Huffman distance_codes;
+        };
+        static FixedCodes* s_fixed_codes;
+        auto* fixed_codes = __atomic_load_n(&s_fixed_codes, __ATOMIC_ACQUIRE);
+        if (!fixed_codes) {
+            auto* new_codes = new FixedCodes;
+            byte lengths[288];
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            new_codes->literal_codes.build(lengths, 288);
+            memset(lengths, 5, 32);
+            new_codes->distance_codes.build(lengths, 32);
+            FixedCodes* expected = nullptr;
+            if (__atomic_compare_exchange_n(&s_fixed_codes, &expected, new_codes, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                fixed_codes = new_codes;
+            } else {
+                delete new_codes;
+                fixed_codes = expected;
+            }
+        }
+        m_literal_codes = fixed_codes->literal_codes;
+        m_distance_codes = fixed_codes->distance_codes;
+        m_state = State::Compressed;
+        return true;
+    }
+    case 2:
+        if (!read_dynamic_tables())
+            return false;
+        m_state = State::Compressed;
+        return true;
+    default:
+        return fail();
+    }
+}
+
+// The hot loop. Everything lives in locals, since every byte stored through `buffer`
+// could otherwise alias the members and force them to be reloaded. Output goes straight
+// into `buffer`, and back-references are copied from there when they can be; the window
+// only gets updated once, on the way out.
+bool Inflater::inflate_compressed(byte* buffer, int& produced, int size)
+{
+    dword bit_buffer = m_bit_buffer;
+    int bit_count = m_bit_count;
+    const byte* input = m_input_ptr;
+    const byte* input_end = m_input_end;
+    const byte* window = m_window;
+    const dword window_position = m_window_position;
+    const int start = produced;
+    int out = produced;
+    bool ok = true;
+
+    auto refill = [&] {
+        while (bit_count <= 24) {
+            byte value;
+            if (input < input_end) {
+                value = *input++;
+            } else {
+                m_input_ptr = input;
+                value = next_segment_byte();
+                input = m_input_ptr;
+                input_end = m_input_end;
+            }
+            bit_buffer |= (dword)value << bit_count;
+            bit_count += 8;
+        }
+    };
+    auto take_bits = [&](int count) -> dword {
+        if (bit_count < count)
+            refill();
+        dword bits = bit_buffer & ((1u << count) - 1);
+        bit_buffer >>= count;
+        bit_count -= count;
+        return bits;
+    };
+    auto decode = [&](const Huffman& huffman) -> int {
+        if (bit_count < 16)
+            refill();
+        int entry = huffman.fast[bit_buffer & ((1 << Huffman::fast_bits) - 1)];
+        if (entry) {
+            int length = entry >> 9;
+            bit_buffer >>= length;
+            bit_count -= length;
+            return entry & 511;
+        }
+        m_bit_buffer = bit_buffer;
+        m_bit_count = bit_count;
+        int symbol = decode_symbol_slowly(huffman);
+        bit_buffer = m_bit_buffer;
+        bit_count = m_bit_count;
+        return symbol;
+    };
+
+    while (out < size) {
+        int symbol = decode(m_literal_codes);
+        if (symbol < 256) {
+            if (symbol < 0) {
+                ok = false;
+                break;
+            }
+            buffer[out++] = symbol;
+            continue;
+        }
+        if (symbol == 256) {
+            m_state = State::BlockHeader;
+            break;
+        }
+        symbol -= 257;
+        if (symbol >= 29) {
+            ok = false;
+            break;
+        }
+        int length = s_length_base[symbol];
+        if (s_length_extra[symbol])
+            length += take_bits(s_length_extra[symbol]);
+        int distance_symbol = decode(m_distance_codes);
+        if (distance_symbol < 0 || distance_symbol >= 30) {
+            ok = false;
+            break;
+        }
+        int distance = s_distance_base[distance_symbol];
+        if (s_distance_extra[distance_symbol])
+            distance += take_bits(s_distance_extra[distance_symbol]);
+        if ((dword)distance > window_position + (out - start)) {
+            ok = false;
+            break;
+        }
+
+        int count = min(length, size - out);
+        int end = out + count;
+        // The start of the match may still be in the window, from before this call.
+        while (out < end && out - start < distance) {
+            buffer[out] = window[(window_position + (out - start) - distance) & window_mask];
+            ++out;
+        }
+        const byte* from = buffer + out - distance;
+        while (out < end)
+            buffer[out++] = *from++;
+
+        if (count < length) {
+            // The caller's buffer is full; finish this match on the next read().
+            m_copy_remaining = length - count;
+            m_copy_distance = distance;
+            break;
+        }
+    }
+
+    m_bit_buffer = bit_buffer;
+    m_bit_count = bit_count;
+    m_input_ptr = input;
+    m_input_end = input_end;
+    produced = out;
+    append_to_window(buffer + start, out - start);
+    if (!ok)
+        return fail();
+    return true;
+}
+
+void Inflater::append_to_window(const byte* data, int size)
+{
+    if (size > window_size) {
+        m_window_position += size - window_size;
+        data += size - window_size;
+        size = window_size;
+    }
+    int offset = m_window_position & window_mask;
+    int first_part = min(size, window_size - offset);
+    memcpy(m_window + offset, data, first_part);
+    memcpy(m_window, data + first_part, size - first_part);
+    m_window_position += size;
+}
+
+bool Inflater::read(byte* buffer, int size)
+{
+    int produced = 0;
+    while (produced < size) {
+        if (m_copy_remaining) {
+            int count = min(m_copy_remaining, size - produced);
+            m_copy_remaining -= count;
+            for (int i = 0; i < count; ++i) {
+                byte value = m_window[(m_window_position - m_copy_distance) & window_mask];
+                buffer[produced++] = value;
+                emit(value);
+            }
+            continue;
+        }
+
+        switch (m_state) {
+        case State::Header:
+            if (!read_header())
+                return false;
+            break;
+        case State::BlockHeader:
+            if (!read_block_header())
+                return false;
+            break;
+        case State::Stored:
+            while (m_stored_remaining && produced < size) {
+                byte value = take_bits(8);
+                buffer[produced++] = value;
+                emit(value);
+                --m_stored_remaining;
+            }
+            if (!m_stored_remaining)
+                m_state = State::BlockHeader;
+            break;
+        case State::Compressed:
+            if (!inflate_compressed(buffer, produced, size))
+                return false;
+            break;
+        case State::Done:
+        case State::Error:
+            return fail();
+        }
+    }
+
+    // The bit buffer is padded with zeroes past the end of the input, which is fine
+    // as long as none of them were consumed.
+    if (m_overrun_bytes * 8 > m_bit_count)
+        return fail();
+    return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+// A streaming zlib/DEFLATE decompressor.
+//
+// Compressed input is handed over as a list of segments (e.g. the payloads of a PNG's IDAT
+// chunks, straight out of the mapped file), which must stay valid while inflating. Output is
+// pulled out in whatever pieces the caller likes, so nothing ever holds the whole
+// decompressed stream. Only the last 32 KB of output are kept around for back-references.
+//
+// Huffman codes are decoded with a 9-bit lookup table, falling back to a canonical-code
+// search for the rare longer codes. Bits are fed through a 32-bit buffer that's refilled a
+// byte at a time (a 64-bit buffer doesn't pay off on i686.)
+class Inflater {
+public:
+    enum class Format {
+        Raw,
+        Zlib,
+    };
+
+    explicit Inflater(Format = Format::Zlib);
+    ~Inflater() { }
+
+    void append_input(const byte* data, int size);
+
+    // Decompresses exactly `size` bytes into `buffer`.
+    // Returns false if the stream is malformed or ends early.
+    bool read(byte* buffer, int size);
+
+    bool has_error() const { return m_state == State::Error; }
+
+private:
+    struct Huffman {
+        static const int fast_bits = 9;
+        word fast[1 << fast_bits];
+        word first_code[16];
+        int max_code[17];
+        word first_symbol[16];
+        byte size[288];
+        word value[288];
+
+        bool build(const byte* code_lengths, int count);
+    };
+
+    enum class State {
+        Header,
+        BlockHeader,
+        Stored,
+        Compressed,
+        Done,
+        Error,
+    };
+
+    byte next_input_byte()
+    {
+        if (m_input_ptr < m_input_end)
+            return *m_input_ptr++;
+        return next_segment_byte();
+    }
+    byte next_segment_byte();
+
+    void refill()
+    {
+        while (m_bit_count <= 24) {
+            m_bit_buffer |= (dword)next_input_byte() << m_bit_count;
+            m_bit_count += 8;
+        }
+    }
+
+    dword take_bits(int count)
+    {
+        if (m_bit_count < count)
+            refill();
+        dword bits = m_bit_buffer & ((1u << count) - 1);
+        m_bit_buffer >>= count;
+        m_bit_count -= count;
+        return bits;
+    }
+
+    int decode_symbol(const Huffman&);
+    int decode_symbol_slowly(const Huffman&);
+    bool inflate_compressed(byte* buffer, int& produced, int size);
+    void append_to_window(const byte*, int);
+
+    void emit(byte value)
+    {
+        m_window[m_window_position++ & window_mask] = value;
+    }
+
+    bool read_header();
+    bool read_block_header();
+    bool read_dynamic_tables();
+    bool fail();
+
+    static const int window_size = 32768;
+    static const int window_mask = window_size - 1;
+
+    struct Segment {
+        const byte* data;
+        int size;
+    };
+
+    Format m_format { Format::Zlib };
+    State m_state { State::Header };
+    bool m_final_block { false };
+
+    Vector<Segment> m_segments;
+    int m_next_segment { 0 };
+    const byte* m_input_ptr { nullptr };
+    const byte* m_input_end { nullptr };
+    int m_overrun_bytes { 0 };
+
+    dword m_bit_buffer { 0 };
+    int m_bit_count { 0 };
+
+    int m_stored_remaining { 0 };
+    int m_copy_remaining { 0 };
+    int m_copy_distance { 0 };
+
+    Huffman m_literal_codes;
+    Huffman m_distance_codes;
+
+    byte m_window[window_size];
+    // Counts every byte of output, so it also tells how far back references may reach.
+    dword m_window_position { 0 };
+};
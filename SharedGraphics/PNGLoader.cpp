@@ -1,14 +1,17 @@
 #include <SharedGraphics/PNGLoader.h>
+#include <SharedGraphics/Inflater.h>
+#include <SharedGraphics/PixelKernels.h>
 #include <AK/NetworkOrdered.h>
 #include <AK/MappedFile.h>
 #include <AK/FileSystemPath.h>
+#include <AK/OwnPtr.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <string.h>
-#include <SharedGraphics/puff.c>
+#include <emmintrin.h>
 #include <serenity.h>
 
 //#define PNG_STOPWATCH_DEBUG
@@ -25,11 +28,6 @@ struct PNG_IHDR {
 
 static_assert(sizeof(PNG_IHDR) == 13);
 
-struct Scanline {
-    byte filter { 0 };
-    ByteBuffer data;
-};
-
 struct PNGLoadingContext {
     int width { -1 };
     int height { -1 };
@@ -39,13 +37,9 @@ struct PNGLoadingContext {
     byte filter_method { 0 };
     byte interlace_method { 0 };
     byte bytes_per_pixel { 0 };
-    bool has_seen_zlib_header { false };
     bool has_alpha() const { return color_type & 4; }
-    Vector<Scanline> scanlines;
     RetainPtr<GraphicsBitmap> bitmap;
-    byte* decompression_buffer { nullptr };
-    int decompression_buffer_size { 0 };
-    Vector<byte> compressed_data;
+    OwnPtr<Inflater> inflater;
 };
 
 class Streamer {
@@ -125,174 +119,146 @@ RetainPtr<GraphicsBitmap> load_png(const String& path)
     return c;
 }
 
-union [[gnu::packed]] Pixel {
-    RGBA32 rgba { 0 };
-    byte v[4];
-    struct {
-        byte r;
-        byte g;
-        byte b;
-        byte a;
-    };
-};
-static_assert(sizeof(Pixel) == 4);
+// The filters work on bytes, but the bitmap holds 4-byte pixels, so each pixel's four
+// channels are handled at once as lanes of a dword (or of an SSE2 register.)
+// For RGB images the alpha lane is garbage after filtering, so alpha_mask forces it back to opaque.
 
-template<bool has_alpha, byte filter_type>
-[[gnu::always_inline]] static inline void unfilter_impl(GraphicsBitmap& bitmap, int y, const void* dummy_scanline_data)
+static inline dword add_bytes(dword a, dword b)
 {
-    auto* dummy_scanline = (const Pixel*)dummy_scanline_data;
-    if constexpr (filter_type == 0) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-        }
-    }
+    return ((a & 0x7f7f7f7f) + (b & 0x7f7f7f7f)) ^ ((a ^ b) & 0x80808080);
+}
 
-    if constexpr (filter_type == 1) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        swap(pixels[0].r, pixels[0].b);
-        for (int i = 1; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            auto& a = (const Pixel&)pixels[i - 1];
-            x.v[0] += a.v[0];
-            x.v[1] += a.v[1];
-            x.v[2] += a.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += a.v[3];
-        }
-        return;
-    }
-    if constexpr (filter_type == 2) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] += b.v[0];
-            x.v[1] += b.v[1];
-            x.v[2] += b.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += b.v[3];
-        }
-        return;
+static inline dword average_bytes(dword a, dword b)
+{
+    return (a & b) + (((a ^ b) & 0xfefefefe) >> 1);
+}
+
+static void unfilter_sub(dword* pixels, const dword*, int width, dword alpha_mask)
+{
+    for (int i = 1; i < width; ++i)
+        pixels[i] = add_bytes(pixels[i], pixels[i - 1]) | alpha_mask;
+}
+
+static void unfilter_up(dword* pixels, const dword* prior, int width, dword alpha_mask)
+{
+    for (int i = 0; i < width; ++i)
+        pixels[i] = add_bytes(pixels[i], prior[i]) | alpha_mask;
+}
+
+[[gnu::target("sse2")]] static void sse2_unfilter_up(dword* pixels, const dword* prior, int width, dword alpha_mask)
+{
+    __m128i mask = _mm_set1_epi32(alpha_mask);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(pixels + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(prior + i));
+        _mm_storeu_si128((__m128i*)(pixels + i), _mm_or_si128(_mm_add_epi8(x, b), mask));
     }
-    if constexpr (filter_type == 3) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            if (i != 0) a = pixels[i - 1];
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] = x.v[0] + ((a.v[0] + b.v[0]) / 2);
-            x.v[1] = x.v[1] + ((a.v[1] + b.v[1]) / 2);
-            x.v[2] = x.v[2] + ((a.v[2] + b.v[2]) / 2);
-            if constexpr (has_alpha)
-                x.v[3] = x.v[3] + ((a.v[3] + b.v[3]) / 2);
-        }
-        return;
+    for (; i < width; ++i)
+        pixels[i] = add_bytes(pixels[i], prior[i]) | alpha_mask;
+}
+
+static void unfilter_average(dword* pixels, const dword* prior, int width, dword alpha_mask)
+{
+    dword a = 0;
+    for (int i = 0; i < width; ++i) {
+        a = add_bytes(pixels[i], average_bytes(a, prior[i])) | alpha_mask;
+        pixels[i] = a;
     }
-    if constexpr (filter_type == 4) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            const Pixel& b = pixels_y_minus_1[i];
-            Pixel c;
-            if (i != 0) {
-                a = pixels[i - 1];
-                c = pixels_y_minus_1[i - 1];
-            }
-            x.v[0] += paeth_predictor(a.v[0], b.v[0], c.v[0]);
-            x.v[1] += paeth_predictor(a.v[1], b.v[1], c.v[1]);
-            x.v[2] += paeth_predictor(a.v[2], b.v[2], c.v[2]);
-            if constexpr (has_alpha)
-                x.v[3] += paeth_predictor(a.v[3], b.v[3], c.v[3]);
-        }
+}
+
+// Each pixel depends on the one before it, so there's only one pixel's worth of lanes to
+// work with. _mm_avg_epu8 rounds up where the filter rounds down, hence the correction.
+[[gnu::target("sse2")]] static void sse2_unfilter_average(dword* pixels, const dword* prior, int width, dword alpha_mask)
+{
+    __m128i one = _mm_set1_epi8(1);
+    __m128i mask = _mm_cvtsi32_si128(alpha_mask);
+    __m128i a = _mm_setzero_si128();
+    for (int i = 0; i < width; ++i) {
+        __m128i b = _mm_cvtsi32_si128(prior[i]);
+        __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        a = _mm_or_si128(_mm_add_epi8(_mm_cvtsi32_si128(pixels[i]), average), mask);
+        pixels[i] = _mm_cvtsi128_si32(a);
     }
 }
 
-[[gnu::noinline]] static void unfilter(PNGLoadingContext& context)
+static void unfilter_paeth(dword* pixels, const dword* prior, int width, dword alpha_mask)
 {
-    {
-#ifdef PNG_STOPWATCH_DEBUG
-    Stopwatch sw("load_png_impl: unfilter: unpack");
-#endif
-    // First unpack the scanlines to RGBA:
-    switch (context.color_type) {
-    case 2:
-        for (int y = 0; y < context.height; ++y) {
-            struct [[gnu::packed]] Triplet { byte r; byte g; byte b; };
-            auto* triplets = (Triplet*)context.scanlines[y].data.pointer();
-            for (int i = 0; i < context.width; ++i) {
-                auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                pixel.r = triplets[i].r;
-                pixel.g = triplets[i].g;
-                pixel.b = triplets[i].b;
-                pixel.a = 0xff;
-            }
-        }
-        break;
-    case 6:
-        for (int y = 0; y < context.height; ++y) {
-            memcpy(context.bitmap->scanline(y), context.scanlines[y].data.pointer(), context.scanlines[y].data.size());
-        }
-        break;
-    default:
-        ASSERT_NOT_REACHED();
-        break;
+    dword a = 0;
+    dword c = 0;
+    for (int i = 0; i < width; ++i) {
+        dword b = prior[i];
+        dword x = pixels[i];
+        dword predicted = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+            predicted |= (dword)paeth_predictor((a >> shift) & 0xff, (b >> shift) & 0xff, (c >> shift) & 0xff) << shift;
+        a = add_bytes(x, predicted) | alpha_mask;
+        pixels[i] = a;
+        c = b;
     }
+}
+
+[[gnu::target("sse2")]] static inline __m128i sse2_abs16(__m128i x)
+{
+    return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+[[gnu::target("sse2")]] static inline __m128i sse2_select(__m128i condition, __m128i if_true, __m128i if_false)
+{
+    return _mm_or_si128(_mm_and_si128(condition, if_true), _mm_andnot_si128(condition, if_false));
+}
+
+// The four channels as 16-bit lanes, so the predictor's differences can't overflow.
+[[gnu::target("sse2")]] static void sse2_unfilter_paeth(dword* pixels, const dword* prior, int width, dword alpha_mask)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i mask = _mm_cvtsi32_si128(alpha_mask);
+    __m128i a = zero;
+    __m128i c = zero;
+    for (int i = 0; i < width; ++i) {
+        __m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(prior[i]), zero);
+        __m128i x = _mm_cvtsi32_si128(pixels[i]);
+
+        __m128i pa = _mm_sub_epi16(b, c);
+        __m128i pb = _mm_sub_epi16(a, c);
+        __m128i pc = sse2_abs16(_mm_add_epi16(pa, pb));
+        pa = sse2_abs16(pa);
+        pb = sse2_abs16(pb);
+        __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+        // Ties go to a, then b, then c, like paeth_predictor().
+        __m128i predicted = sse2_select(_mm_cmpeq_epi16(smallest, pc), c, b);
+        predicted = sse2_select(_mm_cmpeq_epi16(smallest, pb), b, predicted);
+        predicted = sse2_select(_mm_cmpeq_epi16(smallest, pa), a, predicted);
+
+        x = _mm_or_si128(_mm_add_epi8(x, _mm_packus_epi16(predicted, predicted)), mask);
+        pixels[i] = _mm_cvtsi128_si32(x);
+        a = _mm_unpacklo_epi8(x, zero);
+        c = b;
     }
+}
 
-    auto dummy_scanline = ByteBuffer::create_zeroed(context.width * sizeof(RGBA32));
+typedef void (*UnfilterFunction)(dword* pixels, const dword* prior, int width, dword alpha_mask);
 
-#ifdef PNG_STOPWATCH_DEBUG
-    Stopwatch sw("load_png_impl: unfilter: process");
-#endif
-    for (int y = 0; y < context.height; ++y) {
-        auto filter = context.scanlines[y].filter;
-        if (filter == 0) {
-            if (context.has_alpha())
-                unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
-        if (filter == 1) {
-            if (context.has_alpha())
-                unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
-        if (filter == 2) {
-            if (context.has_alpha())
-                unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
-        if (filter == 3) {
-            if (context.has_alpha())
-                unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
-        if (filter == 4) {
-            if (context.has_alpha())
-                unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
+// Indexed by PNG filter type. None is a no-op.
+static const UnfilterFunction* unfilter_functions()
+{
+    static const UnfilterFunction s_scalar[5] = { nullptr, unfilter_sub, unfilter_up, unfilter_average, unfilter_paeth };
+    static const UnfilterFunction s_sse2[5] = { nullptr, unfilter_sub, sse2_unfilter_up, sse2_unfilter_average, sse2_unfilter_paeth };
+    return cpu_has_sse2() ? s_sse2 : s_scalar;
+}
+
+// Converts one scanline of RGB or RGBA bytes to our pixel layout.
+// Unfiltering works the same on swapped channels, so it can happen afterwards, in place.
+static void unpack_scanline(const PNGLoadingContext& context, const byte* data, dword* pixels)
+{
+    if (context.color_type == 2) {
+        for (int i = 0; i < context.width; ++i, data += 3)
+            pixels[i] = 0xff000000 | (data[0] << 16) | (data[1] << 8) | data[2];
+        return;
     }
+    for (int i = 0; i < context.width; ++i, data += 4)
+        pixels[i] = (data[3] << 24) | (data[0] << 16) | (data[1] << 8) | data[2];
 }
 
 static RetainPtr<GraphicsBitmap> load_png_impl(const byte* data, int data_size)
@@ -304,15 +270,13 @@ static RetainPtr<GraphicsBitmap> load_png_impl(const byte* data, int data_size)
     int data_remaining = data_size;
 
     const byte png_header[8] = { 0x89, 'P', 'N', 'G', 13, 10, 26, 10 };
-    if (memcmp(data, png_header, sizeof(png_header))) {
+    if (data_size < (int)sizeof(png_header) || memcmp(data, png_header, sizeof(png_header))) {
         dbgprintf("Invalid PNG header\n");
         return nullptr;
     }
 
     PNGLoadingContext context;
 
-    context.compressed_data.ensure_capacity(data_size);
-
     data_ptr += sizeof(png_header);
     data_remaining -= sizeof(png_header);
 
@@ -328,49 +292,39 @@ static RetainPtr<GraphicsBitmap> load_png_impl(const byte* data, int data_size)
         }
     }
 
-    {
-#ifdef PNG_STOPWATCH_DEBUG
-        Stopwatch sw("load_png_impl: uncompress");
-#endif
-        unsigned long srclen = context.compressed_data.size() - 6;
-        unsigned long destlen = context.decompression_buffer_size;
-        int ret = puff(context.decompression_buffer, &destlen, context.compressed_data.data() + 2, &srclen);
-        if (ret < 0)
-            return nullptr;
-        context.compressed_data.clear();
-    }
+    if (!context.inflater)
+        return nullptr;
 
     {
 #ifdef PNG_STOPWATCH_DEBUG
-        Stopwatch sw("load_png_impl: extract scanlines");
+        Stopwatch sw("load_png_impl: create bitmap");
 #endif
-        context.scanlines.ensure_capacity(context.height);
-        Streamer streamer(context.decompression_buffer, context.decompression_buffer_size);
-        for (int y = 0; y < context.height; ++y) {
-            byte filter;
-            if (!streamer.read(filter))
-                return nullptr;
-
-            context.scanlines.append({ filter });
-            auto& scanline_buffer = context.scanlines.last().data;
-            if (!streamer.wrap_bytes(scanline_buffer, context.width * context.bytes_per_pixel))
-                return nullptr;
-        }
+        context.bitmap = GraphicsBitmap::create(context.has_alpha() ? GraphicsBitmap::Format::RGBA32 : GraphicsBitmap::Format::RGB32, { context.width, context.height });
     }
 
-    {
 #ifdef PNG_STOPWATCH_DEBUG
-        Stopwatch sw("load_png_impl: create bitmap");
+    Stopwatch sw("load_png_impl: decode scanlines");
 #endif
-        context.bitmap = GraphicsBitmap::create(context.has_alpha() ? GraphicsBitmap::Format::RGBA32 : GraphicsBitmap::Format::RGB32, { context.width, context.height });
+    // Inflate one scanline at a time, so neither the compressed nor the filtered
+    // image ever needs to be held in memory as a whole.
+    auto scanline = ByteBuffer::create_uninitialized(1 + context.width * context.bytes_per_pixel);
+    auto zeroed_scanline = ByteBuffer::create_zeroed(context.width * sizeof(RGBA32));
+    auto* unfilter = unfilter_functions();
+    dword alpha_mask = context.has_alpha() ? 0 : 0xff000000;
+    for (int y = 0; y < context.height; ++y) {
+        if (!context.inflater->read(scanline.pointer(), scanline.size()))
+            return nullptr;
+        byte filter = scanline[0];
+        if (filter > 4)
+            return nullptr;
+        auto* pixels = context.bitmap->scanline(y);
+        unpack_scanline(context, scanline.pointer() + 1, pixels);
+        if (filter) {
+            auto* prior = y ? context.bitmap->scanline(y - 1) : (const dword*)zeroed_scanline.pointer();
+            unfilter[filter](pixels, prior, context.width, alpha_mask);
+        }
     }
 
-    unfilter(context);
-
-    munmap(context.decompression_buffer, context.decompression_buffer_size);
-    context.decompression_buffer = nullptr;
-    context.decompression_buffer_size = 0;
-
     return context.bitmap;
 }
 
@@ -387,6 +341,11 @@ static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context)
     context.filter_method = ihdr.filter_method;
     context.interlace_method = ihdr.interlace_method;
 
+    if (context.bit_depth != 8 || context.compression_method != 0 || context.filter_method != 0 || context.interlace_method != 0) {
+        dbgprintf("PNG: Unsupported format (bit depth %u, interlace method %u)\n", context.bit_depth, context.interlace_method);
+        return false;
+    }
+
     switch (context.color_type) {
     case 2:
         context.bytes_per_pixel = 3;
@@ -395,23 +354,29 @@ static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context)
         context.bytes_per_pixel = 4;
         break;
     default:
-        ASSERT_NOT_REACHED();
+        dbgprintf("PNG: Unsupported color type %u\n", context.color_type);
+        return false;
     }
 
+    if (context.width <= 0 || context.height <= 0 || context.width > 16384 || context.height > 16384)
+        return false;
+
 #ifdef PNG_DEBUG
     printf("PNG: %dx%d (%d bpp)\n", context.width, context.height, context.bit_depth);
     printf("     Color type: %b\n", context.color_type);
     printf(" Interlace type: %b\n", context.interlace_method);
 #endif
 
-    context.decompression_buffer_size = (context.width * context.height * context.bytes_per_pixel + context.height);
-    context.decompression_buffer = (byte*)mmap(nullptr, context.decompression_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    context.inflater = make<Inflater>(Inflater::Format::Zlib);
     return true;
 }
 
 static bool process_IDAT(const ByteBuffer& data, PNGLoadingContext& context)
 {
-    context.compressed_data.append(data.pointer(), data.size());
+    if (!context.inflater)
+        return false;
+    // The chunk data stays mapped until decoding is done, so the inflater can read it in place.
+    context.inflater->append_input(data.pointer(), data.size());
     return true;
 }
 
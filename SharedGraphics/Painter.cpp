@@ -2,6 +2,7 @@
 #include "Font.h"
 #include "GraphicsBitmap.h"
 #include <SharedGraphics/CharacterBitmap.h>
+#include <SharedGraphics/PixelKernels.h>
 #include <AK/Assertions.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringBuilder.h>
@@ -89,26 +90,30 @@ void Painter::fill_rect_with_gradient(const Rect& a_rect, Color gradient_start,
     RGBA32* dst = m_target->scanline(clipped_rect.top()) + clipped_rect.left();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
-    float increment = (1.0/((rect.width())/255.0));
-
-    int r2 = gradient_start.red();
-    int g2 = gradient_start.green();
-    int b2 = gradient_start.blue();
-    int r1 = gradient_end.red();
-    int g1 = gradient_end.green();
-    int b1 = gradient_end.blue();
-
-    for (int i = clipped_rect.height() - 1; i >= 0; --i) {
-        float c = x_offset * increment;
-        for (int j = 0; j < clipped_rect.width(); ++j) {
-            dst[j] = Color(
-                r1 / 255.0 * c + r2 / 255.0 * (255 - c),
-                g1 / 255.0 * c + g2 / 255.0 * (255 - c),
-                b1 / 255.0 * c + b2 / 255.0 * (255 - c)
-            ).value();
-            c += increment;
-        }
+    // Every row of a horizontal gradient is the same, so compute the first one
+    // with 16.16 fixed-point steps (no per-pixel float math) and copy it down.
+    int width = rect.width();
+    int r = gradient_start.red() << 16;
+    int g = gradient_start.green() << 16;
+    int b = gradient_start.blue() << 16;
+    int r_step = ((gradient_end.red() - gradient_start.red()) << 16) / width;
+    int g_step = ((gradient_end.green() - gradient_start.green()) << 16) / width;
+    int b_step = ((gradient_end.blue() - gradient_start.blue()) << 16) / width;
+    r += x_offset * r_step;
+    g += x_offset * g_step;
+    b += x_offset * b_step;
+
+    for (int j = 0; j < clipped_rect.width(); ++j) {
+        dst[j] = Color(r >> 16, g >> 16, b >> 16).value();
+        r += r_step;
+        g += g_step;
+        b += b_step;
+    }
+
+    const RGBA32* first_row = dst;
+    for (int i = clipped_rect.height() - 1; i > 0; --i) {
         dst += dst_skip;
+        fast_dword_copy(dst, first_row, clipped_rect.width());
     }
 }
 
@@ -224,19 +229,14 @@ void Painter::blit_with_opacity(const Point& position, const GraphicsBitmap& sou
     const int first_row = clipped_rect.top() - dst_rect.top();
     const int last_row = clipped_rect.bottom() - dst_rect.top();
     const int first_column = clipped_rect.left() - dst_rect.left();
-    const int last_column = clipped_rect.right() - dst_rect.left();
     RGBA32* dst = m_target->scanline(clipped_rect.y()) + clipped_rect.x();
     const RGBA32* src = source.scanline(src_rect.top() + first_row) + src_rect.left() + first_column;
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const unsigned src_skip = source.pitch() / sizeof(RGBA32);
 
+    auto& kernels = pixel_kernels();
     for (int row = first_row; row <= last_row; ++row) {
-        for (int x = 0; x <= (last_column - first_column); ++x) {
-            Color src_color_with_alpha = Color::from_rgb(src[x]);
-            src_color_with_alpha.set_alpha(alpha);
-            Color dst_color = Color::from_rgb(dst[x]);
-            dst[x] = dst_color.blend(src_color_with_alpha).value();
-        }
+        kernels.blend_with_opacity(dst, src, clipped_rect.width(), alpha);
         dst += dst_skip;
         src += src_skip;
     }
@@ -258,6 +258,16 @@ void Painter::blit_dimmed(const Point& position, const GraphicsBitmap& source, c
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const size_t src_skip = source.pitch() / sizeof(RGBA32);
 
+    if (!m_target->has_alpha_channel()) {
+        auto& kernels = pixel_kernels();
+        for (int row = first_row; row <= last_row; ++row) {
+            kernels.blend_dimmed(dst, src, clipped_rect.width());
+            dst += dst_skip;
+            src += src_skip;
+        }
+        return;
+    }
+
     for (int row = first_row; row <= last_row; ++row) {
         for (int x = 0; x <= (last_column - first_column); ++x) {
             byte alpha = Color::from_rgba(src[x]).alpha();
@@ -291,6 +301,16 @@ void Painter::blit_with_alpha(const Point& position, const GraphicsBitmap& sourc
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const size_t src_skip = source.pitch() / sizeof(RGBA32);
 
+    if (!m_target->has_alpha_channel()) {
+        auto& kernels = pixel_kernels();
+        for (int row = first_row; row <= last_row; ++row) {
+            kernels.blend_with_alpha(dst, src, clipped_rect.width());
+            dst += dst_skip;
+            src += src_skip;
+        }
+        return;
+    }
+
     for (int row = first_row; row <= last_row; ++row) {
         for (int x = 0; x <= (last_column - first_column); ++x) {
             byte alpha = Color::from_rgba(src[x]).alpha();
@@ -401,7 +421,147 @@ ALWAYS_INLINE static void do_draw_scaled_bitmap(GraphicsBitmap& target, const Re
     }
 }
 
-void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& source, const Rect& src_rect)
+// Where one destination column (or row) samples the source, in source bitmap coordinates.
+struct ScaleSample {
+    int first;  // NearestNeighbor: the sample. Bilinear: the left/top tap. BoxFilter: first pixel of the span.
+    int second; // Bilinear: the right/bottom tap. BoxFilter: one past the last pixel of the span.
+    int weight; // Bilinear: how much of `second` to use, out of 256.
+
+    bool operator==(const ScaleSample& other) const { return first == other.first && second == other.second && weight == other.weight; }
+};
+
+static void compute_scale_samples(Vector<ScaleSample>& samples, Painter::ScalingMode mode, int src_origin, int src_length, int src_limit, int dst_length, int first, int count)
+{
+    // 16.16 fixed point, so sources are limited to 32767 pixels in each direction.
+    int step = (src_length << 16) / dst_length;
+    auto clamp_to_source = [src_limit](int i) { return max(0, min(i, src_limit - 1)); };
+    samples.resize(count);
+    for (int i = 0; i < count; ++i) {
+        int position = (first + i) * step;
+        auto& sample = samples[i];
+        sample = { 0, 0, 0 };
+        switch (mode) {
+        case Painter::ScalingMode::NearestNeighbor:
+            sample.first = clamp_to_source(src_origin + (position >> 16));
+            break;
+        case Painter::ScalingMode::Bilinear: {
+            // Sample at the center of the destination pixel.
+            int center = max(0, min(position + step / 2 - 0x8000, (src_length - 1) << 16));
+            sample.first = clamp_to_source(src_origin + (center >> 16));
+            sample.second = clamp_to_source(src_origin + (center >> 16) + 1);
+            sample.weight = ((center & 0xffff) + 0x80) >> 8;
+            break;
+        }
+        case Painter::ScalingMode::BoxFilter: {
+            // Work the span out exactly rather than from the truncated step, so the
+            // spans tile the source and the last one reaches its last pixel.
+            int begin = (first + i) * src_length / dst_length;
+            int end = max(begin + 1, (first + i + 1) * src_length / dst_length);
+            sample.first = clamp_to_source(src_origin + begin);
+            sample.second = clamp_to_source(src_origin + end - 1) + 1;
+            break;
+        }
+        }
+    }
+}
+
+static void resample_row_nearest(dword* out, const RGBA32* src, const Vector<ScaleSample>& columns)
+{
+    for (int x = 0; x < columns.size(); ++x)
+        out[x] = src[columns[x].first];
+}
+
+static void resample_row_bilinear(dword* out, const RGBA32* src, const Vector<ScaleSample>& columns)
+{
+    for (int x = 0; x < columns.size(); ++x) {
+        auto& column = columns[x];
+        out[x] = lerp_pixel(src[column.first], src[column.second], column.weight);
+    }
+}
+
+// Averages the column spans of sums that a PixelKernels::accumulate() pass has filled in for `row_count` rows.
+static void resolve_box_row(dword* out, const dword* sums, int sums_origin, int row_count, const Vector<ScaleSample>& columns)
+{
+    for (int x = 0; x < columns.size(); ++x) {
+        auto& column = columns[x];
+        dword b = 0, g = 0, r = 0, a = 0;
+        for (const dword* sum = sums + (column.first - sums_origin) * 4, *end = sums + (column.second - sums_origin) * 4; sum != end; sum += 4) {
+            b += sum[0];
+            g += sum[1];
+            r += sum[2];
+            a += sum[3];
+        }
+        dword count = (column.second - column.first) * row_count;
+        out[x] = (b / count) | ((g / count) << 8) | ((r / count) << 16) | ((a / count) << 24);
+    }
+}
+
+// Resamples RGB32/RGBA32 sources a destination row at a time from per-column and per-row sample tables,
+// then hands each row to the span kernels.
+static void do_draw_filtered_scaled_bitmap(GraphicsBitmap& target, const Rect& dst_rect, const Rect& clipped_rect, const GraphicsBitmap& source, const Rect& src_rect, Painter::ScalingMode mode)
+{
+    auto& kernels = pixel_kernels();
+    const int width = clipped_rect.width();
+
+    Vector<ScaleSample> columns;
+    Vector<ScaleSample> rows;
+    compute_scale_samples(columns, mode, src_rect.x(), src_rect.width(), source.width(), dst_rect.width(), clipped_rect.left() - dst_rect.left(), width);
+    compute_scale_samples(rows, mode, src_rect.y(), src_rect.height(), source.height(), dst_rect.height(), clipped_rect.top() - dst_rect.top(), clipped_rect.height());
+
+    Vector<dword> buffer;
+    buffer.resize(width * 3);
+    dword* row = buffer.data();
+    dword* upper = row + width;
+    dword* lower = upper + width;
+    int upper_y = -1;
+    int lower_y = -1;
+
+    Vector<dword> sums;
+    int sums_origin = columns.first().first;
+    if (mode == Painter::ScalingMode::BoxFilter)
+        sums.resize((columns.last().second - sums_origin) * 4);
+
+    for (int i = 0; i < rows.size(); ++i) {
+        auto& sample = rows[i];
+        // Enlarging repeats rows, and those only need to be drawn again.
+        if (i == 0 || !(sample == rows[i - 1])) {
+            switch (mode) {
+            case Painter::ScalingMode::NearestNeighbor:
+                resample_row_nearest(row, source.scanline(sample.first), columns);
+                break;
+            case Painter::ScalingMode::Bilinear:
+                if (sample.first != upper_y) {
+                    if (sample.first == lower_y) {
+                        swap(upper, lower);
+                        swap(upper_y, lower_y);
+                    } else {
+                        resample_row_bilinear(upper, source.scanline(sample.first), columns);
+                        upper_y = sample.first;
+                    }
+                }
+                if (sample.second != lower_y) {
+                    resample_row_bilinear(lower, source.scanline(sample.second), columns);
+                    lower_y = sample.second;
+                }
+                kernels.lerp(row, upper, lower, width, sample.weight);
+                break;
+            case Painter::ScalingMode::BoxFilter:
+                memset(sums.data(), 0, sums.size() * sizeof(dword));
+                for (int y = sample.first; y < sample.second; ++y)
+                    kernels.accumulate(sums.data(), source.scanline(y) + sums_origin, sums.size() / 4);
+                resolve_box_row(row, sums.data(), sums_origin, sample.second - sample.first, columns);
+                break;
+            }
+        }
+        RGBA32* dst = target.scanline(clipped_rect.top() + i) + clipped_rect.left();
+        if (source.has_alpha_channel())
+            kernels.blend_with_alpha(dst, row, width);
+        else
+            fast_dword_copy(dst, row, width);
+    }
+}
+
+void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& source, const Rect& src_rect, ScalingMode mode)
 {
     auto dst_rect = a_dst_rect;
     if (dst_rect.size() == src_rect.size())
@@ -411,23 +571,22 @@ void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& s
     ASSERT(source.rect().contains(safe_src_rect));
     dst_rect.move_by(state().translation);
     auto clipped_rect = dst_rect.intersected(clip_rect());
-    if (clipped_rect.is_empty())
+    if (clipped_rect.is_empty() || src_rect.is_empty())
         return;
 
+    if (source.format() == GraphicsBitmap::Format::RGB32 || source.format() == GraphicsBitmap::Format::RGBA32)
+        return do_draw_filtered_scaled_bitmap(*m_target, dst_rect, clipped_rect, source, src_rect, mode);
+
     int hscale = (src_rect.width() << 16) / dst_rect.width();
     int vscale = (src_rect.height() << 16) / dst_rect.height();
 
     if (source.has_alpha_channel()) {
         switch (source.format()) {
-        case GraphicsBitmap::Format::RGB32: do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::RGB32>); break;
-        case GraphicsBitmap::Format::RGBA32: do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::RGB32>); break;
         case GraphicsBitmap::Format::Indexed8: do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::Indexed8>); break;
         default: do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::Invalid>); break;
         }
     } else {
         switch (source.format()) {
-        case GraphicsBitmap::Format::RGB32: do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::RGB32>); break;
-        case GraphicsBitmap::Format::RGBA32: do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::RGB32>); break;
         case GraphicsBitmap::Format::Indexed8: do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::Indexed8>); break;
         default: do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::Invalid>); break;
         }
@@ -441,7 +600,54 @@ void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& s
 
 [[gnu::flatten]] void Painter::draw_glyph(const Point& point, char ch, const Font& font, Color color)
 {
-    draw_bitmap(point, font.glyph_bitmap(ch), color);
+    draw_text_run(point, &ch, 1, font, color);
+}
+
+void Painter::draw_text_run(const Point& a_point, const char* text, int length, const Font& font, Color color)
+{
+    // The run is clipped once. Glyphs are then drawn from the font's span cache,
+    // and only the glyphs straddling the left or right clip edge clip their spans.
+    auto point = a_point.translated(translation());
+    auto clip_rect = this->clip_rect();
+    int first_row = max(0, clip_rect.top() - point.y());
+    int last_row = min(font.glyph_height() - 1, clip_rect.bottom() - point.y());
+    if (first_row > last_row)
+        return;
+
+    const RGBA32 value = color.value();
+    const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
+    RGBA32* const dst = m_target->scanline(0) + point.y() * (int)dst_skip;
+    const int clip_left = clip_rect.left();
+    const int clip_right = clip_rect.right() + 1;
+    const int glyph_spacing = font.glyph_spacing();
+
+    int x = point.x();
+    for (int i = 0; i < length && x < clip_right; ++i) {
+        char ch = text[i];
+        int glyph_width = font.glyph_width(ch);
+        if (ch != ' ' && x + glyph_width > clip_left) {
+            bool needs_clipping = x < clip_left || x + glyph_width > clip_right;
+            int span_count;
+            auto* spans = font.glyph_spans(ch, span_count);
+            for (int j = 0; j < span_count; ++j) {
+                auto& span = spans[j];
+                if (span.row < first_row)
+                    continue;
+                if (span.row > last_row)
+                    break;
+                int left = x + span.x;
+                int right = left + span.length;
+                if (needs_clipping) {
+                    left = max(left, clip_left);
+                    right = min(right, clip_right);
+                }
+                RGBA32* scanline = dst + span.row * dst_skip;
+                for (int k = left; k < right; ++k)
+                    scanline[k] = value;
+            }
+        }
+        x += glyph_width + glyph_spacing;
+    }
 }
 
 void Painter::draw_text(const Rect& rect, const char* text, int length, const Font& font, TextAlignment alignment, Color color, TextElision elision)
@@ -492,16 +698,7 @@ void Painter::draw_text(const Rect& rect, const char* text, int length, const Fo
         ASSERT_NOT_REACHED();
     }
 
-    int space_width = font.glyph_width(' ') + font.glyph_spacing();
-    for (ssize_t i = 0; i < length; ++i) {
-        char ch = text[i];
-        if (ch == ' ') {
-            point.move_by(space_width, 0);
-            continue;
-        }
-        draw_glyph(point, ch, font, color);
-        point.move_by(font.glyph_width(ch) + font.glyph_spacing(), 0);
-    }
+    draw_text_run(point, text, length, font, color);
 }
 
 void Painter::draw_text(const Rect& rect, const String& text, TextAlignment alignment, Color color, TextElision elision)
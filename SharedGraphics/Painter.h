@@ -24,7 +24,11 @@ public:
     void draw_bitmap(const Point&, const GlyphBitmap&, Color = Color());
     void set_pixel(const Point&, Color);
     void draw_line(const Point&, const Point&, Color);
-    void draw_scaled_bitmap(const Rect& dst_rect, const GraphicsBitmap&, const Rect& src_rect);
+    // BoxFilter averages every source pixel under a destination pixel, so it's the one to use when shrinking.
+    // It behaves like NearestNeighbor in directions where the bitmap is enlarged.
+    // Only RGB32 and RGBA32 sources are filtered; others always use NearestNeighbor.
+    enum class ScalingMode { NearestNeighbor, Bilinear, BoxFilter };
+    void draw_scaled_bitmap(const Rect& dst_rect, const GraphicsBitmap&, const Rect& src_rect, ScalingMode = ScalingMode::NearestNeighbor);
     void blit(const Point&, const GraphicsBitmap&, const Rect& src_rect, float opacity = 1.0f);
     void blit_dimmed(const Point&, const GraphicsBitmap&, const Rect& src_rect);
 
@@ -34,6 +38,7 @@ public:
     void draw_text(const Rect&, const String&, TextAlignment = TextAlignment::TopLeft, Color = Color::Black, TextElision = TextElision::None);
     void draw_glyph(const Point&, char, Color);
     void draw_glyph(const Point&, char, const Font&, Color);
+    void draw_text_run(const Point&, const char* text, int length, const Font&, Color);
 
     const Font& font() const { return *state().font; }
     void set_font(const Font& font) { state().font = &font; }
@@ -0,0 +1,243 @@
+#include <SharedGraphics/PixelKernels.h>
+#include <emmintrin.h>
+
+#pragma GCC optimize("O3")
+
+// x / 255 for 0 <= x <= 255 * 255, rounded to nearest.
+static inline dword div255(dword x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// Blends one pixel by blending red/blue and green as two 16-bit lanes of a dword.
+static inline dword blend_pixel(dword dst, dword src, dword alpha)
+{
+    dword inverse_alpha = 255 - alpha;
+    dword rb = (src & 0xff00ff) * alpha + (dst & 0xff00ff) * inverse_alpha + 0x800080;
+    rb = ((rb + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+    dword g = ((src >> 8) & 0xff) * alpha + ((dst >> 8) & 0xff) * inverse_alpha;
+    g = div255(g);
+    return 0xff000000 | rb | (g << 8);
+}
+
+static inline dword dimmed_pixel(dword src)
+{
+    dword r = (src >> 16) & 0xff;
+    dword g = (src >> 8) & 0xff;
+    dword b = src & 0xff;
+    // (r + g + b) / 3, then lightened by 20% and clamped (same as Color::to_grayscale().lightened())
+    dword gray = ((r + g + b) * 21846) >> 16;
+    gray = (gray * 1229) >> 10;
+    if (gray > 255)
+        gray = 255;
+    return (src & 0xff000000) | (gray << 16) | (gray << 8) | gray;
+}
+
+static void scalar_blend_with_alpha(dword* dst, const dword* src, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        dword alpha = src[i] >> 24;
+        if (alpha == 0xff)
+            dst[i] = src[i];
+        else if (alpha)
+            dst[i] = blend_pixel(dst[i], src[i], alpha);
+    }
+}
+
+static void scalar_blend_with_opacity(dword* dst, const dword* src, int count, byte alpha)
+{
+    for (int i = 0; i < count; ++i)
+        dst[i] = blend_pixel(dst[i], src[i], alpha);
+}
+
+static void scalar_blend_dimmed(dword* dst, const dword* src, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        dword alpha = src[i] >> 24;
+        if (alpha == 0xff)
+            dst[i] = dimmed_pixel(src[i]);
+        else if (alpha)
+            dst[i] = blend_pixel(dst[i], dimmed_pixel(src[i]), alpha);
+    }
+}
+
+static void scalar_lerp(dword* dst, const dword* a, const dword* b, int count, int weight)
+{
+    for (int i = 0; i < count; ++i)
+        dst[i] = lerp_pixel(a[i], b[i], weight);
+}
+
+static void scalar_accumulate(dword* sums, const dword* src, int count)
+{
+    for (int i = 0; i < count; ++i, sums += 4) {
+        dword pixel = src[i];
+        sums[0] += pixel & 0xff;
+        sums[1] += (pixel >> 8) & 0xff;
+        sums[2] += (pixel >> 16) & 0xff;
+        sums[3] += pixel >> 24;
+    }
+}
+
+// Blends two pixels (unpacked to 16 bits per channel) given their per-channel alphas.
+[[gnu::target("sse2")]] static inline __m128i sse2_blend_unpacked(__m128i dst, __m128i src, __m128i alpha)
+{
+    const __m128i v255 = _mm_set1_epi16(255);
+    const __m128i v128 = _mm_set1_epi16(128);
+    __m128i inverse_alpha = _mm_sub_epi16(v255, alpha);
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, inverse_alpha));
+    x = _mm_add_epi16(x, v128);
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Blends four pixels at once. The alpha for each pixel is taken from the top byte of `alpha_source`.
+[[gnu::target("sse2")]] static inline __m128i sse2_blend4(__m128i dst, __m128i src, __m128i alpha_source)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi32(0xff000000);
+
+    __m128i alpha_lo = _mm_unpacklo_epi8(alpha_source, zero);
+    __m128i alpha_hi = _mm_unpackhi_epi8(alpha_source, zero);
+    alpha_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(alpha_lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    alpha_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(alpha_hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+    __m128i lo = sse2_blend_unpacked(_mm_unpacklo_epi8(dst, zero), _mm_unpacklo_epi8(src, zero), alpha_lo);
+    __m128i hi = sse2_blend_unpacked(_mm_unpackhi_epi8(dst, zero), _mm_unpackhi_epi8(src, zero), alpha_hi);
+    return _mm_or_si128(_mm_packus_epi16(lo, hi), opaque);
+}
+
+[[gnu::target("sse2")]] static void sse2_blend_with_alpha(dword* dst, const dword* src, int count)
+{
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i alphas = _mm_and_si128(s, alpha_mask);
+        // Skip the arithmetic entirely for runs of fully transparent or fully opaque pixels.
+        int transparent = _mm_movemask_epi8(_mm_cmpeq_epi32(alphas, _mm_setzero_si128()));
+        if (transparent == 0xffff)
+            continue;
+        int opaque = _mm_movemask_epi8(_mm_cmpeq_epi32(alphas, alpha_mask));
+        if (opaque == 0xffff) {
+            _mm_storeu_si128((__m128i*)&dst[i], s);
+            continue;
+        }
+        __m128i d = _mm_loadu_si128((const __m128i*)&dst[i]);
+        _mm_storeu_si128((__m128i*)&dst[i], sse2_blend4(d, s, s));
+    }
+    scalar_blend_with_alpha(dst + i, src + i, count - i);
+}
+
+[[gnu::target("sse2")]] static void sse2_blend_with_opacity(dword* dst, const dword* src, int count, byte alpha)
+{
+    const __m128i alpha_source = _mm_set1_epi32((dword)alpha << 24);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i d = _mm_loadu_si128((const __m128i*)&dst[i]);
+        _mm_storeu_si128((__m128i*)&dst[i], sse2_blend4(d, s, alpha_source));
+    }
+    scalar_blend_with_opacity(dst + i, src + i, count - i, alpha);
+}
+
+[[gnu::target("sse2")]] static void sse2_blend_dimmed(dword* dst, const dword* src, int count)
+{
+    // The grayscale conversion is cheap next to the blend, so do it in chunks
+    // and hand the result to the vector blend.
+    dword dimmed[64];
+    while (count > 0) {
+        int chunk = count < 64 ? count : 64;
+        for (int i = 0; i < chunk; ++i)
+            dimmed[i] = dimmed_pixel(src[i]);
+        sse2_blend_with_alpha(dst, dimmed, chunk);
+        dst += chunk;
+        src += chunk;
+        count -= chunk;
+    }
+}
+
+[[gnu::target("sse2")]] static void sse2_lerp(dword* dst, const dword* a, const dword* b, int count, int weight)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w = _mm_set1_epi16(weight);
+    const __m128i inverse_w = _mm_set1_epi16(256 - weight);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i va = _mm_loadu_si128((const __m128i*)&a[i]);
+        __m128i vb = _mm_loadu_si128((const __m128i*)&b[i]);
+        // The products can't exceed 255 * 256, so the unsigned sums fit in 16 bits.
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), inverse_w), _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), w));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), inverse_w), _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), w));
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+    scalar_lerp(dst + i, a + i, b + i, count - i, weight);
+}
+
+[[gnu::target("sse2")]] static void sse2_accumulate(dword* sums, const dword* src, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4, sums += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i lo = _mm_unpacklo_epi8(s, zero);
+        __m128i hi = _mm_unpackhi_epi8(s, zero);
+        __m128i* out = (__m128i*)sums;
+        _mm_storeu_si128(out + 0, _mm_add_epi32(_mm_loadu_si128(out + 0), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+    scalar_accumulate(sums, src + i, count - i);
+}
+
+bool cpu_has_sse2()
+{
+    static int s_has_sse2 = -1;
+    if (s_has_sse2 == -1) {
+        dword eax, ebx, ecx, edx;
+        asm volatile("cpuid"
+                     : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                     : "a"(1), "c"(0));
+        s_has_sse2 = (edx & (1 << 26)) != 0;
+    }
+    return s_has_sse2;
+}
+
+static const PixelKernels s_scalar_kernels {
+    "scalar",
+    scalar_blend_with_alpha,
+    scalar_blend_with_opacity,
+    scalar_blend_dimmed,
+    scalar_lerp,
+    scalar_accumulate,
+};
+
+static const PixelKernels s_sse2_kernels {
+    "sse2",
+    sse2_blend_with_alpha,
+    sse2_blend_with_opacity,
+    sse2_blend_dimmed,
+    sse2_lerp,
+    sse2_accumulate,
+};
+
+const PixelKernels& scalar_pixel_kernels()
+{
+    return s_scalar_kernels;
+}
+
+const PixelKernels* sse2_pixel_kernels()
+{
+    return cpu_has_sse2() ? &s_sse2_kernels : nullptr;
+}
+
+const PixelKernels& pixel_kernels()
+{
+    static const PixelKernels* s_kernels;
+    if (!s_kernels) {
+        s_kernels = sse2_pixel_kernels();
+        if (!s_kernels)
+            s_kernels = &s_scalar_kernels;
+    }
+    return *s_kernels;
+}
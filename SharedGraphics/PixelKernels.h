@@ -0,0 +1,47 @@
+#pragma once
+
+#include <AK/Types.h>
+
+// Span kernels used by Painter for the blending-heavy blits.
+// All of them assume an opaque (RGB32) destination and write opaque pixels back,
+// which lets them use plain "source over" math with no divisions.
+// Source pixels are RGBA32 (alpha in the top byte.)
+struct PixelKernels {
+    const char* name;
+
+    // dst = src over dst, using each source pixel's alpha.
+    void (*blend_with_alpha)(dword* dst, const dword* src, int count);
+
+    // dst = src over dst, using a constant alpha for every source pixel.
+    void (*blend_with_opacity)(dword* dst, const dword* src, int count, byte alpha);
+
+    // Like blend_with_alpha(), but the source is grayscaled and lightened first.
+    void (*blend_dimmed)(dword* dst, const dword* src, int count);
+
+    // The scaling kernels below work on all four channels and don't care about the formats.
+
+    // dst = a + (b - a) * weight / 256, for 0 <= weight <= 256.
+    void (*lerp)(dword* dst, const dword* a, const dword* b, int count, int weight);
+
+    // Adds the channels of each source pixel to its four sums, in memory order (b, g, r, a.)
+    void (*accumulate)(dword* sums, const dword* src, int count);
+};
+
+// Interpolates between two pixels, channel by channel, for 0 <= weight <= 256.
+inline dword lerp_pixel(dword a, dword b, dword weight)
+{
+    dword inverse_weight = 256 - weight;
+    dword rb = (((a & 0xff00ff) * inverse_weight + (b & 0xff00ff) * weight) >> 8) & 0xff00ff;
+    dword ag = (((a >> 8) & 0xff00ff) * inverse_weight + ((b >> 8) & 0xff00ff) * weight) & 0xff00ff00;
+    return rb | ag;
+}
+
+// Checked once, via CPUID. Also used by the PNG decoder's unfilter kernels.
+bool cpu_has_sse2();
+
+// The best kernels this CPU supports.
+const PixelKernels& pixel_kernels();
+
+// Kernel sets for benchmarking. sse2_pixel_kernels() returns null if the CPU lacks SSE2.
+const PixelKernels& scalar_pixel_kernels();
+const PixelKernels* sse2_pixel_kernels();
@@ -0,0 +1,35 @@
+#include <AK/AKString.h>
+#include <stdio.h>
+
+int main(int, char**)
+{
+    FILE* fp = fopen("/proc/arp", "r");
+    if (!fp) {
+        perror("failed to open /proc/arp");
+        return 1;
+    }
+    printf("Address          HWaddress          State       Age  Drops  Iface\n");
+    for (;;) {
+        char buf[256];
+        char* ptr = fgets(buf, sizeof(buf), fp);
+        if (!ptr)
+            break;
+        auto parts = String(buf, Chomp).split(',');
+        if (parts.size() < 5)
+            break;
+        bool ok;
+        unsigned age = parts[3].to_uint(ok);
+        ASSERT(ok);
+        printf("%-16s ", parts[0].characters());
+        printf("%-18s ", parts[2] == "incomplete" ? "(incomplete)" : parts[1].characters());
+        printf("%-10s ", parts[2].characters());
+        printf("%5u  ", age);
+        unsigned dropped = parts.size() > 5 ? parts[5].to_uint(ok) : 0;
+        printf("%5u  ", dropped);
+        printf("%s", parts[4].characters());
+        printf("\n");
+    }
+    int rc = fclose(fp);
+    ASSERT(rc == 0);
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <SharedGraphics/PixelKernels.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+// Measures throughput of the Painter pixel kernels in Mpixels/s.
+// Only depends on PixelKernels, so it also builds on the host:
+//     g++ -O2 -I. Userland/blitbench.cpp SharedGraphics/PixelKernels.cpp
+
+static const int span_length = 1024;
+static const int span_count = 256;
+
+static dword s_src[span_length * span_count];
+static dword s_dst[span_length * span_count];
+
+static int elapsed_ms(const timeval& start)
+{
+    timeval now;
+    gettimeofday(&now, nullptr);
+    return (now.tv_sec - start.tv_sec) * 1000 + (now.tv_usec - start.tv_usec) / 1000;
+}
+
+static void fill_test_pattern()
+{
+    unsigned seed = 1234;
+    for (int i = 0; i < span_length * span_count; ++i) {
+        seed = seed * 1103515245 + 12345;
+        dword alpha = (seed >> 24) & 0xff;
+        // Mix in some fully transparent and fully opaque pixels, like real icons have.
+        if ((i & 15) < 4)
+            alpha = 0;
+        else if ((i & 15) < 8)
+            alpha = 0xff;
+        s_src[i] = (alpha << 24) | (seed & 0xffffff);
+        s_dst[i] = 0xff000000 | ((seed >> 8) & 0xffffff);
+    }
+}
+
+template<typename Callback>
+static void run(const char* kernel_set, const char* kernel_name, int iterations, Callback callback)
+{
+    fill_test_pattern();
+    timeval start;
+    gettimeofday(&start, nullptr);
+    for (int i = 0; i < iterations; ++i) {
+        for (int span = 0; span < span_count; ++span)
+            callback(s_dst + span * span_length, s_src + span * span_length, span_length);
+    }
+    int ms = elapsed_ms(start);
+    if (ms <= 0)
+        ms = 1;
+    long long pixels = (long long)iterations * span_count * span_length;
+    printf("%-8s %-20s %6d ms %8lld Mpixels/s\n", kernel_set, kernel_name, ms, pixels / 1000 / ms);
+}
+
+static void benchmark(const PixelKernels& kernels, int iterations)
+{
+    run(kernels.name, "blend_with_alpha", iterations, [&](dword* dst, const dword* src, int count) {
+        kernels.blend_with_alpha(dst, src, count);
+    });
+    run(kernels.name, "blend_with_opacity", iterations, [&](dword* dst, const dword* src, int count) {
+        kernels.blend_with_opacity(dst, src, count, 0x80);
+    });
+    run(kernels.name, "blend_dimmed", iterations, [&](dword* dst, const dword* src, int count) {
+        kernels.blend_dimmed(dst, src, count);
+    });
+}
+
+static bool kernels_agree(const PixelKernels& a, const PixelKernels& b)
+{
+    static dword dst_a[span_length];
+    static dword dst_b[span_length];
+    fill_test_pattern();
+    for (int pass = 0; pass < 3; ++pass) {
+        memcpy(dst_a, s_dst, sizeof(dst_a));
+        memcpy(dst_b, s_dst, sizeof(dst_b));
+        // Use an odd length so the scalar tail of the vector kernels is exercised too.
+        int count = span_length - 3;
+        if (pass == 0) {
+            a.blend_with_alpha(dst_a, s_src, count);
+            b.blend_with_alpha(dst_b, s_src, count);
+        } else if (pass == 1) {
+            a.blend_with_opacity(dst_a, s_src, count, 0x80);
+            b.blend_with_opacity(dst_b, s_src, count, 0x80);
+        } else {
+            a.blend_dimmed(dst_a, s_src, count);
+            b.blend_dimmed(dst_b, s_src, count);
+        }
+        if (memcmp(dst_a, dst_b, sizeof(dst_a)))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 20;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: blitbench [iterations]\n");
+        return 1;
+    }
+
+    printf("Selected kernels: %s\n", pixel_kernels().name);
+    benchmark(scalar_pixel_kernels(), iterations);
+    if (auto* sse2 = sse2_pixel_kernels()) {
+        if (!kernels_agree(scalar_pixel_kernels(), *sse2)) {
+            fprintf(stderr, "sse2 kernels disagree with scalar kernels!\n");
+            return 1;
+        }
+        benchmark(*sse2, iterations);
+    }
+    return 0;
+}
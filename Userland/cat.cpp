@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <assert.h>
+#include <sys/sendfile.h>
 
 int main(int argc, char** argv)
 {
@@ -13,6 +14,18 @@ int main(int argc, char** argv)
         printf("failed to open %s: %s\n", argv[1], strerror(errno));
         return 1;
     }
+    // Regular files can go straight to the output without passing through here.
+    for (;;) {
+        ssize_t nsent = sendfile(1, fd, nullptr, 1024 * 1024);
+        if (nsent == 0)
+            return 0;
+        if (nsent < 0) {
+            if (errno == EINVAL)
+                break;
+            printf("sendfile() error: %s\n", strerror(errno));
+            return 2;
+        }
+    }
     for (;;) {
         char buf[4096];
         ssize_t nread = read(fd, buf, sizeof(buf));
@@ -2,11 +2,56 @@
 #include <fcntl.h>
 #include <assert.h>
 #include <stdio.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <AK/AKString.h>
 #include <AK/StringBuilder.h>
 #include <AK/FileSystemPath.h>
 
+static bool copy_with_read_and_write(int src_fd, int dst_fd)
+{
+    for (;;) {
+        char buffer[BUFSIZ];
+        ssize_t nread = read(src_fd, buffer, sizeof(buffer));
+        if (nread < 0) {
+            perror("read src");
+            return false;
+        }
+        if (nread == 0)
+            break;
+        ssize_t remaining_to_write = nread;
+        char* bufptr = buffer;
+        while (remaining_to_write) {
+            ssize_t nwritten = write(dst_fd, bufptr, remaining_to_write);
+            if (nwritten < 0) {
+                perror("write dst");
+                return false;
+            }
+            assert(nwritten > 0);
+            remaining_to_write -= nwritten;
+            bufptr += nwritten;
+        }
+    }
+    return true;
+}
+
+static bool copy_file(int src_fd, int dst_fd)
+{
+    // Let the kernel move the data without it passing through here.
+    // It can't do that from devices and the like, so fall back to reading and writing those ourselves.
+    for (;;) {
+        ssize_t nsent = sendfile(dst_fd, src_fd, nullptr, 1024 * 1024);
+        if (nsent < 0) {
+            if (errno == EINVAL)
+                return copy_with_read_and_write(src_fd, dst_fd);
+            perror("sendfile");
+            return false;
+        }
+        if (nsent == 0)
+            return true;
+    }
+}
+
 int main(int argc, char** argv)
 {
     if (argc != 3) {
@@ -52,28 +97,8 @@ int main(int argc, char** argv)
         }
     }
 
-    for (;;) {
-        char buffer[BUFSIZ];
-        ssize_t nread = read(src_fd, buffer, sizeof(buffer));
-        if (nread < 0) {
-            perror("read src");
-            return 1;
-        }
-        if (nread == 0)
-            break;
-        ssize_t remaining_to_write = nread;
-        char* bufptr = buffer;
-        while (remaining_to_write) {
-            ssize_t nwritten = write(dst_fd, bufptr, remaining_to_write);
-            if (nwritten < 0) {
-                perror("write dst");
-                return 1;
-            }
-            assert(nwritten > 0);
-            remaining_to_write -= nwritten;
-            bufptr += nwritten;
-        }
-    }
+    if (!copy_file(src_fd, dst_fd))
+        return 1;
 
     auto my_umask = umask(0);
     umask(my_umask);
@@ -0,0 +1,40 @@
+#include <AK/AKString.h>
+#include <LibCore/CArgsParser.h>
+#include <LibGUI/GApplication.h>
+#include <LibGUI/GDesktop.h>
+#include <stdio.h>
+
+static void print_duration(const char* name, unsigned us)
+{
+    printf("%-16s %u.%03u ms\n", name, us / 1000, us % 1000);
+}
+
+int main(int argc, char** argv)
+{
+    GApplication app(argc, argv);
+
+    CArgsParser args_parser("framestats");
+    args_parser.add_arg("o", "on|off", "show or hide the frame time overlay");
+    CArgsParserResult args = args_parser.parse(argc, (const char**)argv);
+
+    if (args.is_present("o")) {
+        String value = args.get("o");
+        if (value != "on" && value != "off") {
+            args_parser.print_usage();
+            return 1;
+        }
+        GDesktop::the().set_frame_time_overlay_enabled(value == "on");
+        return 0;
+    }
+
+    auto stats = GDesktop::the().frame_stats();
+    printf("%-16s %u\n", "frames", stats.frame_count);
+    printf("%-16s %u\n", "missed deadlines", stats.missed_deadline_count);
+    print_duration("last compose", stats.last_compose_us);
+    print_duration("last flush", stats.last_flush_us);
+    print_duration("average compose", stats.average_compose_us);
+    print_duration("average flush", stats.average_flush_us);
+    print_duration("max compose", stats.max_compose_us);
+    print_duration("max flush", stats.max_flush_us);
+    return 0;
+}
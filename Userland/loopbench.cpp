@@ -0,0 +1,134 @@
+#include <LibCore/CElapsedTimer.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Measures UDP round-trip latency over 127.0.0.1, once with the loopback
+// fast path disabled (the old Ethernet/NetworkTask route) and once with it enabled.
+
+static const int echo_port = 8089;
+
+static bool set_fast_path(bool enabled)
+{
+    int fd = open("/proc/sys/loopback_fast_path", O_WRONLY);
+    if (fd < 0) {
+        perror("open /proc/sys/loopback_fast_path");
+        return false;
+    }
+    write(fd, enabled ? "1" : "0", 1);
+    close(fd);
+    return true;
+}
+
+static void run_echo_server()
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        exit(1);
+    }
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(echo_port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (bind(fd, (const sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        exit(1);
+    }
+    char buffer[64];
+    for (;;) {
+        sockaddr_in peer_addr;
+        socklen_t peer_addr_len = sizeof(peer_addr);
+        ssize_t nrecv = recvfrom(fd, buffer, sizeof(buffer), 0, (sockaddr*)&peer_addr, &peer_addr_len);
+        if (nrecv < 0)
+            continue;
+        sendto(fd, buffer, nrecv, 0, (const sockaddr*)&peer_addr, peer_addr_len);
+    }
+}
+
+static int measure_round_trips(int iterations)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    struct timeval timeout { 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in dst_addr;
+    memset(&dst_addr, 0, sizeof(dst_addr));
+    dst_addr.sin_family = AF_INET;
+    dst_addr.sin_port = htons(echo_port);
+    inet_pton(AF_INET, "127.0.0.1", &dst_addr.sin_addr);
+
+    char buffer[64];
+    memset(buffer, 'x', sizeof(buffer));
+
+    CElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        sendto(fd, buffer, 32, 0, (const sockaddr*)&dst_addr, sizeof(dst_addr));
+        sockaddr_in src_addr;
+        socklen_t src_addr_len = sizeof(src_addr);
+        if (recvfrom(fd, buffer, sizeof(buffer), 0, (sockaddr*)&src_addr, &src_addr_len) < 0) {
+            perror("recvfrom");
+            close(fd);
+            return -1;
+        }
+    }
+    int elapsed = timer.elapsed();
+    close(fd);
+    return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 1000;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: loopbench [iterations]\n");
+        return 1;
+    }
+
+    pid_t server_pid = fork();
+    if (server_pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (server_pid == 0) {
+        run_echo_server();
+        return 0;
+    }
+    // Give the server a moment to bind.
+    sleep(1);
+
+    for (int pass = 0; pass < 2; ++pass) {
+        bool fast_path = pass == 1;
+        if (!set_fast_path(fast_path))
+            break;
+        int elapsed = measure_round_trips(iterations);
+        if (elapsed < 0)
+            break;
+        printf("%-10s %d round trips in %d ms (%d us each)\n",
+            fast_path ? "fast path" : "queued",
+            iterations,
+            elapsed,
+            elapsed * 1000 / iterations);
+    }
+
+    set_fast_path(true);
+    kill(server_pid, SIGKILL);
+    int status;
+    waitpid(server_pid, &status, 0);
+    return 0;
+}
@@ -113,18 +113,12 @@ int do_dir(const char* path)
     }
     char pathbuf[PATH_MAX];
 
-    while (auto* de = readdir(dirp)) {
+    struct stat st;
+    while (auto* de = readdir_with_stat(dirp, &st)) {
         if (de->d_name[0] == '.' && !flag_show_dotfiles)
             continue;
         sprintf(pathbuf, "%s/%s", path, de->d_name);
 
-        struct stat st;
-        int rc = lstat(pathbuf, &st);
-        if (rc == -1) {
-            printf("lstat(%s) failed: %s\n", pathbuf, strerror(errno));
-            return 2;
-        }
-
         if (flag_show_inode)
             printf("%08u ", de->d_ino);
 
@@ -198,11 +192,14 @@ int do_dir_short(const char* path)
     }
 
     Vector<String, 1024> names;
+    Vector<struct stat, 1024> stats;
     int longest_name = 0;
-    while (auto* de = readdir(dirp)) {
+    struct stat st;
+    while (auto* de = readdir_with_stat(dirp, &st)) {
         if (de->d_name[0] == '.' && !flag_show_dotfiles)
             continue;
         names.append(de->d_name);
+        stats.append(st);
         if (names.last().length() > longest_name)
             longest_name = names.last().length();
     }
@@ -212,16 +209,7 @@ int do_dir_short(const char* path)
 
     for (int i = 0; i < names.size(); ++i) {
         auto& name = names[i];
-        struct stat st;
-        char pathbuf[256];
-        sprintf(pathbuf, "%s/%s", path, name.characters());
-        int rc = lstat(pathbuf, &st);
-        if (rc == -1) {
-            printf("lstat(%s) failed: %s\n", pathbuf, strerror(errno));
-            return 2;
-        }
-
-        int nprinted = print_name(st, name.characters());
+        int nprinted = print_name(stats[i], name.characters());
         int column_width = 14;
         printed_on_row += column_width;
 
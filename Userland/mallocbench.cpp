@@ -0,0 +1,68 @@
+#include <LibCore/CElapsedTimer.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Hammers malloc() and free() with a mix of small and page-sized allocations
+// from 1, 2, ... N threads at once, and reports the combined throughput.
+
+static const int slot_count = 256;
+static const int max_thread_count = 64;
+static int s_operations_per_thread = 200000;
+
+static void* run_worker(void* argument)
+{
+    unsigned seed = (unsigned)(uintptr_t)argument;
+    void* slots[slot_count];
+    memset(slots, 0, sizeof(slots));
+    for (int i = 0; i < s_operations_per_thread; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int slot = (seed >> 8) % slot_count;
+        if (slots[slot]) {
+            free(slots[slot]);
+            slots[slot] = nullptr;
+            continue;
+        }
+        // Mostly small objects, like the rest of the system allocates.
+        size_t size = (seed & 15) ? 1 + ((seed >> 16) % 128) : 1 + ((seed >> 16) % 4000);
+        slots[slot] = malloc(size);
+        *(volatile char*)slots[slot] = 0;
+    }
+    for (int i = 0; i < slot_count; ++i)
+        free(slots[i]);
+    return nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    int max_threads = argc > 1 ? atoi(argv[1]) : 4;
+    if (argc > 2)
+        s_operations_per_thread = atoi(argv[2]);
+    if (max_threads <= 0 || max_threads > max_thread_count || s_operations_per_thread <= 0) {
+        fprintf(stderr, "usage: mallocbench [max threads] [operations per thread]\n");
+        return 1;
+    }
+
+    for (int thread_count = 1; thread_count <= max_threads; ++thread_count) {
+        pthread_t threads[max_thread_count];
+        CElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < thread_count; ++i) {
+            int rc = pthread_create(&threads[i], nullptr, run_worker, (void*)(uintptr_t)(i + 1));
+            if (rc != 0) {
+                fprintf(stderr, "pthread_create: %s\n", strerror(rc));
+                return 1;
+            }
+        }
+        for (int i = 0; i < thread_count; ++i)
+            pthread_join(threads[i], nullptr);
+        int ms = timer.elapsed();
+        if (ms <= 0)
+            ms = 1;
+        long long operations = (long long)thread_count * s_operations_per_thread;
+        printf("%2d thread(s): %lld operations in %d ms, %lld k/s\n", thread_count, operations, ms, operations / ms);
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <AK/AKString.h>
+#include <AK/Vector.h>
+#include <LibCore/CElapsedTimer.h>
+#include <SharedGraphics/Inflater.h>
+#include <SharedGraphics/PNGLoader.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Decodes every PNG below a directory (default /res) a number of times
+// and reports the total decoding time. Before that, makes sure the inflater
+// rejects some malformed streams.
+
+// A dynamic block header with HLIT=31 and HDIST=31 (288 literal and 32 distance codes,
+// more than DEFLATE allows), followed by code lengths filling all 320 of them.
+static const byte s_too_many_codes_stream[] = { 0xfd, 0x1f, 0x80, 0xe4, 0xff, 0x7f, 0x08 };
+
+static bool check_malformed_streams()
+{
+    Inflater inflater(Inflater::Format::Raw);
+    inflater.append_input(s_too_many_codes_stream, sizeof(s_too_many_codes_stream));
+    byte output[16];
+    if (inflater.read(output, sizeof(output)) || !inflater.has_error()) {
+        fprintf(stderr, "pngbench: inflater accepted a block with too many codes!\n");
+        return false;
+    }
+    return true;
+}
+
+static void find_pngs(const String& path, Vector<String>& paths)
+{
+    DIR* dirp = opendir(path.characters());
+    if (!dirp)
+        return;
+    while (auto* de = readdir(dirp)) {
+        if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
+            continue;
+        String child_path = String::format("%s/%s", path.characters(), de->d_name);
+        struct stat st;
+        if (lstat(child_path.characters(), &st) < 0)
+            continue;
+        if (S_ISDIR(st.st_mode)) {
+            find_pngs(child_path, paths);
+            continue;
+        }
+        if (child_path.ends_with(".png"))
+            paths.append(move(child_path));
+    }
+    closedir(dirp);
+}
+
+int main(int argc, char** argv)
+{
+    String root = argc > 1 ? argv[1] : "/res";
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: pngbench [directory] [iterations]\n");
+        return 1;
+    }
+
+    if (!check_malformed_streams())
+        return 1;
+
+    Vector<String> paths;
+    find_pngs(root, paths);
+    if (paths.is_empty()) {
+        fprintf(stderr, "No PNGs found in %s\n", root.characters());
+        return 1;
+    }
+
+    int decoded = 0;
+    int failed = 0;
+    long long pixels = 0;
+    CElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        for (auto& path : paths) {
+            auto bitmap = load_png(path);
+            if (!bitmap) {
+                if (i == 0)
+                    fprintf(stderr, "Failed to decode %s\n", path.characters());
+                ++failed;
+                continue;
+            }
+            pixels += bitmap->width() * bitmap->height();
+            ++decoded;
+        }
+    }
+    int ms = timer.elapsed();
+    if (ms <= 0)
+        ms = 1;
+    printf("%d PNGs (%d failed) in %d ms, %lld kpixels/s\n", decoded, failed, ms, pixels / ms);
+    return 0;
+}
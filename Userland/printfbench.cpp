@@ -0,0 +1,105 @@
+#include <LibCore/CElapsedTimer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Checks a handful of conversions against known output, then times snprintf()
+// on integers, strings and floating point. Times are per call.
+
+static int s_failures = 0;
+
+static void check(const char* expected, const char* fmt, ...)
+{
+    char buffer[128];
+    va_list ap;
+    va_start(ap, fmt);
+    int length = vsnprintf(buffer, sizeof(buffer), fmt, ap);
+    va_end(ap);
+    if (strcmp(buffer, expected) || length != (int)strlen(expected)) {
+        fprintf(stderr, "printfbench: \"%s\" gave \"%s\" (%d), expected \"%s\"\n", fmt, buffer, length, expected);
+        ++s_failures;
+    }
+}
+
+static void check_conversions()
+{
+    check("0 -1 2147483647 -2147483648", "%d %d %d %d", 0, -1, 2147483647, (int)-2147483648LL);
+    check("4294967295 18446744073709551615", "%u %llu", 0xffffffffu, 0xffffffffffffffffULL);
+    check("-9223372036854775807", "%lld", -9223372036854775807LL);
+    check("[   42][42   ][00042][+42]", "[%5d][%-5d][%05d][%+d]", 42, 42, 42, 42);
+    check("[  -42][-0042]", "[%*d][%05d]", 5, -42, -42);
+    check("5 +5 0 010 0017", "%+u %+d %#o %#o %#.4o", 5, 5, 0, 8, 15);
+    check("-1 255 -32768 2345", "%hhd %hhu %hd %hx", 0xff, -1, 0x18000, 0x12345);
+    check("c0debabe C0DEBABE 0x0000001f beef", "%x %X %#x %w", 0xc0debabe, 0xc0debabe, 0x1f, 0xbeef);
+    check("0xc0000000", "%p", (void*)0xc0000000);
+    check("[abc][  abc][ab]", "[%s][%5s][%.2s]", "abc", "abc", "abc");
+    check("0.000000 1.500000 -2.25", "%f %f %.2f", 0.0, 1.5, -2.25);
+    check("0.1000000000000000055511151231257827", "%.34f", 0.1);
+    check("2 0 2", "%.0f %.0f %.0f", 2.5, 0.5, 1.5);
+    check("1.000000e+100 1.23e-05", "%e %.2e", 1e100, 0.0000123);
+    check("100000 1e+06 0.0001 1e-05", "%g %g %g %g", 100000.0, 1000000.0, 0.0001, 0.00001);
+    check("0.30000000000000004", "%.17g", 0.1 + 0.2);
+    check("inf -inf nan", "%f %f %f", __builtin_inf(), -__builtin_inf(), __builtin_nan(""));
+
+    char small[8];
+    int length = snprintf(small, sizeof(small), "%s-%d", "hello", 12345);
+    if (strcmp(small, "hello-1") || length != 11) {
+        fprintf(stderr, "printfbench: truncated snprintf gave \"%s\" (%d)\n", small, length);
+        ++s_failures;
+    }
+}
+
+template<typename Callback>
+static void report(const char* name, int iterations, Callback callback)
+{
+    CElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback(i);
+    int elapsed = timer.elapsed();
+    printf("%-32s %10d ns\n", name, (int)((long long)elapsed * 1000 * 1000 / iterations));
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 100000;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: printfbench [iterations]\n");
+        return 1;
+    }
+
+    check_conversions();
+    if (s_failures) {
+        fprintf(stderr, "printfbench: %d conversion(s) failed!\n", s_failures);
+        return 1;
+    }
+
+    char buffer[256];
+    report("%d", iterations, [&](int i) {
+        snprintf(buffer, sizeof(buffer), "%d", i * 7919);
+    });
+    report("%llu", iterations, [&](int i) {
+        snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)i * 0x9e3779b97f4a7c15ULL);
+    });
+    report("%x", iterations, [&](int i) {
+        snprintf(buffer, sizeof(buffer), "%x", (unsigned)i * 2654435761u);
+    });
+    report("log line", iterations, [&](int i) {
+        snprintf(buffer, sizeof(buffer), "[%s(%u:%u)] Ext2FS: read_block %u at %x, %d bytes\n", "WindowServer", i, 13, i * 7, i, -i);
+    });
+    report("%-20s|%5s", iterations, [&](int) {
+        snprintf(buffer, sizeof(buffer), "%-20s|%5s", "name", "value");
+    });
+    report("%f", iterations / 10 + 1, [&](int i) {
+        snprintf(buffer, sizeof(buffer), "%f", i * 1.25 + 0.001);
+    });
+    report("%.17g", iterations / 10 + 1, [&](int i) {
+        snprintf(buffer, sizeof(buffer), "%.17g", 1.0 / (i + 3));
+    });
+    report("%e", iterations / 10 + 1, [&](int i) {
+        snprintf(buffer, sizeof(buffer), "%e", i * 1e10 + 0.5);
+    });
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <LibCore/CElapsedTimer.h>
+#include <SharedGraphics/GraphicsBitmap.h>
+#include <SharedGraphics/Painter.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Measures Painter::draw_scaled_bitmap() for each scaling mode over a range of scale factors.
+
+static Retained<GraphicsBitmap> make_test_bitmap(GraphicsBitmap::Format format, const Size& size)
+{
+    auto bitmap = GraphicsBitmap::create(format, size);
+    unsigned seed = 1234;
+    for (int y = 0; y < size.height(); ++y) {
+        auto* scanline = bitmap->scanline(y);
+        for (int x = 0; x < size.width(); ++x) {
+            seed = seed * 1103515245 + 12345;
+            scanline[x] = ((x ^ y) & 8 ? 0xff000000 : (seed & 0xff000000)) | (seed >> 8);
+        }
+    }
+    return bitmap;
+}
+
+static const char* name_for_mode(Painter::ScalingMode mode)
+{
+    switch (mode) {
+    case Painter::ScalingMode::NearestNeighbor:
+        return "nearest";
+    case Painter::ScalingMode::Bilinear:
+        return "bilinear";
+    case Painter::ScalingMode::BoxFilter:
+        return "box";
+    }
+    return "?";
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 5;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: scalebench [iterations]\n");
+        return 1;
+    }
+
+    const Size source_size { 640, 480 };
+    // Scale factors in percent.
+    const int factors[] = { 10, 25, 50, 75, 133, 200, 330 };
+    const Painter::ScalingMode modes[] = { Painter::ScalingMode::NearestNeighbor, Painter::ScalingMode::Bilinear, Painter::ScalingMode::BoxFilter };
+    const GraphicsBitmap::Format formats[] = { GraphicsBitmap::Format::RGB32, GraphicsBitmap::Format::RGBA32 };
+
+    for (auto format : formats) {
+        auto source = make_test_bitmap(format, source_size);
+        for (int factor : factors) {
+            Size target_size { source_size.width() * factor / 100, source_size.height() * factor / 100 };
+            auto target = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, target_size);
+            Painter painter(*target);
+            for (auto mode : modes) {
+                CElapsedTimer timer;
+                timer.start();
+                for (int i = 0; i < iterations; ++i)
+                    painter.draw_scaled_bitmap(target->rect(), *source, source->rect(), mode);
+                int ms = timer.elapsed();
+                if (ms <= 0)
+                    ms = 1;
+                long long pixels = (long long)iterations * target_size.width() * target_size.height();
+                printf("%-6s %3d%% %-8s %6d ms %6lld kpixels/s\n", format == GraphicsBitmap::Format::RGB32 ? "RGB32" : "RGBA32", factor, name_for_mode(mode), ms, pixels / ms);
+            }
+        }
+    }
+    return 0;
+}
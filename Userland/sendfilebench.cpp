@@ -0,0 +1,242 @@
+#include <LibCore/CElapsedTimer.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Compares copying a file with read()/write() (the way cp and cat used to)
+// against sendfile(), into another file, a pipe and a local socket.
+
+static const char* s_source_path = "/tmp/sendfilebench.src";
+static const char* s_destination_path = "/tmp/sendfilebench.dst";
+static const char* s_socket_path = "/tmp/sendfilebench.sock";
+
+enum class Method {
+    ReadWrite,
+    SendFile,
+};
+
+static bool copy(Method method, int src_fd, int dst_fd, int buffer_size)
+{
+    if (method == Method::SendFile) {
+        for (;;) {
+            ssize_t nsent = sendfile(dst_fd, src_fd, nullptr, 1024 * 1024);
+            if (nsent < 0) {
+                perror("sendfile");
+                return false;
+            }
+            if (nsent == 0)
+                return true;
+        }
+    }
+    auto* buffer = (char*)malloc(buffer_size);
+    for (;;) {
+        ssize_t nread = read(src_fd, buffer, buffer_size);
+        if (nread < 0) {
+            perror("read");
+            free(buffer);
+            return false;
+        }
+        if (nread == 0)
+            break;
+        for (ssize_t offset = 0; offset < nread;) {
+            ssize_t nwritten = write(dst_fd, buffer + offset, nread - offset);
+            if (nwritten <= 0) {
+                perror("write");
+                free(buffer);
+                return false;
+            }
+            offset += nwritten;
+        }
+    }
+    free(buffer);
+    return true;
+}
+
+static void report(const char* name, int size, int elapsed)
+{
+    if (!elapsed)
+        elapsed = 1;
+    int tenths_of_mb_per_second = (int)((long long)size * 10000 / (1024 * 1024) / elapsed);
+    printf("%-32s %6d ms %4d.%d MB/s\n", name, elapsed, tenths_of_mb_per_second / 10, tenths_of_mb_per_second % 10);
+}
+
+// Reads and throws away everything from fd until EOF, then checks the byte count.
+static void drain(int fd, int expected_size)
+{
+    char buffer[4096];
+    int total = 0;
+    for (;;) {
+        ssize_t nread = read(fd, buffer, sizeof(buffer));
+        if (nread <= 0)
+            break;
+        total += nread;
+    }
+    if (total != expected_size) {
+        fprintf(stderr, "sendfilebench: drained %d bytes, expected %d!\n", total, expected_size);
+        exit(1);
+    }
+    exit(0);
+}
+
+static void wait_for(pid_t pid)
+{
+    int status;
+    waitpid(pid, &status, 0);
+}
+
+static void bench_file(const char* name, Method method, int buffer_size, int size)
+{
+    int src_fd = open(s_source_path, O_RDONLY);
+    int dst_fd = open(s_destination_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (src_fd < 0 || dst_fd < 0) {
+        perror("open");
+        exit(1);
+    }
+    CElapsedTimer timer;
+    timer.start();
+    if (!copy(method, src_fd, dst_fd, buffer_size))
+        exit(1);
+    report(name, size, timer.elapsed());
+
+    // Make sure the copy is actually a copy.
+    lseek(src_fd, 0, SEEK_SET);
+    lseek(dst_fd, 0, SEEK_SET);
+    static char expected[4096];
+    static char actual[4096];
+    for (;;) {
+        ssize_t nexpected = read(src_fd, expected, sizeof(expected));
+        ssize_t nactual = read(dst_fd, actual, sizeof(actual));
+        if (nexpected != nactual || memcmp(expected, actual, nexpected)) {
+            fprintf(stderr, "sendfilebench: %s produced a different file!\n", name);
+            exit(1);
+        }
+        if (nexpected <= 0)
+            break;
+    }
+    close(src_fd);
+    close(dst_fd);
+}
+
+static void bench_pipe(const char* name, Method method, int buffer_size, int size)
+{
+    int pipefd[2];
+    if (pipe(pipefd) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        close(pipefd[1]);
+        drain(pipefd[0], size);
+    }
+    close(pipefd[0]);
+
+    int src_fd = open(s_source_path, O_RDONLY);
+    CElapsedTimer timer;
+    timer.start();
+    if (!copy(method, src_fd, pipefd[1], buffer_size))
+        exit(1);
+    close(pipefd[1]);
+    wait_for(pid);
+    report(name, size, timer.elapsed());
+    close(src_fd);
+}
+
+static void bench_socket(const char* name, Method method, int buffer_size, int size)
+{
+    unlink(s_socket_path);
+    int server_fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        perror("socket");
+        exit(1);
+    }
+    sockaddr_un address;
+    address.sun_family = AF_LOCAL;
+    strcpy(address.sun_path, s_socket_path);
+    if (bind(server_fd, (const sockaddr*)&address, sizeof(address)) < 0 || listen(server_fd, 1) < 0) {
+        perror("bind");
+        exit(1);
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        close(server_fd);
+        int fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (const sockaddr*)&address, sizeof(address)) < 0) {
+            perror("connect");
+            exit(1);
+        }
+        drain(fd, size);
+    }
+
+    sockaddr_un client_address;
+    socklen_t client_address_size = sizeof(client_address);
+    int client_fd = accept(server_fd, (sockaddr*)&client_address, &client_address_size);
+    if (client_fd < 0) {
+        perror("accept");
+        exit(1);
+    }
+
+    int src_fd = open(s_source_path, O_RDONLY);
+    CElapsedTimer timer;
+    timer.start();
+    if (!copy(method, src_fd, client_fd, buffer_size))
+        exit(1);
+    close(client_fd);
+    wait_for(pid);
+    report(name, size, timer.elapsed());
+    close(src_fd);
+    close(server_fd);
+    unlink(s_socket_path);
+}
+
+int main(int argc, char** argv)
+{
+    int megabytes = 4;
+    if (argc > 1)
+        megabytes = atoi(argv[1]);
+    if (megabytes <= 0) {
+        fprintf(stderr, "usage: sendfilebench [megabytes]\n");
+        return 1;
+    }
+    int size = megabytes * 1024 * 1024;
+
+    int fd = open(s_source_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("open");
+        return 1;
+    }
+    static char chunk[4096];
+    for (int offset = 0; offset < size; offset += sizeof(chunk)) {
+        for (int i = 0; i < (int)sizeof(chunk); ++i)
+            chunk[i] = (char)(offset / sizeof(chunk) + i * 7);
+        write(fd, chunk, sizeof(chunk));
+    }
+    close(fd);
+
+    printf("%d MB\n", megabytes);
+    bench_file("file: read+write (BUFSIZ)", Method::ReadWrite, BUFSIZ, size);
+    bench_file("file: read+write (64 KB)", Method::ReadWrite, 64 * 1024, size);
+    bench_file("file: sendfile", Method::SendFile, 0, size);
+    bench_pipe("pipe: read+write (4 KB)", Method::ReadWrite, 4096, size);
+    bench_pipe("pipe: sendfile", Method::SendFile, 0, size);
+    bench_socket("socket: read+write (4 KB)", Method::ReadWrite, 4096, size);
+    bench_socket("socket: sendfile", Method::SendFile, 0, size);
+
+    unlink(s_source_path);
+    unlink(s_destination_path);
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <AK/AKString.h>
+#include <AK/QuickSort.h>
+#include <AK/Vector.h>
+#include <LibCore/CElapsedTimer.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Times quick_sort(), merge_sort() and qsort() on a few input distributions,
+// including the ones (presorted, all equal) that used to make quick_sort() quadratic.
+
+enum class Distribution {
+    Random,
+    Sorted,
+    Reversed,
+    OrganPipe,
+    FewUnique,
+    AllEqual,
+};
+
+static const char* distribution_name(Distribution distribution)
+{
+    switch (distribution) {
+    case Distribution::Random:
+        return "random";
+    case Distribution::Sorted:
+        return "sorted";
+    case Distribution::Reversed:
+        return "reversed";
+    case Distribution::OrganPipe:
+        return "organ pipe";
+    case Distribution::FewUnique:
+        return "few unique";
+    case Distribution::AllEqual:
+        return "all equal";
+    }
+    return "?";
+}
+
+static Vector<int> make_input(Distribution distribution, int count)
+{
+    Vector<int> values;
+    values.ensure_capacity(count);
+    for (int i = 0; i < count; ++i) {
+        switch (distribution) {
+        case Distribution::Random:
+            values.unchecked_append(rand());
+            break;
+        case Distribution::Sorted:
+            values.unchecked_append(i);
+            break;
+        case Distribution::Reversed:
+            values.unchecked_append(count - i);
+            break;
+        case Distribution::OrganPipe:
+            values.unchecked_append(i < count / 2 ? i : count - i);
+            break;
+        case Distribution::FewUnique:
+            values.unchecked_append(rand() % 8);
+            break;
+        case Distribution::AllEqual:
+            values.unchecked_append(42);
+            break;
+        }
+    }
+    return values;
+}
+
+static int compare_ints(const void* a, const void* b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static bool is_sorted(Vector<int>& values)
+{
+    for (int i = 1; i < values.size(); ++i) {
+        if (values[i] < values[i - 1])
+            return false;
+    }
+    return true;
+}
+
+template<typename Callback>
+static int time_sort(const Vector<int>& input, Callback sort)
+{
+    auto values = input;
+    CElapsedTimer timer;
+    timer.start();
+    sort(values);
+    int elapsed = timer.elapsed();
+    if (!is_sorted(values)) {
+        fprintf(stderr, "sortbench: result not sorted!\n");
+        exit(1);
+    }
+    return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    int count = 100000;
+    if (argc > 1)
+        count = atoi(argv[1]);
+    if (count <= 0) {
+        fprintf(stderr, "usage: sortbench [count]\n");
+        return 1;
+    }
+
+    printf("%d elements, times in ms\n", count);
+    printf("%-12s %10s %10s %10s\n", "input", "quick_sort", "merge_sort", "qsort");
+    Distribution distributions[] = {
+        Distribution::Random,
+        Distribution::Sorted,
+        Distribution::Reversed,
+        Distribution::OrganPipe,
+        Distribution::FewUnique,
+        Distribution::AllEqual,
+    };
+    for (auto distribution : distributions) {
+        auto input = make_input(distribution, count);
+        int quick_ms = time_sort(input, [](auto& values) {
+            quick_sort(values.begin(), values.end(), [](int a, int b) { return a < b; });
+        });
+        int merge_ms = time_sort(input, [](auto& values) {
+            merge_sort(values.begin(), values.end(), [](int a, int b) { return a < b; });
+        });
+        int qsort_ms = time_sort(input, [](auto& values) {
+            qsort(values.data(), values.size(), sizeof(int), compare_ints);
+        });
+        printf("%-12s %10d %10d %10d\n", distribution_name(distribution), quick_ms, merge_ms, qsort_ms);
+    }
+
+    // Strings are where copying the pivot used to hurt.
+    Vector<String> strings;
+    strings.ensure_capacity(count);
+    for (int i = 0; i < count; ++i)
+        strings.unchecked_append(String::format("line %d", rand()));
+    CElapsedTimer timer;
+    timer.start();
+    quick_sort(strings.begin(), strings.end(), [](auto& a, auto& b) {
+        return strcmp(a.characters(), b.characters()) < 0;
+    });
+    printf("%-12s %10d\n", "strings", timer.elapsed());
+    return 0;
+}
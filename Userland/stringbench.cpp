@@ -0,0 +1,167 @@
+#include <LibC/StringKernels.h>
+#include <LibCore/CElapsedTimer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// Checks every string kernel set against the scalar one on random inputs
+// (including strings that end right before an unmapped page), then times them.
+
+// Keeps the timed calls from being optimized away.
+static volatile size_t s_sink;
+
+static int sign(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+static int check_kernels(const StringKernels& kernels, int iterations)
+{
+    auto& scalar = scalar_string_kernels();
+
+    // A page with nothing mapped after it, so reading past the end crashes.
+    auto* reservation = mmap(nullptr, 2 * PAGE_SIZE, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    if (reservation == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    munmap(reservation, 2 * PAGE_SIZE);
+    auto* page = (char*)mmap(reservation, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    if (page == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    int failures = 0;
+    auto fail = [&](const char* what, const char* a) {
+        if (failures++ < 10)
+            fprintf(stderr, "%s: %s mismatch on \"%s\"\n", kernels.name, what, a);
+    };
+
+    char other_buffer[160];
+    for (int i = 0; i < iterations; ++i) {
+        int length = rand() % 128;
+        char* a = page + PAGE_SIZE - length - 1 - (rand() % 2 ? rand() % 32 : 0);
+        for (int j = 0; j < length; ++j)
+            a[j] = 'a' + rand() % 4;
+        a[length] = '\0';
+
+        // A copy at some other alignment, maybe with one byte changed.
+        char* b = other_buffer + rand() % 16;
+        memcpy(b, a, length + 1);
+        if (length && rand() % 2)
+            b[rand() % length] = 'a' + rand() % 4;
+
+        int ch = rand() % 20 ? 'a' + rand() % 5 : '\0';
+        size_t size = rand() % (length + 1);
+        char needle[8];
+        int needle_length = rand() % 7;
+        for (int j = 0; j < needle_length; ++j)
+            needle[j] = 'a' + rand() % 3;
+        needle[needle_length] = '\0';
+
+        if (kernels.strlen(a) != scalar.strlen(a))
+            fail("strlen", a);
+        if (kernels.strchr(a, ch) != scalar.strchr(a, ch))
+            fail("strchr", a);
+        if (kernels.memchr(a, ch, size) != scalar.memchr(a, ch, size))
+            fail("memchr", a);
+        if (sign(kernels.strcmp(a, b)) != sign(scalar.strcmp(a, b)) || sign(kernels.strcmp(b, a)) != sign(scalar.strcmp(b, a)))
+            fail("strcmp", a);
+        if (sign(kernels.memcmp(a, b, size)) != sign(scalar.memcmp(a, b, size)))
+            fail("memcmp", a);
+        if (kernels.strstr(a, needle) != scalar.strstr(a, needle))
+            fail("strstr", a);
+    }
+    munmap(page, PAGE_SIZE);
+    return failures;
+}
+
+static void time_kernels(const StringKernels& kernels, int iterations)
+{
+    static char text[64 * 1024];
+    static char copy[64 * 1024];
+    memset(text, 'x', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    memcpy(copy, text, sizeof(text));
+    // Nearly-matching needles are the naive strstr()'s worst case.
+    const char* needle = "xxxxxxxxxxxxxxxy";
+    const char* short_needle = "xy";
+
+    size_t total = 0;
+    int elapsed[6];
+    CElapsedTimer timer;
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        total += kernels.strlen(text + i % 8);
+    elapsed[0] = timer.elapsed();
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        total += kernels.strchr(text + i % 8, 'y') != nullptr;
+    elapsed[1] = timer.elapsed();
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        total += kernels.memchr(text + i % 8, 'y', sizeof(text) - 8) != nullptr;
+    elapsed[2] = timer.elapsed();
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        total += kernels.strcmp(text, copy);
+    elapsed[3] = timer.elapsed();
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        total += kernels.memcmp(text, copy + i % 8, sizeof(text) - 8);
+    elapsed[4] = timer.elapsed();
+
+    // That's a lot slower, so it gets fewer rounds.
+    int strstr_iterations = iterations / 10 + 1;
+    timer.start();
+    for (int i = 0; i < strstr_iterations; ++i)
+        total += kernels.strstr(text, i % 2 ? needle : short_needle) != nullptr;
+    elapsed[5] = timer.elapsed();
+
+    // Everything scans about 64 KB per call.
+    printf("%-8s", kernels.name);
+    for (int i = 0; i < 6; ++i) {
+        int kilobytes = (i == 5 ? strstr_iterations : iterations) * 64;
+        printf(" %8d", elapsed[i] ? kilobytes / elapsed[i] : 0);
+    }
+    printf("\n");
+    s_sink = total;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 1000;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: stringbench [iterations]\n");
+        return 1;
+    }
+
+    const StringKernels* kernel_sets[] = { &scalar_string_kernels(), &swar_string_kernels(), sse2_string_kernels() };
+
+    int failures = 0;
+    for (auto* kernels : kernel_sets) {
+        if (!kernels)
+            continue;
+        int kernel_failures = check_kernels(*kernels, iterations * 100);
+        if (kernel_failures < 0)
+            return 1;
+        failures += kernel_failures;
+    }
+    printf("correctness: %s\n", failures ? "FAILED" : "ok");
+
+    printf("%-8s %8s %8s %8s %8s %8s %8s  (MB/s)\n", "kernels", "strlen", "strchr", "memchr", "strcmp", "memcmp", "strstr");
+    for (auto* kernels : kernel_sets) {
+        if (kernels)
+            time_kernels(*kernels, iterations);
+    }
+    return failures ? 1 : 0;
+}
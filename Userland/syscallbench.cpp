@@ -0,0 +1,168 @@
+#include <AK/AKString.h>
+#include <Kernel/Syscall.h>
+#include <LibCore/CElapsedTimer.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Measures syscall entry cost (int 0x82 vs sysenter) and what the batched
+// calls save over their one-call-per-item equivalents. Times are per line item.
+
+static const char* s_scratch_path = "/tmp/syscallbench.tmp";
+static const int chunk_count = 16;
+static const int chunk_size = 256;
+
+template<typename Callback>
+static void report(const char* name, int iterations, Callback callback)
+{
+    CElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback();
+    int elapsed = timer.elapsed();
+    printf("%-32s %10d ns\n", name, (int)((long long)elapsed * 1000 * 1000 / iterations));
+}
+
+static void bench_entry(int iterations)
+{
+    report("gettid (int 0x82)", iterations, [] {
+        bool saved = __syscall_use_sysenter;
+        __syscall_use_sysenter = false;
+        gettid();
+        __syscall_use_sysenter = saved;
+    });
+    if (!__syscall_use_sysenter) {
+        printf("%-32s (not supported by this CPU)\n", "gettid (sysenter)");
+        return;
+    }
+    report("gettid (sysenter)", iterations, [] {
+        gettid();
+    });
+}
+
+static void bench_vectored_io(int iterations)
+{
+    int fd = open(s_scratch_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("open");
+        exit(1);
+    }
+
+    static char chunks[chunk_count][chunk_size];
+    iovec iov[chunk_count];
+    for (int i = 0; i < chunk_count; ++i) {
+        memset(chunks[i], 'a' + i, chunk_size);
+        iov[i] = { chunks[i], chunk_size };
+    }
+    if (pwritev(fd, iov, chunk_count, 0) != chunk_count * chunk_size) {
+        perror("pwritev");
+        exit(1);
+    }
+
+    // Make sure the vectored calls put the right bytes in the right places before timing them.
+    static char check[chunk_count][chunk_size];
+    iovec check_iov[chunk_count];
+    for (int i = 0; i < chunk_count; ++i)
+        check_iov[i] = { check[i], chunk_size };
+    if (preadv(fd, check_iov, chunk_count, 0) != chunk_count * chunk_size || memcmp(check, chunks, sizeof(check))) {
+        fprintf(stderr, "syscallbench: preadv() returned the wrong data!\n");
+        exit(1);
+    }
+    lseek(fd, 0, SEEK_SET);
+    memset(check, 0, sizeof(check));
+    if (readv(fd, check_iov, chunk_count) != chunk_count * chunk_size || memcmp(check, chunks, sizeof(check))) {
+        fprintf(stderr, "syscallbench: readv() returned the wrong data!\n");
+        exit(1);
+    }
+
+    report("16 x (lseek + read)", iterations, [&] {
+        for (int i = 0; i < chunk_count; ++i) {
+            lseek(fd, i * chunk_size, SEEK_SET);
+            read(fd, check[i], chunk_size);
+        }
+    });
+    report("16 x read", iterations, [&] {
+        lseek(fd, 0, SEEK_SET);
+        for (int i = 0; i < chunk_count; ++i)
+            read(fd, check[i], chunk_size);
+    });
+    report("readv of 16", iterations, [&] {
+        lseek(fd, 0, SEEK_SET);
+        readv(fd, check_iov, chunk_count);
+    });
+    report("preadv of 16", iterations, [&] {
+        preadv(fd, check_iov, chunk_count, 0);
+    });
+    report("16 x (lseek + write)", iterations, [&] {
+        for (int i = 0; i < chunk_count; ++i) {
+            lseek(fd, i * chunk_size, SEEK_SET);
+            write(fd, chunks[i], chunk_size);
+        }
+    });
+    report("pwritev of 16", iterations, [&] {
+        pwritev(fd, iov, chunk_count, 0);
+    });
+
+    close(fd);
+    unlink(s_scratch_path);
+}
+
+static void bench_directory(const char* path, int iterations)
+{
+    int entry_count = 0;
+    char pathbuf[PATH_MAX];
+    String name = String::format("readdir + lstat (%s)", path);
+    report(name.characters(), iterations, [&] {
+        DIR* dirp = opendir(path);
+        if (!dirp) {
+            perror("opendir");
+            exit(1);
+        }
+        entry_count = 0;
+        while (auto* de = readdir(dirp)) {
+            sprintf(pathbuf, "%s/%s", path, de->d_name);
+            struct stat st;
+            if (lstat(pathbuf, &st) == 0)
+                ++entry_count;
+        }
+        closedir(dirp);
+    });
+    int entries_with_stat = 0;
+    name = String::format("readdir_with_stat (%s)", path);
+    report(name.characters(), iterations, [&] {
+        DIR* dirp = opendir(path);
+        if (!dirp) {
+            perror("opendir");
+            exit(1);
+        }
+        entries_with_stat = 0;
+        struct stat st;
+        while (readdir_with_stat(dirp, &st))
+            ++entries_with_stat;
+        closedir(dirp);
+    });
+    if (entries_with_stat != entry_count)
+        fprintf(stderr, "syscallbench: saw %d entries with lstat() but %d with readdir_with_stat()\n", entry_count, entries_with_stat);
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 10000;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: syscallbench [iterations] [directory]\n");
+        return 1;
+    }
+    const char* directory = argc > 2 ? argv[2] : "/bin";
+
+    bench_entry(iterations * 10);
+    bench_vectored_io(iterations / 10 + 1);
+    bench_directory(directory, iterations / 100 + 1);
+    return 0;
+}
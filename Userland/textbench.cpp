@@ -0,0 +1,70 @@
+#include <LibCore/CElapsedTimer.h>
+#include <SharedGraphics/Font.h>
+#include <SharedGraphics/GraphicsBitmap.h>
+#include <SharedGraphics/Painter.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Draws a full 1024x768 screen of text, once glyph by glyph through draw_bitmap()
+// (the old per-pixel path) and once with draw_text(), which uses the font's span cache.
+
+static const char* s_sample_text = "The quick brown fox jumps over the lazy dog. 0123456789 {}[]()<>+-*/=!?";
+
+static int run(Painter& painter, const Font& font, int iterations, bool per_glyph)
+{
+    int line_count = 768 / font.glyph_height();
+    int length = strlen(s_sample_text);
+    CElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        for (int line = 0; line < line_count; ++line) {
+            Point point { 0, line * font.glyph_height() };
+            // Keep drawing the sample until the line is full.
+            while (point.x() < 1024) {
+                if (per_glyph) {
+                    for (int j = 0; j < length; ++j) {
+                        char ch = s_sample_text[j];
+                        if (ch != ' ')
+                            painter.draw_bitmap(point, font.glyph_bitmap(ch), Color::Black);
+                        point.move_by(font.glyph_width(ch) + font.glyph_spacing(), 0);
+                    }
+                } else {
+                    painter.draw_text({ point, { 1024 - point.x(), font.glyph_height() } }, s_sample_text, length, font, TextAlignment::TopLeft, Color::Black);
+                    point.move_by(font.width(s_sample_text, length) + font.glyph_spacing(), 0);
+                }
+            }
+        }
+    }
+    return timer.elapsed();
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 20;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: textbench [iterations]\n");
+        return 1;
+    }
+
+    auto bitmap = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { 1024, 768 });
+    Painter painter(*bitmap);
+
+    const Font* fonts[] = { &Font::default_font(), &Font::default_fixed_width_font() };
+    for (auto* font : fonts) {
+        for (int pass = 0; pass < 2; ++pass) {
+            bool per_glyph = pass == 0;
+            painter.fill_rect(bitmap->rect(), Color::White);
+            int ms = run(painter, *font, iterations, per_glyph);
+            printf("%-20s %-10s %d screens in %d ms (%d ms each)\n",
+                font->name().characters(),
+                per_glyph ? "per-glyph" : "draw_text",
+                iterations,
+                ms,
+                ms / iterations);
+        }
+    }
+    return 0;
+}